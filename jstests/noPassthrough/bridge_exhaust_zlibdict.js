@@ -0,0 +1,45 @@
+/**
+ * Tests that exhaust queries through mongobridge return every document when the connections
+ * compress their messages with zlibdict, which only embeds a dictionary in the first message of
+ * a connection that uses it.
+ */
+(function() {
+    "use strict";
+
+    const destPort = allocatePort();
+    const bridge = new MongoBridge(
+        {dest: getHostName() + ":" + destPort, networkMessageCompressors: "zlibdict"});
+    const conn = MongoRunner.runMongod({port: destPort, networkMessageCompressors: "zlibdict"});
+    assert.neq(null, conn, "mongod failed to start");
+    bridge.connectToBridge();
+
+    const docCount = 1000;
+    const coll = conn.getDB("test").bridge_exhaust_zlibdict;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < docCount; i++) {
+        bulk.insert({_id: i, payload: "x".repeat(100)});
+    }
+    assert.writeOK(bulk.execute());
+
+    // Run the queries from a shell that compresses its own traffic, so that compressed replies go
+    // through the bridge. Several exhaust queries on one connection make every reply after the
+    // first use a dictionary sent earlier.
+    function runExhaustQueries(docCount) {
+        const coll = db.getSiblingDB("test").bridge_exhaust_zlibdict;
+        for (let i = 0; i < 3; i++) {
+            assert.eq(docCount,
+                      coll.find().batchSize(7).addOption(DBQuery.Option.exhaust).itcount());
+        }
+    }
+    const exitCode = runMongoProgram("mongo",
+                                     "--networkMessageCompressors=zlibdict",
+                                     "--readMode=legacy",
+                                     "--port",
+                                     bridge.port,
+                                     "--eval",
+                                     "(" + runExhaustQueries.toString() + ")(" + docCount + ");");
+    assert.eq(0, exitCode, "exhaust queries through mongobridge failed");
+
+    MongoRunner.stopMongod(conn);
+    bridge.stop();
+}());
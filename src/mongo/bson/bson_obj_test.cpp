@@ -675,4 +675,23 @@ TEST(BSONObj, addField) {
     ASSERT_BSONOBJ_EQ(obj, BSON("a" << 1 << "b" << 2));
 }
 
+TEST(BSONObj, getFieldMatchesWholeNamesOnly) {
+    BSONObj obj = BSON("ab" << 1 << "a" << 2 << "abc" << BSON("x" << 3) << "" << 4 << "b"
+                            << "tail");
+
+    ASSERT_EQ(1, obj.getField("ab").numberInt());
+    ASSERT_EQ(2, obj.getField("a").numberInt());
+    ASSERT_EQ(3, obj.getField("abc").Obj()["x"].numberInt());
+    ASSERT_EQ(4, obj.getField("").numberInt());
+    ASSERT_EQ("tail", obj.getField("b").str());
+    ASSERT_TRUE(obj.getField("abcd").eoo());
+    ASSERT_TRUE(obj.getField("x").eoo());
+    ASSERT_TRUE(obj.getField("a\0"_sd).eoo());
+    ASSERT_TRUE(obj.getField("tailtailtail").eoo());
+    ASSERT_TRUE(BSONObj().getField("a").eoo());
+
+    // Only the first of duplicate fields is found.
+    ASSERT_EQ(1, BSON("d" << 1 << "d" << 2).getField("d").numberInt());
+}
+
 }  // unnamed namespace
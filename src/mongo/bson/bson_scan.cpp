@@ -0,0 +1,238 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_scan.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "mongo/platform/bits.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MONGO_BSON_SCAN_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels need per-function target attributes and __builtin_cpu_supports.
+#if defined(MONGO_BSON_SCAN_HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define MONGO_BSON_SCAN_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace mongo {
+namespace bson_scan {
+
+namespace {
+
+//
+// Portable kernels.
+//
+
+const char* findNulPortable(const char* begin, const char* end) {
+    return static_cast<const char*>(memchr(begin, 0, end - begin));
+}
+
+int leadingOnes(unsigned char c) {
+    int ones = 0;
+    while (c & 0x80) {
+        ++ones;
+        c <<= 1;
+    }
+    return ones;
+}
+
+/**
+ * Validates [p, end) given that 'left' continuation bytes are still due from the bytes before
+ * 'p'. Updates 'left' and returns false as soon as the bytes cannot be valid.
+ */
+bool validateUTF8Bytes(const unsigned char* p, const unsigned char* end, int* left) {
+    for (; p < end; ++p) {
+        const unsigned char c = *p;
+        if (c < 0x80) {
+            if (*left) {
+                return false;  // should be a continuation byte
+            }
+            continue;
+        }
+        const int ones = leadingOnes(c);
+        if (*left) {
+            if (ones != 1) {
+                return false;  // should be a continuation byte
+            }
+            --*left;
+        } else {
+            if (ones == 1) {
+                return false;  // unexpected continuation byte
+            }
+            if (c > 0xF4) {
+                return false;  // codepoint too large (< 0x10FFFF)
+            }
+            if (c == 0xC0 || c == 0xC1) {
+                return false;  // codepoints <= 0x7F shouldn't be 2 bytes
+            }
+            *left = ones - 1;
+        }
+    }
+    return true;
+}
+
+#if !defined(MONGO_BSON_SCAN_HAVE_SSE2)
+bool isValidUTF8Portable(const char* data, size_t len) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    int left = 0;
+    return validateUTF8Bytes(p, p + len, &left) && left == 0;
+}
+#endif
+
+//
+// SSE2 kernels. SSE2 is part of x86-64, so these need no dispatch.
+//
+
+#if defined(MONGO_BSON_SCAN_HAVE_SSE2)
+
+const char* findNulSSE2(const char* begin, const char* end) {
+    const __m128i zero = _mm_setzero_si128();
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+        if (mask) {
+            return p + countTrailingZeros64(mask);
+        }
+    }
+    return p == end ? nullptr : findNulPortable(p, end);
+}
+
+bool isValidUTF8SSE2(const char* data, size_t len) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    const auto end = p + len;
+    int left = 0;
+    for (; end - p >= 16; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // All ASCII, and no codepoint still open from the previous chunk.
+        if (0 == _mm_movemask_epi8(chunk) && 0 == left) {
+            continue;
+        }
+        if (!validateUTF8Bytes(p, p + 16, &left)) {
+            return false;
+        }
+    }
+    return validateUTF8Bytes(p, end, &left) && left == 0;
+}
+
+#endif  // MONGO_BSON_SCAN_HAVE_SSE2
+
+//
+// AVX2 kernels, only called when the CPU supports AVX2.
+//
+
+#if defined(MONGO_BSON_SCAN_HAVE_AVX2)
+
+__attribute__((target("avx2"))) const char* findNulAVX2(const char* begin, const char* end) {
+    const __m256i zero = _mm256_setzero_si256();
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero));
+        if (mask) {
+            return p + countTrailingZeros64(mask);
+        }
+    }
+    return p == end ? nullptr : findNulSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) bool isValidUTF8AVX2(const char* data, size_t len) {
+    auto p = reinterpret_cast<const unsigned char*>(data);
+    const auto end = p + len;
+    int left = 0;
+    for (; end - p >= 32; p += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (0 == _mm256_movemask_epi8(chunk) && 0 == left) {
+            continue;
+        }
+        if (!validateUTF8Bytes(p, p + 32, &left)) {
+            return false;
+        }
+    }
+    return validateUTF8Bytes(p, end, &left) && left == 0;
+}
+
+#endif  // MONGO_BSON_SCAN_HAVE_AVX2
+
+struct Kernels {
+    const char* (*findNul)(const char*, const char*);
+    bool (*isValidUTF8)(const char*, size_t);
+    StringData name;
+};
+
+Kernels pickKernels() {
+#if defined(MONGO_BSON_SCAN_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {findNulAVX2, isValidUTF8AVX2, "avx2"_sd};
+    }
+#endif
+#if defined(MONGO_BSON_SCAN_HAVE_SSE2)
+    return {findNulSSE2, isValidUTF8SSE2, "sse2"_sd};
+#else
+    return {findNulPortable, isValidUTF8Portable, "portable"_sd};
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels picked = pickKernels();
+    return picked;
+}
+
+}  // namespace
+
+const char* findNul(const char* begin, const char* end) {
+    // Field names are mostly short enough to find in the first word, without a call.
+    if (end - begin >= 8) {
+        for (int i = 0; i < 8; ++i) {
+            if (!begin[i]) {
+                return begin + i;
+            }
+        }
+        begin += 8;
+    }
+    return begin == end ? nullptr : kernels().findNul(begin, end);
+}
+
+bool isValidUTF8(const char* data, size_t len) {
+    return kernels().isValidUTF8(data, len);
+}
+
+StringData kernelName() {
+    return kernels().name;
+}
+
+}  // namespace bson_scan
+}  // namespace mongo
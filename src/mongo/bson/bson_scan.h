@@ -0,0 +1,62 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+/**
+ * Byte scanning kernels for BSON parsing and validation. Each function picks, once per process,
+ * the widest implementation the CPU supports: AVX2 or SSE2 on x86-64, and a portable one
+ * everywhere else.
+ */
+namespace bson_scan {
+
+/**
+ * Returns a pointer to the first NUL byte in [begin, end), or nullptr if there is none. Never
+ * reads outside of [begin, end).
+ */
+const char* findNul(const char* begin, const char* end);
+
+/**
+ * Returns true if the 'len' bytes at 'data' are well formed UTF-8, by the same rules as
+ * isValidUTF8() in util/text.h. NUL bytes count as ASCII.
+ */
+bool isValidUTF8(const char* data, size_t len);
+
+/**
+ * Returns the name of the kernels in use: "avx2", "sse2" or "portable".
+ */
+StringData kernelName();
+
+}  // namespace bson_scan
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include <cstring>
+#include <string>
+
+#include "mongo/bson/bson_scan.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/log.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace {
+
+TEST(BSONScan, FindNulAtEveryOffsetAndLength) {
+    log() << "bson scan kernels: " << bson_scan::kernelName();
+
+    // Long enough for several vector widths, plus the unaligned tails around them.
+    std::string buf(100, 'x');
+    for (size_t len = 0; len <= 80; ++len) {
+        for (size_t start = 0; start < 16; ++start) {
+            const char* begin = buf.data() + start;
+            ASSERT(!bson_scan::findNul(begin, begin + len)) << start << " " << len;
+            for (size_t nul = 0; nul < len; ++nul) {
+                buf[start + nul] = '\0';
+                ASSERT_EQ(static_cast<const void*>(begin + nul),
+                          static_cast<const void*>(bson_scan::findNul(begin, begin + len)));
+                buf[start + nul] = 'x';
+            }
+        }
+    }
+}
+
+TEST(BSONScan, FindNulDoesNotLookPastTheEnd) {
+    const char buf[] = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz";
+    ASSERT(!bson_scan::findNul(buf, buf + sizeof(buf) - 1));
+    ASSERT_EQ(static_cast<const void*>(buf + sizeof(buf) - 1),
+              static_cast<const void*>(bson_scan::findNul(buf, buf + sizeof(buf))));
+}
+
+TEST(BSONScan, ValidUTF8) {
+    ASSERT(bson_scan::isValidUTF8("", 0));
+    ASSERT(bson_scan::isValidUTF8("plain ascii", 11));
+    ASSERT(bson_scan::isValidUTF8("caf\xc3\xa9", 5));
+    ASSERT(bson_scan::isValidUTF8("\xe2\x82\xac euro", 8));
+    ASSERT(bson_scan::isValidUTF8("\xf0\x9f\x98\x80", 4));
+    ASSERT(bson_scan::isValidUTF8("nul\0inside", 10));
+
+    ASSERT_FALSE(bson_scan::isValidUTF8("\x80", 1));
+    ASSERT_FALSE(bson_scan::isValidUTF8("\xc3", 1));
+    ASSERT_FALSE(bson_scan::isValidUTF8("\xc0\x80", 2));
+    ASSERT_FALSE(bson_scan::isValidUTF8("\xf5\x80\x80\x80", 4));
+    ASSERT_FALSE(bson_scan::isValidUTF8("\xe2\x82x", 3));
+}
+
+TEST(BSONScan, ValidUTF8AgreesWithCStringCheckAcrossVectorBoundaries) {
+    const char* pieces[] = {"a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\x80", "\xc3"};
+    PseudoRandom random(1);
+    for (int i = 0; i < 20000; ++i) {
+        std::string s;
+        const int numPieces = random.nextInt32(40);
+        for (int j = 0; j < numPieces; ++j) {
+            s += pieces[random.nextInt32(random.nextInt32(8) == 0 ? 6 : 4)];
+        }
+        ASSERT_EQ(isValidUTF8(s), bson_scan::isValidUTF8(s.data(), s.size())) << s;
+    }
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,129 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * The document shapes, chosen by state.range(0).
+ */
+enum Shape {
+    // Many small fields with short names, like a metrics document.
+    kManySmallFields,
+    // A handful of fields with long names and long string values, like a log entry.
+    kLongStrings,
+    // Nested subdocuments and arrays, like an order with line items.
+    kNested,
+};
+
+BSONObj makeDoc(int shape) {
+    BSONObjBuilder bob;
+    switch (shape) {
+        case kManySmallFields:
+            for (int i = 0; i < 200; ++i) {
+                bob.append(std::string("f") + std::to_string(i), i);
+            }
+            break;
+        case kLongStrings:
+            for (int i = 0; i < 12; ++i) {
+                bob.append(std::string(40, 'a' + i) + "_field_name", std::string(1024, 'v'));
+            }
+            break;
+        case kNested:
+            for (int i = 0; i < 20; ++i) {
+                BSONArrayBuilder items(bob.subarrayStart(std::string("order") + std::to_string(i)));
+                for (int j = 0; j < 10; ++j) {
+                    items.append(BSON("sku" << j << "description" << std::string(32, 'd') << "qty"
+                                            << 2
+                                            << "price"
+                                            << 9.99));
+                }
+            }
+            break;
+        default:
+            MONGO_UNREACHABLE;
+    }
+    // A field at the very end, for lookups that must scan the whole document.
+    bob.append("zzz_last", "end");
+    return bob.obj();
+}
+
+void BM_ValidateBSON(benchmark::State& state) {
+    const BSONObj doc = makeDoc(state.range(0));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(validateBSON(doc.objdata(), doc.objsize(), BSONVersion::kLatest));
+    }
+    state.SetBytesProcessed(state.iterations() * doc.objsize());
+}
+
+void BM_GetLastField(benchmark::State& state) {
+    const BSONObj doc = makeDoc(state.range(0));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(doc.getField("zzz_last"));
+    }
+    state.SetBytesProcessed(state.iterations() * doc.objsize());
+}
+
+void BM_GetMissingField(benchmark::State& state) {
+    const BSONObj doc = makeDoc(state.range(0));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(doc.getField("not_there"));
+    }
+    state.SetBytesProcessed(state.iterations() * doc.objsize());
+}
+
+// UTF-8 validation of a string value, all ASCII (state.range(0) == 0) or about one character
+// in eight multi-byte.
+void BM_IsValidUTF8(benchmark::State& state) {
+    std::string s;
+    for (int i = 0; s.size() < 16 * 1024; ++i) {
+        s += (state.range(0) && i % 8 == 0) ? "\xc3\xa9" : "a";
+    }
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(isValidUTF8(s));
+    }
+    state.SetBytesProcessed(state.iterations() * s.size());
+}
+
+BENCHMARK(BM_ValidateBSON)->Arg(kManySmallFields)->Arg(kLongStrings)->Arg(kNested);
+BENCHMARK(BM_GetLastField)->Arg(kManySmallFields)->Arg(kLongStrings)->Arg(kNested);
+BENCHMARK(BM_GetMissingField)->Arg(kManySmallFields)->Arg(kLongStrings)->Arg(kNested);
+BENCHMARK(BM_IsValidUTF8)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mongo
@@ -32,6 +32,7 @@
 #include "mongo/db/jsobj.h"
 
 #include "mongo/base/data_range.h"
+#include "mongo/bson/bson_scan.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/bsonelement_comparator_interface.h"
 #include "mongo/db/json.h"
@@ -501,15 +502,25 @@ void BSONObj::getFields(unsigned n, const char** fieldNames, BSONElement* fields
 }
 
 BSONElement BSONObj::getField(StringData name) const {
-    BSONObjIterator i(*this);
-    while (i.more()) {
-        BSONElement e = i.next();
-        // We know that e has a cached field length since BSONObjIterator::next internally
-        // called BSONElement::size on the BSONElement that it returned, so it is more
-        // efficient to re-use that information by obtaining the field name as a
-        // StringData, which will be pre-populated with the cached length.
-        if (name == e.fieldNameStringData())
-            return e;
+    // No field name contains a NUL byte.
+    if (name.find('\0') != std::string::npos)
+        return BSONElement();
+
+    // Compare each field name against 'name' in place, so that only the names that differ need
+    // to be measured to find the next element.
+    const char* p = objdata() + 4;
+    const char* const end = objdata() + objsize() - 1;
+    while (p < end) {
+        const char* const fieldName = p + 1;
+        if (static_cast<size_t>(end - fieldName) > name.size() &&
+            memcmp(fieldName, name.rawData(), name.size()) == 0 && !fieldName[name.size()]) {
+            return BSONElement(p, name.size() + 1, -1, BSONElement::CachedSizeTag());
+        }
+
+        const char* const nameEnd = bson_scan::findNul(fieldName, end);
+        if (!nameEnd)
+            break;
+        p += BSONElement(p, nameEnd - fieldName + 1, -1, BSONElement::CachedSizeTag()).size();
     }
     return BSONElement();
 }
@@ -30,9 +30,9 @@
 #include "mongo/db/audit.h"
 
 #include <algorithm>
-#include <boost/algorithm/string/predicate.hpp>
 
 #include "mongo/bson/mutable/document.h"
+#include "mongo/db/audit_ns_filter.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/privilege_parser.h"
 #include "mongo/db/client.h"
@@ -43,7 +43,6 @@
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/map_util.h"
-//#include "mongo/util/concurrency/rwlock.h"
 
 
 #if MONGO_ENTERPRISE_VERSION
@@ -84,12 +83,6 @@ using namespace mongo::logger;
 
 const std::string ROLE_NAME_FIELD_NAME = "role";
 const std::string ROLE_DB_FIELD_NAME = "db";
-/*
-RWLock auditOpNsMapLock("auditOpNsMapMutex");
-RWLock& getAuditGlobalRWLock() {
-    return auditOpNsMapLock;
-}
-*/
 void getAuthenticatedUsersAndRoles(Client* client,
                                    std::vector<UserName>* userNames,
                                    std::vector<RoleName>* roleNames) {
@@ -182,31 +175,13 @@ bool isAuthWithCustomer(Client* client) {
         (NULL != client->getOperationContext() && client->getOperationContext()->isCustomerTxn());
 }
 
-bool needLogNS(const std::string& inputNs, const std::string& auditOp) {
+bool needLogNS(StringData inputNs, AuditOp auditOp) {
     // if auditOpFilterStr is all, that means will audit all op with all coll
     if (serverGlobalParams.auditOpFilterStr == "all" ||
-        (serverGlobalParams.auditOpFilter & auditOpFromString(auditOp)) != 0) {
+        (serverGlobalParams.auditOpFilter & auditOp) != 0) {
         return true;
     }
-    std::set<std::string> nullSet;
-    // rwlock lk(getAuditGlobalRWLock(), false);
-    const auto& it = serverGlobalParams.auditOpNsFilterMap.find(auditOp);
-    if (it == serverGlobalParams.auditOpNsFilterMap.end()) {
-        return false;
-    }
-    const auto& allowSetOpNss = serverGlobalParams.auditOpNsFilterMap.find(auditOp)->second;
-    bool inputNsIsDB = inputNs.find(".") == std::string::npos ? true : false;
-    for (auto& nsMapInConfig : allowSetOpNss) {
-        bool nsInConfIsDB = nsMapInConfig.second;
-        std::string nsInConfig = nsMapInConfig.first;
-        if ((!nsInConfIsDB && inputNs == nsInConfig) ||
-            (nsInConfIsDB && inputNsIsDB && inputNs == nsInConfig) ||
-            (nsInConfIsDB && !inputNsIsDB &&
-             boost::algorithm::starts_with(inputNs, nsInConfig + "."))) {
-            return true;
-        }
-    }
-    return false;
+    return getAuditNsFilter().matches(auditOp, inputNs);
 }
 
 // Command that does not require auditing
@@ -220,7 +195,7 @@ void logAuthentication(Client* client,
                        StringData mechanism,
                        const UserName& user,
                        ErrorCodes::Error result) {
-    if (!needLogNS(user.getDB().toString(), "auth") || !isAuthWithCustomer(client)) {
+    if (!needLogNS(user.getDB(), opAuth) || !isAuthWithCustomer(client)) {
         return;
     }
 
@@ -250,8 +225,8 @@ bool needLogCommand(Client* client) {
     return (serverGlobalParams.auditOpFilter & opCommand) != 0 && isAuthWithCustomer(client);
 }
 
-bool needLogCmdOnNs(Client* client, std::string ns) {
-    return needLogNS(ns, "command") && isAuthWithCustomer(client);
+bool needLogCmdOnNs(Client* client, StringData ns) {
+    return needLogNS(ns, opCommand) && isAuthWithCustomer(client);
 }
 
 bool needLogSlowOp(Client* client) {
@@ -279,7 +254,7 @@ void logCommandAuthzCheck(Client* client,
             logger::auditOpList.end()) {
             cmdFilterName = "command";
         }
-        if (!needLogNS(nsStr, cmdFilterName) || shouldFilterOutCmd(cmdName)) {
+        if (!needLogNS(nsStr, auditOpFromString(cmdFilterName)) || shouldFilterOutCmd(cmdName)) {
             return;
         }
         builder.append("command", cmdName);
@@ -299,7 +274,7 @@ void logDeleteAuthzCheck(Client* client,
                          const NamespaceString& ns,
                          const BSONObj& pattern,
                          ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "delete")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opDelete)) {
         return;
     }
 
@@ -316,7 +291,7 @@ void logGetMoreAuthzCheck(Client* client,
                           const NamespaceString& ns,
                           long long cursorId,
                           ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "query")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opQuery)) {
         return;
     }
 
@@ -333,7 +308,7 @@ void logInsertAuthzCheck(Client* client,
                          const NamespaceString& ns,
                          const BSONObj& insertedObj,
                          ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "insert")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opInsert)) {
         return;
     }
 
@@ -350,7 +325,7 @@ void logKillCursorsAuthzCheck(Client* client,
                               const NamespaceString& ns,
                               long long cursorId,
                               ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "query")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opQuery)) {
         return;
     }
 
@@ -367,7 +342,7 @@ void logQueryAuthzCheck(Client* client,
                         const NamespaceString& ns,
                         const BSONObj& query,
                         ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "query")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opQuery)) {
         return;
     }
 
@@ -387,7 +362,7 @@ void logUpdateAuthzCheck(Client* client,
                          bool isUpsert,
                          bool isMulti,
                          ErrorCodes::Error result) {
-    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), "update")) {
+    if (!needLogAuthzCheck(client, result) || !needLogNS(ns.ns(), opUpdate)) {
         return;
     }
 
@@ -579,7 +554,7 @@ void logDropRole(Client* client, const RoleName& role) {
     logAuditEventCommon("dropRole", client, param, ErrorCodes::OK);
 }
 void logDropAllRolesFromDatabase(Client* client, StringData dbname) {
-    if (!needLogCmdOnNs(client, dbname.toString())) {
+    if (!needLogCmdOnNs(client, dbname)) {
         return;
     }
     BSONObjBuilder builder;
@@ -697,7 +672,7 @@ void logCreateIndex(Client* client,
                     const BSONObj* indexSpec,
                     StringData indexname,
                     StringData nsname) {
-    if (!needLogCmdOnNs(client, nsname.toString())) {
+    if (!needLogCmdOnNs(client, nsname)) {
         return;
     }
 
@@ -713,7 +688,7 @@ void logCreateIndex(Client* client,
 }
 
 void logCreateCollection(Client* client, StringData nsname) {
-    if (!needLogCmdOnNs(client, nsname.toString())) {
+    if (!needLogCmdOnNs(client, nsname)) {
         return;
     }
 
@@ -724,7 +699,7 @@ void logCreateCollection(Client* client, StringData nsname) {
 }
 
 void logCreateDatabase(Client* client, StringData dbname) {
-    if (!needLogCmdOnNs(client, dbname.toString())) {
+    if (!needLogCmdOnNs(client, dbname)) {
         return;
     }
 
@@ -737,7 +712,7 @@ void logCreateDatabase(Client* client, StringData dbname) {
 
 
 void logDropIndex(Client* client, StringData indexname, StringData nsname) {
-    if (!needLogCmdOnNs(client, nsname.toString())) {
+    if (!needLogCmdOnNs(client, nsname)) {
         return;
     }
 
@@ -751,7 +726,7 @@ void logDropIndex(Client* client, StringData indexname, StringData nsname) {
 }
 
 void logDropCollection(Client* client, StringData nsname) {
-    if (!needLogCmdOnNs(client, nsname.toString())) {
+    if (!needLogCmdOnNs(client, nsname)) {
         return;
     }
 
@@ -763,7 +738,7 @@ void logDropCollection(Client* client, StringData nsname) {
 }
 
 void logDropDatabase(Client* client, StringData dbname) {
-    if (!needLogCmdOnNs(client, dbname.toString())) {
+    if (!needLogCmdOnNs(client, dbname)) {
         return;
     }
     BSONObjBuilder builder;
@@ -774,7 +749,7 @@ void logDropDatabase(Client* client, StringData dbname) {
 }
 
 void logRenameCollection(Client* client, StringData source, StringData target) {
-    if (!needLogCmdOnNs(client, source.toString())) {
+    if (!needLogCmdOnNs(client, source)) {
         return;
     }
 
@@ -787,7 +762,7 @@ void logRenameCollection(Client* client, StringData source, StringData target) {
 }
 
 void logEnableSharding(Client* client, StringData dbname) {
-    if (!needLogCmdOnNs(client, dbname.toString())) {
+    if (!needLogCmdOnNs(client, dbname)) {
         return;
     }
 
@@ -825,7 +800,7 @@ void logRemoveShard(Client* client, StringData shardname) {
 }
 
 void logShardCollection(Client* client, StringData ns, const BSONObj& keyPattern, bool unique) {
-    if (!needLogCmdOnNs(client, ns.toString())) {
+    if (!needLogCmdOnNs(client, ns)) {
         return;
     }
 
@@ -54,8 +54,6 @@ class CurOp;
 
 namespace audit {
 
-// RWLock& getAuditGlobalRWLock();
-
 /**
  * Narrow API for the parts of mongo::Command used by the audit library.
  */
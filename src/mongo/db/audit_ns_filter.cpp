@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/audit_ns_filter.h"
+
+#include <atomic>
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+namespace {
+
+// Publication protocol: the filter is stored before the version is bumped, so a thread that
+// observes a new version always loads a filter at least that new.
+AtomicUInt64 publishedVersion{1};
+
+std::shared_ptr<const AuditNsFilter>& publishedFilter() {
+    static std::shared_ptr<const AuditNsFilter> filter = std::make_shared<AuditNsFilter>();
+    return filter;
+}
+
+struct CachedFilter {
+    uint64_t version = 0;
+    std::shared_ptr<const AuditNsFilter> filter;
+};
+
+thread_local CachedFilter cachedFilter;
+
+}  // namespace
+
+std::shared_ptr<const AuditNsFilter> AuditNsFilter::compile(const OpNsMap& opNsMap) {
+    auto filter = std::make_shared<AuditNsFilter>();
+    for (const auto& opEntry : opNsMap) {
+        const logger::AuditOp op = logger::auditOpFromString(opEntry.first);
+        if (op == logger::opInvalid || opEntry.second.empty()) {
+            continue;
+        }
+        filter->_configuredOps |= op;
+        for (const auto& nsEntry : opEntry.second) {
+            const bool isDB = nsEntry.second;
+            auto& table = isDB ? filter->_dbs : filter->_namespaces;
+            table[nsEntry.first] |= op;
+        }
+    }
+    return filter;
+}
+
+void publishAuditNsFilter(const AuditNsFilter::OpNsMap& opNsMap) {
+    std::shared_ptr<const AuditNsFilter> filter = AuditNsFilter::compile(opNsMap);
+    std::atomic_store(&publishedFilter(), filter);
+    publishedVersion.fetchAndAdd(1);
+}
+
+const AuditNsFilter& getAuditNsFilter() {
+    const uint64_t version = publishedVersion.load();
+    if (cachedFilter.version != version) {
+        cachedFilter.filter = std::atomic_load(&publishedFilter());
+        cachedFilter.version = version;
+    }
+    return *cachedFilter.filter;
+}
+
+}  // namespace mongo
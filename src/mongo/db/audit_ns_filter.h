@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/logger/audit_event.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+/**
+ * Immutable, precompiled form of auditLog.nsFilter.
+ *
+ * Every configured database and collection namespace is stored once in a hash table, together
+ * with the bitmask of AuditOps it is configured for. A lookup hashes the namespace, and at most
+ * its database prefix, as StringData and never allocates.
+ *
+ * A database entry "db" matches the database "db" itself and every namespace "db.<anything>";
+ * a collection entry "db.coll" only matches that exact namespace.
+ */
+class AuditNsFilter {
+    MONGO_DISALLOW_COPYING(AuditNsFilter);
+
+public:
+    /**
+     * Map from op name to the configured namespaces for that op, each flagged with whether it
+     * names a database. This is the layout of serverGlobalParams.auditOpNsFilterMap.
+     */
+    typedef std::map<std::string, std::map<std::string, bool>> OpNsMap;
+
+    AuditNsFilter() = default;
+
+    static std::shared_ptr<const AuditNsFilter> compile(const OpNsMap& opNsMap);
+
+    /**
+     * Returns true if "ns" (a database name or a full namespace) is configured for "op".
+     */
+    bool matches(logger::AuditOp op, StringData ns) const {
+        if ((_configuredOps & op) == 0) {
+            return false;
+        }
+
+        const size_t dot = ns.find('.');
+        if (dot != std::string::npos) {
+            auto nsIt = _namespaces.find(ns);
+            if (nsIt != _namespaces.end() && (nsIt->second & op)) {
+                return true;
+            }
+            ns = ns.substr(0, dot);
+        }
+
+        auto dbIt = _dbs.find(ns);
+        return dbIt != _dbs.end() && (dbIt->second & op);
+    }
+
+    /**
+     * Number of distinct databases and collection namespaces configured.
+     */
+    size_t size() const {
+        return _dbs.size() + _namespaces.size();
+    }
+
+private:
+    // Bitwise or of every AuditOp with at least one configured namespace.
+    uint32_t _configuredOps = 0;
+
+    // Configured name -> bitwise or of the AuditOps it is configured for.
+    StringMap<uint32_t> _dbs;
+    StringMap<uint32_t> _namespaces;
+};
+
+/**
+ * Compiles "opNsMap" and makes it the filter returned by getAuditNsFilter(). Threads pick up
+ * the new filter on their next call to getAuditNsFilter(); filters still in use by other
+ * threads stay alive until those threads move on.
+ */
+void publishAuditNsFilter(const AuditNsFilter::OpNsMap& opNsMap);
+
+/**
+ * Returns the most recently published filter. Lock-free: in steady state this is one atomic
+ * load and a thread-local read. The reference remains valid until the calling thread calls
+ * getAuditNsFilter() again.
+ */
+const AuditNsFilter& getAuditNsFilter();
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <string>
+
+#include "mongo/db/audit_ns_filter.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Builds an insert filter with state.range(0) entries: a quarter of them databases, the rest
+ * collections spread over those databases.
+ */
+AuditNsFilter::OpNsMap makeOpNsMap(int entries) {
+    std::map<std::string, bool> nss;
+    const int dbs = std::max(1, entries / 4);
+    for (int i = 0; i < dbs; ++i) {
+        nss.insert({"db" + std::to_string(i), true});
+    }
+    for (int i = dbs; i < entries; ++i) {
+        nss.insert({"other" + std::to_string(i % dbs) + ".coll" + std::to_string(i), false});
+    }
+    return {{"insert", nss}};
+}
+
+/**
+ * The per-event check that nsFilter used before it was compiled: a linear scan over every
+ * configured namespace for the op, with a string allocation per database entry.
+ */
+bool legacyNeedLogNS(const AuditNsFilter::OpNsMap& opNsMap,
+                     const std::string& inputNs,
+                     const std::string& auditOp) {
+    const auto& it = opNsMap.find(auditOp);
+    if (it == opNsMap.end()) {
+        return false;
+    }
+    bool inputNsIsDB = inputNs.find(".") == std::string::npos;
+    for (auto& nsMapInConfig : it->second) {
+        bool nsInConfIsDB = nsMapInConfig.second;
+        const std::string& nsInConfig = nsMapInConfig.first;
+        if ((!nsInConfIsDB && inputNs == nsInConfig) ||
+            (nsInConfIsDB && inputNsIsDB && inputNs == nsInConfig) ||
+            (nsInConfIsDB && !inputNsIsDB && StringData(inputNs).startsWith(nsInConfig + "."))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A namespace that is not configured, which is the common case and the worst case for a scan.
+const std::string kMissNs = "unaudited.coll";
+
+void BM_LegacyNsFilterMiss(benchmark::State& state) {
+    auto opNsMap = makeOpNsMap(state.range(0));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(legacyNeedLogNS(opNsMap, kMissNs, "insert"));
+    }
+}
+
+void BM_CompiledNsFilterMiss(benchmark::State& state) {
+    publishAuditNsFilter(makeOpNsMap(state.range(0)));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(getAuditNsFilter().matches(logger::opInsert, kMissNs));
+    }
+}
+
+void BM_CompiledNsFilterHit(benchmark::State& state) {
+    publishAuditNsFilter(makeOpNsMap(state.range(0)));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(getAuditNsFilter().matches(logger::opInsert, "db0.coll"));
+    }
+}
+
+BENCHMARK(BM_LegacyNsFilterMiss)->Arg(16)->Arg(1024)->Arg(8192);
+BENCHMARK(BM_CompiledNsFilterMiss)->Arg(16)->Arg(1024)->Arg(8192)->ThreadRange(1, 8);
+BENCHMARK(BM_CompiledNsFilterHit)->Arg(16)->Arg(1024)->Arg(8192)->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/audit_ns_filter.h"
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using logger::opCommand;
+using logger::opDelete;
+using logger::opInsert;
+using logger::opQuery;
+
+TEST(AuditNsFilterTest, EmptyFilterMatchesNothing) {
+    auto filter = AuditNsFilter::compile({});
+    ASSERT_EQ(0U, filter->size());
+    ASSERT_FALSE(filter->matches(opInsert, "test"));
+    ASSERT_FALSE(filter->matches(opInsert, "test.coll"));
+}
+
+TEST(AuditNsFilterTest, DatabaseEntryMatchesDatabaseAndItsCollections) {
+    auto filter = AuditNsFilter::compile({{"insert", {{"test", true}}}});
+    ASSERT_TRUE(filter->matches(opInsert, "test"));
+    ASSERT_TRUE(filter->matches(opInsert, "test.coll"));
+    ASSERT_TRUE(filter->matches(opInsert, "test.system.indexes"));
+    ASSERT_FALSE(filter->matches(opInsert, "test2.coll"));
+    ASSERT_FALSE(filter->matches(opInsert, "tes.coll"));
+    ASSERT_FALSE(filter->matches(opInsert, "testcoll"));
+}
+
+TEST(AuditNsFilterTest, CollectionEntryMatchesOnlyThatNamespace) {
+    auto filter = AuditNsFilter::compile({{"insert", {{"test.coll", false}}}});
+    ASSERT_TRUE(filter->matches(opInsert, "test.coll"));
+    ASSERT_FALSE(filter->matches(opInsert, "test"));
+    ASSERT_FALSE(filter->matches(opInsert, "test.coll2"));
+    ASSERT_FALSE(filter->matches(opInsert, "test.col"));
+    ASSERT_FALSE(filter->matches(opInsert, "test.coll.sub"));
+}
+
+TEST(AuditNsFilterTest, EntriesAreScopedToTheirOp) {
+    auto filter = AuditNsFilter::compile(
+        {{"insert", {{"a", true}, {"b.c", false}}}, {"query", {{"b.c", false}}}, {"delete", {}}});
+    ASSERT_EQ(2U, filter->size());
+    ASSERT_TRUE(filter->matches(opInsert, "a.x"));
+    ASSERT_FALSE(filter->matches(opQuery, "a.x"));
+    ASSERT_TRUE(filter->matches(opInsert, "b.c"));
+    ASSERT_TRUE(filter->matches(opQuery, "b.c"));
+    ASSERT_FALSE(filter->matches(opDelete, "b.c"));
+    ASSERT_FALSE(filter->matches(opCommand, "b.c"));
+}
+
+TEST(AuditNsFilterTest, UnknownOpsAreIgnored) {
+    auto filter = AuditNsFilter::compile({{"all", {{"a", true}}}, {"bogus", {{"b", true}}}});
+    ASSERT_EQ(0U, filter->size());
+    ASSERT_FALSE(filter->matches(opInsert, "a"));
+}
+
+TEST(AuditNsFilterTest, PublishReplacesGlobalFilter) {
+    publishAuditNsFilter({{"insert", {{"first", true}}}});
+    ASSERT_TRUE(getAuditNsFilter().matches(opInsert, "first.coll"));
+
+    publishAuditNsFilter({{"insert", {{"second", true}}}});
+    ASSERT_FALSE(getAuditNsFilter().matches(opInsert, "first.coll"));
+    ASSERT_TRUE(getAuditNsFilter().matches(opInsert, "second.coll"));
+
+    publishAuditNsFilter({});
+    ASSERT_FALSE(getAuditNsFilter().matches(opInsert, "second.coll"));
+}
+
+TEST(AuditNsFilterTest, PublishIsVisibleToOtherThreads) {
+    publishAuditNsFilter({{"query", {{"before", true}}}});
+    bool sawBefore = false;
+    stdx::thread([&] { sawBefore = getAuditNsFilter().matches(opQuery, "before.c"); }).join();
+    ASSERT_TRUE(sawBefore);
+
+    publishAuditNsFilter({{"query", {{"after", true}}}});
+    bool sawAfter = false;
+    stdx::thread([&] { sawAfter = getAuditNsFilter().matches(opQuery, "after.c"); }).join();
+    ASSERT_TRUE(sawAfter);
+    publishAuditNsFilter({});
+}
+
+}  // namespace
+}  // namespace mongo
@@ -61,6 +61,7 @@ CollectionInfoCacheImpl::CollectionInfoCacheImpl(Collection* collection, const N
       _keysComputed(false),
       _planCache(stdx::make_unique<PlanCache>(ns.ns())),
       _querySettings(stdx::make_unique<QuerySettings>()),
+      _indexCardinalityStats(stdx::make_unique<IndexCardinalityStatsCache>()),
       _indexUsageTracker(getGlobalServiceContext()->getPreciseClockSource()) {}
 
 CollectionInfoCacheImpl::~CollectionInfoCacheImpl() {
@@ -174,6 +175,10 @@ QuerySettings* CollectionInfoCacheImpl::getQuerySettings() const {
     return _querySettings.get();
 }
 
+IndexCardinalityStatsCache* CollectionInfoCacheImpl::getIndexCardinalityStats() const {
+    return _indexCardinalityStats.get();
+}
+
 void CollectionInfoCacheImpl::updatePlanCacheIndexEntries(OperationContext* opCtx) {
     std::vector<IndexEntry> indexEntries;
 
@@ -235,6 +240,7 @@ void CollectionInfoCacheImpl::droppedIndex(OperationContext* opCtx, StringData i
 
 void CollectionInfoCacheImpl::rebuildIndexData(OperationContext* opCtx) {
     clearQueryCache();
+    _indexCardinalityStats->clear();
 
     _keysComputed = false;
     computeIndexKeys(opCtx);
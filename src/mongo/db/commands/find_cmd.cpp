@@ -43,6 +43,7 @@
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/query_admission.h"
 #include "mongo/db/query/find.h"
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/get_executor.h"
@@ -299,6 +300,10 @@ public:
             uassertStatusOK(status);
         }
 
+        /// OOM feature
+        // Wait for stage memory before acquiring locks, rather than failing part-way through.
+        uassertStatusOK(QueryAdmissionQueue::get().admit(opCtx));
+
         // Acquire locks. If the query is on a view, we release our locks and convert the query
         // request into an aggregation command.
         boost::optional<AutoGetCollectionForReadCommand> ctx;
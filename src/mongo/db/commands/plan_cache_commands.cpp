@@ -238,11 +238,13 @@ Status PlanCacheListQueryShapes::runPlanCacheCommand(OperationContext* opCtx,
         arrayBuilder.doneFast();
         return Status::OK();
     }
-    return list(*planCache, bob);
+    return list(*planCache, bob, cmdObj["stats"].trueValue());
 }
 
 // static
-Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder* bob) {
+Status PlanCacheListQueryShapes::list(const PlanCache& planCache,
+                                      BSONObjBuilder* bob,
+                                      bool includeStats) {
     invariant(bob);
 
     // Fetch all cached solutions from plan cache.
@@ -260,6 +262,9 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
         if (!entry->collation.isEmpty()) {
             shapeBuilder.append("collation", entry->collation);
         }
+        if (includeStats) {
+            shapeBuilder.append("stats", entry->shapeStats->toBSON());
+        }
         shapeBuilder.doneFast();
 
         // Release resources for cached solution after extracting query shape.
@@ -102,8 +102,9 @@ private:
 /**
  * planCacheListQueryShapes
  *
- * { planCacheListQueryShapes: <collection> }
+ * { planCacheListQueryShapes: <collection>, stats: <bool> }
  *
+ * With 'stats' each shape also reports its hits, misses, replans and evictions.
  */
 class PlanCacheListQueryShapes : public PlanCacheCommand {
 public:
@@ -115,9 +116,9 @@ public:
 
     /**
      * Looks up cache keys for collection's plan cache.
-     * Inserts keys for query into BSON builder.
+     * Inserts keys for query into BSON builder, with per-shape statistics if 'includeStats'.
      */
-    static Status list(const PlanCache& planCache, BSONObjBuilder* bob);
+    static Status list(const PlanCache& planCache, BSONObjBuilder* bob, bool includeStats = false);
 };
 
 /**
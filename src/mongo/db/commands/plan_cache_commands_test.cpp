@@ -164,6 +164,41 @@ TEST(PlanCacheCommandsTest, planCacheListQueryShapesOneKey) {
     ASSERT_BSONOBJ_EQ(shapes[0].getObjectField("collation"), cq->getCollator()->getSpec().toBSON());
 }
 
+TEST(PlanCacheCommandsTest, planCacheListQueryShapesWithStats) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{a: 1}"));
+    auto statusWithCQ = CanonicalQuery::canonicalize(opCtx.get(), std::move(qr));
+    ASSERT_OK(statusWithCQ.getStatus());
+    unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(createSolutionCacheData());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    ASSERT_OK(planCache.add(*cq,
+                            solns,
+                            createDecision(1U),
+                            opCtx->getServiceContext()->getPreciseClockSource()->now()));
+    CachedSolution* rawCS;
+    ASSERT_OK(planCache.get(*cq, &rawCS));
+    delete rawCS;
+
+    // Statistics are only listed on request.
+    ASSERT_TRUE(getShapes(planCache)[0]["stats"].eoo());
+
+    BSONObjBuilder bob;
+    ASSERT_OK(PlanCacheListQueryShapes::list(planCache, &bob, true));
+    BSONObj result = bob.obj();
+    BSONObj shape = result["shapes"].Array()[0].Obj();
+    ASSERT_BSONOBJ_EQ(shape.getObjectField("stats"),
+                      BSON("hits" << 1LL << "misses" << 0LL << "replans" << 0LL << "evictions"
+                                  << 0LL));
+}
+
 /**
  * Tests for planCacheClear
  */
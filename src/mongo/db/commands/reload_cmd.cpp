@@ -163,10 +163,7 @@ namespace mongo {
                         }
                     }
                 }
-                serverGlobalParams.auditOpNsFilterMap.clear();
                 if (!parseAuditNsFilter(auditNsFilterMap)) {
-                    serverGlobalParams.auditOpNsFilterMap.clear();
-                    parseAuditNsFilter(serverGlobalParams.auditNsFilterMap);
                     errmsg = "reload: invalid value " + value.toString();
                     return false;
                 }
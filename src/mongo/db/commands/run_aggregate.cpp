@@ -55,6 +55,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_admission.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/read_concern_args.h"
@@ -326,6 +327,14 @@ Status runAggregate(OperationContext* opCtx,
     boost::intrusive_ptr<ExpressionContext> expCtx;
     Pipeline* unownedPipeline;
     auto curOp = CurOp::get(opCtx);
+
+    /// OOM feature
+    // Wait for stage memory before acquiring locks, rather than failing part-way through.
+    Status admission = QueryAdmissionQueue::get().admit(opCtx);
+    if (!admission.isOK()) {
+        return admission;
+    }
+
     {
         const LiteParsedPipeline liteParsedPipeline(request);
 
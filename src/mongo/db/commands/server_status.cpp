@@ -34,6 +34,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_internal.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/log.h"
@@ -204,6 +205,24 @@ BSONObj OpCounterServerStatusSection::generateSection(OperationContext* opCtx,
 
 OpCounterServerStatusSection globalOpCounterServerStatusSection("opcounters", &globalOpCounters);
 
+AuditLogStatSection::AuditLogStatSection(const string& sectionName,
+                                         logger::AsyncAppenderStats* stats)
+    : ServerStatusSection(sectionName), _stats(stats) {}
+
+BSONObj AuditLogStatSection::generateSection(OperationContext* opCtx,
+                                             const BSONElement& configElement) const {
+    if (!serverGlobalParams.auditLogAsync) {
+        return BSONObj();
+    }
+    BSONObjBuilder b;
+    b.append("async", true);
+    b.append("overflowPolicy", serverGlobalParams.auditLogAsyncOverflowPolicy);
+    _stats->append(&b);
+    return b.obj();
+}
+
+AuditLogStatSection globalAuditLogStat("auditLog", logger::globalAuditAsyncAppenderStats());
+
 /// OOM feature
 StageMemStatSection::StageMemStatSection(const string& sectionName, StageMemCounter* counters)
     : ServerStatusSection(sectionName), _counters(counters) {}
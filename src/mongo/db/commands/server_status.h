@@ -33,6 +33,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/logger/async_appender_stats.h"
 #include "mongo/platform/atomic_word.h"
 #include <string>
 
@@ -122,6 +123,21 @@ private:
     const OpCounters* _counters;
 };
 
+class AuditLogStatSection : public ServerStatusSection {
+public:
+    AuditLogStatSection(const std::string& sectionName, logger::AsyncAppenderStats* stats);
+
+    virtual bool includeByDefault() const {
+        return true;
+    }
+
+    virtual BSONObj generateSection(OperationContext* opCtx,
+                                    const BSONElement& configElement) const;
+
+private:
+    const logger::AsyncAppenderStats* _stats;
+};
+
 /// OOM feature
 class StageMemStatSection : public ServerStatusSection {
 public:
@@ -82,10 +82,16 @@ public:
         BSONObjBuilder b;
         networkCounter.append(b);
         appendMessageCompressionStats(&b);
-        auto executor = opCtx->getServiceContext()->getServiceExecutor();
+        auto svcCtx = opCtx->getServiceContext();
+        auto executor = svcCtx->getServiceExecutor();
         if (executor)
             executor->appendStats(&b);
 
+        if (svcCtx->hasAdminServiceExecutor()) {
+            BSONObjBuilder adminBob(b.subobjStart("adminServiceExecutor"));
+            svcCtx->getAdminServiceExecutor()->appendStats(&adminBob);
+        }
+
         return b.obj();
     }
 
@@ -476,6 +476,17 @@ void CurOp::reportState(BSONObjBuilder* builder, bool truncateOps) {
     }
 
     builder->append("numYields", _numYields);
+
+    if (_admissionWaitStart || _admissionWaitTotal > Microseconds{0}) {
+        Microseconds waited = _admissionWaitTotal;
+        if (_admissionWaitStart) {
+            waited +=
+                Microseconds{static_cast<long long>(curTimeMicros64() - _admissionWaitStart)};
+        }
+        BSONObjBuilder sub(builder->subobjStart("admissionQueue"));
+        sub.append("waiting", _admissionWaitStart != 0);
+        sub.append("waitMicros", durationCount<Microseconds>(waited));
+    }
 }
 
 namespace {
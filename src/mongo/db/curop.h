@@ -554,6 +554,20 @@ public:
         _planSummary = std::move(summary);
     }
 
+    /// OOM feature
+    /**
+     * Marks the start and end of a wait in the query admission queue, so that currentOp can show
+     * queued operations. The Client must be locked.
+     */
+    void beginAdmissionWait_inlock() {
+        _admissionWaitStart = curTimeMicros64();
+    }
+    void endAdmissionWait_inlock() {
+        _admissionWaitTotal +=
+            Microseconds{static_cast<long long>(curTimeMicros64() - _admissionWaitStart)};
+        _admissionWaitStart = 0;
+    }
+
 private:
     class CurOpStack;
 
@@ -596,6 +610,10 @@ private:
     int _numYields{0};
 
     std::string _planSummary;
+
+    // The time at which the current admission wait started, or 0 if not waiting.
+    long long _admissionWaitStart{0};
+    Microseconds _admissionWaitTotal{0};
 };
 
 /**
@@ -645,6 +645,14 @@ ExitCode _initAndListen(int listenPort) {
         return EXIT_NET_ERROR;
     }
 
+    if (serviceContext->hasAdminServiceExecutor()) {
+        start = serviceContext->getAdminServiceExecutor()->start();
+        if (!start.isOK()) {
+            error() << "Failed to start the admin service executor: " << start;
+            return EXIT_NET_ERROR;
+        }
+    }
+
     if (!storageGlobalParams.repair) {
         start = serviceContext->getTransportLayer()->start();
         if (!start.isOK()) {
@@ -932,6 +940,14 @@ void shutdownTask() {
                                         << status.reason();
         }
     }
+    if (serviceContext->hasAdminServiceExecutor()) {
+        Status status = serviceContext->getAdminServiceExecutor()->shutdown(Seconds(5));
+        if (!status.isOK()) {
+            log(LogComponent::kNetwork)
+                << "Admin service executor failed to shutdown within timelimit: "
+                << status.reason();
+        }
+    }
 #endif
     stopFreeMonitoring();
 
@@ -970,6 +986,9 @@ void shutdownTask() {
     log(LogComponent::kControl) << "now exiting";
 
     audit::logShutdown(client);
+
+    // Drain the audit writer thread, if any, before the process exits.
+    logger::globalAuditLogDomain()->flush();
 }
 
 
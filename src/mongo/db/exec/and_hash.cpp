@@ -54,6 +54,7 @@ const size_t AndHashStage::kLookAheadWorks = 10;
 // static
 const char* AndHashStage::kStageType = "AND_HASH";
 const size_t AndHashStage::_dataMapItemSize = sizeof(RecordId) + sizeof(WorkingSetID);
+const size_t AndHashStage::_spilledMapItemSize = sizeof(RecordId) + sizeof(SpilledMember);
 
 AndHashStage::AndHashStage(OperationContext* opCtx, WorkingSet* ws, const Collection* collection)
     : PlanStage(kStageType, opCtx),
@@ -102,7 +103,7 @@ bool AndHashStage::isEOF() {
     // Or we're streaming in results from the last child.
 
     // If there's nothing to probe against, we're EOF.
-    if (_dataMap.empty()) {
+    if (hashedCount() == 0) {
         return true;
     }
 
@@ -117,7 +118,11 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
-    if (chkCachedMemOversize()) {
+    const auto memLimit = chkCachedMemLimit();
+    if (memLimit == StageMemCounter::LimitLevel::kGlobal && canSpillStageMemory()) {
+        // Each time the global limit is hit, move whatever has been hashed since the last spill.
+        spillDataMap();
+    } else if (memLimit != StageMemCounter::LimitLevel::kNone) {
         *out = chkMemFailureRet(_ws);
         return PlanStage::FAILURE;
     }
@@ -148,6 +153,7 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
                     // A child went right to EOF.  Bail out.
                     _hashingChildren = false;
                     _dataMap.clear();
+                    _spilledMap.clear();
                     return PlanStage::IS_EOF;
                 } else if (PlanStage::ADVANCED == childStatus) {
                     // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we
@@ -161,6 +167,7 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
                     *out = _lookAheadResults[i];
                     _hashingChildren = false;
                     _dataMap.clear();
+                    _spilledMap.clear();
                     return childStatus;
                 }
                 // We ignore NEED_TIME. TODO: what do we want to do if we get NEED_YIELD here?
@@ -203,7 +210,7 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
     // hash map.
 
     // We should be EOF if we're not hashing results and the dataMap is empty.
-    verify(!_dataMap.empty());
+    verify(hashedCount() != 0);
 
     // We probe _dataMap with the last child.
     verify(_currentChild == _children.size() - 1);
@@ -226,9 +233,22 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
 
     DataMap::iterator it = _dataMap.find(member->recordId);
     if (_dataMap.end() == it) {
-        // Child's output wasn't in every previous child.  Throw it out.
+        SpilledMap::iterator spilledIt = _spilledMap.find(member->recordId);
+        if (_spilledMap.end() == spilledIt) {
+            // Child's output wasn't in every previous child.  Throw it out.
+            _ws->free(*out);
+            return PlanStage::NEED_TIME;
+        }
+
+        WorkingSetID hashID = unspillMember(spilledIt->second);
+        decCachedMemory(_spilledMapItemSize);
+        _spilledMap.erase(spilledIt);
+
+        AndCommon::mergeFrom(_ws, hashID, *member);
         _ws->free(*out);
-        return PlanStage::NEED_TIME;
+
+        *out = hashID;
+        return PlanStage::ADVANCED;
     } else {
         // Child's output was in every previous child.  Merge any key data in
         // the child's output and free the child's just-outputted WSM.
@@ -270,7 +290,8 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
             return PlanStage::NEED_TIME;
         }
 
-        if (!_dataMap.insert(std::make_pair(member->recordId, id)).second) {
+        if (_spilledMap.count(member->recordId) ||
+            !_dataMap.insert(std::make_pair(member->recordId, id)).second) {
             // Didn't insert because we already had this RecordId inside the map. This should only
             // happen if we're seeing a newer copy of the same doc in a more recent snapshot.
             // Throw out the newer copy of the doc.
@@ -291,12 +312,12 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
         _currentChild = 1;
 
         // If our first child was empty, don't scan any others, no possible results.
-        if (_dataMap.empty()) {
+        if (hashedCount() == 0) {
             _hashingChildren = false;
             return PlanStage::IS_EOF;
         }
 
-        _specificStats.mapAfterChild.push_back(_dataMap.size());
+        _specificStats.mapAfterChild.push_back(hashedCount());
 
         return PlanStage::NEED_TIME;
     } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
@@ -333,7 +354,25 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         verify(member->hasRecordId());
         size_t cachedSize = 0;
         if (_dataMap.end() == _dataMap.find(member->recordId)) {
-            // Ignore.  It's not in any previous child.
+            SpilledMap::iterator spilledIt = _spilledMap.find(member->recordId);
+            if (_spilledMap.end() != spilledIt) {
+                // We have a hit on a spilled member. Read it back, merge, and write the merged
+                // member out again.
+                _seenMap.insert(member->recordId);
+                WorkingSetID olderMemberID = unspillMember(spilledIt->second);
+                WorkingSetMember* olderMember = _ws->get(olderMemberID);
+
+                AndCommon::mergeFrom(_ws, olderMemberID, *member);
+
+                const size_t memUsageAfter = olderMember->getMemUsage();
+                _memUsage += memUsageAfter - spilledIt->second.memUsage;
+                spilledIt->second.memUsage = memUsageAfter;
+                spilledIt->second.location = _spillFile->append(_spillCodec.encode(*olderMember));
+                _specificStats.spilledBytes = _spillFile->bytesWritten();
+                _ws->free(olderMemberID);
+                incCachedMemory(sizeof(RecordId));
+            }
+            // Otherwise ignore.  It's not in any previous child.
         } else {
             // We have a hit.  Copy data into the WSM we already have.
             _seenMap.insert(member->recordId);
@@ -374,8 +413,18 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
                 ++it;
             }
         }
+        SpilledMap::iterator spilledIt = _spilledMap.begin();
+        while (spilledIt != _spilledMap.end()) {
+            if (_seenMap.end() == _seenMap.find(spilledIt->first)) {
+                _memUsage -= spilledIt->second.memUsage;
+                releaseSize += _spilledMapItemSize;
+                spilledIt = _spilledMap.erase(spilledIt);
+            } else {
+                ++spilledIt;
+            }
+        }
 
-        _specificStats.mapAfterChild.push_back(_dataMap.size());
+        _specificStats.mapAfterChild.push_back(hashedCount());
         releaseSize += _seenMap.size() * sizeof(RecordId);
         decCachedMemory(releaseSize);
         _seenMap.clear();
@@ -383,7 +432,7 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         // _dataMap is now the intersection of the first _currentChild nodes.
 
         // If we have nothing to AND with after finishing any child, stop.
-        if (_dataMap.empty()) {
+        if (hashedCount() == 0) {
             _hashingChildren = false;
             return PlanStage::IS_EOF;
         }
@@ -463,7 +512,58 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
         _dataMap.erase(it);
         releaseSize += _dataMapItemSize;
         decCachedMemory(releaseSize);
+        return;
+    }
+
+    SpilledMap::iterator spilledIt = _spilledMap.find(dl);
+    if (_spilledMap.end() != spilledIt) {
+        WorkingSetID id = unspillMember(spilledIt->second);
+        WorkingSetMember* member = _ws->get(id);
+
+        if (_hashingChildren) {
+            ++_specificStats.flaggedInProgress;
+        } else {
+            ++_specificStats.flaggedButPassed;
+        }
+
+        _memUsage -= spilledIt->second.memUsage;
+        WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        _ws->flagForReview(id);
+
+        _spilledMap.erase(spilledIt);
+        decCachedMemory(_spilledMapItemSize);
+    }
+}
+
+void AndHashStage::spillDataMap() {
+    if (_dataMap.empty()) {
+        return;
+    }
+    if (!_spillFile) {
+        _spillFile = stdx::make_unique<StageSpillFile>(stageSpillTempDir());
+    }
+
+    const uint64_t bytesBefore = _spillFile->bytesWritten();
+    size_t releaseSize = 0;
+    for (const auto& entry : _dataMap) {
+        WorkingSetMember* member = _ws->get(entry.second);
+        const size_t memUsage = member->getMemUsage();
+        SpilledMember spilled{_spillFile->append(_spillCodec.encode(*member)), memUsage};
+        _spilledMap.insert(std::make_pair(entry.first, spilled));
+        _ws->free(entry.second);
+        releaseSize += _dataMapItemSize + memUsage;
     }
+    _specificStats.spilledMembers += _dataMap.size();
+    _specificStats.spilledBytes = _spillFile->bytesWritten();
+    globalStageMemCounters.noteSpill(STAGE_AND_HASH, _spillFile->bytesWritten() - bytesBefore);
+
+    incCachedMemory(_dataMap.size() * _spilledMapItemSize);
+    decCachedMemory(releaseSize);
+    _dataMap.clear();
+}
+
+WorkingSetID AndHashStage::unspillMember(const SpilledMember& spilled) {
+    return _spillCodec.decode(_spillFile->read(spilled.location), _ws);
 }
 
 unique_ptr<PlanStageStats> AndHashStage::getStats() {
@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
@@ -50,6 +51,10 @@ namespace mongo {
  * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
  * operates with RecordIds, we are unable to evaluate the AND for the invalidated RecordId, and it
  * must be fully matched later.
+ *
+ * If the global stage memory limit is reached and canSpillStageMemory(), the members held in the
+ * hash table are written to a spill file and only their RecordIds and file locations stay in
+ * memory. Probes that hit a spilled member read it back.
  */
 class AndHashStage final : public PlanStage {
 public:
@@ -97,6 +102,31 @@ private:
     StageState hashOtherChildren(WorkingSetID* out);
     StageState workChild(size_t childNo, WorkingSetID* out);
 
+    // Where a member moved out of _dataMap by spillDataMap() lives.
+    struct SpilledMember {
+        StageSpillFile::Location location;
+        size_t memUsage;  // The member's getMemUsage(), still counted in _memUsage.
+    };
+    typedef stdx::unordered_map<RecordId, SpilledMember, RecordId::Hasher> SpilledMap;
+
+    /**
+     * Moves every member in _dataMap to _spillFile.
+     */
+    void spillDataMap();
+
+    /**
+     * Reads a spilled member back into the working set and returns its id. The entry stays in
+     * _spilledMap.
+     */
+    WorkingSetID unspillMember(const SpilledMember& spilled);
+
+    /**
+     * Number of RecordIds in the hash table, in memory or spilled.
+     */
+    size_t hashedCount() const {
+        return _dataMap.size() + _spilledMap.size();
+    }
+
     // Not owned by us.
     const Collection* _collection;
 
@@ -114,6 +144,12 @@ private:
     DataMap _dataMap;
     static const size_t _dataMapItemSize;
 
+    // Members of the hash table that have been spilled. Disjoint from _dataMap.
+    SpilledMap _spilledMap;
+    static const size_t _spilledMapItemSize;
+    WorkingSetSpillCodec _spillCodec;
+    std::unique_ptr<StageSpillFile> _spillFile;
+
     // Keeps track of what elements from _dataMap subsequent children have seen.
     // Only used while _hashingChildren.
     typedef stdx::unordered_set<RecordId, RecordId::Hasher> SeenMap;
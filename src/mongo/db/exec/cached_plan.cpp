@@ -199,6 +199,7 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
     _children.clear();
 
     _specificStats.replanned = true;
+    _collection->infoCache()->getPlanCache()->recordReplan(*_canonicalQuery);
 
     // Use the query planning module to plan the whole query.
     auto statusWithSolutions = QueryPlanner::plan(*_canonicalQuery, _plannerParams);
@@ -296,6 +297,31 @@ PlanStage::StageState CachedPlanStage::doWork(WorkingSetID* out) {
     return child()->work(out);
 }
 
+PlanStage::StageState CachedPlanStage::doWorkBatch(size_t maxWorks,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateOut) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    // Results buffered during the trial period were made owned when they were buffered.
+    const size_t resultsBefore = out->size();
+    for (; !_results.empty() && maxWorks > 0; --maxWorks) {
+        out->push_back(_results.front());
+        _results.pop_front();
+    }
+
+    if (maxWorks == 0) {
+        return PlanStage::ADVANCED;
+    }
+
+    const StageState state = child()->workBatch(_ws, maxWorks, out, stateOut);
+    if (PlanStage::NEED_TIME == state && out->size() > resultsBefore) {
+        return PlanStage::ADVANCED;
+    }
+    return state;
+}
+
 void CachedPlanStage::doInvalidate(OperationContext* opCtx,
                                    const RecordId& dl,
                                    InvalidationType type) {
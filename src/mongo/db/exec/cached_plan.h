@@ -65,6 +65,10 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
 
     StageType stageType() const final {
@@ -87,6 +91,11 @@ public:
      */
     Status pickBestPlan(PlanYieldPolicy* yieldPolicy);
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
     /**
      * Passes stats from the trial period run of the cached plan to the plan cache.
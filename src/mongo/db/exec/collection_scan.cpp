@@ -38,6 +38,7 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
@@ -75,6 +76,10 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
         _endCondition = stdx::make_unique<GTEMatchExpression>(repl::OpTime::kTimestampFieldName,
                                                               _endConditionBSON.firstElement());
     }
+
+    if (_filter && internalQueryCompileMatchExpressions.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
 }
 
 PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
@@ -170,16 +175,7 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     }
 
     if (!record) {
-        // We just hit EOF. If we are tailable and have already returned data, leave us in a
-        // state to pick up where we left off on the next call to work(). Otherwise EOF is
-        // permanent.
-        if (_params.tailable && !_lastSeenId.isNull()) {
-            _cursor.reset();
-        } else {
-            _commonStats.isEOF = true;
-        }
-
-        return PlanStage::IS_EOF;
+        return hitEOF();
     }
 
     _lastSeenId = record->id;
@@ -200,6 +196,80 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(size_t maxWorks,
+                                                  std::vector<WorkingSetID>* out,
+                                                  WorkingSetID* stateOut) {
+    return doWorkUnits(maxWorks, out, stateOut, [this](WorkingSetID* id) {
+        return workForBatch(id);
+    });
+}
+
+PlanStage::StageState CollectionScan::workForBatch(WorkingSetID* out) {
+    if (!_cursor || _isDead || _commonStats.isEOF || _params.maxScan || _endCondition ||
+        _params.stopApplyingFilterAfterFirstMatch || _params.shouldTrackLatestOplogTimestamp ||
+        (_lastSeenId.isNull() && !_params.start.isNull())) {
+        const StageState state = doWork(out);
+        if (PlanStage::ADVANCED == state) {
+            _workingSet->get(*out)->makeObjOwnedIfNeeded();
+        }
+        return state;
+    }
+
+    boost::optional<Record> record;
+    try {
+        if (auto fetcher = _cursor->fetcherForNext()) {
+            WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+            member->setFetcher(fetcher.release());
+            *out = _wsidForFetch;
+            return PlanStage::NEED_YIELD;
+        }
+
+        record = _cursor->next();
+    } catch (const WriteConflictException&) {
+        *out = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (!record) {
+        return hitEOF();
+    }
+
+    _lastSeenId = record->id;
+    ++_specificStats.docsTested;
+
+    // The record's buffer belongs to the cursor and is reused by the next record, so only
+    // documents that pass the filter are copied.
+    if (_filter && !passesFilter(record->data.toBson())) {
+        return PlanStage::NEED_TIME;
+    }
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    member->recordId = record->id;
+    member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(),
+                   record->data.releaseToBson().getOwned()};
+    _workingSet->transitionToRecordIdAndObj(id);
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+bool CollectionScan::passesFilter(const BSONObj& obj) const {
+    return _compiledFilter ? _compiledFilter->matchesBSON(obj) : _filter->matchesBSON(obj);
+}
+
+PlanStage::StageState CollectionScan::hitEOF() {
+    // If we are tailable and have already returned data, leave us in a state to pick up where we
+    // left off on the next call to work(). Otherwise EOF is permanent.
+    if (_params.tailable && !_lastSeenId.isNull()) {
+        _cursor.reset();
+    } else {
+        _commonStats.isEOF = true;
+    }
+
+    return PlanStage::IS_EOF;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -218,9 +288,13 @@ PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID* out) {
     ++_specificStats.docsTested;
 
-    if (Filter::passes(member, _filter)) {
+    const bool passes = _compiledFilter && member->hasObj()
+        ? _compiledFilter->matchesBSON(member->obj.value())
+        : Filter::passes(member, _filter);
+    if (passes) {
         if (_params.stopApplyingFilterAfterFirstMatch) {
             _filter = nullptr;
+            _compiledFilter.reset();
         }
         *out = memberID;
         return PlanStage::ADVANCED;
@@ -32,6 +32,7 @@
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
 
@@ -58,6 +59,10 @@ public:
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
     void doSaveState() final;
     void doRestoreState() final;
@@ -78,7 +83,29 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
+    /**
+     * One unit of work for doWorkBatch(). Reads the next record straight off the cursor and
+     * only creates a WorkingSetMember, with an owned copy of the document, if it passes the
+     * filter. Anything other than the steady state of a plain scan goes through doWork().
+     */
+    StageState workForBatch(WorkingSetID* out);
+
+    /**
+     * Returns whether 'obj' passes '_filter', which must be set.
+     */
+    bool passesFilter(const BSONObj& obj) const;
+
+    /**
+     * Records that the cursor is exhausted and returns IS_EOF.
+     */
+    StageState hitEOF();
+
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
      * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -98,6 +125,9 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // '_filter' compiled for matching whole documents, if that speeds it up.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
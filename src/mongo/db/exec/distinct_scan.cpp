@@ -81,11 +81,12 @@ PlanStage::StageState DistinctScan::doWork(WorkingSetID* out) {
     try {
         if (!_cursor)
             _cursor = _iam->newCursor(getOpCtx(), _params.direction == 1);
-        kv = _cursor->seek(_seekPoint);
+        kv = _cursorOnLastValue ? stepToNextValue() : _cursor->seek(_seekPoint);
     } catch (const WriteConflictException&) {
         *out = WorkingSet::INVALID_ID;
         return PlanStage::NEED_YIELD;
     }
+    _cursorOnLastValue = false;
 
     if (!kv) {
         _commonStats.isEOF = true;
@@ -114,6 +115,7 @@ PlanStage::StageState DistinctScan::doWork(WorkingSetID* out) {
             _seekPoint.keyPrefix = kv->key;
             _seekPoint.prefixLen = _params.fieldNo + 1;
             _seekPoint.prefixExclusive = true;
+            _cursorOnLastValue = _params.maxStepsBeforeSeek > 0;
 
             // Package up the result for the caller.
             WorkingSetID id = _workingSet->allocate();
@@ -128,12 +130,38 @@ PlanStage::StageState DistinctScan::doWork(WorkingSetID* out) {
     MONGO_UNREACHABLE;
 }
 
+boost::optional<IndexKeyEntry> DistinctScan::stepToNextValue() {
+    for (int i = 0; i < _params.maxStepsBeforeSeek; ++i) {
+        boost::optional<IndexKeyEntry> kv = _cursor->next();
+        if (!kv || !hasSeekPrefix(kv->key)) {
+            return kv;
+        }
+        ++_specificStats.keysExamined;
+    }
+    return _cursor->seek(_seekPoint);
+}
+
+bool DistinctScan::hasSeekPrefix(const BSONObj& key) const {
+    BSONObjIterator keyIt(key);
+    BSONObjIterator prefixIt(_seekPoint.keyPrefix);
+    for (int i = 0; i < _seekPoint.prefixLen; ++i) {
+        if (!keyIt.more() || !prefixIt.more()) {
+            return false;
+        }
+        if (keyIt.next().woCompare(prefixIt.next(), false) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool DistinctScan::isEOF() {
     return _commonStats.isEOF;
 }
 
 void DistinctScan::doSaveState() {
-    // We always seek, so we don't care where the cursor is.
+    // We seek after a yield, so we don't care where the cursor is.
+    _cursorOnLastValue = false;
     if (_cursor)
         _cursor->saveUnpositioned();
 }
@@ -60,6 +60,11 @@ struct DistinctParams {
     // If we distinct over 'a' the position is 0.
     // If we distinct over 'b' the position is 1.
     int fieldNo;
+
+    // How many keys to step over with next() looking for the next value before seeking to it.
+    // Worth it when values have few keys each, as a step is much cheaper than a seek. 0 always
+    // seeks.
+    int maxStepsBeforeSeek = 0;
 };
 
 /**
@@ -93,6 +98,15 @@ public:
     static const char* kStageType;
 
 private:
+    /**
+     * Steps the cursor from the key of the last value returned towards the next value, seeking to
+     * it once _params.maxStepsBeforeSeek keys of the last value have been passed.
+     */
+    boost::optional<IndexKeyEntry> stepToNextValue();
+
+    // Does 'key' start with the prefix in _seekPoint, i.e. belong to the last value returned?
+    bool hasSeekPrefix(const BSONObj& key) const;
+
     // The WorkingSet we annotate with results.  Not owned by us.
     WorkingSet* _workingSet;
 
@@ -109,6 +123,9 @@ private:
     IndexBoundsChecker _checker;
     IndexSeekPoint _seekPoint;
 
+    // Is _cursor on the key of the last value returned, so that stepToNextValue() can be used?
+    bool _cursorOnLastValue = false;
+
     // Stats
     DistinctScanStats _specificStats;
 };
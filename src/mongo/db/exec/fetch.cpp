@@ -71,6 +71,11 @@ bool FetchStage::isEOF() {
         return false;
     }
 
+    if (_childBatchPos < _childBatch.size() || _childBatchEnd) {
+        // Our child has already handed us results or a state that we haven't passed on yet.
+        return false;
+    }
+
     return child()->isEOF();
 }
 
@@ -83,7 +88,7 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     WorkingSetID id;
     StageState status;
     if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
+        status = nextFromChild(&id);
     } else {
         status = ADVANCED;
         id = _idRetrying;
@@ -144,6 +149,52 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxWorks,
+                                              std::vector<WorkingSetID>* out,
+                                              WorkingSetID* stateOut) {
+    return doWorkUnits(maxWorks, out, stateOut, [this, maxWorks](WorkingSetID* id) {
+        if (WorkingSet::INVALID_ID == _idRetrying && _childBatchPos == _childBatch.size() &&
+            !_childBatchEnd) {
+            _childBatch.clear();
+            _childBatchPos = 0;
+
+            WorkingSetID endId = WorkingSet::INVALID_ID;
+            const StageState childState =
+                child()->workBatch(_ws, maxWorks, &_childBatch, &endId);
+            if (PlanStage::ADVANCED != childState && PlanStage::NEED_TIME != childState) {
+                _childBatchEnd = childState;
+                _childBatchEndId = endId;
+            } else if (_childBatch.empty()) {
+                return PlanStage::NEED_TIME;
+            }
+        }
+
+        // Fetched documents point into _cursor, which the next fetch moves.
+        const StageState state = doWork(id);
+        if (PlanStage::ADVANCED == state) {
+            _ws->get(*id)->makeObjOwnedIfNeeded();
+        }
+        return state;
+    });
+}
+
+PlanStage::StageState FetchStage::nextFromChild(WorkingSetID* out) {
+    if (_childBatchPos < _childBatch.size()) {
+        *out = _childBatch[_childBatchPos++];
+        return PlanStage::ADVANCED;
+    }
+
+    if (_childBatchEnd) {
+        const StageState state = *_childBatchEnd;
+        *out = _childBatchEndId;
+        _childBatchEnd = boost::none;
+        _childBatchEndId = WorkingSet::INVALID_ID;
+        return state;
+    }
+
+    return child()->work(out);
+}
+
 void FetchStage::doSaveState() {
     if (_cursor)
         _cursor->saveUnpositioned();
@@ -174,6 +225,14 @@ void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inval
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
         }
     }
+
+    // The same goes for results of our child's last batch that we haven't fetched yet.
+    for (size_t i = _childBatchPos; i < _childBatch.size(); ++i) {
+        WorkingSetMember* member = _ws->get(_childBatch[i]);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
 }
 
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
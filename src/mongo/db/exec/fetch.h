@@ -60,6 +60,10 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     void doSaveState() final;
     void doRestoreState() final;
     void doDetachFromOperationContext() final;
@@ -76,7 +80,18 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
+    /**
+     * Returns the next result of the child's last batch, then the state that ended that batch,
+     * and once both are used up works the child directly.
+     */
+    StageState nextFromChild(WorkingSetID* out);
+
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
      * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -98,6 +113,14 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results of the child's last batch that have not been fetched yet, see doWorkBatch().
+    std::vector<WorkingSetID> _childBatch;
+    size_t _childBatchPos = 0;
+
+    // The state that ended the child's last batch, returned once _childBatch is used up.
+    boost::optional<StageState> _childBatchEnd;
+    WorkingSetID _childBatchEndId = WorkingSet::INVALID_ID;
+
     // Stats
     FetchStats _specificStats;
 };
@@ -247,6 +247,13 @@ PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IndexScan::doWorkBatch(size_t maxWorks,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* stateOut) {
+    // doWork() already copies each key it returns out of the cursor.
+    return doWorkUnits(maxWorks, out, stateOut, [this](WorkingSetID* id) { return doWork(id); });
+}
+
 bool IndexScan::isEOF() {
     return _commonStats.isEOF;
 }
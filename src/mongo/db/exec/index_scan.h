@@ -99,6 +99,10 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
+
+    bool supportsBatchedWork() const final {
+        return true;
+    }
     void doSaveState() final;
     void doRestoreState() final;
     void doDetachFromOperationContext() final;
@@ -115,6 +119,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
     /**
      * Initialize the underlying index Cursor, returning first result if any.
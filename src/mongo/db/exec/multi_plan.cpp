@@ -39,16 +39,27 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/stage_builder.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/storage/record_fetcher.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -61,6 +72,187 @@ using stdx::make_unique;
 // static
 const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
+namespace {
+
+// How long a trial thread waits for its intent locks before the parallel trial is abandoned. The
+// planning thread already holds the same locks, so this only expires behind a queued exclusive
+// request, such as a collection drop.
+const Milliseconds kTrialLockTimeout(100);
+
+// How often the planning thread checks for interruption while the trial threads run.
+const Milliseconds kTrialInterruptCheckPeriod(10);
+
+/**
+ * The pool that runs parallel trial periods, shared by all queries. Created on first use, sized by
+ * 'internalQueryPlanEvaluationMaxThreads', and never destroyed.
+ */
+ThreadPool* getTrialThreadPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "MultiPlanTrialPool";
+        options.threadNamePrefix = "MultiPlanTrial-";
+        options.minThreads = 0;
+        options.maxThreads = static_cast<size_t>(internalQueryPlanEvaluationMaxThreads.load());
+        auto newPool = new ThreadPool(options);
+        newPool->startup();
+        return newPool;
+    }();
+    return pool;
+}
+
+/**
+ * What a trial thread leaves behind for one candidate: its private plan tree and WorkingSet,
+ * the results it buffered and whether it failed.
+ */
+struct TrialOutcome {
+    // Declared before 'root' so that the tree is destroyed first.
+    std::unique_ptr<WorkingSet> ws;
+    std::unique_ptr<PlanStage> root;
+
+    std::vector<WorkingSetID> results;
+    bool failed = false;
+    WorkingSetID statusMemberId = WorkingSet::INVALID_ID;
+    long long wallTimeMicros = 0;
+};
+
+/**
+ * State shared between the planning thread and the trial threads of one parallel trial period.
+ */
+struct ParallelTrial {
+    explicit ParallelTrial(size_t numCandidates) : outcomes(numCandidates) {}
+
+    // Indexed like the candidates. Each trial thread only touches its own entry.
+    std::vector<TrialOutcome> outcomes;
+
+    // Set once any candidate has finished, or the trial period is being abandoned.
+    AtomicBool done{false};
+
+    // The first candidate to hit EOF or return enough results.
+    AtomicInt32 firstFinished{-1};
+
+    stdx::mutex mutex;
+    stdx::condition_variable finishedCV;
+
+    // Guarded by 'mutex'.
+    size_t running = 0;
+    bool abandoned = false;
+};
+
+/**
+ * Works the trial tree of candidate 'ix' on 'opCtx', buffering its results, until it finishes,
+ * fails, runs out of works, or another candidate finishes. Returns false if the trial could not
+ * start because the locks were not granted in time.
+ */
+bool workTrial(OperationContext* opCtx,
+               const NamespaceString& nss,
+               size_t numWorks,
+               size_t numResults,
+               ParallelTrial* trial,
+               size_t ix) {
+    const Date_t deadline = Date_t::now() + kTrialLockTimeout;
+    Lock::DBLock dbLock(opCtx, nss.db(), MODE_IS, deadline);
+    if (!dbLock.isLocked()) {
+        return false;
+    }
+    Lock::CollectionLock collLock(opCtx->lockState(), nss.ns(), MODE_IS, deadline);
+    if (!collLock.isLocked()) {
+        return false;
+    }
+
+    TrialOutcome& outcome = trial->outcomes[ix];
+    PlanStage* root = outcome.root.get();
+    WorkingSet* ws = outcome.ws.get();
+
+    root->reattachToOperationContext(opCtx);
+    ON_BLOCK_EXIT([&] {
+        // Give up our cursors while this operation still holds its locks and its snapshot.
+        WorkingSetCommon::prepareForSnapshotChange(ws);
+        root->saveState();
+        root->detachFromOperationContext();
+    });
+
+    const auto finish = [&] {
+        trial->firstFinished.compareAndSwap(-1, static_cast<int>(ix));
+        trial->done.store(true);
+    };
+
+    // Every candidate gets at least one work so that it can be scored.
+    for (size_t works = 0; works < numWorks && (works == 0 || !trial->done.load()); ++works) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = root->work(&id);
+
+        if (PlanStage::ADVANCED == state) {
+            ws->get(id)->makeObjOwnedIfNeeded();
+            outcome.results.push_back(id);
+            if (outcome.results.size() >= numResults) {
+                finish();
+                break;
+            }
+        } else if (PlanStage::IS_EOF == state) {
+            finish();
+            break;
+        } else if (PlanStage::NEED_YIELD == state) {
+            if (id != WorkingSet::INVALID_ID) {
+                // Only storage engines without document-level locking hand out fetchers.
+                std::unique_ptr<RecordFetcher> fetcher(ws->get(id)->releaseFetcher());
+            }
+            // Nothing else is waiting on our intent locks; a fresh snapshot is all we need.
+            WorkingSetCommon::prepareForSnapshotChange(ws);
+            root->saveState();
+            opCtx->recoveryUnit()->abandonSnapshot();
+            root->restoreState();
+        } else if (PlanStage::NEED_TIME != state) {
+            outcome.failed = true;
+            if (PlanStage::FAILURE == state) {
+                outcome.statusMemberId = id;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Body of the trial thread for candidate 'ix'. Runs under its own Client and OperationContext,
+ * and so its own storage snapshot. Stage memory is charged to 'memCounter', the counter of the
+ * planning operation, so the trials count against that operation's and its database's limits.
+ */
+void runTrial(ServiceContext* service,
+              const NamespaceString& nss,
+              std::shared_ptr<OperationStageMemCounter> memCounter,
+              size_t numWorks,
+              size_t numResults,
+              ParallelTrial* trial,
+              size_t ix) {
+    bool started = false;
+    {
+        auto client = service->makeClient(str::stream() << "MultiPlanTrial-" << ix);
+        AlternativeClientRegion acr(client);
+        auto opCtx = cc().makeOperationContext();
+        PlanStage::setOperationMemCounter(opCtx.get(), std::move(memCounter));
+
+        Timer timer;
+        try {
+            started = workTrial(opCtx.get(), nss, numWorks, numResults, trial, ix);
+        } catch (const DBException& ex) {
+            LOG(1) << "Parallel plan trial of candidate " << ix << " failed: " << redact(ex);
+            started = false;
+        }
+        trial->outcomes[ix].wallTimeMicros = timer.micros();
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(trial->mutex);
+    if (!started) {
+        trial->abandoned = true;
+        trial->done.store(true);
+    }
+    --trial->running;
+    // Notify under the mutex: the planning thread destroys 'trial' as soon as it sees zero.
+    trial->finishedCV.notify_all();
+}
+
+}  // namespace
+
 MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
                                const Collection* collection,
                                CanonicalQuery* cq,
@@ -73,7 +265,8 @@ MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
       _backupPlanIdx(kNoSuchPlan),
       _failure(false),
       _failureCount(0),
-      _statusMemberId(WorkingSet::INVALID_ID) {
+      _statusMemberId(WorkingSet::INVALID_ID),
+      _firstFinishedIdx(kNoSuchPlan) {
     invariant(_collection);
 }
 
@@ -117,7 +310,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
 
     // best plan had no (or has no more) cached results
 
-    StageState state = bestPlan.root->work(out);
+    StageState state = workCandidate(_bestPlanIdx, out);
 
     if (PlanStage::FAILURE == state && hasBackupPlan()) {
         LOG(5) << "Best plan errored out switching to backup";
@@ -134,7 +327,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
         _bestPlanIdx = _backupPlanIdx;
         _backupPlanIdx = kNoSuchPlan;
 
-        return _candidates[_bestPlanIdx].root->work(out);
+        return workCandidate(_bestPlanIdx, out);
     }
 
     if (hasBackupPlan() && PlanStage::ADVANCED == state) {
@@ -145,6 +338,70 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+PlanStage::StageState MultiPlanStage::workCandidate(size_t ix, WorkingSetID* out) {
+    StageState state = _candidates[ix].root->work(out);
+    if (_trialWorkingSets.empty()) {
+        return state;
+    }
+
+    const bool hasMember = PlanStage::ADVANCED == state || PlanStage::NEED_YIELD == state ||
+        PlanStage::FAILURE == state;
+    if (hasMember && WorkingSet::INVALID_ID != *out) {
+        *out = _candidates[ix].ws->moveFrom(_trialWorkingSets[ix].get(), *out);
+    }
+    return state;
+}
+
+void MultiPlanStage::doSaveState() {
+    // Our caller only prepares the WorkingSet it knows about.
+    for (auto&& ws : _trialWorkingSets) {
+        WorkingSetCommon::prepareForSnapshotChange(ws.get());
+    }
+}
+
+bool MultiPlanStage::supportsBatchedWork() const {
+    return !_failure && bestPlanChosen() && !hasBackupPlan();
+}
+
+PlanStage::StageState MultiPlanStage::doWorkBatch(size_t maxWorks,
+                                                  std::vector<WorkingSetID>* out,
+                                                  WorkingSetID* stateOut) {
+    CandidatePlan& bestPlan = _candidates[_bestPlanIdx];
+
+    // Results produced during the trial period were made owned when they were buffered.
+    const size_t resultsBefore = out->size();
+    for (; !bestPlan.results.empty() && maxWorks > 0; --maxWorks) {
+        out->push_back(bestPlan.results.front());
+        bestPlan.results.pop_front();
+    }
+
+    if (maxWorks == 0) {
+        return PlanStage::ADVANCED;
+    }
+
+    if (!_trialWorkingSets.empty()) {
+        WorkingSet* trialWs = _trialWorkingSets[_bestPlanIdx].get();
+        const size_t batchStart = out->size();
+        const StageState state = bestPlan.root->workBatch(trialWs, maxWorks, out, stateOut);
+        for (size_t i = batchStart; i < out->size(); ++i) {
+            (*out)[i] = bestPlan.ws->moveFrom(trialWs, (*out)[i]);
+        }
+        if (WorkingSet::INVALID_ID != *stateOut) {
+            *stateOut = bestPlan.ws->moveFrom(trialWs, *stateOut);
+        }
+        if (PlanStage::NEED_TIME == state && out->size() > resultsBefore) {
+            return PlanStage::ADVANCED;
+        }
+        return state;
+    }
+
+    const StageState state = bestPlan.root->workBatch(bestPlan.ws, maxWorks, out, stateOut);
+    if (PlanStage::NEED_TIME == state && out->size() > resultsBefore) {
+        return PlanStage::ADVANCED;
+    }
+    return state;
+}
+
 Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
     // These are the conditions which can cause us to yield:
     //   1) The yield policy's timer elapsed, or
@@ -212,10 +469,12 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
-    for (size_t ix = 0; ix < numWorks; ++ix) {
-        bool moreToDo = workAllPlans(numResults, yieldPolicy);
-        if (!moreToDo) {
-            break;
+    if (!(canTrialInParallel() && runTrialsInParallel(numWorks, numResults))) {
+        for (size_t ix = 0; ix < numWorks; ++ix) {
+            bool moreToDo = workAllPlans(numResults, yieldPolicy);
+            if (!moreToDo) {
+                break;
+            }
         }
     }
 
@@ -231,6 +490,27 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     _bestPlanIdx = PlanRanker::pickBestPlan(_candidates, ranking.get());
     verify(_bestPlanIdx >= 0 && _bestPlanIdx < static_cast<int>(_candidates.size()));
 
+    // In a parallel trial the candidates did different amounts of work in the same wall time, so
+    // the first one to finish wins outright. It moves to the front of the ranking, which leaves
+    // the remaining plans in score order.
+    if (kNoSuchPlan != _firstFinishedIdx && _firstFinishedIdx != _bestPlanIdx &&
+        !_candidates[_firstFinishedIdx].failed) {
+        auto& order = ranking->candidateOrder;
+        const size_t pos =
+            std::find(order.begin(), order.end(), static_cast<size_t>(_firstFinishedIdx)) -
+            order.begin();
+        invariant(pos < order.size());
+        std::rotate(order.begin(), order.begin() + pos, order.begin() + pos + 1);
+        std::rotate(ranking->scores.begin(),
+                    ranking->scores.begin() + pos,
+                    ranking->scores.begin() + pos + 1);
+        std::rotate(ranking->stats.begin(),
+                    ranking->stats.begin() + pos,
+                    ranking->stats.begin() + pos + 1);
+        ranking->tieForBest = false;
+        _bestPlanIdx = _firstFinishedIdx;
+    }
+
     // Copy candidate order. We will need this to sort candidate stats for explain
     // after transferring ownership of 'ranking' to plan cache.
     std::vector<size_t> candidateOrder = ranking->candidateOrder;
@@ -337,6 +617,126 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     return Status::OK();
 }
 
+bool MultiPlanStage::canTrialInParallel() const {
+    if (!internalQueryPlanEvaluationParallel.load() || _candidates.size() < 2 ||
+        !supportsDocLocking()) {
+        return false;
+    }
+
+    auto opCtx = getOpCtx();
+    if (opCtx->lockState()->inAWriteUnitOfWork()) {
+        return false;
+    }
+    const auto readSource = opCtx->recoveryUnit()->getTimestampReadSource();
+    return RecoveryUnit::ReadSource::kUnset == readSource ||
+        RecoveryUnit::ReadSource::kNoTimestamp == readSource;
+}
+
+bool MultiPlanStage::runTrialsInParallel(size_t numWorks, size_t numResults) {
+    const size_t numCandidates = _candidates.size();
+    ParallelTrial trial(numCandidates);
+
+    // The trial trees are built here, with our OperationContext, and handed over detached.
+    for (size_t ix = 0; ix < numCandidates; ++ix) {
+        TrialOutcome& outcome = trial.outcomes[ix];
+        outcome.ws = stdx::make_unique<WorkingSet>();
+        PlanStage* root;
+        if (!StageBuilder::build(getOpCtx(),
+                                 const_cast<Collection*>(_collection),
+                                 *_query,
+                                 *_candidates[ix].solution,
+                                 outcome.ws.get(),
+                                 &root)) {
+            return false;
+        }
+        outcome.root.reset(root);
+        outcome.root->detachFromOperationContext();
+    }
+
+    auto service = getOpCtx()->getServiceContext();
+    const NamespaceString nss = _collection->ns();
+    auto memCounter = PlanStage::getOperationMemCounter(getOpCtx());
+    auto pool = getTrialThreadPool();
+    for (size_t ix = 0; ix < numCandidates; ++ix) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(trial.mutex);
+            ++trial.running;
+        }
+        Status scheduled =
+            pool->schedule([service, nss, memCounter, numWorks, numResults, &trial, ix] {
+                runTrial(service, nss, memCounter, numWorks, numResults, &trial, ix);
+            });
+        if (!scheduled.isOK()) {
+            stdx::lock_guard<stdx::mutex> lk(trial.mutex);
+            --trial.running;
+            trial.abandoned = true;
+            trial.done.store(true);
+            break;
+        }
+    }
+
+    // Wait for every trial thread, stopping them early if we are killed or time out.
+    Status interruptStatus = Status::OK();
+    {
+        stdx::unique_lock<stdx::mutex> lk(trial.mutex);
+        while (!trial.finishedCV.wait_for(lk,
+                                          kTrialInterruptCheckPeriod.toSystemDuration(),
+                                          [&] { return trial.running == 0; })) {
+            if (interruptStatus.isOK()) {
+                interruptStatus = getOpCtx()->checkForInterruptNoAssert();
+                if (!interruptStatus.isOK()) {
+                    trial.done.store(true);
+                }
+            }
+        }
+    }
+
+    if (!interruptStatus.isOK()) {
+        _failure = true;
+        _statusMemberId =
+            WorkingSetCommon::allocateStatusMember(_candidates[0].ws, interruptStatus);
+        return true;
+    }
+
+    if (trial.abandoned) {
+        LOG(1) << "Parallel plan trial abandoned, working the candidates in turn. query: "
+               << redact(_query->toStringShort());
+        return false;
+    }
+
+    // Install the trial trees, which pick up where they left off, in place of the candidates.
+    _trialWorkingSets.resize(numCandidates);
+    for (size_t ix = 0; ix < numCandidates; ++ix) {
+        TrialOutcome& outcome = trial.outcomes[ix];
+        CandidatePlan& candidate = _candidates[ix];
+
+        outcome.root->reattachToOperationContext(getOpCtx());
+        outcome.root->restoreState();
+        candidate.root = outcome.root.get();
+        _children[ix] = std::move(outcome.root);
+
+        for (auto id : outcome.results) {
+            candidate.results.push_back(candidate.ws->moveFrom(outcome.ws.get(), id));
+        }
+        if (outcome.failed) {
+            candidate.failed = true;
+            ++_failureCount;
+            if (WorkingSet::INVALID_ID != outcome.statusMemberId) {
+                _statusMemberId = candidate.ws->moveFrom(outcome.ws.get(), outcome.statusMemberId);
+            }
+        }
+
+        _trialWorkingSets[ix] = std::move(outcome.ws);
+        _specificStats.trialWallTimeMicros.push_back(outcome.wallTimeMicros);
+    }
+
+    _firstFinishedIdx = trial.firstFinished.load();
+    if (_failureCount == numCandidates) {
+        _failure = true;
+    }
+    return true;
+}
+
 bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy) {
     bool doneWorking = false;
 
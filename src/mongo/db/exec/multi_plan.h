@@ -84,6 +84,14 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
 
+    void doSaveState() final;
+
+    /**
+     * Once a plan has been chosen, batches come from it, unless it has a backup plan that may
+     * still have to take over.
+     */
+    bool supportsBatchedWork() const final;
+
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
 
     StageType stageType() const final {
@@ -108,6 +116,10 @@ public:
      * works of the candidate plans. By default, 'yieldPolicy' is NULL and no yielding will
      * take place.
      *
+     * If 'internalQueryPlanEvaluationParallel' is set, the trial periods may instead run
+     * concurrently on the trial thread pool, in which case no yielding takes place until a plan
+     * has been picked. See runTrialsInParallel().
+     *
      * Returns a non-OK status if query planning fails. In particular, this function returns
      * ErrorCodes::QueryPlanKilled if the query plan was killed during a yield.
      */
@@ -153,6 +165,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
     //
     // Have all our candidate plans do something.
@@ -176,6 +193,32 @@ private:
      */
     Status tryYield(PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Returns true if the trial periods may run in parallel: the knob is set, there is more than
+     * one candidate, the storage engine supports document-level locking, and this operation reads
+     * the latest data without a timestamp and outside of a write unit of work, so that snapshots
+     * opened by other threads see what ours would.
+     */
+    bool canTrialInParallel() const;
+
+    /**
+     * Builds a private copy of each candidate plan over its own WorkingSet and works the copies
+     * concurrently on the trial thread pool, each from its own Client, OperationContext and
+     * storage snapshot, for up to 'numWorks' works. The first copy to hit EOF or to return
+     * 'numResults' results ends the trial period for all of them. The copies then replace the
+     * candidates, with their buffered results moved into the candidates' WorkingSets.
+     *
+     * Returns false, leaving the candidates untouched, if a copy could not be built or a trial
+     * thread could not take its locks promptly. The caller must then work the candidates in turn.
+     */
+    bool runTrialsInParallel(size_t numWorks, size_t numResults);
+
+    /**
+     * Works the root of candidate 'ix' once. If the candidate runs over a private trial
+     * WorkingSet, any member returned through 'out' is first moved into the candidate's WorkingSet.
+     */
+    StageState workCandidate(size_t ix, WorkingSetID* out);
+
     static const int kNoSuchPlan = -1;
 
     // Not owned here. Must be non-null.
@@ -228,6 +271,14 @@ private:
     // just pass a NULL fetcher.
     std::unique_ptr<RecordFetcher> _fetcher;
 
+    // Set only if the trial periods ran in parallel: the WorkingSet that the root of each
+    // candidate works over, by candidate index. Members leave them for the candidate's own
+    // WorkingSet as they are returned.
+    std::vector<std::unique_ptr<WorkingSet>> _trialWorkingSets;
+
+    // The candidate that ended a parallel trial period, which wins it. kNoSuchPlan otherwise.
+    int _firstFinishedIdx;
+
     // Stats
     MultiPlanStats _specificStats;
 };
@@ -0,0 +1,768 @@
+/**
+ *    Copyright (C) 2013-2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <vector>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/fail_point_service.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+namespace {
+
+// How many records the random cursor samples per range to place the range boundaries.
+const size_t kSamplesPerRange = 32;
+
+// How many records a scanning thread reads before it releases its locks and its snapshot.
+const size_t kRecordsPerSlice = 1000;
+
+// How many buffered results work() takes at a time.
+const size_t kResultsPerTake = 64;
+
+// How long a scanning thread waits for its locks before checking whether it should stop.
+const Milliseconds kLockRetryPeriod(100);
+
+// How long work() waits for a result before returning NEED_TIME.
+const Milliseconds kResultWaitPeriod(1);
+
+// Makes a scanning thread that has just claimed the start of its range hit a write conflict.
+MONGO_FAIL_POINT_DEFINE(parallelCollectionScanWriteConflictAfterClaim);
+
+/**
+ * The pool that scans collection ranges, shared by all queries. Created on first use, sized by
+ * 'internalQueryParallelCollectionScanThreads' or 'internalDocumentSourceGroupParallelism',
+ * whichever is larger, and never destroyed.
+ */
+ThreadPool* getScanThreadPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "ParallelCollectionScanPool";
+        options.threadNamePrefix = "ParallelCollectionScan-";
+        options.minThreads = 0;
+        options.maxThreads = static_cast<size_t>(
+            std::max({internalQueryParallelCollectionScanThreads.load(),
+                      internalDocumentSourceGroupParallelism.load(),
+                      2}));
+        auto newPool = new ThreadPool(options);
+        newPool->startup();
+        return newPool;
+    }();
+    return pool;
+}
+
+/**
+ * Who scans the records from the start of a range: the range's own thread, once it has found
+ * the first record, or the thread of an earlier range, if that reached the boundary first or the
+ * first record was gone by the time the range's own thread looked for it.
+ */
+enum BoundaryOwner : int { kUnclaimed, kOwnThread, kEarlierThread };
+
+/**
+ * Returns false if evaluating 'expr' may change state shared by the threads evaluating it.
+ */
+bool canEvaluateConcurrently(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        if (!canEvaluateConcurrently(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+struct ParallelCollectionScan::SharedState {
+    struct Result {
+        RecordId id;
+        BSONObj obj;  // Owned.
+    };
+
+    struct Range {
+        // Existed when the boundaries were picked. Null for the first range.
+        RecordId start;
+
+        // A BoundaryOwner.
+        AtomicInt32 startOwner{kUnclaimed};
+
+        // Only used by the task scanning the range. A range may be scanned by a series of tasks,
+        // each of which leaves the cursor saved and detached for the next.
+        std::unique_ptr<ParallelScanRangeReducer> reducer;  // Null unless the range is reduced.
+        std::unique_ptr<SeekableRecordCursor> cursor;
+        // Whether 'cursor' has been positioned at the start. Set as soon as the range claims its
+        // start, so a task that fails afterwards does not seek it again.
+        bool positioned = false;
+        size_t nextBoundary = 0;  // The next later range whose start we have not passed yet.
+        bool done = false;
+
+        // Guarded by 'mutex'.
+        std::deque<Result> results;
+        size_t bufferedBytes = 0;
+        size_t reducerBytes = 0;  // As of the end of the last slice.
+        size_t docsTested = 0;
+        size_t reducedResults = 0;
+        bool scheduled = false;  // Whether a task for the range is queued or running.
+        bool finished = false;
+    };
+
+    SharedState(ServiceContext* service,
+                const NamespaceString& nss,
+                CollectionUUID uuid,
+                const MatchExpression* filter,
+                size_t numRanges)
+        : service(service),
+          nss(nss),
+          uuid(uuid),
+          filter(filter),
+          maxBufferedBytesPerRange(
+              static_cast<size_t>(internalQueryParallelCollectionScanMaxBufferedBytes.load())),
+          maxRunning(
+              static_cast<size_t>(internalQueryParallelCollectionScanMaxThreadsPerQuery.load())),
+          ranges(numRanges) {
+        for (size_t ix = 0; ix < numRanges; ++ix) {
+            ranges[ix].nextBoundary = ix + 1;
+        }
+        if (filter && internalQueryCompileMatchExpressions.load()) {
+            compiledFilter = CompiledMatchExpression::compile(filter);
+        }
+    }
+
+    bool matches(const BSONObj& obj) const {
+        if (compiledFilter) {
+            return compiledFilter->matchesBSON(obj);
+        }
+        return !filter || filter->matchesBSON(obj);
+    }
+
+    bool hasSpace(const Range& range) const {
+        return range.bufferedBytes < maxBufferedBytesPerRange;
+    }
+
+    ServiceContext* const service;
+    const NamespaceString nss;
+    const CollectionUUID uuid;
+    const MatchExpression* const filter;
+    std::unique_ptr<CompiledMatchExpression> compiledFilter;
+
+    // Read from the knobs once per scan.
+    const size_t maxBufferedBytesPerRange;
+    const size_t maxRunning;
+
+    std::vector<Range> ranges;
+
+    // Set when the stage goes away or a scanning task fails.
+    AtomicBool stopping{false};
+
+    stdx::mutex mutex;
+
+    // Signalled by the scanning tasks when they buffer results or end.
+    stdx::condition_variable resultsAvailable;
+
+    // Guarded by 'mutex'.
+    size_t running = 0;  // Tasks queued on or running in the pool.
+    size_t bufferedBytes = 0;  // Over all the ranges.
+    size_t reducerBytes = 0;   // Over all the ranges.
+    std::set<size_t> runnable;  // Ranges with buffer space waiting for one of our threads.
+    Status status = Status::OK();
+
+    // Results taken out of the ranges and not yet returned. Only used by the stage's thread.
+    std::deque<Result> taken;
+    size_t takenBytes = 0;
+};
+
+namespace {
+
+using SharedState = ParallelCollectionScan::SharedState;
+
+void scanRange(SharedState* shared, size_t ix);
+
+/**
+ * Makes the scan fail with 'status' and stops it.
+ */
+void failScan(WithLock, SharedState* shared, Status status) {
+    if (shared->status.isOK()) {
+        shared->status = std::move(status);
+    }
+    shared->stopping.store(true);
+    shared->runnable.clear();
+}
+
+/**
+ * Queues a task on the pool to scan range 'ix', unless one is queued or running already, or the
+ * query uses all the threads it may, in which case the range waits in 'runnable'.
+ */
+void scheduleRange(WithLock lk, SharedState* shared, size_t ix) {
+    auto& range = shared->ranges[ix];
+    shared->runnable.erase(ix);
+    if (range.scheduled || range.finished || shared->stopping.load()) {
+        return;
+    }
+    if (shared->running >= shared->maxRunning) {
+        shared->runnable.insert(ix);
+        return;
+    }
+
+    range.scheduled = true;
+    ++shared->running;
+    Status status = getScanThreadPool()->schedule([shared, ix] { scanRange(shared, ix); });
+    if (!status.isOK()) {
+        range.scheduled = false;
+        range.finished = true;
+        --shared->running;
+        failScan(lk, shared, std::move(status));
+    }
+}
+
+/**
+ * Scans one range on a pool thread, a slice of records at a time, until the range is done, its
+ * buffer is full or the scan is stopping. Each slice takes the collection lock and a new
+ * snapshot, and releases both before the next. A range whose buffer fills does not wait for
+ * space: its task ends, and the stage schedules the range again once it takes some results.
+ */
+class RangeScanner {
+public:
+    RangeScanner(OperationContext* opCtx, SharedState* shared, size_t ix)
+        : _opCtx(opCtx), _shared(shared), _range(shared->ranges[ix]) {}
+
+    void run() {
+        while (!_range.done) {
+            const size_t budget = bufferSpace();
+            if (0 == budget) {
+                return;
+            }
+            scanSlice(budget);
+            _opCtx->recoveryUnit()->abandonSnapshot();
+        }
+    }
+
+private:
+    /**
+     * Returns how many bytes of results the range may buffer, or zero if the scan is stopping.
+     */
+    size_t bufferSpace() {
+        stdx::lock_guard<stdx::mutex> lk(_shared->mutex);
+        if (_shared->stopping.load() || !_shared->hasSpace(_range)) {
+            return 0;
+        }
+        return _shared->maxBufferedBytesPerRange - _range.bufferedBytes;
+    }
+
+    /**
+     * Returns true once 'id' is past the start of a later range that is being scanned by its own
+     * tasks. Claims the boundaries it passes on the way.
+     */
+    bool reachedOwnedBoundary(const RecordId& id) {
+        auto& ranges = _shared->ranges;
+        size_t& next = _range.nextBoundary;
+        while (next < ranges.size() && id >= ranges[next].start) {
+            const int owner = ranges[next].startOwner.compareAndSwap(kUnclaimed, kEarlierThread);
+            if (kOwnThread == owner) {
+                return true;
+            }
+            ++next;
+        }
+        return false;
+    }
+
+    void scanSlice(size_t budget) {
+        boost::optional<Lock::DBLock> dbLock;
+        boost::optional<Lock::CollectionLock> collLock;
+        while (!collLock) {
+            if (_shared->stopping.load()) {
+                return;
+            }
+            const Date_t deadline = Date_t::now() + kLockRetryPeriod;
+            dbLock.emplace(_opCtx, _shared->nss.db(), MODE_IS, deadline);
+            if (dbLock->isLocked()) {
+                collLock.emplace(_opCtx->lockState(), _shared->nss.ns(), MODE_IS, deadline);
+                if (!collLock->isLocked()) {
+                    collLock = boost::none;
+                }
+            }
+            if (!collLock) {
+                dbLock = boost::none;
+            }
+        }
+
+        Database* db = DatabaseHolder::getDatabaseHolder().get(_opCtx, _shared->nss.db());
+        Collection* collection = db ? db->getCollection(_opCtx, _shared->nss) : nullptr;
+        uassert(ErrorCodes::QueryPlanKilled,
+                str::stream() << "collection dropped during parallel scan: " << _shared->nss.ns(),
+                collection && collection->uuid() == _shared->uuid);
+
+        auto& cursor = _range.cursor;
+        std::vector<SharedState::Result> pending;
+        size_t pendingBytes = 0;
+        size_t docsTested = 0;
+
+        try {
+            boost::optional<Record> record;
+            bool claimedStart = false;
+            if (!cursor) {
+                cursor = collection->getCursor(_opCtx, true);
+                if (!_range.start.isNull()) {
+                    record = cursor->seekExact(_range.start);
+                    const int owner = record ? kOwnThread : kEarlierThread;
+                    if (kUnclaimed != _range.startOwner.compareAndSwap(kUnclaimed, owner) ||
+                        !record) {
+                        // An earlier range's tasks scan this range.
+                        _range.done = true;
+                    } else {
+                        _range.positioned = true;
+                        claimedStart = true;
+                    }
+                }
+            } else {
+                // The cursor may have been detached by an earlier task, on another operation.
+                cursor->reattachToOperationContext(_opCtx);
+                uassert(ErrorCodes::CappedPositionLost,
+                        "parallel collection scan lost its position in a capped collection",
+                        cursor->restore());
+            }
+
+            for (size_t n = 0; !_range.done && n < kRecordsPerSlice; ++n) {
+                if (!record) {
+                    if (claimedStart &&
+                        MONGO_FAIL_POINT(parallelCollectionScanWriteConflictAfterClaim)) {
+                        throw WriteConflictException();
+                    }
+                    record = cursor->next();
+                }
+                if (!record || reachedOwnedBoundary(record->id)) {
+                    _range.done = true;
+                    break;
+                }
+
+                ++docsTested;
+                const BSONObj obj = record->data.toBson();
+                if (_shared->matches(obj)) {
+                    if (!_range.reducer) {
+                        pending.push_back({record->id, obj.getOwned()});
+                        pendingBytes += obj.objsize();
+                    } else if (_range.reducer->add(obj)) {
+                        flushReducer(&pending, &pendingBytes);
+                    }
+                    if (pendingBytes >= budget) {
+                        break;
+                    }
+                }
+                record = boost::none;
+
+                if (_shared->stopping.load()) {
+                    break;
+                }
+            }
+        } catch (const WriteConflictException&) {
+            // Carry on from the same position in the next slice, with a new snapshot. A cursor
+            // that never got positioned is recreated. One positioned at the start of the range
+            // resumes after the last record it returned, as the range has claimed its start.
+            if (!_range.positioned && !_range.start.isNull()) {
+                cursor.reset();
+            }
+        }
+
+        if (_range.done && _range.reducer) {
+            flushReducer(&pending, &pendingBytes);
+        }
+        const size_t reducerBytes = _range.reducer ? _range.reducer->getMemoryUsageBytes() : 0;
+
+        if (cursor) {
+            _range.positioned = true;
+            if (_range.done) {
+                cursor.reset();
+            } else {
+                cursor->save();
+                cursor->detachFromOperationContext();
+            }
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_shared->mutex);
+        _range.docsTested += docsTested;
+        if (_range.reducer) {
+            _range.reducedResults += pending.size();
+            _shared->reducerBytes += reducerBytes;
+            _shared->reducerBytes -= _range.reducerBytes;
+            _range.reducerBytes = reducerBytes;
+        }
+        if (!pending.empty()) {
+            _range.bufferedBytes += pendingBytes;
+            _shared->bufferedBytes += pendingBytes;
+            std::move(pending.begin(), pending.end(), std::back_inserter(_range.results));
+            _shared->resultsAvailable.notify_all();
+        }
+    }
+
+    /**
+     * Moves the output of the range's reducer to 'pending'.
+     */
+    void flushReducer(std::vector<SharedState::Result>* pending, size_t* pendingBytes) {
+        std::vector<BSONObj> reduced;
+        _range.reducer->flush(&reduced);
+        for (auto&& obj : reduced) {
+            *pendingBytes += obj.objsize();
+            pending->push_back({RecordId(), std::move(obj)});
+        }
+    }
+
+    OperationContext* const _opCtx;
+    SharedState* const _shared;
+    SharedState::Range& _range;
+};
+
+/**
+ * Body of a pool task for range 'ix'. Once the range's scanning stops, hands the thread to the
+ * lowest waiting range, and requeues this one if the stage made space in its buffer meanwhile.
+ */
+void scanRange(SharedState* shared, size_t ix) {
+    auto& range = shared->ranges[ix];
+    Status status = Status::OK();
+    {
+        auto client = shared->service->makeClient(str::stream() << "ParallelCollectionScan-" << ix);
+        AlternativeClientRegion acr(client);
+        auto opCtx = cc().makeOperationContext();
+        try {
+            RangeScanner(opCtx.get(), shared, ix).run();
+        } catch (const DBException& ex) {
+            status = ex.toStatus();
+            // The cursor may still be attached to 'opCtx'.
+            range.cursor.reset();
+            range.done = true;
+        }
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(shared->mutex);
+    range.scheduled = false;
+    --shared->running;
+    if (!status.isOK()) {
+        failScan(lk, shared, std::move(status));
+    }
+    if (range.done) {
+        range.finished = true;
+    } else if (shared->hasSpace(range) && !shared->stopping.load()) {
+        shared->runnable.insert(ix);
+    }
+    while (!shared->runnable.empty() && shared->running < shared->maxRunning) {
+        scheduleRange(lk, shared, *shared->runnable.begin());
+    }
+    // Notify under the mutex: the stage may destroy 'shared' as soon as it sees nothing running.
+    shared->resultsAvailable.notify_all();
+}
+
+}  // namespace
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               size_t numRanges,
+                                               bool ordered,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : PlanStage(kStageType, opCtx),
+      _collection(collection),
+      _nss(collection->ns()),
+      _numRanges(std::max(numRanges, size_t(1))),
+      _ordered(ordered),
+      _workingSet(workingSet),
+      _filter(filter) {
+    invariant(_collection->uuid());
+    _specificStats.ordered = ordered;
+    incStageObj(STAGE_PARALLEL_COLLSCAN);
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    if (_shared) {
+        _shared->stopping.store(true);
+        stdx::unique_lock<stdx::mutex> lk(_shared->mutex);
+        _shared->resultsAvailable.wait(lk, [&] { return 0 == _shared->running; });
+    }
+    decStageObjAndMem(STAGE_PARALLEL_COLLSCAN);
+}
+
+// static
+bool ParallelCollectionScan::canScanInParallel(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               const MatchExpression* filter,
+                                               size_t numRanges) {
+    if (numRanges < 2 || !supportsDocLocking()) {
+        return false;
+    }
+    if (!collection || collection->ns().isOplog() || !collection->uuid() ||
+        collection->numRecords(opCtx) < internalQueryParallelCollectionScanMinRecords.load()) {
+        return false;
+    }
+
+    // Scanning threads read the latest data, so the operation must too.
+    if (opCtx->lockState()->inAWriteUnitOfWork() ||
+        repl::ReadConcernArgs::get(opCtx).getLevel() ==
+            repl::ReadConcernLevel::kSnapshotReadConcern) {
+        return false;
+    }
+    const auto readSource = opCtx->recoveryUnit()->getTimestampReadSource();
+    if (RecoveryUnit::ReadSource::kUnset != readSource &&
+        RecoveryUnit::ReadSource::kNoTimestamp != readSource) {
+        return false;
+    }
+
+    if (filter && !canEvaluateConcurrently(filter)) {
+        return false;
+    }
+    return static_cast<bool>(collection->getRecordStore()->getRandomCursor(opCtx));
+}
+
+void ParallelCollectionScan::setRangeReducer(ParallelScanReducerFactory factory) {
+    invariant(!_shared);
+    _reducerFactory = std::move(factory);
+    _specificStats.reduced = true;
+}
+
+void ParallelCollectionScan::startScan() {
+    // Sample the collection and split it at evenly spaced samples.
+    std::vector<RecordId> samples;
+    if (auto cursor = _collection->getRecordStore()->getRandomCursor(getOpCtx())) {
+        for (size_t i = 0; i < _numRanges * kSamplesPerRange; ++i) {
+            auto record = cursor->next();
+            if (!record) {
+                break;
+            }
+            samples.push_back(record->id);
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+
+    std::vector<RecordId> starts{RecordId()};
+    for (size_t i = 1; i < _numRanges && !samples.empty(); ++i) {
+        const RecordId& start = samples[i * samples.size() / _numRanges];
+        if (start > starts.back()) {
+            starts.push_back(start);
+        }
+    }
+
+    _shared = make_unique<SharedState>(
+        getOpCtx()->getServiceContext(), _nss, *_collection->uuid(), _filter, starts.size());
+    for (size_t i = 0; i < starts.size(); ++i) {
+        _shared->ranges[i].start = starts[i];
+        if (_reducerFactory) {
+            _shared->ranges[i].reducer = _reducerFactory();
+        }
+    }
+    _specificStats.ranges = starts.size();
+
+    // Ranges past the query's share of the pool wait in 'runnable', lowest first.
+    stdx::lock_guard<stdx::mutex> lk(_shared->mutex);
+    for (size_t ix = 0; ix < starts.size(); ++ix) {
+        scheduleRange(lk, _shared.get(), ix);
+    }
+}
+
+void ParallelCollectionScan::chargeBufferedMemory(size_t bytes) {
+    if (bytes > _chargedBytes) {
+        incCachedMemory(bytes - _chargedBytes);
+    } else if (bytes < _chargedBytes) {
+        decCachedMemory(_chargedBytes - bytes);
+    }
+    _chargedBytes = bytes;
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_shared) {
+        try {
+            startScan();
+        } catch (const WriteConflictException&) {
+            _shared.reset();
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    if (chkCachedMemOversize()) {
+        *out = chkMemFailureRet(_workingSet);
+        return PlanStage::FAILURE;
+    }
+
+    auto& taken = _shared->taken;
+    if (taken.empty()) {
+        stdx::unique_lock<stdx::mutex> lk(_shared->mutex);
+        if (!_shared->status.isOK()) {
+            const Status status = _shared->status;
+            lk.unlock();
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
+            return PlanStage::FAILURE;
+        }
+
+        auto& ranges = _shared->ranges;
+        const auto takeFrom = [&](size_t ix) {
+            auto& range = ranges[ix];
+            const bool wasFull = !_shared->hasSpace(range);
+            for (size_t i = 0; i < kResultsPerTake && !range.results.empty(); ++i) {
+                const size_t objSize = range.results.front().obj.objsize();
+                range.bufferedBytes -= objSize;
+                _shared->bufferedBytes -= objSize;
+                _shared->takenBytes += objSize;
+                taken.push_back(std::move(range.results.front()));
+                range.results.pop_front();
+            }
+            if (wasFull && _shared->hasSpace(range)) {
+                // The range's task ended when its buffer filled up.
+                scheduleRange(lk, _shared.get(), ix);
+            }
+        };
+
+        bool allFinished = true;
+        if (_ordered) {
+            while (_nextRange < ranges.size() && ranges[_nextRange].finished &&
+                   ranges[_nextRange].results.empty()) {
+                ++_nextRange;
+            }
+            if (_nextRange < ranges.size()) {
+                allFinished = false;
+                takeFrom(_nextRange);
+            }
+        } else {
+            for (size_t n = 0; n < ranges.size() && taken.empty(); ++n) {
+                const size_t ix = (_nextRange + n) % ranges.size();
+                takeFrom(ix);
+                allFinished = allFinished && ranges[ix].finished;
+                if (!taken.empty()) {
+                    _nextRange = (ix + 1) % ranges.size();
+                }
+            }
+        }
+
+        // Results buffered by the ranges, and what their reducers hold, count against this stage
+        // until they are returned.
+        chargeBufferedMemory(_shared->bufferedBytes + _shared->reducerBytes +
+                             _shared->takenBytes);
+
+        if (taken.empty()) {
+            if (allFinished) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+            _shared->resultsAvailable.wait_for(lk, kResultWaitPeriod.toSystemDuration());
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    member->obj = {SnapshotId(), std::move(taken.front().obj)};
+    if (_reducerFactory) {
+        // Reduced results do not correspond to any record.
+        _workingSet->transitionToOwnedObj(id);
+    } else {
+        member->recordId = taken.front().id;
+        _workingSet->transitionToRecordIdAndObj(id);
+    }
+    _shared->takenBytes -= member->obj.value().objsize();
+    taken.pop_front();
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    if (NULL != _filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    if (_shared) {
+        stdx::lock_guard<stdx::mutex> lk(_shared->mutex);
+        _specificStats.docsTested = 0;
+        _specificStats.reducedResults = 0;
+        for (auto&& range : _shared->ranges) {
+            _specificStats.docsTested += range.docsTested;
+            _specificStats.reducedResults += range.reducedResults;
+        }
+    }
+
+    unique_ptr<PlanStageStats> ret =
+        make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,188 @@
+/**
+ *    Copyright (C) 2013-2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+class Collection;
+class MatchExpression;
+class OperationContext;
+class WorkingSet;
+
+/**
+ * Replaces the documents one range of a ParallelCollectionScan matches with fewer documents
+ * derived from them, such as partial aggregates, on the pool threads scanning the range. Each
+ * range has its own reducer, which only the range's tasks use, one at a time.
+ */
+class ParallelScanRangeReducer {
+public:
+    virtual ~ParallelScanRangeReducer() = default;
+
+    /**
+     * Takes a matching document, which is only valid for the duration of the call. Returns true
+     * once the reducer holds enough that its output should be taken with flush().
+     */
+    virtual bool add(const BSONObj& obj) = 0;
+
+    /**
+     * Appends owned documents for everything added since the last flush to 'out'.
+     */
+    virtual void flush(std::vector<BSONObj>* out) = 0;
+
+    /**
+     * Returns roughly how many bytes the reducer holds for what was added since the last flush.
+     * The scan charges them to its own memory.
+     */
+    virtual size_t getMemoryUsageBytes() const = 0;
+};
+
+using ParallelScanReducerFactory = stdx::function<std::unique_ptr<ParallelScanRangeReducer>()>;
+
+/**
+ * Scans a collection forwards on other threads. The collection is split into RecordId ranges at
+ * points sampled with a random cursor, and each range is scanned by tasks on the parallel
+ * collection scan pool, with their own Client, OperationContext and storage snapshot, evaluating
+ * the filter as they go. Matching documents are buffered, owned, per range and handed out here,
+ * and count against this stage's memory until they are, as does what the range reducers hold. A
+ * range whose buffer is full gives its thread back to the pool until some of its results are
+ * taken, and a query uses at most 'internalQueryParallelCollectionScanMaxThreadsPerQuery'
+ * threads at a time.
+ *
+ * If 'ordered' is true, results come out in RecordId order, one range after another. Otherwise
+ * they come out in whatever order the ranges produce them.
+ *
+ * Scanning threads take the collection lock in intent mode, a little at a time, and never wait
+ * for this stage while holding it, so this stage may yield as usual. A scanning thread that
+ * finds the collection dropped or recreated makes this stage fail with QueryPlanKilled. Like a
+ * CollectionScan that yields, each range reads from a sequence of snapshots rather than one.
+ *
+ * Results are returned in the RID_AND_OBJ state with owned documents. Their SnapshotId is not
+ * that of any snapshot of this operation, so a stage that depends on the document being current
+ * must refetch it; this stage is only used by read-only plans. If the ranges are reduced (see
+ * setRangeReducer()), results are the reducers' output, in the OWNED_OBJ state.
+ */
+class ParallelCollectionScan final : public PlanStage {
+public:
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const Collection* collection,
+                           size_t numRanges,
+                           bool ordered,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    /**
+     * Stops the scanning tasks and waits for them.
+     */
+    ~ParallelCollectionScan();
+
+    /**
+     * Returns true if scanning 'collection' under 'filter' with this stage is possible and
+     * worthwhile for this operation: 'numRanges' is more than one, the collection is large
+     * enough and supports random cursors, the storage engine supports document-level locking,
+     * the operation reads the latest data outside of a transaction, and the filter can be
+     * evaluated on several threads at once.
+     */
+    static bool canScanInParallel(OperationContext* opCtx,
+                                  const Collection* collection,
+                                  const MatchExpression* filter,
+                                  size_t numRanges);
+
+    /**
+     * Makes each range pass its matching documents through a reducer made by 'factory', and
+     * return the reducer's output instead. Results then come out in no particular order, with no
+     * RecordId. Must be called before the first call to work().
+     */
+    void setRangeReducer(ParallelScanReducerFactory factory);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+    /**
+     * State shared with the scanning threads. Defined in the .cpp.
+     */
+    struct SharedState;
+
+private:
+    /**
+     * Picks the range boundaries and schedules the ranges on the pool.
+     */
+    void startScan();
+
+    /**
+     * Makes the memory charged to this stage for buffered results 'bytes'.
+     */
+    void chargeBufferedMemory(size_t bytes);
+
+    // Not owned here.
+    const Collection* _collection;
+    const NamespaceString _nss;
+
+    const size_t _numRanges;
+    const bool _ordered;
+
+    // Not owned here.
+    WorkingSet* _workingSet;
+
+    // Not owned here. Evaluated by the scanning threads.
+    const MatchExpression* _filter;
+
+    // Empty unless the ranges are reduced.
+    ParallelScanReducerFactory _reducerFactory;
+
+    // Null until the first call to work().
+    std::unique_ptr<SharedState> _shared;
+
+    // The range results are taken from next: the current one if ordered, round robin otherwise.
+    size_t _nextRange = 0;
+
+    // Bytes of buffered results currently charged to this stage.
+    size_t _chargedBytes = 0;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
@@ -32,12 +32,51 @@
 
 #include "mongo/db/exec/plan_stage.h"
 
+#include <algorithm>
+
+#include "mongo/db/curop.h"
 #include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/service_context.h"
 
 namespace mongo {
 
+namespace {
+
+const auto getOperationStageMem =
+    OperationContext::declareDecoration<std::shared_ptr<OperationStageMemCounter>>();
+
+// The stage memory counter of 'opCtx', created on first use for the database of its namespace.
+const std::shared_ptr<OperationStageMemCounter>& operationMemCounter(OperationContext* opCtx) {
+    auto& counter = getOperationStageMem(opCtx);
+    if (!counter) {
+        const std::string ns = CurOp::get(opCtx)->getNS();
+        counter = std::make_shared<OperationStageMemCounter>(
+            globalStageMemCounters.getTenantCounter(nsToDatabaseSubstring(ns)));
+    }
+    return counter;
+}
+
+// The smallest reservation a stage takes. Reservations then grow with the stage, up to
+// internalQueryStageMemReserveChunkBytes at a time.
+const int64_t kMinMemReservation = 4 * 1024;
+
+int64_t memReservationHeadroom(int64_t used) {
+    return std::min(std::max(used, kMinMemReservation),
+                    static_cast<int64_t>(internalQueryStageMemReserveChunkBytes.load()));
+}
+
+}  // namespace
+
+PlanStage::~PlanStage() {
+    // Stages normally release their memory in decStageObjAndMem(); this catches any that don't.
+    // stageType() can no longer be called here, so use the type recorded by the last reservation.
+    if (_reservedMemSize > 0) {
+        _reserveMemory(_memStageType, -_reservedMemSize);
+    }
+}
+
 PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     invariant(_opCtx);
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
@@ -56,6 +95,54 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(WorkingSet* ws,
+                                           size_t maxWorks,
+                                           std::vector<WorkingSetID>* out,
+                                           WorkingSetID* stateOut) {
+    invariant(maxWorks > 0);
+    const size_t resultsBefore = out->size();
+
+    if (!supportsBatchedWork()) {
+        for (size_t works = 0; works < maxWorks; ++works) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const StageState state = work(&id);
+            if (ADVANCED == state) {
+                // The next call to work() may reuse the storage a result points into.
+                WorkingSetMember* member = ws->get(id);
+                member->makeObjOwnedIfNeeded();
+                for (auto&& key : member->keyData) {
+                    if (!key.keyData.isOwned()) {
+                        key.keyData = key.keyData.getOwned();
+                    }
+                }
+                out->push_back(id);
+            } else if (NEED_TIME != state) {
+                *stateOut = id;
+                return state;
+            }
+        }
+        return out->size() > resultsBefore ? ADVANCED : NEED_TIME;
+    }
+
+    invariant(_opCtx);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    const size_t needTimeBefore = _commonStats.needTime;
+
+    StageState batchResult = doWorkBatch(maxWorks, out, stateOut);
+
+    const size_t advanced = out->size() - resultsBefore;
+    _commonStats.advanced += advanced;
+    _commonStats.works += advanced + (_commonStats.needTime - needTimeBefore);
+    if (ADVANCED != batchResult && NEED_TIME != batchResult) {
+        ++_commonStats.works;
+        if (NEED_YIELD == batchResult) {
+            ++_commonStats.needYield;
+        }
+    }
+
+    return batchResult;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -85,6 +172,10 @@ void PlanStage::invalidate(OperationContext* opCtx, const RecordId& dl, Invalida
 
 void PlanStage::detachFromOperationContext() {
     invariant(_opCtx);
+    if (_memOperation) {
+        _memOperation->reserve(-_reservedMemSize);
+        _memOperation.reset();
+    }
     _opCtx = nullptr;
 
     for (auto&& child : _children) {
@@ -97,6 +188,10 @@ void PlanStage::detachFromOperationContext() {
 void PlanStage::reattachToOperationContext(OperationContext* opCtx) {
     invariant(_opCtx == nullptr);
     _opCtx = opCtx;
+    if (_reservedMemSize > 0) {
+        _memOperation = _getOperationMemCounter();
+        _memOperation->reserve(_reservedMemSize);
+    }
 
     for (auto&& child : _children) {
         child->reattachToOperationContext(opCtx);
@@ -110,27 +205,106 @@ ClockSource* PlanStage::getClock() const {
 }
 
 bool PlanStage::chkCachedMemOversize() const {
-    return globalStageMemCounters.chkCachedMemOversize(_cachedMemSize);
+    return chkCachedMemLimit() != StageMemCounter::LimitLevel::kNone;
+}
+
+StageMemLimitLevel PlanStage::chkCachedMemLimit() const {
+    return globalStageMemCounters.chkCachedMemOversize(
+        _cachedMemSize, _memOperation.get(), _memTenant.get());
 }
 
 WorkingSetID PlanStage::chkMemFailureRet(WorkingSet* ws) const {
+    const auto level = chkCachedMemLimit();
+    globalStageMemCounters.noteRejected(level, _memTenant.get());
+
     mongoutils::str::stream ss;
-    ss << "All stage objects used " << globalStageMemCounters.getTotalMemSize()
-       << " bytes of RAM that more than the maximum (" << internalQueryStageMemUsageMAX.load()
-       << ") bytes of RAM. This " << _commonStats.stageTypeStr << " object use " << _cachedMemSize
+    switch (level) {
+        case StageMemCounter::LimitLevel::kOperation:
+            ss << "Stage objects of this operation used " << _memOperation->getReservedMemSize()
+               << " bytes of RAM that more than the per-operation maximum ("
+               << internalQueryStageMemUsageOpMAX.load() << ") bytes of RAM.";
+            break;
+        case StageMemCounter::LimitLevel::kTenant:
+            ss << "Stage objects on database " << _memTenant->getDB() << " used "
+               << _memTenant->getReservedMemSize()
+               << " bytes of RAM that more than the per-database maximum ("
+               << internalQueryStageMemUsageTenantMAX.load() << ") bytes of RAM.";
+            break;
+        default:
+            ss << "All stage objects used " << globalStageMemCounters.getTotalMemSize()
+               << " bytes of RAM that more than the maximum ("
+               << internalQueryStageMemUsageMAX.load() << ") bytes of RAM.";
+            break;
+    }
+    ss << " This " << _commonStats.stageTypeStr << " object use " << _cachedMemSize
        << " bytes of RAM. OperationFailed to avoid OOM.";
     Status status(ErrorCodes::OperationFailed, ss);
     return WorkingSetCommon::allocateStatusMember(ws, status);
 }
 
 void PlanStage::incCachedMemory(const size_t& memSize) {
-    globalStageMemCounters.incCachedMemSize(stageType(), memSize);
     _cachedMemSize += memSize;
+    if (static_cast<int64_t>(_cachedMemSize) > _reservedMemSize) {
+        _adjustMemReservation();
+    }
 }
 
 void PlanStage::decCachedMemory(const size_t& memSize) {
-    globalStageMemCounters.decCachedMemSize(stageType(), memSize);
     _cachedMemSize -= memSize;
+    _adjustMemReservation();
+}
+
+void PlanStage::_adjustMemReservation() {
+    const int64_t used = static_cast<int64_t>(_cachedMemSize);
+    if (used == 0) {
+        if (_reservedMemSize > 0) {
+            _reserveMemory(stageType(), -_reservedMemSize);
+        }
+        return;
+    }
+
+    // Grow to "used" plus some headroom; shrink only once the slack is twice that headroom, so a
+    // stage that oscillates around a chunk boundary does not keep reserving and releasing.
+    const int64_t headroom = memReservationHeadroom(used);
+    if (used > _reservedMemSize || _reservedMemSize - used > 2 * headroom) {
+        _reserveMemory(stageType(), used + headroom - _reservedMemSize);
+    }
+}
+
+void PlanStage::_reserveMemory(StageType type, int64_t size) {
+    // Only a growing reservation looks up the operation: ~PlanStage() may release after the
+    // operation context is gone.
+    if (size > 0 && !_memOperation && _opCtx) {
+        _memOperation = _getOperationMemCounter();
+        if (!_memTenant) {
+            _memTenant = _memOperation->getTenant();
+        }
+    }
+
+    _memStageType = type;
+    _reservedMemSize += size;
+    globalStageMemCounters.reserveMemSize(type, size);
+    if (_memTenant) {
+        _memTenant->reserve(size);
+    }
+    if (_memOperation) {
+        _memOperation->reserve(size);
+    }
+}
+
+const std::shared_ptr<OperationStageMemCounter>& PlanStage::_getOperationMemCounter() {
+    invariant(_opCtx);
+    return operationMemCounter(_opCtx);
+}
+
+std::shared_ptr<OperationStageMemCounter> PlanStage::getOperationMemCounter(
+    OperationContext* opCtx) {
+    return operationMemCounter(opCtx);
+}
+
+void PlanStage::setOperationMemCounter(OperationContext* opCtx,
+                                       std::shared_ptr<OperationStageMemCounter> counter) {
+    getOperationStageMem(opCtx) = std::move(counter);
 }
 
 void PlanStage::incStageObj(const StageType& type) {
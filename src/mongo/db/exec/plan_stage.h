@@ -36,13 +36,17 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/util/assert_util.h"
 
 namespace mongo {
 
 class ClockSource;
 class Collection;
 class OperationContext;
+class OperationStageMemCounter;
 class RecordId;
+class TenantStageMemCounter;
+enum class StageMemLimitLevel;
 
 /**
  * A PlanStage ("stage") is the basic building block of a "Query Execution Plan."  A stage is
@@ -110,7 +114,7 @@ public:
     PlanStage(const char* typeName, OperationContext* opCtx)
         : _cachedMemSize(0), _commonStats(typeName), _opCtx(opCtx) {}
 
-    virtual ~PlanStage() {}
+    virtual ~PlanStage();
 
     using Children = std::vector<std::unique_ptr<PlanStage>>;
 
@@ -190,6 +194,33 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Batched form of work(). Does up to 'maxWorks' units of work, appending each result to
+     * 'out', and returns why the batch ended:
+     *  - ADVANCED or NEED_TIME when the budget ran out, depending on whether anything was
+     *    produced.
+     *  - Otherwise the IS_EOF, NEED_YIELD, DEAD or FAILURE state that stopped it, with the
+     *    WorkingSetID that work() would have returned alongside it in *stateOut. The results
+     *    appended before that state come before it and must be consumed first.
+     *
+     * Unlike a result of work(), a result of a batch stays valid while the rest of the batch is
+     * produced and across a yield, because its document and keys are owned.
+     *
+     * Stages that override supportsBatchedWork() fill the batch in a single call to
+     * doWorkBatch(). For all other stages the batch is built by calling work() once per unit.
+     */
+    StageState workBatch(WorkingSet* ws,
+                         size_t maxWorks,
+                         std::vector<WorkingSetID>* out,
+                         WorkingSetID* stateOut);
+
+    /**
+     * Whether this stage builds batches itself rather than through work(), see workBatch().
+     */
+    virtual bool supportsBatchedWork() const {
+        return false;
+    }
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -352,23 +383,88 @@ public:
     virtual bool chkCachedMemOversize() const;
     WorkingSetID chkMemFailureRet(WorkingSet* ws) const;
 
+    /**
+     * Like chkCachedMemOversize(), but says which level's limit is exceeded. Stages that can
+     * spill to disk do so when only the global limit is exceeded and canSpillStageMemory().
+     */
+    StageMemLimitLevel chkCachedMemLimit() const;
+
     void incCachedMemory(const size_t& memSize);
     void decCachedMemory(const size_t& memSize);
 
     void incStageObj(const StageType& type);
     void decStageObjAndMem(const StageType& type);
 
+    /**
+     * Returns the per-operation stage memory counter of 'opCtx', creating it for the database of
+     * the operation's namespace if the operation has none yet.
+     */
+    static std::shared_ptr<OperationStageMemCounter> getOperationMemCounter(
+        OperationContext* opCtx);
+
+    /**
+     * Makes stages attached to 'opCtx' charge their memory to 'counter', which belongs to another
+     * operation. For helper operations that work part of a plan on behalf of that operation.
+     */
+    static void setOperationMemCounter(OperationContext* opCtx,
+                                       std::shared_ptr<OperationStageMemCounter> counter);
+
     /**
      *The memory size that reported to the globalStageMemCounters, release it the dtor.
      */
     size_t _cachedMemSize;
 
+    /**
+     * Memory charged to the operation, tenant and global levels on behalf of this stage. Always
+     * at least _cachedMemSize; the difference is headroom so that most inc/decCachedMemory calls
+     * do not touch shared counters.
+     */
+    int64_t _reservedMemSize = 0;
+
 protected:
     /**
      * Performs one unit of work.  See comment at work() above.
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs up to 'maxWorks' units of work. See comment at workBatch() above. Only called
+     * when supportsBatchedWork() is true.
+     *
+     * Each unit of work that produced no result must be counted in _commonStats.needTime.
+     */
+    virtual StageState doWorkBatch(size_t maxWorks,
+                                   std::vector<WorkingSetID>* out,
+                                   WorkingSetID* stateOut) {
+        MONGO_UNREACHABLE;
+    }
+
+    /**
+     * Helper for doWorkBatch(): calls 'workUnit', which has the signature of doWork(), until
+     * 'maxWorks' units have been done or it returns something other than ADVANCED or NEED_TIME.
+     * 'workUnit' must only return results that are safe to hold in a batch.
+     */
+    template <typename WorkUnit>
+    StageState doWorkUnits(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut,
+                           WorkUnit&& workUnit) {
+        const size_t resultsBefore = out->size();
+        for (size_t works = 0; works < maxWorks; ++works) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const StageState state = workUnit(&id);
+            if (ADVANCED == state) {
+                out->push_back(id);
+            } else if (NEED_TIME == state) {
+                ++_commonStats.needTime;
+            } else {
+                *stateOut = id;
+                return state;
+            }
+        }
+        return out->size() > resultsBefore ? ADVANCED : NEED_TIME;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -418,7 +514,29 @@ protected:
     CommonStats _commonStats;
 
 private:
+    /**
+     * Grows or shrinks _reservedMemSize to track _cachedMemSize.
+     */
+    void _adjustMemReservation();
+    void _reserveMemory(StageType type, int64_t size);
+
+    /**
+     * Returns the per-operation stage memory counter of the attached operation.
+     */
+    const std::shared_ptr<OperationStageMemCounter>& _getOperationMemCounter();
+
     OperationContext* _opCtx;
+
+    // Set while this stage holds a reservation and is attached to an operation; reset when
+    // detaching so a reservation never outlives the operation it was charged to.
+    std::shared_ptr<OperationStageMemCounter> _memOperation;
+
+    // The stage type the reservation is charged to, for releasing it from ~PlanStage().
+    StageType _memStageType = STAGE_UNKNOWN;
+
+    // The database this stage's reservation is charged to. Fixed by the first reservation so
+    // that releases always go back to the same tenant.
+    std::shared_ptr<TenantStageMemCounter> _memTenant;
 };
 
 }  // namespace mongo
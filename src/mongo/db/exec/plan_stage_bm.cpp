@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/repl/replication_coordinator_mock.h"
+#include "mongo/db/repl/storage_interface_impl.h"
+#include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("plan_stage_bm.coll");
+const int kNumDocs = 10000;
+
+/**
+ * Sets up an ephemeralForTest mongod with a single collection of kNumDocs documents of the form
+ * {_id: i, a: i, b: "<padding>", c: i % 10}.
+ */
+class PlanStageBenchmarkFixture : public ServiceContextMongoDTest {
+public:
+    PlanStageBenchmarkFixture() {
+        auto service = getServiceContext();
+        auto replCoord = std::make_unique<repl::ReplicationCoordinatorMock>(service);
+        invariant(replCoord->setFollowerMode(repl::MemberState::RS_PRIMARY));
+        repl::ReplicationCoordinator::set(service, std::move(replCoord));
+
+        _opCtx = cc().makeOperationContext();
+
+        repl::StorageInterfaceImpl storage;
+        invariant(storage.createCollection(_opCtx.get(), kNss, CollectionOptions()));
+
+        std::vector<InsertStatement> docs;
+        const std::string padding(64, 'x');
+        for (int i = 0; i < kNumDocs; ++i) {
+            docs.emplace_back(BSON("_id" << i << "a" << i << "b" << padding << "c" << i % 10));
+        }
+        invariant(storage.insertDocuments(_opCtx.get(), kNss, docs));
+    }
+
+    OperationContext* opCtx() {
+        return _opCtx.get();
+    }
+
+private:
+    void _doTest() override {}
+
+    ServiceContext::UniqueOperationContext _opCtx;
+};
+
+std::unique_ptr<MatchExpression> parseFilter(OperationContext* opCtx, const BSONObj& filter) {
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(opCtx, nullptr));
+    return uassertStatusOK(MatchExpressionParser::parse(filter, expCtx));
+}
+
+/**
+ * Drains 'root' to EOF either one work() unit at a time or through workBatch() with a budget of
+ * 'batchSize' units, freeing every result. Returns the number of results.
+ */
+long long drain(PlanStage* root, WorkingSet* ws, size_t batchSize) {
+    long long results = 0;
+    if (batchSize <= 1) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state;
+        while ((state = root->work(&id)) != PlanStage::IS_EOF) {
+            invariant(state != PlanStage::FAILURE && state != PlanStage::DEAD);
+            if (state == PlanStage::ADVANCED) {
+                benchmark::DoNotOptimize(ws->get(id)->obj.value().objdata());
+                ws->free(id);
+                ++results;
+            }
+        }
+        return results;
+    }
+
+    std::vector<WorkingSetID> batch;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (state != PlanStage::IS_EOF) {
+        WorkingSetID stateId = WorkingSet::INVALID_ID;
+        batch.clear();
+        state = root->workBatch(ws, batchSize, &batch, &stateId);
+        invariant(state != PlanStage::FAILURE && state != PlanStage::DEAD);
+        for (auto id : batch) {
+            benchmark::DoNotOptimize(ws->get(id)->obj.value().objdata());
+            ws->free(id);
+        }
+        results += batch.size();
+    }
+    return results;
+}
+
+/**
+ * Runs a full scan of the collection per iteration, optionally under a filter and a projection.
+ * state.range(0) is the batch size; 1 is the classic work() loop.
+ */
+void runScan(benchmark::State& state, const BSONObj& filterObj, const BSONObj& projObj) {
+    PlanStageBenchmarkFixture fixture;
+    auto opCtx = fixture.opCtx();
+    AutoGetCollectionForRead autoColl(opCtx, kNss);
+
+    std::unique_ptr<MatchExpression> filter;
+    if (!filterObj.isEmpty()) {
+        filter = parseFilter(opCtx, filterObj);
+    }
+
+    long long documents = 0;
+    for (auto keepRunning : state) {
+        WorkingSet ws;
+        CollectionScanParams params;
+        params.collection = autoColl.getCollection();
+        std::unique_ptr<PlanStage> root =
+            std::make_unique<CollectionScan>(opCtx, params, &ws, filter.get());
+        if (!projObj.isEmpty()) {
+            ProjectionStageParams projParams;
+            projParams.projImpl = ProjectionStageParams::SIMPLE_DOC;
+            projParams.projObj = projObj;
+            root = std::make_unique<ProjectionStage>(opCtx, projParams, &ws, root.release());
+        }
+        benchmark::DoNotOptimize(drain(root.get(), &ws, state.range(0)));
+        documents += kNumDocs;
+    }
+    state.SetItemsProcessed(documents);
+}
+
+void BM_CollectionScan(benchmark::State& state) {
+    runScan(state, BSONObj(), BSONObj());
+}
+
+// Matches one document in ten.
+void BM_CollectionScanSelectiveFilter(benchmark::State& state) {
+    runScan(state, BSON("c" << 3), BSONObj());
+}
+
+void BM_CollectionScanFilterProject(benchmark::State& state) {
+    runScan(state, BSON("c" << 3), BSON("a" << 1 << "_id" << 0));
+}
+
+BENCHMARK(BM_CollectionScan)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_CollectionScanSelectiveFilter)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_CollectionScanFilterProject)->Arg(1)->Arg(16)->Arg(128);
+
+}  // namespace
+}  // namespace mongo
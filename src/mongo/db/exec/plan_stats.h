@@ -138,7 +138,13 @@ private:
 };
 
 struct AndHashStats : public SpecificStats {
-    AndHashStats() : flaggedButPassed(0), flaggedInProgress(0), memUsage(0), memLimit(0) {}
+    AndHashStats()
+        : flaggedButPassed(0),
+          flaggedInProgress(0),
+          memUsage(0),
+          memLimit(0),
+          spilledMembers(0),
+          spilledBytes(0) {}
 
     SpecificStats* clone() const final {
         AndHashStats* specific = new AndHashStats(*this);
@@ -165,6 +171,11 @@ struct AndHashStats : public SpecificStats {
 
     // What's our memory limit?
     size_t memLimit;
+
+    // How many hashed members were moved to disk after hitting the global stage memory limit,
+    // and how many bytes were written for them?
+    size_t spilledMembers;
+    size_t spilledBytes;
 };
 
 struct AndSortedStats : public SpecificStats {
@@ -483,6 +494,10 @@ struct MultiPlanStats : public SpecificStats {
     SpecificStats* clone() const final {
         return new MultiPlanStats(*this);
     }
+
+    // Wall clock time each candidate spent in its trial period, by candidate index, when the
+    // trial periods ran in parallel. Empty when the candidates were worked in turn.
+    std::vector<long long> trialWallTimeMicros;
 };
 
 struct OrStats : public SpecificStats {
@@ -500,6 +515,28 @@ struct OrStats : public SpecificStats {
     size_t recordIdsForgotten;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new ParallelCollectionScanStats(*this);
+    }
+
+    // How many documents did the scanning threads check against the filter?
+    size_t docsTested = 0;
+
+    // How many RecordId ranges was the collection split into?
+    size_t ranges = 0;
+
+    // Are results returned in RecordId order?
+    bool ordered = false;
+
+    // Were the matching documents of each range reduced on the range's thread, for instance to
+    // partial groups?
+    bool reduced = false;
+
+    // How many documents did the reducers return in place of the matching documents?
+    size_t reducedResults = 0;
+};
+
 struct ProjectionStats : public SpecificStats {
     ProjectionStats() {}
 
@@ -513,7 +550,7 @@ struct ProjectionStats : public SpecificStats {
 };
 
 struct SortStats : public SpecificStats {
-    SortStats() : forcedFetches(0), memUsage(0), memLimit(0) {}
+    SortStats() : forcedFetches(0), memUsage(0), memLimit(0), spills(0), spilledBytes(0) {}
 
     SpecificStats* clone() const final {
         SortStats* specific = new SortStats(*this);
@@ -529,6 +566,11 @@ struct SortStats : public SpecificStats {
     // What's our memory limit?
     size_t memLimit;
 
+    // How many files did we spill to after hitting the global stage memory limit, and how big
+    // were they in total?
+    size_t spills;
+    size_t spilledBytes;
+
     // The number of results to return from the sort.
     size_t limit;
 
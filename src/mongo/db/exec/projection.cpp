@@ -221,6 +221,28 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxWorks,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateOut) {
+    const size_t first = out->size();
+    const StageState status = child()->workBatch(_ws, maxWorks, out, stateOut);
+
+    for (size_t i = first; i < out->size(); ++i) {
+        Status projStatus = transform(_ws->get((*out)[i]));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+            for (size_t j = i; j < out->size(); ++j) {
+                _ws->free((*out)[j]);
+            }
+            out->resize(i);
+            *stateOut = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    return status;
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
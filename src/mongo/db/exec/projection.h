@@ -83,6 +83,10 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     StageType stageType() const final {
         return STAGE_PROJECTION;
     }
@@ -112,6 +116,11 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateOut) final;
+
 private:
     Status transform(WorkingSetMember* member);
 
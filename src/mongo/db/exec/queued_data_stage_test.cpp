@@ -128,4 +128,37 @@ TEST_F(QueuedDataStageTest, validateStats) {
     unique_ptr<PlanStageStats> allStats(mock->getStats());
     ASSERT_TRUE(stats->isEOF);
 }
+
+//
+// Test that a stage without batch support is batched through work(), one unit at a time.
+//
+TEST_F(QueuedDataStageTest, workBatchFallsBackToWork) {
+    WorkingSet ws;
+    auto mock = make_unique<QueuedDataStage>(getOpCtx(), &ws);
+    ASSERT_FALSE(mock->supportsBatchedWork());
+
+    WorkingSetID first = ws.allocate();
+    WorkingSetID second = ws.allocate();
+    mock->pushBack(first);
+    mock->pushBack(PlanStage::NEED_TIME);
+    mock->pushBack(second);
+
+    // The budget runs out after the NEED_TIME.
+    std::vector<WorkingSetID> batch;
+    WorkingSetID stateId = WorkingSet::INVALID_ID;
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(&ws, 2, &batch, &stateId));
+    ASSERT_EQUALS(1U, batch.size());
+    ASSERT_EQUALS(first, batch[0]);
+
+    // The next batch ends at EOF, after the remaining result.
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::IS_EOF, mock->workBatch(&ws, 10, &batch, &stateId));
+    ASSERT_EQUALS(1U, batch.size());
+    ASSERT_EQUALS(second, batch[0]);
+
+    const CommonStats* stats = mock->getCommonStats();
+    ASSERT_EQUALS(stats->works, 4U);
+    ASSERT_EQUALS(stats->advanced, 2U);
+    ASSERT_EQUALS(stats->needTime, 1U);
+}
 }
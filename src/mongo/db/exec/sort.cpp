@@ -41,6 +41,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -68,6 +69,20 @@ bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
     return lhs.recordId < rhs.recordId;
 }
 
+int SortStage::SpillComparator::operator()(const std::pair<BSONObj, BSONObj>& lhs,
+                                           const std::pair<BSONObj, BSONObj>& rhs) const {
+    int result = lhs.first.woCompare(rhs.first, _pattern, false);
+    if (0 != result) {
+        return result;
+    }
+    // The codec writes the RecordId first, as "r", and leaves it out for members without one.
+    BSONElement lhsId = lhs.second.firstElement();
+    BSONElement rhsId = rhs.second.firstElement();
+    RecordId lhsRecordId(lhsId.fieldNameStringData() == "r" ? lhsId.numberLong() : 0);
+    RecordId rhsRecordId(rhsId.fieldNameStringData() == "r" ? rhsId.numberLong() : 0);
+    return lhsRecordId.compare(rhsRecordId);
+}
+
 SortStage::SortStage(OperationContext* opCtx,
                      const SortStageParams& params,
                      WorkingSet* ws,
@@ -79,6 +94,8 @@ SortStage::SortStage(OperationContext* opCtx,
       _limit(params.limit),
       _sorted(false),
       _resultIterator(_data.end()),
+      _sortOrdering(Ordering::make(BSONObj())),
+      _topKKeyBuilder(KeyString::Version::V1),
       _memUsage(0) {
     _children.emplace_back(child);
     incStageObj(STAGE_SORT);
@@ -86,11 +103,10 @@ SortStage::SortStage(OperationContext* opCtx,
     BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
     _sortKeyComparator = stdx::make_unique<WorkingSetComparator>(sortComparator);
 
-    // If limit > 1, we need to initialize _dataSet here to maintain ordered set of data items while
-    // fetching from the child stage.
-    if (_limit > 1) {
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        _dataSet.reset(new SortableDataItemSet(cmp));
+    // An Ordering holds at most 32 fields.
+    _topKByKeyString = sortComparator.nFields() <= 32;
+    if (_topKByKeyString) {
+        _sortOrdering = Ordering::make(sortComparator);
     }
 }
 
@@ -101,6 +117,9 @@ SortStage::~SortStage() {
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
+    if (_spillIterator) {
+        return child()->isEOF() && _sorted && !_spillIterator->more();
+    }
     return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
 }
 
@@ -119,9 +138,15 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
-    if (chkCachedMemOversize()) {
-        *out = chkMemFailureRet(_ws);
-        return PlanStage::FAILURE;
+    if (!_spillSorter && !_spillIterator) {
+        const auto memLimit = chkCachedMemLimit();
+        if (memLimit == StageMemCounter::LimitLevel::kGlobal && !_sorted &&
+            canSpillStageMemory()) {
+            startSpilling();
+        } else if (memLimit != StageMemCounter::LimitLevel::kNone) {
+            *out = chkMemFailureRet(_ws);
+            return PlanStage::FAILURE;
+        }
     }
 
     // Still reading in results to sort.
@@ -135,11 +160,12 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
             // the WorkingSet as quickly as possible to handle it.
             WorkingSetMember* member = _ws->get(id);
 
-            // Planner must put a fetch before we get here.
-            verify(member->hasObj());
+            // Planner must put a fetch before we get here, unless this is a limited sort on keys
+            // read from an index, in which case the fetch is above us.
+            verify(member->hasObj() || member->getState() == WorkingSetMember::RID_AND_IDX);
 
             // We might be sorting something that was invalidated at some point.
-            if (member->hasRecordId()) {
+            if (member->hasRecordId() && !_spillSorter) {
                 if (_wsidByRecordId.find(member->recordId) == _wsidByRecordId.end()) {
                     incCachedMemory(_dataMapItemSize);
                 }
@@ -160,10 +186,26 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
                 item.recordId = member->recordId;
             }
 
-            addToBuffer(item);
+            if (_spillSorter) {
+                addToSpillSorter(item);
+            } else {
+                if (_limit > 1) {
+                    encodeTopKKey(&item);
+                }
+                addToBuffer(item);
+            }
 
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
+            if (_spillSorter) {
+                _specificStats.spills = _spillSorter->numFiles();
+                _specificStats.spilledBytes = _spillSorter->spilledBytes();
+                globalStageMemCounters.noteSpill(STAGE_SORT, _specificStats.spilledBytes);
+                _spillIterator.reset(_spillSorter->done());
+                _sorted = true;
+                return PlanStage::NEED_TIME;
+            }
+
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
             sortBuffer();
@@ -184,6 +226,25 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
+    if (_spillIterator) {
+        verify(_spillIterator->more());
+        auto next = _spillIterator->next();
+        *out = _spillCodec.decode(next.second, _ws);
+        WorkingSetMember* member = _ws->get(*out);
+        member->addComputed(new SortKeyComputedData(next.first));
+        if (member->hasRecordId() && _invalidatedWhileSpilled.count(member->recordId)) {
+            member->recordId = RecordId();
+            _ws->transitionToOwnedObj(*out);
+        }
+        if (!_spillIterator->more()) {
+            // The sorter's buffers are released with the iterator.
+            _spillSorter.reset();
+            decCachedMemory(_spillSorterMem);
+            _spillSorterMem = 0;
+        }
+        return PlanStage::ADVANCED;
+    }
+
     verify(_resultIterator != _data.end());
     verify(_sorted);
     *out = _resultIterator->wsid;
@@ -222,6 +283,9 @@ void SortStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Invali
         _wsidByRecordId.erase(it);
         decCachedMemory(_dataMapItemSize);
         ++_specificStats.forcedFetches;
+    } else if (_spillSorter || _spillIterator) {
+        // The member may already be on disk, where it is owned but still carries the RecordId.
+        _invalidatedWhileSpilled.insert(dl);
     }
 }
 
@@ -258,10 +322,11 @@ const SpecificStats* SortStage::getSpecificStats() const {
  *                     Updates memory usage if item was replaced.
  *     sortBuffer() - Does nothing.
  * limit > 1:
- *     addToBuffer() - Does not update vector. Adds item to set.
- *                     If size of set exceeds limit, remove item from set
- *                     with lowest key. Updates memory usage accordingly.
- *     sortBuffer() - Copies items from set to vectors.
+ *     addToBuffer() - Pushes item onto the max-heap in the vector.
+ *                     Once the heap holds limit items, a new item replaces
+ *                     the top only if it sorts before it, and is dropped
+ *                     otherwise. Updates memory usage accordingly.
+ *     sortBuffer() - Turns the heap into a sorted vector.
  */
 void SortStage::addToBuffer(const SortableDataItem& item) {
     // Holds ID of working set member to be freed at end of this function.
@@ -298,40 +363,34 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
             _memUsage = member->getMemUsage();
         }
     } else {
-        // Update data item set instead of vector
-        // Limit not reached - insert and return
-        vector<SortableDataItem>::size_type limit(_limit);
-        if (_dataSet->size() < limit) {
+        const auto cmp = [this](const SortableDataItem& lhs, const SortableDataItem& rhs) {
+            return topKLess(lhs, rhs);
+        };
+        // Limit not reached - push onto the heap and return
+        if (_data.size() < _limit) {
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
-            cachedSize = item.getObjSize();
+            _data.push_back(item);
+            std::push_heap(_data.begin(), _data.end(), cmp);
             _memUsage += member->getMemUsage();
-            cachedSize += member->getMemUsage();
-            incCachedMemory(cachedSize);
+            incCachedMemory(item.getObjSize() + member->getMemUsage());
             return;
         }
-        // Limit will be exceeded - compare with item with lowest key
-        // If new item does not have a lower key value than last item,
-        // do nothing.
+        // Limit will be exceeded - compare with the worst item, at the top of the heap.
+        // If new item does not sort before it, drop the new item.
         wsidToFree = item.wsid;
-        SortableDataItemSet::const_iterator lastItemIt = --(_dataSet->end());
-        const SortableDataItem& lastItem = *lastItemIt;
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        if (cmp(item, lastItem)) {
-            _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
-            releasedSize = _ws->get(lastItem.wsid)->getMemUsage();
-            _memUsage += member->getMemUsage();
-            cachedSize = member->getMemUsage();
-            wsidToFree = lastItem.wsid;
-            // According to std::set iterator validity rules,
-            // it does not matter which of erase()/insert() happens first.
-            // Here, we choose to erase first to release potential resources
-            // used by the last item and to keep the scope of the iterator to a minimum.
-            cachedSize += item.getObjSize();
-            releasedSize -= lastItem.getObjSize();
-            _dataSet->erase(lastItemIt);
+        if (topKLess(item, _data.front())) {
+            const SortableDataItem& worst = _data.front();
+            const size_t worstMemUsage = _ws->get(worst.wsid)->getMemUsage();
+            wsidToFree = worst.wsid;
+            releasedSize = worstMemUsage + worst.getObjSize();
+
+            std::pop_heap(_data.begin(), _data.end(), cmp);
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
+            _data.back() = item;
+            std::push_heap(_data.begin(), _data.end(), cmp);
+
+            _memUsage = _memUsage - worstMemUsage + member->getMemUsage();
+            cachedSize = member->getMemUsage() + item.getObjSize();
         }
     }
 
@@ -349,6 +408,56 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
     decCachedMemory(releasedSize);
 }
 
+void SortStage::startSpilling() {
+    invariant(!_sorted);
+
+    const BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
+    _spillSorter.reset(SpillSorter::make(
+        SortOptions()
+            .Limit(_limit)
+            .ExtSortAllowed()
+            .TempDir(stageSpillTempDir())
+            .MaxMemoryUsageBytes(
+                static_cast<size_t>(internalQueryStageMemSpillBufferBytes.load())),
+        SpillComparator(sortComparator)));
+
+    std::vector<SortableDataItem> buffered;
+    buffered.swap(_data);
+    _resultIterator = _data.end();
+
+    for (const auto& item : buffered) {
+        addToSpillSorter(item);
+    }
+
+    // Everything buffered now lives in the sorter; only what it still holds in memory counts.
+    _wsidByRecordId.clear();
+    decCachedMemory(_cachedMemSize - _spillSorterMem);
+}
+
+void SortStage::addToSpillSorter(const SortableDataItem& item) {
+    WorkingSetMember* member = _ws->get(item.wsid);
+    if (member->hasRecordId()) {
+        _wsidByRecordId.erase(member->recordId);
+    }
+    if (_limit == 0) {
+        _memUsage += member->getMemUsage();
+    }
+
+    _spillSorter->add(item.sortKey, _spillCodec.encode(*member, false));
+    _ws->free(item.wsid);
+    syncSpillMemory();
+}
+
+void SortStage::syncSpillMemory() {
+    const size_t sorterMem = _spillSorter->memUsed();
+    if (sorterMem > _spillSorterMem) {
+        incCachedMemory(sorterMem - _spillSorterMem);
+    } else {
+        decCachedMemory(_spillSorterMem - sorterMem);
+    }
+    _spillSorterMem = sorterMem;
+}
+
 void SortStage::sortBuffer() {
     if (_limit == 0) {
         const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -357,13 +466,31 @@ void SortStage::sortBuffer() {
         // Buffer contains either 0 or 1 item so it is already in a sorted state.
         return;
     } else {
-        // Set already contains items in sorted order, so we simply copy the items
-        // from the set to the vector.
-        // Release the memory for the set after the copy.
-        vector<SortableDataItem> newData(_dataSet->begin(), _dataSet->end());
-        _data.swap(newData);
-        _dataSet.reset();
+        std::sort_heap(_data.begin(),
+                       _data.end(),
+                       [this](const SortableDataItem& lhs, const SortableDataItem& rhs) {
+                           return topKLess(lhs, rhs);
+                       });
+    }
+}
+
+void SortStage::encodeTopKKey(SortableDataItem* item) {
+    if (!_topKByKeyString) {
+        return;
+    }
+
+    try {
+        _topKKeyBuilder.resetToKey(item->sortKey, _sortOrdering, item->recordId);
+    } catch (const ExceptionFor<ErrorCodes::KeyTooLong>&) {
+        // Keys already in the heap keep their encodings, so memory accounting stays balanced,
+        // but they are no longer looked at.
+        _topKByKeyString = false;
+        return;
     }
+    item->topKKey.assign(_topKKeyBuilder.getBuffer(), _topKKeyBuilder.getSize());
 }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -28,17 +28,22 @@
 
 #pragma once
 
-#include <set>
+#include <string>
 #include <vector>
 
+#include "mongo/bson/ordering.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/sort_key_generator.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_spill.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/stdx/unordered_map.h"
+#include "mongo/stdx/unordered_set.h"
 
 namespace mongo {
 
@@ -62,6 +67,15 @@ public:
 /**
  * Sorts the input received from the child according to the sort pattern provided.
  *
+ * If the global stage memory limit is reached while reading input and canSpillStageMemory(),
+ * the buffered members and all further input are encoded and handed to an external Sorter
+ * instead of failing the query. Results are then rebuilt from the Sorter's output.
+ *
+ * With a limit greater than one, only the best 'limit' members are kept, in a bounded heap
+ * ordered on KeyString encodings of (sort key, RecordId). When the planner can read the sort keys
+ * from index keys, the inputs carry no document and the fetch happens above this stage, so only
+ * the members returned are ever fetched.
+ *
  * Preconditions:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
  *   field.
@@ -123,11 +137,14 @@ private:
         // RecordId to break sortKey ties.
         // See sorta.js.
         RecordId recordId;
+        // KeyString encoding of (sortKey, recordId), only built for the top-k heap.
+        std::string topKKey;
         size_t getObjSize() const {
-            return recordId.memUsageForSorter() + sortKey.objsize() + sizeof(wsid);
+            return recordId.memUsageForSorter() + sortKey.objsize() + sizeof(wsid) +
+                topKKey.size();
         };
     };
-    // Comparison object for data buffers (vector and set). Items are compared on (sortKey, loc).
+    // Comparison object for data buffers. Items are compared on (sortKey, loc).
     // This is also how the items are ordered in the indices. Keys are compared using
     // BSONObj::woCompare() with RecordId as a tie-breaker.
     //
@@ -142,7 +159,7 @@ private:
     };
 
     /**
-     * Inserts one item into data buffer (vector or set).
+     * Inserts one item into data buffer.
      * If limit is exceeded, remove item with lowest key.
      */
     void addToBuffer(const SortableDataItem& item);
@@ -150,11 +167,40 @@ private:
     /**
      * Sorts data buffer.
      * Assumes no more items will be added to buffer.
-     * If data is stored in set, copy set
-     * contents to vector and clear set.
      */
     void sortBuffer();
 
+    /**
+     * Fills in item->topKKey. If the sort key is too large to encode, the heap falls back to
+     * WorkingSetComparator for good and the key is left empty.
+     */
+    void encodeTopKKey(SortableDataItem* item);
+
+    // Orders the top-k heap. Both ways of comparing give the same order.
+    bool topKLess(const SortableDataItem& lhs, const SortableDataItem& rhs) const {
+        return _topKByKeyString ? lhs.topKKey < rhs.topKKey : (*_sortKeyComparator)(lhs, rhs);
+    }
+
+    /**
+     * Moves everything buffered so far into _spillSorter. From then on addToBuffer() is not used
+     * and input goes straight to _spillSorter.
+     */
+    void startSpilling();
+    void addToSpillSorter(const SortableDataItem& item);
+    void syncSpillMemory();
+
+    // Sorter comparator for spilled members: sort key, then RecordId, like WorkingSetComparator.
+    class SpillComparator {
+    public:
+        explicit SpillComparator(BSONObj pattern) : _pattern(std::move(pattern)) {}
+        int operator()(const std::pair<BSONObj, BSONObj>& lhs,
+                       const std::pair<BSONObj, BSONObj>& rhs) const;
+
+    private:
+        BSONObj _pattern;
+    };
+    using SpillSorter = Sorter<BSONObj, BSONObj>;
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -163,12 +209,14 @@ private:
     // _data will contain sorted data when all data is gathered
     // and sorted.
     // When _limit is greater than 1 and not all data has been gathered from child stage,
-    // _dataSet is used instead to maintain an ordered set of the incomplete data set.
-    // When the data set is complete, we copy the items from _dataSet to _data which will
-    // be used to provide the results of this stage through _resultIterator.
+    // _data is a max-heap (by topKLess()) of the best _limit items so far, whose front is the
+    // next item to evict.
     std::vector<SortableDataItem> _data;
-    typedef std::set<SortableDataItem, WorkingSetComparator> SortableDataItemSet;
-    std::unique_ptr<SortableDataItemSet> _dataSet;
+
+    // Top-k heap ordering. Encoded keys compare with memcmp, which is cheaper than woCompare().
+    Ordering _sortOrdering;
+    KeyString _topKKeyBuilder;
+    bool _topKByKeyString;
 
     // Iterates through _data post-sort returning it.
     std::vector<SortableDataItem>::iterator _resultIterator;
@@ -182,6 +230,21 @@ private:
 
     // The usage in bytes of all buffered data that we're sorting.
     size_t _memUsage;
+
+    //
+    // Spilling. Only used once the global stage memory limit has been hit.
+    //
+
+    WorkingSetSpillCodec _spillCodec;
+    std::unique_ptr<SpillSorter> _spillSorter;
+    std::unique_ptr<SpillSorter::Iterator> _spillIterator;
+
+    // Memory held by _spillSorter as last charged with incCachedMemory().
+    size_t _spillSorterMem = 0;
+
+    // RecordIds invalidated after their members were spilled. Spilled members are returned
+    // without a RecordId if they appear here, as fetchAndInvalidateRecordId() would have left them.
+    stdx::unordered_set<RecordId, RecordId::Hasher> _invalidatedWhileSpilled;
 };
 
 }  // namespace mongo
@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/stage_spill_file.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/encryption_hooks.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/destructor_guard.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+AtomicUInt32 spillFileCounter;
+
+}  // namespace
+
+bool canWriteStageSpillFiles() {
+    return !storageGlobalParams.readOnly &&
+        !EncryptionHooks::get(getGlobalServiceContext())->enabled();
+}
+
+bool canSpillStageMemory() {
+    return internalQueryStageMemSpillOnGlobalLimit.load() && canWriteStageSpillFiles();
+}
+
+std::string stageSpillTempDir() {
+    return storageGlobalParams.dbpath + "/_tmp";
+}
+
+StageSpillFile::StageSpillFile(const std::string& tempDir) {
+    _fileName = str::stream() << tempDir << "/stagespill." << spillFileCounter.fetchAndAdd(1);
+
+    boost::filesystem::create_directories(tempDir);
+    _file.open(_fileName.c_str(),
+               std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "error opening stage spill file \"" << _fileName << "\": "
+                          << errnoWithDescription(),
+            _file.good());
+}
+
+StageSpillFile::~StageSpillFile() {
+    _file.close();
+    DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName);)
+}
+
+StageSpillFile::Location StageSpillFile::append(const BSONObj& obj) {
+    const Location location{static_cast<int64_t>(_bytesWritten), obj.objsize()};
+    _file.seekp(location.offset);
+    _file.write(obj.objdata(), obj.objsize());
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "error writing to stage spill file \"" << _fileName << "\": "
+                          << errnoWithDescription(),
+            _file.good());
+    _bytesWritten += obj.objsize();
+    return location;
+}
+
+BSONObj StageSpillFile::read(const Location& location) {
+    // The previous append may still be buffered, so seekg must go through the same stream.
+    SharedBuffer buffer = SharedBuffer::allocate(location.size);
+    _file.seekg(location.offset);
+    _file.read(buffer.get(), location.size);
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "error reading stage spill file \"" << _fileName << "\": "
+                          << errnoWithDescription(),
+            _file.good());
+    return BSONObj(std::move(buffer));
+}
+
+}  // namespace mongo
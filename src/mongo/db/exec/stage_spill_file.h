@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+/**
+ * Returns true if stage spill files may be written: the node is writable, and temporary data does
+ * not have to be encrypted.
+ */
+bool canWriteStageSpillFiles();
+
+/**
+ * Returns true if a stage that has hit the global stage memory limit may spill to disk instead of
+ * failing: internalQueryStageMemSpillOnGlobalLimit is on, the node is writable, and temporary
+ * data does not have to be encrypted.
+ */
+bool canSpillStageMemory();
+
+/**
+ * The directory stage spill files are written to. It is cleared on startup.
+ */
+std::string stageSpillTempDir();
+
+/**
+ * An append-only temporary file of BSON objects with random-access reads. The file is removed
+ * when this object is destroyed. File errors are thrown as FileStreamFailed.
+ */
+class StageSpillFile {
+    MONGO_DISALLOW_COPYING(StageSpillFile);
+
+public:
+    struct Location {
+        int64_t offset;
+        int32_t size;
+    };
+
+    explicit StageSpillFile(const std::string& tempDir);
+    ~StageSpillFile();
+
+    Location append(const BSONObj& obj);
+
+    /**
+     * Returns an owned copy of the object at "location".
+     */
+    BSONObj read(const Location& location);
+
+    uint64_t bytesWritten() const {
+        return _bytesWritten;
+    }
+
+private:
+    std::string _fileName;
+    std::fstream _file;
+    uint64_t _bytesWritten = 0;
+};
+
+}  // namespace mongo
@@ -39,26 +39,50 @@ using std::string;
 
 namespace dps = ::mongo::dotted_path_support;
 
+namespace {
+
+// Members per chunk. Freed members are reused first, so a streaming plan that only holds a few
+// members at a time never needs more than the first chunk.
+const size_t kFirstChunkSize = 4;
+const size_t kMaxChunkSize = 1024;
+
+size_t chunkSize(size_t chunkIndex) {
+    size_t size = kFirstChunkSize;
+    for (size_t i = 0; i < chunkIndex && size < kMaxChunkSize; ++i) {
+        size *= 2;
+    }
+    return size;
+}
+
+}  // namespace
+
 WorkingSet::MemberHolder::MemberHolder() : member(NULL) {}
 WorkingSet::MemberHolder::~MemberHolder() {}
 
-WorkingSet::WorkingSet() : _freeList(INVALID_ID) {}
+WorkingSet::WorkingSet() : _freeList(INVALID_ID), _currentChunk(0), _currentChunkUsed(0) {}
 
-WorkingSet::~WorkingSet() {
-    for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
+WorkingSet::~WorkingSet() {}
+
+WorkingSetMember* WorkingSet::carveMember() {
+    if (_currentChunk < _chunks.size() && _currentChunkUsed == chunkSize(_currentChunk)) {
+        ++_currentChunk;
+        _currentChunkUsed = 0;
+    }
+    if (_currentChunk == _chunks.size()) {
+        _chunks.emplace_back(new WorkingSetMember[chunkSize(_currentChunk)]);
     }
+    return &_chunks[_currentChunk][_currentChunkUsed++];
 }
 
 WorkingSetID WorkingSet::allocate() {
     if (_freeList == INVALID_ID) {
-        // The free list is empty so we need to make a single new WSM to return. This relies on
+        // The free list is empty so we need to hand out a new WSM. This relies on
         // vector::resize being amortized O(1) for efficient allocation. Note that the free list
         // remains empty until something is returned by a call to free().
         WorkingSetID id = _data.size();
         _data.resize(_data.size() + 1);
         _data.back().nextFreeOrSelf = id;
-        _data.back().member = new WorkingSetMember();
+        _data.back().member = carveMember();
         return id;
     }
 
@@ -96,10 +120,14 @@ bool WorkingSet::isFlagged(WorkingSetID id) const {
 }
 
 void WorkingSet::clear() {
+    // Every member handed out so far has an entry in '_data', so this resets all of them and they
+    // can be carved again from the first chunk.
     for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
+        _data[i].member->reset();
     }
     _data.clear();
+    _currentChunk = 0;
+    _currentChunkUsed = 0;
 
     // Since working set is now empty, the free list pointer should
     // point to nothing.
@@ -109,6 +137,25 @@ void WorkingSet::clear() {
     _yieldSensitiveIds.clear();
 }
 
+WorkingSetID WorkingSet::moveFrom(WorkingSet* other, WorkingSetID id) {
+    invariant(other != this);
+    const bool flagged = other->isFlagged(id);
+
+    // Members belong to their working set's chunks, so the data moves rather than the member.
+    // The other slot gets our cleared member, which free() leaves cleared.
+    WorkingSetID newId = allocate();
+    _data[newId].member->swap(*other->_data[id].member);
+    other->free(id);
+
+    if (flagged) {
+        _flagged.insert(newId);
+    }
+    if (WorkingSetMember::RID_AND_IDX == get(newId)->getState()) {
+        _yieldSensitiveIds.push_back(newId);
+    }
+    return newId;
+}
+
 void WorkingSet::transitionToRecordIdAndIdx(WorkingSetID id) {
     WorkingSetMember* member = get(id);
     member->_state = WorkingSetMember::RID_AND_IDX;
@@ -150,6 +197,26 @@ void WorkingSetMember::clear() {
     _state = WorkingSetMember::INVALID;
 }
 
+void WorkingSetMember::swap(WorkingSetMember& other) {
+    using std::swap;
+    swap(recordId, other.recordId);
+    swap(obj, other.obj);
+    keyData.swap(other.keyData);
+    swap(isSuspicious, other.isSuspicious);
+    swap(_state, other._state);
+    for (size_t i = 0; i < WSM_COMPUTED_NUM_TYPES; i++) {
+        _computed[i].swap(other._computed[i]);
+    }
+    _fetcher.swap(other._fetcher);
+}
+
+void WorkingSetMember::reset() {
+    clear();
+    recordId = RecordId();
+    isSuspicious = false;
+    _fetcher.reset();
+}
+
 WorkingSetMember::MemberState WorkingSetMember::getState() const {
     return _state;
 }
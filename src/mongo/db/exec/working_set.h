@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -112,10 +113,17 @@ public:
     const stdx::unordered_set<WorkingSetID>& getFlagged() const;
 
     /**
-     * Removes and deallocates all members of this working set.
+     * Removes all members of this working set. The memory backing them is kept and reused by
+     * subsequent calls to allocate().
      */
     void clear();
 
+    /**
+     * Moves member 'id' of 'other' into a newly allocated member of this working set, which is
+     * returned, and frees 'id' in 'other'. The member keeps its state and its flag for review.
+     */
+    WorkingSetID moveFrom(WorkingSet* other, WorkingSetID id);
+
     //
     // WorkingSetMember state transitions
     //
@@ -146,10 +154,15 @@ private:
         // Free list link if freed. Points to self if in use.
         WorkingSetID nextFreeOrSelf;
 
-        // Owning pointer
+        // Points into one of '_chunks'.
         WorkingSetMember* member;
     };
 
+    /**
+     * Returns an unused member from the current chunk, starting a new chunk if it is full.
+     */
+    WorkingSetMember* carveMember();
+
     // All WorkingSetIDs are indexes into this, except for INVALID_ID.
     // Elements are added to _freeList rather than removed when freed.
     std::vector<MemberHolder> _data;
@@ -164,6 +177,15 @@ private:
 
     // Contains ids of WSMs that may need to be adjusted when we next yield.
     std::vector<WorkingSetID> _yieldSensitiveIds;
+
+    // Backing store of all members. Chunk sizes double up to a limit, so that a query makes a
+    // handful of allocations rather than one per member, and members allocated one after another
+    // sit next to each other in memory. Chunks are only released by the destructor.
+    std::vector<std::unique_ptr<WorkingSetMember[]>> _chunks;
+
+    // The chunk new members are carved from, and how many of its members are already taken.
+    size_t _currentChunk;
+    size_t _currentChunkUsed;
 };
 
 /**
@@ -333,6 +355,17 @@ public:
 private:
     friend class WorkingSet;
 
+    /**
+     * Exchanges all data, including state, with 'other'.
+     */
+    void swap(WorkingSetMember& other);
+
+    /**
+     * Like clear(), but also forgets what clear() keeps, so that the member can be handed out
+     * again as if newly constructed.
+     */
+    void reset();
+
     MemberState _state = WorkingSetMember::INVALID;
 
     std::unique_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
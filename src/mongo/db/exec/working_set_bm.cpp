@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+namespace {
+
+const BSONObj kKeyPattern = BSON("a" << 1);
+const BSONObj kKey = BSON("" << 1);
+const BSONObj kDoc = BSON("_id" << 1 << "a" << 1 << "b" << std::string(64, 'x'));
+
+/**
+ * Hands out 'numMembers' members the way an index scan feeding a fetch does: each one gets a
+ * RecordId and an index key, then a document, and is freed once returned.
+ */
+void produceMembers(WorkingSet* ws, int numMembers) {
+    for (int i = 0; i < numMembers; ++i) {
+        WorkingSetID id = ws->allocate();
+        WorkingSetMember* member = ws->get(id);
+        member->recordId = RecordId(i + 1);
+        member->keyData.push_back(IndexKeyDatum(kKeyPattern, kKey, nullptr));
+        ws->transitionToRecordIdAndIdx(id);
+
+        member->keyData.clear();
+        member->obj = {SnapshotId(), kDoc};
+        ws->transitionToRecordIdAndObj(id);
+        benchmark::DoNotOptimize(member->obj.value().objdata());
+        ws->free(id);
+    }
+    benchmark::DoNotOptimize(ws->getAndClearYieldSensitiveIds());
+}
+
+/**
+ * Allocates 'numMembers' members that are all live at once, as a blocking stage such as a sort
+ * holds them, then frees them.
+ */
+void holdMembers(WorkingSet* ws, int numMembers) {
+    std::vector<WorkingSetID> ids;
+    ids.reserve(numMembers);
+    for (int i = 0; i < numMembers; ++i) {
+        WorkingSetID id = ws->allocate();
+        WorkingSetMember* member = ws->get(id);
+        member->recordId = RecordId(i + 1);
+        member->obj = {SnapshotId(), kDoc};
+        ws->transitionToRecordIdAndObj(id);
+        ids.push_back(id);
+    }
+    for (auto id : ids) {
+        ws->free(id);
+    }
+}
+
+// A short find: a new WorkingSet per query.
+void BM_WorkingSetShortQuery(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        WorkingSet ws;
+        produceMembers(&ws, state.range(0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// A query whose results are all live at once, with a new WorkingSet per query.
+void BM_WorkingSetHoldAll(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        WorkingSet ws;
+        holdMembers(&ws, state.range(0));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// The same, reusing one WorkingSet that is cleared between queries.
+void BM_WorkingSetHoldAllReused(benchmark::State& state) {
+    WorkingSet ws;
+    for (auto keepRunning : state) {
+        holdMembers(&ws, state.range(0));
+        ws.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_WorkingSetShortQuery)->Arg(1)->Arg(10)->Arg(101);
+BENCHMARK(BM_WorkingSetHoldAll)->Arg(10)->Arg(101)->Arg(10000);
+BENCHMARK(BM_WorkingSetHoldAllReused)->Arg(10)->Arg(101)->Arg(10000);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/working_set_spill.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// Field names of the encoded member. Kept short since every spilled member carries them.
+const char kRecordIdField[] = "r";
+const char kObjField[] = "o";
+const char kKeyDataField[] = "k";
+const char kIndexOrdinalField[] = "i";
+const char kKeyField[] = "d";
+const char kSuspiciousField[] = "x";
+const char kTextScoreField[] = "ts";
+const char kGeoDistanceField[] = "gd";
+const char kIndexKeyField[] = "ik";
+const char kGeoNearPointField[] = "gp";
+const char kSortKeyField[] = "sk";
+
+}  // namespace
+
+//
+// WorkingSetSpillCodec
+//
+
+size_t WorkingSetSpillCodec::_indexOrdinal(const IndexKeyDatum& datum) {
+    for (size_t i = 0; i < _indexes.size(); ++i) {
+        if (_indexes[i].index == datum.index &&
+            _indexes[i].keyPattern.objdata() == datum.indexKeyPattern.objdata()) {
+            return i;
+        }
+    }
+    _indexes.push_back({datum.indexKeyPattern, datum.index});
+    return _indexes.size() - 1;
+}
+
+BSONObj WorkingSetSpillCodec::encode(const WorkingSetMember& member, bool includeSortKey) {
+    BSONObjBuilder bob;
+    if (member.hasRecordId()) {
+        bob.append(kRecordIdField, static_cast<long long>(member.recordId.repr()));
+    }
+    if (member.hasObj()) {
+        bob.append(kObjField, member.obj.value());
+    }
+    if (!member.keyData.empty()) {
+        BSONArrayBuilder keys(bob.subarrayStart(kKeyDataField));
+        for (const auto& datum : member.keyData) {
+            BSONObjBuilder key(keys.subobjStart());
+            key.append(kIndexOrdinalField, static_cast<int>(_indexOrdinal(datum)));
+            key.append(kKeyField, datum.keyData);
+        }
+    }
+    if (member.isSuspicious) {
+        bob.append(kSuspiciousField, true);
+    }
+
+    if (member.hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+        bob.append(kTextScoreField,
+                   static_cast<const TextScoreComputedData*>(
+                       member.getComputed(WSM_COMPUTED_TEXT_SCORE))
+                       ->getScore());
+    }
+    if (member.hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+        bob.append(kGeoDistanceField,
+                   static_cast<const GeoDistanceComputedData*>(
+                       member.getComputed(WSM_COMPUTED_GEO_DISTANCE))
+                       ->getDist());
+    }
+    if (member.hasComputed(WSM_INDEX_KEY)) {
+        bob.append(kIndexKeyField,
+                   static_cast<const IndexKeyComputedData*>(member.getComputed(WSM_INDEX_KEY))
+                       ->getKey());
+    }
+    if (member.hasComputed(WSM_GEO_NEAR_POINT)) {
+        bob.append(kGeoNearPointField,
+                   static_cast<const GeoNearPointComputedData*>(
+                       member.getComputed(WSM_GEO_NEAR_POINT))
+                       ->getPoint());
+    }
+    if (includeSortKey && member.hasComputed(WSM_SORT_KEY)) {
+        bob.append(
+            kSortKeyField,
+            static_cast<const SortKeyComputedData*>(member.getComputed(WSM_SORT_KEY))->getSortKey());
+    }
+    return bob.obj();
+}
+
+WorkingSetID WorkingSetSpillCodec::decode(const BSONObj& encoded, WorkingSet* ws) const {
+    WorkingSetID id = ws->allocate();
+    WorkingSetMember* member = ws->get(id);
+
+    BSONElement recordIdElt = encoded[kRecordIdField];
+    BSONElement objElt = encoded[kObjField];
+    if (!recordIdElt.eoo()) {
+        member->recordId = RecordId(recordIdElt.numberLong());
+    }
+    if (!objElt.eoo()) {
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), objElt.Obj().getOwned());
+    }
+    if (BSONElement keysElt = encoded[kKeyDataField]) {
+        for (auto&& keyElt : keysElt.Array()) {
+            const IndexRef& ref = _indexes[keyElt[kIndexOrdinalField].numberInt()];
+            member->keyData.push_back(
+                IndexKeyDatum(ref.keyPattern, keyElt[kKeyField].Obj().getOwned(), ref.index));
+        }
+    }
+    member->isSuspicious = encoded[kSuspiciousField].trueValue();
+
+    if (!recordIdElt.eoo() && !objElt.eoo()) {
+        ws->transitionToRecordIdAndObj(id);
+    } else if (!recordIdElt.eoo()) {
+        ws->transitionToRecordIdAndIdx(id);
+    } else {
+        ws->transitionToOwnedObj(id);
+    }
+
+    if (BSONElement elt = encoded[kTextScoreField]) {
+        member->addComputed(new TextScoreComputedData(elt.numberDouble()));
+    }
+    if (BSONElement elt = encoded[kGeoDistanceField]) {
+        member->addComputed(new GeoDistanceComputedData(elt.numberDouble()));
+    }
+    if (BSONElement elt = encoded[kIndexKeyField]) {
+        member->addComputed(new IndexKeyComputedData(elt.Obj()));
+    }
+    if (BSONElement elt = encoded[kGeoNearPointField]) {
+        member->addComputed(new GeoNearPointComputedData(elt.Obj()));
+    }
+    if (BSONElement elt = encoded[kSortKeyField]) {
+        member->addComputed(new SortKeyComputedData(elt.Obj()));
+    }
+    return id;
+}
+
+}  // namespace mongo
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/stage_spill_file.h"
+#include "mongo/db/exec/working_set.h"
+
+namespace mongo {
+
+class IndexAccessMethod;
+
+/**
+ * Converts WorkingSetMembers to owned BSON and back, so that a blocking stage can move the
+ * members it buffers out of memory.
+ *
+ * The encoding is only meaningful to the codec that produced it, in the same process: index key
+ * data refers to its index by an ordinal into a table held by the codec. The snapshot id of the
+ * object is not kept, so a decoded RID_AND_OBJ member is refetched by anything that checks it.
+ */
+class WorkingSetSpillCodec {
+    MONGO_DISALLOW_COPYING(WorkingSetSpillCodec);
+
+public:
+    WorkingSetSpillCodec() = default;
+
+    /**
+     * Encodes "member". The sort key is left out when "includeSortKey" is false, for callers that
+     * keep it separately.
+     */
+    BSONObj encode(const WorkingSetMember& member, bool includeSortKey = true);
+
+    /**
+     * Allocates a member in "ws" holding the data encoded in "encoded" and returns its id.
+     */
+    WorkingSetID decode(const BSONObj& encoded, WorkingSet* ws) const;
+
+private:
+    struct IndexRef {
+        BSONObj keyPattern;
+        const IndexAccessMethod* index;
+    };
+
+    size_t _indexOrdinal(const IndexKeyDatum& datum);
+
+    std::vector<IndexRef> _indexes;
+};
+
+}  // namespace mongo
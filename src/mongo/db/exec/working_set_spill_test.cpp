@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/working_set_spill.h"
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(WorkingSetSpillCodecTest, RoundTripsRecordIdAndObj) {
+    WorkingSet ws;
+    WorkingSetSpillCodec codec;
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->recordId = RecordId(42);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), fromjson("{a: 1, b: 'x'}"));
+    ws.transitionToRecordIdAndObj(id);
+    member->addComputed(new SortKeyComputedData(BSON("" << 1)));
+    member->addComputed(new TextScoreComputedData(2.5));
+
+    BSONObj encoded = codec.encode(*member);
+    ws.free(id);
+
+    WorkingSetMember* decoded = ws.get(codec.decode(encoded, &ws));
+    ASSERT_EQ(WorkingSetMember::RID_AND_OBJ, decoded->getState());
+    ASSERT_EQ(RecordId(42), decoded->recordId);
+    ASSERT_BSONOBJ_EQ(fromjson("{a: 1, b: 'x'}"), decoded->obj.value());
+    ASSERT_TRUE(decoded->obj.value().isOwned());
+    ASSERT_BSONOBJ_EQ(BSON("" << 1),
+                      static_cast<const SortKeyComputedData*>(decoded->getComputed(WSM_SORT_KEY))
+                          ->getSortKey());
+    ASSERT_EQ(2.5,
+              static_cast<const TextScoreComputedData*>(
+                  decoded->getComputed(WSM_COMPUTED_TEXT_SCORE))
+                  ->getScore());
+}
+
+TEST(WorkingSetSpillCodecTest, LeavesOutSortKeyOnRequest) {
+    WorkingSet ws;
+    WorkingSetSpillCodec codec;
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << 1));
+    ws.transitionToOwnedObj(id);
+    member->addComputed(new SortKeyComputedData(BSON("" << 1)));
+
+    WorkingSetMember* decoded = ws.get(codec.decode(codec.encode(*member, false), &ws));
+    ASSERT_EQ(WorkingSetMember::OWNED_OBJ, decoded->getState());
+    ASSERT_FALSE(decoded->hasComputed(WSM_SORT_KEY));
+}
+
+TEST(WorkingSetSpillCodecTest, RoundTripsIndexKeys) {
+    WorkingSet ws;
+    WorkingSetSpillCodec codec;
+    BSONObj keyPatternA = BSON("a" << 1);
+    BSONObj keyPatternB = BSON("b" << 1);
+
+    WorkingSetID id = ws.allocate();
+    WorkingSetMember* member = ws.get(id);
+    member->recordId = RecordId(7);
+    member->keyData.push_back(IndexKeyDatum(keyPatternA, BSON("" << 3), nullptr));
+    member->keyData.push_back(IndexKeyDatum(keyPatternB, BSON("" << 4), nullptr));
+    ws.transitionToRecordIdAndIdx(id);
+
+    WorkingSetMember* decoded = ws.get(codec.decode(codec.encode(*member), &ws));
+    ASSERT_EQ(WorkingSetMember::RID_AND_IDX, decoded->getState());
+    ASSERT_EQ(RecordId(7), decoded->recordId);
+    ASSERT_EQ(2U, decoded->keyData.size());
+    ASSERT_BSONOBJ_EQ(keyPatternA, decoded->keyData[0].indexKeyPattern);
+    ASSERT_BSONOBJ_EQ(BSON("" << 3), decoded->keyData[0].keyData);
+    ASSERT_BSONOBJ_EQ(keyPatternB, decoded->keyData[1].indexKeyPattern);
+    ASSERT_BSONOBJ_EQ(BSON("" << 4), decoded->keyData[1].keyData);
+}
+
+TEST(StageSpillFileTest, ReadsBackAppendedObjects) {
+    unittest::TempDir tempDir("stage_spill_file_test");
+    StageSpillFile file(tempDir.path());
+
+    auto first = file.append(BSON("a" << 1));
+    auto second = file.append(BSON("b" << std::string(100, 'x')));
+    auto third = file.append(BSON("c" << 3));
+
+    ASSERT_EQ(static_cast<uint64_t>(BSON("a" << 1).objsize() +
+                                    BSON("b" << std::string(100, 'x')).objsize() +
+                                    BSON("c" << 3).objsize()),
+              file.bytesWritten());
+    ASSERT_BSONOBJ_EQ(BSON("b" << std::string(100, 'x')), file.read(second));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1), file.read(first));
+
+    // Reads and appends may interleave.
+    auto fourth = file.append(BSON("d" << 4));
+    ASSERT_BSONOBJ_EQ(BSON("c" << 3), file.read(third));
+    ASSERT_BSONOBJ_EQ(BSON("d" << 4), file.read(fourth));
+}
+
+}  // namespace
+}  // namespace mongo
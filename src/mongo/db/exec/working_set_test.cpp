@@ -154,4 +154,54 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST_F(WorkingSetFixture, moveFromOtherWorkingSet) {
+    member->recordId = RecordId(42);
+    member->obj = {SnapshotId(), BSON("x" << 1)};
+    ws->transitionToOwnedObj(id);
+
+    WorkingSet other;
+    WorkingSetID otherId = other.moveFrom(ws.get(), id);
+    WorkingSetMember* moved = other.get(otherId);
+    ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, moved->getState());
+    ASSERT_EQUALS(RecordId(42), moved->recordId);
+    ASSERT_BSONOBJ_EQ(BSON("x" << 1), moved->obj.value());
+
+    // The source member was freed and is reused cleared.
+    ASSERT_TRUE(ws->isFree(id));
+    ASSERT_EQUALS(id, ws->allocate());
+    ASSERT_EQUALS(WorkingSetMember::INVALID, ws->get(id)->getState());
+}
+
+TEST_F(WorkingSetFixture, membersStayPutAcrossChunks) {
+    // Enough members to fill several chunks.
+    std::vector<std::pair<WorkingSetID, WorkingSetMember*>> members{{id, member}};
+    for (int i = 1; i < 5000; ++i) {
+        WorkingSetID newId = ws->allocate();
+        WorkingSetMember* newMember = ws->get(newId);
+        newMember->recordId = RecordId(i);
+        members.emplace_back(newId, newMember);
+    }
+    for (int i = 1; i < 5000; ++i) {
+        ASSERT_EQUALS(members[i].second, ws->get(members[i].first));
+        ASSERT_EQUALS(RecordId(i), members[i].second->recordId);
+    }
+}
+
+TEST_F(WorkingSetFixture, clearReusesMembersAsNew) {
+    member->recordId = RecordId(42);
+    member->obj = {SnapshotId(), BSON("x" << 1)};
+    member->isSuspicious = true;
+    ws->transitionToOwnedObj(id);
+
+    ws->clear();
+
+    WorkingSetID newId = ws->allocate();
+    WorkingSetMember* newMember = ws->get(newId);
+    ASSERT_EQUALS(member, newMember);
+    ASSERT_EQUALS(WorkingSetMember::INVALID, newMember->getState());
+    ASSERT_EQUALS(RecordId(), newMember->recordId);
+    ASSERT_FALSE(newMember->isSuspicious);
+    ASSERT_TRUE(newMember->keyData.empty());
+}
+
 }  // namespace
@@ -53,6 +53,8 @@
 #include "mongo/db/auth/security_key.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/logger/async_appender_stats.h"
+#include "mongo/logger/audit_event_owned.h"
 #include "mongo/logger/audit_event_utf8_encoder.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/logger.h"
@@ -228,8 +230,11 @@ MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
     using logger::AuditEventEphemeral;
     using logger::AuditEventJSONEncoder;
     using logger::AuditEventHWDDSEncoder;
+    using logger::AuditEventBSONEncoder;
     using logger::AuditLogDomain;
     using logger::RotatableFileAsyncAppender;
+    using logger::AsyncOverflowPolicy;
+    using logger::Encoder;
 
     // Hook up this global into our logging encoder
     MessageEventDetailsEncoder::setMaxLogSizeKBSource(maxLogSizeKB);
@@ -351,15 +356,34 @@ MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
             return auditWriter.getStatus();
         }
 
-        manager->getGlobalAuditDomain()->clearAppenders();
+        Encoder<AuditEventEphemeral>* auditEncoder;
         if (serverGlobalParams.auditLogFormat == "JSON") {
+            auditEncoder = new AuditEventJSONEncoder;
+        } else if (serverGlobalParams.auditLogFormat == "BSON") {
+            auditEncoder = new AuditEventBSONEncoder;
+        } else {
+            auditEncoder = new AuditEventHWDDSEncoder;
+        }
+
+        manager->getGlobalAuditDomain()->clearAppenders();
+        if (serverGlobalParams.auditLogAsync) {
+            AsyncOverflowPolicy overflowPolicy = AsyncOverflowPolicy::kBlock;
+            if (serverGlobalParams.auditLogAsyncOverflowPolicy == "drop") {
+                overflowPolicy = AsyncOverflowPolicy::kDrop;
+            } else if (serverGlobalParams.auditLogAsyncOverflowPolicy == "spill") {
+                overflowPolicy = AsyncOverflowPolicy::kSpill;
+            }
             manager->getGlobalAuditDomain()->attachAppender(
                 AuditLogDomain::AppenderAutoPtr(new RotatableFileAsyncAppender<AuditEventEphemeral>(
-                    new AuditEventJSONEncoder, auditWriter.getValue())));
+                    auditEncoder,
+                    auditWriter.getValue(),
+                    serverGlobalParams.auditLogAsyncBufferSize,
+                    overflowPolicy,
+                    logger::globalAuditAsyncAppenderStats())));
         } else {
             manager->getGlobalAuditDomain()->attachAppender(
                 AuditLogDomain::AppenderAutoPtr(new RotatableFileAsyncAppender<AuditEventEphemeral>(
-                    new AuditEventHWDDSEncoder, auditWriter.getValue())));
+                    auditEncoder, auditWriter.getValue())));
         }
     } else {
         logger::globalLogManager()
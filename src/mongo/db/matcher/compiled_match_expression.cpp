@@ -0,0 +1,263 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * A rough relative cost of evaluating 'expr' against a document through the expression tree.
+ */
+int evaluationCost(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO:
+        case MatchExpression::GEO_NEAR:
+            return 3;
+        case MatchExpression::REGEX:
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+            return 1;
+        default:
+            break;
+    }
+    if (MatchExpression::MatchCategory::kLeaf == expr->getCategory() &&
+        expr->path().find('.') == std::string::npos) {
+        return 0;
+    }
+    return 2;
+}
+
+template <typename T>
+int compareValues(T lhs, T rhs) {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+bool satisfies(MatchExpression::MatchType op, int cmp) {
+    switch (op) {
+        case MatchExpression::LT:
+            return cmp < 0;
+        case MatchExpression::LTE:
+            return cmp <= 0;
+        case MatchExpression::EQ:
+            return cmp == 0;
+        case MatchExpression::GT:
+            return cmp > 0;
+        case MatchExpression::GTE:
+            return cmp >= 0;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+    const MatchExpression* expr) {
+    std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression());
+
+    // Flatten nested $ands into one conjunction.
+    std::vector<const MatchExpression*> pending{expr};
+    std::vector<const MatchExpression*> conjuncts;
+    while (!pending.empty()) {
+        const MatchExpression* next = pending.back();
+        pending.pop_back();
+        if (MatchExpression::AND == next->matchType()) {
+            for (size_t i = next->numChildren(); i > 0; --i) {
+                pending.push_back(next->getChild(i - 1));
+            }
+        } else {
+            conjuncts.push_back(next);
+        }
+    }
+
+    for (auto conjunct : conjuncts) {
+        if (!compiled->addFieldPredicate(conjunct)) {
+            compiled->_residuals.push_back(conjunct);
+        }
+    }
+    if (compiled->_predicates.empty()) {
+        return nullptr;
+    }
+
+    std::stable_sort(compiled->_residuals.begin(),
+                     compiled->_residuals.end(),
+                     [](const MatchExpression* lhs, const MatchExpression* rhs) {
+                         return evaluationCost(lhs) < evaluationCost(rhs);
+                     });
+    return compiled;
+}
+
+bool CompiledMatchExpression::addFieldPredicate(const MatchExpression* expr) {
+    if (!ComparisonMatchExpression::isComparisonMatchExpression(expr)) {
+        return false;
+    }
+    auto comparison = static_cast<const ComparisonMatchExpression*>(expr);
+    const StringData path = comparison->path();
+    if (path.empty() || path.find('.') != std::string::npos) {
+        return false;
+    }
+
+    Predicate predicate;
+    predicate.expr = comparison;
+    predicate.op = comparison->matchType();
+    const BSONElement& rhs = comparison->getData();
+    switch (rhs.type()) {
+        case NumberInt:
+            predicate.kind = OperandKind::kInt;
+            predicate.intValue = rhs._numberInt();
+            break;
+        case NumberLong:
+            predicate.kind = OperandKind::kLong;
+            predicate.longValue = rhs._numberLong();
+            break;
+        case NumberDouble:
+            if (std::isnan(rhs._numberDouble())) {
+                return false;
+            }
+            predicate.kind = OperandKind::kDouble;
+            predicate.doubleValue = rhs._numberDouble();
+            break;
+        case String:
+            if (comparison->getCollator()) {
+                return false;
+            }
+            predicate.kind = OperandKind::kString;
+            predicate.stringValue = rhs.valueStringData();
+            break;
+        default:
+            // Other operands, null in particular, can match documents without the field.
+            return false;
+    }
+
+    auto field = std::find_if(
+        _fields.begin(), _fields.end(), [&](const Field& f) { return f.name == path; });
+    if (field == _fields.end()) {
+        if (_fields.size() == kMaxFields) {
+            return false;
+        }
+        _fields.push_back({path, {}});
+        field = _fields.end() - 1;
+    }
+    field->predicates.push_back(predicate);
+    _predicates.push_back(comparison);
+    return true;
+}
+
+// static
+bool CompiledMatchExpression::evaluate(const Predicate& predicate,
+                                       const BSONElement& elem,
+                                       const BSONObj& doc) {
+    switch (predicate.kind) {
+        case OperandKind::kInt:
+            if (NumberInt == elem.type()) {
+                return satisfies(predicate.op,
+                                 compareValues(elem._numberInt(), predicate.intValue));
+            }
+            break;
+        case OperandKind::kLong:
+            if (NumberLong == elem.type()) {
+                return satisfies(predicate.op,
+                                 compareValues(elem._numberLong(), predicate.longValue));
+            }
+            break;
+        case OperandKind::kDouble:
+            if (NumberDouble == elem.type() && !std::isnan(elem._numberDouble())) {
+                return satisfies(predicate.op,
+                                 compareValues(elem._numberDouble(), predicate.doubleValue));
+            }
+            break;
+        case OperandKind::kString:
+            if (String == elem.type()) {
+                return satisfies(predicate.op,
+                                 elem.valueStringData().compare(predicate.stringValue));
+            }
+            break;
+    }
+
+    // Mixed types go through the generic comparison, and arrays through the full path traversal.
+    if (Array == elem.type()) {
+        return predicate.expr->matchesBSON(doc);
+    }
+    return predicate.expr->matchesSingleElement(elem);
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+    uint64_t seen = 0;
+    size_t numSeen = 0;
+    BSONObjIterator it(doc);
+    while (numSeen < _fields.size() && it.more()) {
+        const BSONElement elem = it.next();
+        const StringData name = elem.fieldNameStringData();
+        for (size_t i = 0; i < _fields.size(); ++i) {
+            const uint64_t bit = uint64_t(1) << i;
+            if (_fields[i].name != name) {
+                continue;
+            }
+            // Like a path lookup, only the first field of a name counts.
+            if (seen & bit) {
+                break;
+            }
+            seen |= bit;
+            ++numSeen;
+            for (auto&& predicate : _fields[i].predicates) {
+                if (!evaluate(predicate, elem, doc)) {
+                    return false;
+                }
+            }
+            break;
+        }
+    }
+
+    // None of the field predicates match a missing field.
+    if (numSeen < _fields.size()) {
+        return false;
+    }
+
+    for (auto residual : _residuals) {
+        if (!residual->matchesBSON(doc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace mongo
@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+class ComparisonMatchExpression;
+
+/**
+ * A filter flattened for matching whole documents. $eq, $lt, $lte, $gt and $gte on a top-level
+ * field against an int, long, double or (without a collator) string are dispatched by field name
+ * during a single pass over the document's top-level fields, and checked with typed comparisons
+ * as soon as their field is seen. Everything else in the filter is evaluated afterwards through
+ * the original expression tree, cheapest first.
+ *
+ * The MatchExpression it was compiled from must outlive it and must not change.
+ */
+class CompiledMatchExpression {
+    MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+
+public:
+    /**
+     * Returns nullptr if 'expr' has no predicates that compilation would speed up.
+     */
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* expr);
+
+    /**
+     * Equivalent to MatchExpression::matchesBSON() on the expression this was compiled from.
+     */
+    bool matchesBSON(const BSONObj& doc) const;
+
+    size_t numFieldPredicates() const {
+        return _predicates.size();
+    }
+
+    size_t numResiduals() const {
+        return _residuals.size();
+    }
+
+private:
+    // Fields are tracked in a 64-bit mask while scanning a document.
+    static const size_t kMaxFields = 64;
+
+    enum class OperandKind : uint8_t { kInt, kLong, kDouble, kString };
+
+    struct Predicate {
+        const ComparisonMatchExpression* expr;
+        MatchExpression::MatchType op;
+        OperandKind kind;
+        int intValue = 0;
+        long long longValue = 0;
+        double doubleValue = 0;
+        StringData stringValue;
+    };
+
+    struct Field {
+        StringData name;
+        std::vector<Predicate> predicates;
+    };
+
+    CompiledMatchExpression() = default;
+
+    /**
+     * Adds 'expr' as a field predicate if it qualifies, returning false if it does not.
+     */
+    bool addFieldPredicate(const MatchExpression* expr);
+
+    static bool evaluate(const Predicate& predicate, const BSONElement& elem, const BSONObj& doc);
+
+    std::vector<Field> _fields;
+    std::vector<const MatchExpression*> _residuals;
+
+    // Only used for numFieldPredicates().
+    std::vector<const ComparisonMatchExpression*> _predicates;
+};
+
+}  // namespace mongo
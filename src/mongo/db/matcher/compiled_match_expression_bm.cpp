@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const int kNumDocs = 1000;
+
+/**
+ * Documents shaped like an orders collection: a dozen top-level fields of mixed types, with the
+ * filtered fields spread among them.
+ */
+std::vector<BSONObj> makeDocs() {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < kNumDocs; ++i) {
+        docs.push_back(BSON("_id" << OID::gen() << "customer" << BSON("name"
+                                                                     << "customer"
+                                                                     << "id"
+                                                                     << i % 97)
+                                  << "status"
+                                  << (i % 4 == 0 ? "shipped" : "pending")
+                                  << "created"
+                                  << Date_t::fromMillisSinceEpoch(1500000000000LL + i)
+                                  << "items"
+                                  << BSON_ARRAY(BSON("sku" << i % 13 << "qty" << 1))
+                                  << "notes"
+                                  << std::string(48, 'n')
+                                  << "region"
+                                  << (i % 3 == 0 ? "emea" : "apac")
+                                  << "priority"
+                                  << i % 5
+                                  << "discount"
+                                  << 0.05 * (i % 4)
+                                  << "total"
+                                  << 10.0 * (i % 50)
+                                  << "quantity"
+                                  << i % 20
+                                  << "version"
+                                  << static_cast<long long>(i)));
+    }
+    return docs;
+}
+
+void runMatch(benchmark::State& state, const BSONObj& filter, bool compile) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = uassertStatusOK(MatchExpressionParser::parse(filter, expCtx));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    invariant(compiled);
+    const auto docs = makeDocs();
+
+    for (auto keepRunning : state) {
+        long long matched = 0;
+        for (auto&& doc : docs) {
+            matched += compile ? compiled->matchesBSON(doc) : expr->matchesBSON(doc);
+        }
+        benchmark::DoNotOptimize(matched);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumDocs);
+}
+
+// Three predicates on fields near the end of the document; most documents pass.
+const BSONObj kRangeFilter =
+    BSON("total" << BSON("$gte" << 10.0) << "quantity" << BSON("$lt" << 19) << "priority"
+                 << BSON("$lte" << 4));
+
+// Equality on strings and ints; about one document in twelve passes.
+const BSONObj kEqualityFilter = BSON("status"
+                                     << "shipped"
+                                     << "region"
+                                     << "emea"
+                                     << "priority"
+                                     << 2);
+
+// A field predicate that rejects most documents ahead of a regex.
+const BSONObj kMixedFilter = BSON("quantity" << 3 << "notes" << BSON("$regex"
+                                                                    << "^n+$"));
+
+void BM_MatchRangeTree(benchmark::State& state) {
+    runMatch(state, kRangeFilter, false);
+}
+
+void BM_MatchRangeCompiled(benchmark::State& state) {
+    runMatch(state, kRangeFilter, true);
+}
+
+void BM_MatchEqualityTree(benchmark::State& state) {
+    runMatch(state, kEqualityFilter, false);
+}
+
+void BM_MatchEqualityCompiled(benchmark::State& state) {
+    runMatch(state, kEqualityFilter, true);
+}
+
+void BM_MatchMixedTree(benchmark::State& state) {
+    runMatch(state, kMixedFilter, false);
+}
+
+void BM_MatchMixedCompiled(benchmark::State& state) {
+    runMatch(state, kMixedFilter, true);
+}
+
+BENCHMARK(BM_MatchRangeTree);
+BENCHMARK(BM_MatchRangeCompiled);
+BENCHMARK(BM_MatchEqualityTree);
+BENCHMARK(BM_MatchEqualityCompiled);
+BENCHMARK(BM_MatchMixedTree);
+BENCHMARK(BM_MatchMixedCompiled);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& filter,
+                                       const CollatorInterface* collator = nullptr) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(collator);
+    auto status = MatchExpressionParser::parse(filter, expCtx);
+    ASSERT_OK(status.getStatus());
+    return std::move(status.getValue());
+}
+
+const std::vector<BSONObj> kDocs = {
+    fromjson("{}"),
+    fromjson("{a: 1, b: 'x'}"),
+    fromjson("{a: 5, b: 'y', c: {d: 2}}"),
+    fromjson("{a: 5.5, b: 'y'}"),
+    fromjson("{a: NumberLong(5), b: 'z'}"),
+    fromjson("{a: NaN, b: 'x'}"),
+    fromjson("{a: null, b: 'x'}"),
+    fromjson("{a: [1, 5, 9], b: 'x'}"),
+    fromjson("{a: [[5]], b: ['x', 'y']}"),
+    fromjson("{a: '5', b: 5}"),
+    fromjson("{b: 'y', a: 7}"),
+    fromjson("{a: 3, a: 100, b: 'x'}"),
+    fromjson("{a: {$minKey: 1}, b: 'x'}"),
+    fromjson("{a: 4, b: 'x\\u0000y'}"),
+};
+
+/**
+ * Asserts that the compiled form of 'filter' agrees with the expression tree on every document.
+ */
+void assertSameResults(const BSONObj& filter) {
+    auto expr = parse(filter);
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled) << filter;
+    for (auto&& doc : kDocs) {
+        ASSERT_EQ(expr->matchesBSON(doc), compiled->matchesBSON(doc)) << filter << " " << doc;
+    }
+}
+
+TEST(CompiledMatchExpression, AgreesWithExpressionTree) {
+    assertSameResults(fromjson("{a: 5}"));
+    assertSameResults(fromjson("{a: {$gt: 4}}"));
+    assertSameResults(fromjson("{a: {$gte: 5, $lt: 6}}"));
+    assertSameResults(fromjson("{a: {$lte: 5.5}}"));
+    assertSameResults(fromjson("{a: {$gt: NumberLong(4)}}"));
+    assertSameResults(fromjson("{a: 5, b: 'y'}"));
+    assertSameResults(fromjson("{b: {$gt: 'x'}}"));
+    assertSameResults(fromjson("{b: {$lt: 'x\\u0000z'}}"));
+    assertSameResults(fromjson("{a: {$lt: 100}, 'c.d': 2}"));
+    assertSameResults(fromjson("{$and: [{a: {$gt: 0}}, {$and: [{b: 'x'}, {a: {$ne: 9}}]}]}"));
+    assertSameResults(fromjson("{a: {$gt: 0}, $or: [{b: 'x'}, {b: 'z'}]}"));
+    assertSameResults(fromjson("{a: {$gte: 1}, b: {$regex: '^x'}}"));
+    assertSameResults(fromjson("{a: 3}"));
+}
+
+TEST(CompiledMatchExpression, PutsFieldPredicatesAheadOfResiduals) {
+    auto expr = parse(fromjson("{a: {$gt: 1, $lt: 9}, b: /x/, 'c.d': 2, e: null}"));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(2U, compiled->numFieldPredicates());
+    ASSERT_EQ(3U, compiled->numResiduals());
+}
+
+TEST(CompiledMatchExpression, DoesNotCompileWithoutFieldPredicates) {
+    auto expr = parse(fromjson("{$or: [{a: 1}, {b: 2}]}"));
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+
+    expr = parse(fromjson("{'a.b': 1, c: null}"));
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+}
+
+TEST(CompiledMatchExpression, LeavesCollatedStringComparisonsToTheTree) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    auto expr = parse(fromjson("{a: 1, b: 'q'}"), &collator);
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(1U, compiled->numFieldPredicates());
+    ASSERT_TRUE(compiled->matchesBSON(fromjson("{a: 1, b: 'x'}")));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,251 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/column_batch.h"
+#include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const size_t kNumDocs = 10000;
+
+/**
+ * Documents with a few fields that the pipelines use and several that they don't: {_id, a: int,
+ * b: double, c: one of 16 strings, d: {x: int}, and six unused fields}.
+ */
+std::vector<BSONObj> makeDocs() {
+    std::vector<BSONObj> docs;
+    docs.reserve(kNumDocs);
+    const std::string padding(32, 'p');
+    for (size_t i = 0; i < kNumDocs; ++i) {
+        docs.push_back(BSON("_id" << static_cast<long long>(i) << "a" << static_cast<int>(i % 100)
+                                  << "b"
+                                  << 0.5 * (i % 1000)
+                                  << "c"
+                                  << ("category" + std::to_string(i % 16))
+                                  << "d"
+                                  << BSON("x" << static_cast<int>(i % 7))
+                                  << "u1"
+                                  << padding
+                                  << "u2"
+                                  << static_cast<int>(i)
+                                  << "u3"
+                                  << BSON_ARRAY(1 << 2 << 3)
+                                  << "u4"
+                                  << Date_t::fromMillisSinceEpoch(1500000000000LL + i)
+                                  << "u5"
+                                  << true
+                                  << "u6"
+                                  << BSON("k" << padding)));
+    }
+    return docs;
+}
+
+/**
+ * Hands over 'docs' the way DocumentSourceCursor hands over the results of its PlanExecutor: as
+ * Documents holding only the fields the pipeline depends on, or, if 'columnBatchSize' is not 0, as
+ * column batches of that many rows.
+ */
+class BsonReplaySource final : public DocumentSource {
+public:
+    BsonReplaySource(const std::vector<BSONObj>& docs,
+                     const DepsTracker& deps,
+                     size_t columnBatchSize,
+                     const boost::intrusive_ptr<ExpressionContext>& expCtx)
+        : DocumentSource(expCtx),
+          _docs(docs),
+          _parsedDeps(*deps.toParsedDeps()),
+          _columnBatchSize(columnBatchSize) {
+        std::set<std::string> fields;
+        for (auto&& field : deps.fields) {
+            fields.insert(FieldPath(field).getFieldName(0).toString());
+        }
+        _columnBatchFields.assign(fields.begin(), fields.end());
+    }
+
+    GetNextResult getNext() final {
+        if (_position == _docs.size()) {
+            return GetNextResult::makeEOF();
+        }
+        return _parsedDeps.extractFields(_docs[_position++]);
+    }
+
+    bool canProduceColumnBatches() const final {
+        return _columnBatchSize > 0;
+    }
+
+    std::unique_ptr<ColumnBatch> getNextColumnBatch() final {
+        if (_position == _docs.size()) {
+            return nullptr;
+        }
+        auto batch = stdx::make_unique<ColumnBatch>(_columnBatchFields);
+        while (_position < _docs.size() && batch->numRows() < _columnBatchSize) {
+            batch->appendRow(_docs[_position++]);
+        }
+        return batch;
+    }
+
+    const char* getSourceName() const final {
+        return "replay";
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain) const final {
+        return Value();
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kNone,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kAllowed);
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+private:
+    const std::vector<BSONObj>& _docs;
+    const ParsedDeps _parsedDeps;
+    const size_t _columnBatchSize;
+    std::vector<std::string> _columnBatchFields;
+    size_t _position = 0;
+};
+
+/**
+ * Runs 'stageSpecs' over kNumDocs documents per iteration and pulls every result out of the last
+ * stage. state.range(0) is the column batch size; 0 passes one Document at a time.
+ */
+void runPipeline(benchmark::State& state, const std::vector<std::string>& stageSpecs) {
+    const auto docs = makeDocs();
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->inMongos = true;  // Keep $group in memory in debug builds.
+
+    std::vector<BSONObj> specs;
+    for (auto&& spec : stageSpecs) {
+        specs.push_back(fromjson(spec));
+    }
+
+    const size_t columnBatchSize = state.range(0);
+    long long documents = 0;
+    for (auto keepRunning : state) {
+        std::vector<boost::intrusive_ptr<DocumentSource>> stages;
+        for (auto&& spec : specs) {
+            for (auto&& stage : DocumentSource::parse(expCtx, spec)) {
+                stages.push_back(stage->optimize());
+            }
+        }
+
+        DepsTracker deps;
+        for (auto&& stage : stages) {
+            if (stage->getDependencies(&deps) & DocumentSource::EXHAUSTIVE_FIELDS) {
+                break;
+            }
+        }
+        invariant(!deps.needWholeDocument);
+
+        boost::intrusive_ptr<DocumentSource> source(
+            new BsonReplaySource(docs, deps, columnBatchSize, expCtx));
+        DocumentSource* last = source.get();
+        for (auto&& stage : stages) {
+            stage->setSource(last);
+            last = stage.get();
+        }
+
+        long long results = 0;
+        if (dynamic_cast<DocumentSourceGroup*>(last) || !last->canProduceColumnBatches()) {
+            for (auto next = last->getNext(); next.isAdvanced(); next = last->getNext()) {
+                benchmark::DoNotOptimize(next.releaseDocument());
+                ++results;
+            }
+        } else {
+            while (auto batch = last->getNextColumnBatch()) {
+                results += batch->getSelection().size();
+            }
+        }
+        benchmark::DoNotOptimize(results);
+        documents += kNumDocs;
+    }
+    state.SetItemsProcessed(documents);
+}
+
+// Matches half of the documents.
+void BM_Match(benchmark::State& state) {
+    runPipeline(state, {"{$match: {a: {$lt: 50}}}"});
+}
+
+void BM_Project(benchmark::State& state) {
+    runPipeline(state, {"{$project: {a: 1, c: 1, total: '$b'}}"});
+}
+
+// 16 groups keyed on a string.
+void BM_GroupSum(benchmark::State& state) {
+    runPipeline(state, {"{$group: {_id: '$c', total: {$sum: '$b'}, count: {$sum: 1}}}"});
+}
+
+// 100 groups keyed on an int.
+void BM_GroupAvg(benchmark::State& state) {
+    runPipeline(state, {"{$group: {_id: '$a', avg: {$avg: '$b'}, max: {$max: '$d'}}}"});
+}
+
+// A computed argument makes the $group read Documents, with or without batches below it.
+void BM_GroupComputed(benchmark::State& state) {
+    runPipeline(state, {"{$group: {_id: '$c', total: {$sum: {$multiply: ['$a', '$b']}}}}"});
+}
+
+void BM_MatchProjectGroup(benchmark::State& state) {
+    runPipeline(state,
+                {"{$match: {a: {$lt: 50}}}",
+                 "{$project: {c: 1, total: '$b'}}",
+                 "{$group: {_id: '$c', total: {$sum: '$total'}, count: {$sum: 1}}}"});
+}
+
+BENCHMARK(BM_Match)->Arg(0)->Arg(128)->Arg(1024);
+BENCHMARK(BM_Project)->Arg(0)->Arg(128)->Arg(1024);
+BENCHMARK(BM_GroupSum)->Arg(0)->Arg(128)->Arg(1024);
+BENCHMARK(BM_GroupAvg)->Arg(0)->Arg(128)->Arg(1024);
+BENCHMARK(BM_GroupComputed)->Arg(0)->Arg(128)->Arg(1024);
+BENCHMARK(BM_MatchProjectGroup)->Arg(0)->Arg(128)->Arg(1024);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,283 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_batch.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+ColumnBatch::ColumnType columnTypeOf(const BSONElement& elem) {
+    switch (elem.type()) {
+        case NumberInt:
+            return ColumnBatch::ColumnType::kInt;
+        case NumberLong:
+            return ColumnBatch::ColumnType::kLong;
+        case NumberDouble:
+            return ColumnBatch::ColumnType::kDouble;
+        case Bool:
+            return ColumnBatch::ColumnType::kBool;
+        case String:
+            return ColumnBatch::ColumnType::kString;
+        default:
+            return ColumnBatch::ColumnType::kValue;
+    }
+}
+
+}  // namespace
+
+Value ColumnBatch::Column::getValue(size_t row) const {
+    if (isMissing(row)) {
+        return Value();
+    }
+    if (isNull(row)) {
+        return Value(BSONNULL);
+    }
+
+    switch (_type) {
+        case ColumnType::kEmpty:
+            MONGO_UNREACHABLE;
+        case ColumnType::kInt:
+            return Value(_ints[row]);
+        case ColumnType::kLong:
+            return Value(_longs[row]);
+        case ColumnType::kDouble:
+            return Value(_doubles[row]);
+        case ColumnType::kBool:
+            return Value(static_cast<bool>(_bools[row]));
+        case ColumnType::kString:
+            return Value(_strings[row]);
+        case ColumnType::kValue:
+            return _values[row];
+    }
+    MONGO_UNREACHABLE;
+}
+
+void ColumnBatch::Column::append(const BSONElement& elem) {
+    if (elem.type() == jstNULL) {
+        appendAbsent(&_nulls);
+        return;
+    }
+
+    const ColumnType type = columnTypeOf(elem);
+    if (_type == ColumnType::kEmpty) {
+        _type = type;
+        resizeTypedArray();
+    } else if (_type != type && _type != ColumnType::kValue) {
+        widenToValues();
+    }
+
+    switch (_type) {
+        case ColumnType::kEmpty:
+            MONGO_UNREACHABLE;
+        case ColumnType::kInt:
+            _ints.push_back(elem._numberInt());
+            break;
+        case ColumnType::kLong:
+            _longs.push_back(elem._numberLong());
+            break;
+        case ColumnType::kDouble:
+            _doubles.push_back(elem._numberDouble());
+            break;
+        case ColumnType::kBool:
+            _bools.push_back(elem.boolean());
+            break;
+        case ColumnType::kString:
+            _strings.push_back(elem.valueStringData());
+            break;
+        case ColumnType::kValue:
+            _values.push_back(Value(elem));
+            break;
+    }
+    ++_size;
+}
+
+void ColumnBatch::Column::appendMissing() {
+    appendAbsent(&_missing);
+}
+
+void ColumnBatch::Column::setBit(std::vector<uint64_t>* bitmap, size_t row) {
+    if (bitmap->size() <= row / 64) {
+        bitmap->resize(row / 64 + 1, 0);
+    }
+    (*bitmap)[row / 64] |= uint64_t(1) << (row % 64);
+}
+
+void ColumnBatch::Column::appendAbsent(std::vector<uint64_t>* bitmap) {
+    setBit(bitmap, _size);
+    ++_numAbsent;
+    ++_size;
+    resizeTypedArray();
+}
+
+void ColumnBatch::Column::resizeTypedArray() {
+    switch (_type) {
+        case ColumnType::kEmpty:
+            break;
+        case ColumnType::kInt:
+            _ints.resize(_size);
+            break;
+        case ColumnType::kLong:
+            _longs.resize(_size);
+            break;
+        case ColumnType::kDouble:
+            _doubles.resize(_size);
+            break;
+        case ColumnType::kBool:
+            _bools.resize(_size);
+            break;
+        case ColumnType::kString:
+            _strings.resize(_size);
+            break;
+        case ColumnType::kValue:
+            _values.resize(_size);
+            break;
+    }
+}
+
+void ColumnBatch::Column::widenToValues() {
+    std::vector<Value> values;
+    values.reserve(_size + 1);
+    for (size_t row = 0; row < _size; ++row) {
+        // Absent rows are told apart by the bitmaps, so their entry stays missing.
+        values.push_back(isNull(row) ? Value() : getValue(row));
+    }
+
+    std::vector<int>().swap(_ints);
+    std::vector<long long>().swap(_longs);
+    std::vector<double>().swap(_doubles);
+    std::vector<char>().swap(_bools);
+    std::vector<StringData>().swap(_strings);
+    _values = std::move(values);
+    _type = ColumnType::kValue;
+}
+
+ColumnBatch::ColumnBatch(std::vector<std::string> fieldNames)
+    : _fieldNames(std::move(fieldNames)) {
+    _columns.reserve(_fieldNames.size());
+    for (size_t i = 0; i < _fieldNames.size(); ++i) {
+        _columns.push_back(std::make_shared<Column>());
+    }
+    rebuildColumnIndex();
+}
+
+void ColumnBatch::appendRow(BSONObj row) {
+    invariant(_hasSourceRows);
+    dassert(row.isOwned());
+
+    const size_t rowIndex = _numRows;
+    size_t numFound = 0;
+    for (auto&& elem : row) {
+        if (numFound == _columns.size()) {
+            break;
+        }
+        auto it = _columnIndex.find(elem.fieldNameStringData());
+        if (it == _columnIndex.end()) {
+            continue;
+        }
+
+        // As with Document, the first of several fields with the same name wins.
+        Column* column = _columns[it->second].get();
+        if (column->size() == rowIndex) {
+            column->append(elem);
+            ++numFound;
+        }
+    }
+    if (numFound < _columns.size()) {
+        for (auto&& column : _columns) {
+            if (column->size() == rowIndex) {
+                column->appendMissing();
+            }
+        }
+    }
+
+    _selection.push_back(rowIndex);
+    _rowBytes += row.objsize();
+    _rows.push_back(std::move(row));
+    ++_numRows;
+}
+
+boost::optional<size_t> ColumnBatch::findColumn(StringData fieldName) const {
+    auto it = _columnIndex.find(fieldName);
+    if (it == _columnIndex.end()) {
+        return boost::none;
+    }
+    return it->second;
+}
+
+BSONObj ColumnBatch::toBson(size_t row) const {
+    BSONObjBuilder bob;
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        if (!_columns[i]->isMissing(row)) {
+            _columns[i]->getValue(row).addToBsonObj(&bob, _fieldNames[i]);
+        }
+    }
+    return bob.obj();
+}
+
+Document ColumnBatch::getDocument(size_t row) const {
+    MutableDocument md(_columns.size());
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        if (!_columns[i]->isMissing(row)) {
+            md.addField(_fieldNames[i], _columns[i]->getValue(row));
+        }
+    }
+    return md.freeze();
+}
+
+void ColumnBatch::projectColumns(const std::vector<std::pair<std::string, size_t>>& outputs) {
+    std::vector<std::string> fieldNames;
+    std::vector<std::shared_ptr<Column>> columns;
+    fieldNames.reserve(outputs.size());
+    columns.reserve(outputs.size());
+    for (auto&& output : outputs) {
+        fieldNames.push_back(output.first);
+        columns.push_back(_columns[output.second]);
+    }
+
+    _fieldNames = std::move(fieldNames);
+    _columns = std::move(columns);
+    rebuildColumnIndex();
+
+    // The source rows are still needed for the strings they hold.
+    _hasSourceRows = false;
+}
+
+void ColumnBatch::rebuildColumnIndex() {
+    _columnIndex.clear();
+    for (size_t i = 0; i < _fieldNames.size(); ++i) {
+        _columnIndex[_fieldNames[i]] = i;
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,258 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+/**
+ * A run of pipeline results held column by column instead of as one Document each. Every column
+ * holds one top-level field of all the rows. Ints, longs, doubles, bools and strings are stored in
+ * typed arrays, and missing and null entries in bitmaps; a column that sees more than one of these
+ * types, or any other type, falls back to an array of Values. String entries point into the source
+ * rows, which the batch keeps.
+ *
+ * A selection vector lists the rows that are still part of the result, in order, so that a $match
+ * can filter a batch without copying it. A $project that only includes or renames top-level fields
+ * rebuilds the list of columns and shares the columns themselves. Stages that can't work on the
+ * columns convert a row to a Document with getDocument().
+ */
+class ColumnBatch {
+    MONGO_DISALLOW_COPYING(ColumnBatch);
+
+public:
+    enum class ColumnType : uint8_t { kEmpty, kInt, kLong, kDouble, kBool, kString, kValue };
+
+    class Column {
+        MONGO_DISALLOW_COPYING(Column);
+
+    public:
+        Column() = default;
+
+        ColumnType getType() const {
+            return _type;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool isMissing(size_t row) const {
+            return testBit(_missing, row);
+        }
+
+        bool isNull(size_t row) const {
+            return testBit(_nulls, row);
+        }
+
+        /**
+         * True if every row holds a value of the column's type, so that the typed accessors may be
+         * used without checking isMissing() and isNull().
+         */
+        bool isDense() const {
+            return _numAbsent == 0;
+        }
+
+        int getInt(size_t row) const {
+            dassert(_type == ColumnType::kInt);
+            return _ints[row];
+        }
+
+        long long getLong(size_t row) const {
+            dassert(_type == ColumnType::kLong);
+            return _longs[row];
+        }
+
+        double getDouble(size_t row) const {
+            dassert(_type == ColumnType::kDouble);
+            return _doubles[row];
+        }
+
+        bool getBool(size_t row) const {
+            dassert(_type == ColumnType::kBool);
+            return _bools[row];
+        }
+
+        StringData getString(size_t row) const {
+            dassert(_type == ColumnType::kString);
+            return _strings[row];
+        }
+
+        /**
+         * Returns the entry of 'row' as a Value, which is missing for a missing entry.
+         */
+        Value getValue(size_t row) const;
+
+        /**
+         * Appends 'elem' as the next row. String entries point into the object holding 'elem'.
+         */
+        void append(const BSONElement& elem);
+
+        void appendMissing();
+
+    private:
+        static bool testBit(const std::vector<uint64_t>& bitmap, size_t row) {
+            return row / 64 < bitmap.size() && (bitmap[row / 64] >> (row % 64)) & 1;
+        }
+
+        static void setBit(std::vector<uint64_t>* bitmap, size_t row);
+
+        /**
+         * Appends a row that holds no value of the column's type, marked in 'bitmap'.
+         */
+        void appendAbsent(std::vector<uint64_t>* bitmap);
+
+        /**
+         * Sizes the typed array of '_type' to hold the rows appended so far.
+         */
+        void resizeTypedArray();
+
+        /**
+         * Converts the column to an array of Values once it sees a second type.
+         */
+        void widenToValues();
+
+        ColumnType _type = ColumnType::kEmpty;
+        size_t _size = 0;
+        size_t _numAbsent = 0;
+
+        std::vector<uint64_t> _missing;
+        std::vector<uint64_t> _nulls;
+
+        // Only the array of '_type' is in use. Absent rows hold a default entry.
+        std::vector<int> _ints;
+        std::vector<long long> _longs;
+        std::vector<double> _doubles;
+        std::vector<char> _bools;
+        std::vector<StringData> _strings;
+        std::vector<Value> _values;
+    };
+
+    /**
+     * Creates an empty batch with one column for each of 'fieldNames', which must be distinct
+     * top-level field names.
+     */
+    explicit ColumnBatch(std::vector<std::string> fieldNames);
+
+    /**
+     * Appends a row holding the fields of 'row' that have a column. 'row' must be owned.
+     */
+    void appendRow(BSONObj row);
+
+    size_t numRows() const {
+        return _numRows;
+    }
+
+    size_t numColumns() const {
+        return _columns.size();
+    }
+
+    const std::string& getFieldName(size_t column) const {
+        return _fieldNames[column];
+    }
+
+    const Column& getColumn(size_t column) const {
+        return *_columns[column];
+    }
+
+    /**
+     * Returns the column of top-level field 'fieldName', or boost::none if there is none.
+     */
+    boost::optional<size_t> findColumn(StringData fieldName) const;
+
+    /**
+     * The rows that are still part of the result, in ascending order.
+     */
+    const std::vector<uint32_t>& getSelection() const {
+        return _selection;
+    }
+
+    void setSelection(std::vector<uint32_t> selection) {
+        _selection = std::move(selection);
+    }
+
+    /**
+     * True as long as the columns hold the fields of the source rows unchanged, so that
+     * getSourceRow() may stand in for toBson().
+     */
+    bool hasSourceRows() const {
+        return _hasSourceRows;
+    }
+
+    const BSONObj& getSourceRow(size_t row) const {
+        dassert(_hasSourceRows);
+        return _rows[row];
+    }
+
+    /**
+     * Returns the size of the source rows.
+     */
+    size_t getApproximateSize() const {
+        return _rowBytes;
+    }
+
+    /**
+     * Returns the non-missing entries of 'row' as a BSON object or a Document.
+     */
+    BSONObj toBson(size_t row) const;
+    Document getDocument(size_t row) const;
+
+    /**
+     * Replaces the columns with 'outputs': for each, the name of the new column and the index of
+     * the existing column it takes its entries from. The same column may be used more than once.
+     */
+    void projectColumns(const std::vector<std::pair<std::string, size_t>>& outputs);
+
+private:
+    void rebuildColumnIndex();
+
+    std::vector<std::string> _fieldNames;
+    std::vector<std::shared_ptr<Column>> _columns;
+    StringMap<size_t> _columnIndex;
+
+    std::vector<BSONObj> _rows;
+    std::vector<uint32_t> _selection;
+    size_t _numRows = 0;
+    size_t _rowBytes = 0;
+    bool _hasSourceRows = true;
+};
+
+}  // namespace mongo
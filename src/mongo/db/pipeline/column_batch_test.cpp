@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/pipeline/column_batch.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using ColumnType = ColumnBatch::ColumnType;
+
+TEST(ColumnBatchTest, ColumnsOfOneTypeAreTyped) {
+    ColumnBatch batch({"a", "b", "c"});
+    batch.appendRow(fromjson("{a: 1, b: 'x', c: 1.5, d: 'ignored'}"));
+    batch.appendRow(fromjson("{c: 2.5, b: 'y', a: 2}"));
+
+    ASSERT_EQ(batch.numRows(), 2U);
+    ASSERT_EQ(batch.numColumns(), 3U);
+    auto a = *batch.findColumn("a");
+    auto b = *batch.findColumn("b");
+    auto c = *batch.findColumn("c");
+    ASSERT_FALSE(batch.findColumn("d"));
+
+    ASSERT(batch.getColumn(a).getType() == ColumnType::kInt);
+    ASSERT(batch.getColumn(b).getType() == ColumnType::kString);
+    ASSERT(batch.getColumn(c).getType() == ColumnType::kDouble);
+    ASSERT_TRUE(batch.getColumn(a).isDense());
+    ASSERT_EQ(batch.getColumn(a).getInt(1), 2);
+    ASSERT_EQ(batch.getColumn(b).getString(0), "x");
+    ASSERT_EQ(batch.getColumn(c).getDouble(1), 2.5);
+}
+
+TEST(ColumnBatchTest, MissingAndNullAreKeptInBitmaps) {
+    ColumnBatch batch({"a"});
+    batch.appendRow(fromjson("{a: null}"));
+    batch.appendRow(fromjson("{b: 1}"));
+    batch.appendRow(fromjson("{a: {$numberLong: '3'}}"));
+
+    const auto& column = batch.getColumn(0);
+    ASSERT(column.getType() == ColumnType::kLong);
+    ASSERT_FALSE(column.isDense());
+    ASSERT_TRUE(column.isNull(0));
+    ASSERT_TRUE(column.isMissing(1));
+    ASSERT_FALSE(column.isMissing(2));
+    ASSERT_VALUE_EQ(column.getValue(0), Value(BSONNULL));
+    ASSERT_TRUE(column.getValue(1).missing());
+    ASSERT_VALUE_EQ(column.getValue(2), Value(3LL));
+}
+
+TEST(ColumnBatchTest, MixedTypesFallBackToValues) {
+    ColumnBatch batch({"a"});
+    batch.appendRow(fromjson("{a: 1}"));
+    batch.appendRow(fromjson("{}"));
+    batch.appendRow(fromjson("{a: 'two'}"));
+    batch.appendRow(fromjson("{a: [3]}"));
+
+    const auto& column = batch.getColumn(0);
+    ASSERT(column.getType() == ColumnType::kValue);
+    ASSERT_VALUE_EQ(column.getValue(0), Value(1));
+    ASSERT_TRUE(column.getValue(1).missing());
+    ASSERT_VALUE_EQ(column.getValue(2), Value("two"_sd));
+    ASSERT_VALUE_EQ(column.getValue(3), Value(BSON_ARRAY(3)));
+}
+
+TEST(ColumnBatchTest, FirstOfDuplicateFieldsWins) {
+    ColumnBatch batch({"a"});
+    batch.appendRow(BSON("a" << 1 << "a" << 2));
+    ASSERT_VALUE_EQ(batch.getColumn(0).getValue(0), Value(1));
+}
+
+TEST(ColumnBatchTest, RowsConvertToDocumentsAndBson) {
+    ColumnBatch batch({"a", "b"});
+    batch.appendRow(fromjson("{a: 1, b: null, c: 3}"));
+    batch.appendRow(fromjson("{b: 'x'}"));
+
+    ASSERT_DOCUMENT_EQ(batch.getDocument(0), Document(fromjson("{a: 1, b: null}")));
+    ASSERT_DOCUMENT_EQ(batch.getDocument(1), Document(fromjson("{b: 'x'}")));
+    ASSERT_BSONOBJ_EQ(batch.toBson(0), fromjson("{a: 1, b: null}"));
+    ASSERT_TRUE(batch.hasSourceRows());
+    ASSERT_BSONOBJ_EQ(batch.getSourceRow(0), fromjson("{a: 1, b: null, c: 3}"));
+}
+
+TEST(ColumnBatchTest, ProjectColumnsRenamesAndSharesColumns) {
+    ColumnBatch batch({"a", "b"});
+    batch.appendRow(fromjson("{a: 1, b: 'x'}"));
+    batch.appendRow(fromjson("{a: 2, b: 'y'}"));
+
+    batch.projectColumns({{"x", 1}, {"a", 0}, {"y", 1}});
+    ASSERT_FALSE(batch.hasSourceRows());
+    ASSERT_EQ(batch.numColumns(), 3U);
+    ASSERT_FALSE(batch.findColumn("b"));
+    ASSERT_EQ(*batch.findColumn("y"), 2U);
+    ASSERT_DOCUMENT_EQ(batch.getDocument(1), Document(fromjson("{x: 'y', a: 2, y: 'y'}")));
+}
+
+TEST(ColumnBatchTest, SelectionListsRemainingRows) {
+    ColumnBatch batch({"a"});
+    for (int i = 0; i < 100; ++i) {
+        batch.appendRow(BSON("a" << i));
+    }
+    ASSERT_EQ(batch.getSelection().size(), 100U);
+
+    batch.setSelection({3, 70, 99});
+    ASSERT(batch.getSelection() == std::vector<uint32_t>({3, 70, 99}));
+    ASSERT_VALUE_EQ(batch.getColumn(0).getValue(70), Value(70));
+}
+
+}  // namespace
+}  // namespace mongo
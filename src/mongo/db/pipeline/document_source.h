@@ -45,6 +45,7 @@
 #include "mongo/db/generic_cursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/column_batch.h"
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -433,6 +434,25 @@ public:
      */
     virtual GetNextResult getNext() = 0;
 
+    /**
+     * Returns true if getNextColumnBatch() may be called instead of getNext(). Stages that support
+     * column batches only do so if their source does too; a consumer uses one or the other for the
+     * whole execution.
+     */
+    virtual bool canProduceColumnBatches() const {
+        return false;
+    }
+
+    /**
+     * Returns the next run of results as a batch with at least one selected row, or nullptr once
+     * the input is exhausted. Only called if canProduceColumnBatches() returned true.
+     *
+     * All implementers must call pExpCtx->checkForInterrupt().
+     */
+    virtual std::unique_ptr<ColumnBatch> getNextColumnBatch() {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Returns a struct containing information about any special constraints imposed on using this
      * stage. Input parameter Pipeline::SplitState is used by stages whose requirements change
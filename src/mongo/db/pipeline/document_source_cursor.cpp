@@ -35,6 +35,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/find_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/util/scopeguard.h"
 
@@ -63,7 +64,19 @@ DocumentSource::GetNextResult DocumentSourceCursor::getNext() {
     return std::move(out);
 }
 
-void DocumentSourceCursor::loadBatch() {
+std::unique_ptr<ColumnBatch> DocumentSourceCursor::getNextColumnBatch() {
+    pExpCtx->checkForInterrupt();
+    invariant(_columnBatchFields);
+
+    auto batch = stdx::make_unique<ColumnBatch>(*_columnBatchFields);
+    loadBatch(batch.get());
+    if (batch->numRows() == 0) {
+        return nullptr;
+    }
+    return batch;
+}
+
+void DocumentSourceCursor::loadBatch(ColumnBatch* columnBatch) {
     if (!_exec || _exec->isDisposed()) {
         // No more documents.
         return;
@@ -83,7 +96,9 @@ void DocumentSourceCursor::loadBatch() {
             ON_BLOCK_EXIT([this] { recordPlanSummaryStats(); });
 
             while ((state = _exec->getNext(&resultObj, nullptr)) == PlanExecutor::ADVANCED) {
-                if (_shouldProduceEmptyDocs) {
+                if (columnBatch) {
+                    columnBatch->appendRow(resultObj.getOwned());
+                } else if (_shouldProduceEmptyDocs) {
                     _currentBatch.push_back(Document());
                 } else if (_dependencies) {
                     _currentBatch.push_back(_dependencies->extractFields(resultObj));
@@ -98,7 +113,8 @@ void DocumentSourceCursor::loadBatch() {
                     verify(_docsAddedToBatches < _limit->getLimit());
                 }
 
-                memUsageBytes += _currentBatch.back().getApproximateSize();
+                memUsageBytes += columnBatch ? resultObj.objsize()
+                                             : _currentBatch.back().getApproximateSize();
 
                 // As long as we're waiting for inserts, we shouldn't do any batching at this level
                 // we need the whole pipeline to see each document to see if we should stop waiting.
@@ -106,7 +122,10 @@ void DocumentSourceCursor::loadBatch() {
                 // needs-merge case), batching will result in a wrong time.
                 if (awaitDataState(pExpCtx->opCtx).shouldWaitForInserts ||
                     (pExpCtx->isTailableAwaitData() && pExpCtx->needsMerge) ||
-                    memUsageBytes > internalDocumentSourceCursorBatchSizeBytes.load()) {
+                    memUsageBytes > internalDocumentSourceCursorBatchSizeBytes.load() ||
+                    (columnBatch &&
+                     columnBatch->numRows() >=
+                         static_cast<size_t>(internalDocumentSourceColumnBatchSize.load()))) {
                     // End this batch and prepare PlanExecutor for yielding.
                     _exec->saveState();
                     return;
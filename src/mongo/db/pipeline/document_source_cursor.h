@@ -47,6 +47,10 @@ class DocumentSourceCursor final : public DocumentSource {
 public:
     // virtuals from DocumentSource
     GetNextResult getNext() final;
+    bool canProduceColumnBatches() const final {
+        return _columnBatchFields.is_initialized();
+    }
+    std::unique_ptr<ColumnBatch> getNextColumnBatch() final;
     const char* getSourceName() const final;
     BSONObjSet getOutputSorts() final {
         return _outputSorts;
@@ -134,6 +138,14 @@ public:
         _shouldProduceEmptyDocs = true;
     }
 
+    /**
+     * Allows a consumer to read column batches with one column for each of 'fieldNames', which
+     * must be distinct top-level fields that cover everything the later stages depend on.
+     */
+    void setColumnBatchFields(std::vector<std::string> fieldNames) {
+        _columnBatchFields = std::move(fieldNames);
+    }
+
     Timestamp getLatestOplogTimestamp() const {
         if (_exec) {
             return _exec->getLatestOplogTimestamp();
@@ -180,9 +192,10 @@ private:
     void cleanupExecutor(const AutoGetCollectionForRead& readLock);
 
     /**
-     * Reads a batch of data from '_exec'.
+     * Reads a batch of data from '_exec', into 'columnBatch' if it is given and into
+     * '_currentBatch' otherwise.
      */
-    void loadBatch();
+    void loadBatch(ColumnBatch* columnBatch = nullptr);
 
     void recordPlanSummaryStats();
 
@@ -194,6 +207,7 @@ private:
     BSONObj _projection;
     bool _shouldProduceEmptyDocs = false;
     boost::optional<ParsedDeps> _dependencies;
+    boost::optional<std::vector<std::string>> _columnBatchFields;
     boost::intrusive_ptr<DocumentSourceLimit> _limit;
     long long _docsAddedToBatches;  // for _limit enforcement
 
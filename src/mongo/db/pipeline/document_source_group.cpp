@@ -38,6 +38,8 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
@@ -70,57 +72,25 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
-        return getNextSpilled();
-    } else if (_streaming) {
+    if (_streaming) {
         return getNextStreaming();
     } else {
         return getNextStandard();
     }
 }
 
-DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
-    // We aren't streaming, and we have spilled to disk.
-    if (!_sorterIterator)
-        return GetNextResult::makeEOF();
-
-    _currentId = _firstPartOfNextGroup.first;
-    const size_t numAccumulators = _accumulatedFields.size();
-    while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
-        // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
-        // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
-                }
-            }
-        }
-
-        if (!_sorterIterator->more()) {
-            dispose();
-            break;
-        }
-
-        _firstPartOfNextGroup = _sorterIterator->next();
-    }
-
-    return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
-}
-
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
-    // Not spilled, and not streaming.
-    if (_groups->empty())
-        return GetNextResult::makeEOF();
+    // Not streaming. Once the groups in memory are exhausted, move on to the next partition that
+    // was spilled to disk, if any.
+    while (groupsIterator == _groups->end()) {
+        if (_pendingPartitions.empty())
+            return GetNextResult::makeEOF();
+        loadSpilledPartition();
+    }
 
     Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
 
-    if (++groupsIterator == _groups->end())
+    if (++groupsIterator == _groups->end() && _pendingPartitions.empty())
         dispose();
 
     return std::move(out);
@@ -167,7 +137,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-    _sorterIterator.reset();
+    _partitions.clear();
+    _pendingPartitions.clear();
+    _memoryUsageBytes = 0;
+    chargeStageMemory(true);
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -224,6 +197,30 @@ Value DocumentSourceGroup::serialize(boost::optional<ExplainOptions::Verbosity>
     if (explain && findRelevantInputSort()) {
         return Value(DOC("$streamingGroup" << insides.freeze()));
     }
+
+    if (explain && *explain >= ExplainOptions::Verbosity::kExecStats && _spilled) {
+        // Report how the spilled top-level partitions behaved, if this stage has run.
+        vector<Value> partitions;
+        for (size_t i = 0; i < _spillStats.size(); i++) {
+            const SpillPartitionStats& stats = _spillStats[i];
+            if (stats.numSpills == 0) {
+                continue;
+            }
+            MutableDocument partition;
+            partition["partition"] = Value(static_cast<long long>(i));
+            partition["spills"] = Value(stats.numSpills);
+            partition["groupsSpilled"] = Value(stats.groupsSpilled);
+            partition["bytesSpilled"] = Value(stats.bytesSpilled);
+            partitions.push_back(partition.freezeToValue());
+        }
+
+        MutableDocument spillStats;
+        spillStats["numPartitions"] = Value(static_cast<long long>(_spillStats.size()));
+        spillStats["repartitions"] = Value(_numRepartitions);
+        spillStats["spilledPartitions"] = Value(std::move(partitions));
+        return Value(DOC(getSourceName() << insides.freeze() << "spillStats"
+                                         << spillStats.freeze()));
+    }
     return Value(DOC(getSourceName() << insides.freeze()));
 }
 
@@ -268,6 +265,12 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _spilled(false),
       _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {}
 
+DocumentSourceGroup::~DocumentSourceGroup() {
+    if (_chargedMemoryBytes != 0) {
+        globalStageMemCounters.reserveGroupMemSize(-_chargedMemoryBytes);
+    }
+}
+
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
     _accumulatedFields.push_back(accumulationStatement);
 }
@@ -357,34 +360,6 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
 
 namespace {
 
-using GroupsMap = DocumentSourceGroup::GroupsMap;
-
-class SorterComparator {
-public:
-    typedef pair<Value, Value> Data;
-
-    SorterComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
-
-    int operator()(const Data& lhs, const Data& rhs) const {
-        return _valueComparator.compare(lhs.first, rhs.first);
-    }
-
-private:
-    ValueComparator _valueComparator;
-};
-
-class SpillSTLComparator {
-public:
-    SpillSTLComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
-
-    bool operator()(const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-        return _valueComparator.evaluate(lhs->first < rhs->first);
-    }
-
-private:
-    ValueComparator _valueComparator;
-};
-
 bool containsOnlyFieldPathsAndConstants(ExpressionObject* expressionObj) {
     for (auto&& it : expressionObj->getChildExpressions()) {
         const intrusive_ptr<Expression>& childExp = it.second;
@@ -427,25 +402,6 @@ void getFieldPathMap(ExpressionObject* expressionObj,
     }
 }
 
-void getFieldPathListForSpilled(ExpressionObject* expressionObj,
-                                std::string prefix,
-                                std::vector<std::string>* fields) {
-    // Given an expression, attempt to compute a vector of strings, each representing the path
-    // through the object to a leaf. For example, for the expression represented by
-    // {x: 2, y: {z: "$a.b"}}, the output would be ["x", "y.z"].
-    for (auto&& it : expressionObj->getChildExpressions()) {
-        intrusive_ptr<Expression> childExp = it.second;
-        ExpressionObject* expObj = dynamic_cast<ExpressionObject*>(childExp.get());
-
-        std::string newPrefix = prefix.empty() ? it.first : prefix + "." + it.first;
-
-        if (expObj) {
-            getFieldPathListForSpilled(expObj, newPrefix, fields);
-        } else {
-            fields->push_back(newPrefix);
-        }
-    }
-}
 }  // namespace
 
 DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
@@ -478,148 +434,481 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     }
 
 
-    // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
-    GetNextResult input = pSource->getNext();
-    for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
+    GetNextResult input = GetNextResult::makeEOF();
+    if (canAccumulateColumnBatches() && pSource->canProduceColumnBatches()) {
+        // Column batches never pause, so this loop exhausts 'pSource' and populates '_groups'.
+        while (auto batch = pSource->getNextColumnBatch()) {
+            accumulateColumnBatch(*batch);
+        }
+    } else {
+        // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
+        for (input = pSource->getNext(); input.isAdvanced(); input = pSource->getNext()) {
+            spillIfOverMemoryLimit();
+
+            // We release the result document here so that it does not outlive the end of this
+            // loop iteration. Not releasing could lead to an array copy when this group follows an
+            // unwind.
+            auto rootDocument = input.releaseDocument();
+            spillOnDuplicateForTesting(accumulate(rootDocument));
         }
+    }
 
-        // We release the result document here so that it does not outlive the end of this loop
-        // iteration. Not releasing could lead to an array copy when this group follows an unwind.
-        auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
+    switch (input.getStatus()) {
+        case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
+            MONGO_UNREACHABLE;  // We consumed all advances above.
+        }
+        case DocumentSource::GetNextResult::ReturnStatus::kPauseExecution: {
+            return input;  // Propagate pause.
+        }
+        case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
+            // Do any final steps necessary to prepare to output results. The groups of partitions
+            // that never spilled are returned first, straight from memory, and each spilled
+            // partition is then re-aggregated on its own once those run out.
+            if (_spilled) {
+                finishSpilledPartitions();
+            }
+
+            // start the group iterator
+            groupsIterator = _groups->begin();
+
+            // This must happen last so that, unless control gets here, we will re-enter
+            // initialization after getting a GetNextResult::ResultState::kPauseExecution.
+            _initialized = true;
+            return input;
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
+bool DocumentSourceGroup::accumulate(const Document& root) {
+    Value id = computeId(root);
+
+    bool inserted;
+    Accumulators& group = findGroup(id, &inserted);
+
+    /* tickle all the accumulators for the group we found */
+    const size_t numAccumulators = _accumulatedFields.size();
+    dassert(numAccumulators == group.size());
+
+    for (size_t i = 0; i < numAccumulators; i++) {
+        group[i]->process(_accumulatedFields[i].expression->evaluate(root), _doingMerge);
+
+        _memoryUsageBytes += group[i]->memUsageForSorter();
+    }
+    chargeStageMemory();
+    return inserted;
+}
+
+namespace {
+
+/**
+ * Returns true if 'expression' is a constant or a top-level field of the current document.
+ */
+bool canReadFromColumns(const Expression& expression) {
+    if (dynamic_cast<const ExpressionConstant*>(&expression)) {
+        return true;
+    }
+    auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(&expression);
+    return fieldPath && fieldPath->isRootFieldPath() &&
+        fieldPath->getFieldPath().getPathLength() == 2;
+}
+
+/**
+ * Where an expression of a $group reads its value for a row of a column batch: a column, or a
+ * constant. A top-level field without a column is missing from every row, as the batch has a
+ * column for every field that the stages before the $group depend on or output.
+ */
+struct ColumnInput {
+    boost::optional<size_t> column;
+    Value constant;
+};
 
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
+ColumnInput bindToColumns(const Expression& expression, const ColumnBatch& batch) {
+    invariant(canReadFromColumns(expression));
+    ColumnInput input;
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(&expression)) {
+        input.constant = constant->getValue();
+    } else {
+        auto fieldPath = static_cast<const ExpressionFieldPath*>(&expression);
+        input.column = batch.findColumn(fieldPath->getFieldPath().getFieldName(1));
+    }
+    return input;
+}
 
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
+}  // namespace
 
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+bool DocumentSourceGroup::canAccumulateColumnBatches() const {
+    for (auto&& expression : _idExpressions) {
+        if (!canReadFromColumns(*expression)) {
+            return false;
+        }
+    }
+    for (auto&& accumulatedField : _accumulatedFields) {
+        if (!canReadFromColumns(*accumulatedField.expression)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DocumentSourceGroup::accumulateColumnBatch(const ColumnBatch& batch) {
+    std::vector<ColumnInput> idInputs;
+    idInputs.reserve(_idExpressions.size());
+    for (auto&& expression : _idExpressions) {
+        idInputs.push_back(bindToColumns(*expression, batch));
+    }
+
+    const size_t numAccumulators = _accumulatedFields.size();
+    std::vector<ColumnInput> accumulatorInputs;
+    accumulatorInputs.reserve(numAccumulators);
+    for (auto&& accumulatedField : _accumulatedFields) {
+        accumulatorInputs.push_back(bindToColumns(*accumulatedField.expression, batch));
+    }
+
+    for (auto row : batch.getSelection()) {
+        spillIfOverMemoryLimit();
+
+        auto evaluate = [&](const ColumnInput& input) {
+            return input.column ? batch.getColumn(*input.column).getValue(row) : input.constant;
+        };
+
+        // Mirrors computeId().
+        Value id;
+        if (_idExpressions.size() == 1) {
+            id = evaluate(idInputs[0]);
+            if (id.missing()) {
+                id = Value(BSONNULL);
             }
         } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
+            vector<Value> vals;
+            vals.reserve(_idExpressions.size());
+            for (size_t i = 0; i < _idExpressions.size(); i++) {
+                vals.push_back(evaluate(idInputs[i]));
             }
+            id = Value(std::move(vals));
         }
 
-        /* tickle all the accumulators for the group we found */
+        bool inserted;
+        Accumulators& group = findGroup(id, &inserted);
         dassert(numAccumulators == group.size());
 
         for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
-                              _doingMerge);
+            group[i]->process(evaluate(accumulatorInputs[i]), _doingMerge);
 
             _memoryUsageBytes += group[i]->memUsageForSorter();
         }
+        chargeStageMemory();
+        spillOnDuplicateForTesting(inserted);
+    }
+}
+
+void DocumentSourceGroup::spillIfOverMemoryLimit() {
+    if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+        uassert(16945,
+                "Exceeded memory limit for $group, but didn't allow external sort."
+                " Pass allowDiskUse:true to opt in.",
+                _allowDiskUse);
+        spillPartitions(true);
+    } else if (shouldSpillOnGlobalLimit()) {
+        spillPartitions(true);
+    }
+}
 
-        if (kDebugBuild && !storageGlobalParams.readOnly) {
-            // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
-                !pExpCtx->inMongos &&        // can't spill to disk in mongos
-                !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+void DocumentSourceGroup::spillOnDuplicateForTesting(bool inserted) {
+    if (kDebugBuild && !storageGlobalParams.readOnly) {
+        // In debug mode, spill every time we have a duplicate id to stress merge logic.
+        if (!inserted &&           // is a dup
+            !pExpCtx->inMongos &&  // can't spill to disk in mongos
+            !_allowDiskUse &&      // don't change behavior when testing external sort
+            _numSpills < 20) {     // don't write too many small files
 
-                _sortedFiles.push_back(spill());
-            }
+            spillPartitions(true);
         }
     }
+}
 
-    switch (input.getStatus()) {
-        case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
-            MONGO_UNREACHABLE;  // We consumed all advances above.
-        }
-        case DocumentSource::GetNextResult::ReturnStatus::kPauseExecution: {
-            return input;  // Propagate pause.
-        }
-        case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
-            // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
-                _spilled = true;
-                if (!_groups->empty()) {
-                    _sortedFiles.push_back(spill());
-                }
-
-                // We won't be using groups again so free its memory.
-                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-
-                _sorterIterator.reset(Sorter<Value, Value>::Iterator::merge(
-                    _sortedFiles, SortOptions(), SorterComparator(pExpCtx->getValueComparator())));
-
-                // prepare current to accumulate data
-                _currentAccumulators.reserve(numAccumulators);
-                for (auto&& accumulatedField : _accumulatedFields) {
-                    _currentAccumulators.push_back(accumulatedField.makeAccumulator(pExpCtx));
-                }
-
-                verify(_sorterIterator->more());  // we put data in, we should get something out.
-                _firstPartOfNextGroup = _sorterIterator->next();
-            } else {
-                // start the group iterator
-                groupsIterator = _groups->begin();
-            }
+intrusive_ptr<DocumentSourceGroup> DocumentSourceGroup::clonePartial(
+    size_t maxMemoryUsageBytes) const {
+    // Parsing our own specification gives the clone expressions, and thus variables, of its own.
+    const BSONObj spec = serialize().getDocument().toBson();
+    intrusive_ptr<DocumentSourceGroup> clone(static_cast<DocumentSourceGroup*>(
+        createFromBson(spec.firstElement(), pExpCtx->copyWith(pExpCtx->ns)).get()));
+    clone->_maxMemoryUsageBytes = maxMemoryUsageBytes;
+    clone->_partialClone = true;
+    return clone;
+}
 
-            // This must happen last so that, unless control gets here, we will re-enter
-            // initialization after getting a GetNextResult::ResultState::kPauseExecution.
-            _initialized = true;
-            return input;
-        }
+bool DocumentSourceGroup::addToPartialGroups(const Document& root) {
+    accumulate(root);
+    return _memoryUsageBytes > _maxMemoryUsageBytes;
+}
+
+vector<Document> DocumentSourceGroup::releasePartialGroups() {
+    vector<Document> partialGroups;
+    partialGroups.reserve(_groups->size());
+    for (auto&& group : *_groups) {
+        partialGroups.push_back(makeDocument(group.first, group.second, /*mergeableOutput=*/true));
     }
-    MONGO_UNREACHABLE;
+    _groups->clear();
+    _memoryUsageBytes = 0;
+    chargeStageMemory(true);
+    return partialGroups;
 }
 
-shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-    vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
-    ptrs.reserve(_groups->size());
-    for (GroupsMap::const_iterator it = _groups->begin(), end = _groups->end(); it != end; ++it) {
-        ptrs.push_back(&*it);
+namespace {
+
+size_t groupMemoryUsage(const Value& id, const DocumentSourceGroup::Accumulators& accums) {
+    size_t bytes = id.getApproximateSize();
+    for (auto&& accum : accums) {
+        bytes += accum->memUsageForSorter();
     }
+    return bytes;
+}
 
-    stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(pExpCtx->getValueComparator()));
+void writePartialGroup(SortedFileWriter<Value, Value>* writer,
+                       const Value& id,
+                       const DocumentSourceGroup::Accumulators& accums) {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            writer->addAlreadySorted(id, Value());
+            break;
 
-    SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+        case 1:  // just one value, use optimized serialization as single Value
+            writer->addAlreadySorted(id, accums[0]->getValue(/*toBeMerged=*/true));
+            break;
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
             }
+            writer->addAlreadySorted(id, Value(std::move(states)));
             break;
+        }
+    }
+}
 
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+void mergePartialGroup(const Value& state, const DocumentSourceGroup::Accumulators& accums) {
+    switch (accums.size()) {  // mirrors switch in writePartialGroup()
+        case 0:  // No accumulators so no Values.
+            break;
+
+        case 1:  // Single accumulators serialize as a single Value.
+            accums[0]->process(state, true);
+            break;
+
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& states = state.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(states[i], true);
             }
             break;
+        }
+    }
+}
+
+}  // namespace
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::findGroup(const Value& id,
+                                                                  bool* inserted) {
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    *inserted = _groups->size() != oldSize;
+
+    if (*inserted) {
+        _memoryUsageBytes += id.getApproximateSize();
+
+        // Add the accumulators
+        group.reserve(_accumulatedFields.size());
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+        }
+    } else {
+        for (auto&& groupObj : group) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryUsageBytes -= groupObj->memUsageForSorter();
+        }
+    }
+    return group;
+}
+
+size_t DocumentSourceGroup::partitionFor(const Value& id) const {
+    uint64_t hash = pExpCtx->getValueComparator().hash(id);
+
+    // Salt with the depth and mix so that every level draws on different bits of the hash.
+    hash ^= 0x9e3779b97f4a7c15ULL * (_partitionDepth + 1);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash % _partitions.size();
+}
+
+void DocumentSourceGroup::noteBytesSpilled(size_t partition) {
+    auto& part = _partitions[partition];
+    const uint64_t bytes = part.writer->bytesWritten() - part.bytesAccounted;
+    if (bytes == 0) {
+        return;
+    }
+    part.bytesAccounted += bytes;
+    if (_partitionDepth == 0) {
+        _spillStats[partition].bytesSpilled += bytes;
+    }
+    globalStageMemCounters.noteGroupSpill(bytes);
+}
+
+void DocumentSourceGroup::spillPartitions(bool spillHotPartitions) {
+    if (_partitions.empty()) {
+        _partitions.resize(internalDocumentSourceGroupSpillPartitions.load());
+        if (_partitionDepth == 0) {
+            _spillStats.resize(_partitions.size());
+        }
+    }
+    const size_t numPartitions = _partitions.size();
+
+    // Find out which partition each group belongs to, and how much memory each partition holds.
+    // Iteration order over '_groups' is stable until we erase from it below.
+    vector<uint16_t> partitionOfGroup;
+    partitionOfGroup.reserve(_groups->size());
+    vector<size_t> partitionBytes(numPartitions, 0);
+    for (auto&& group : *_groups) {
+        const size_t partition = partitionFor(group.first);
+        partitionOfGroup.push_back(partition);
+        partitionBytes[partition] += groupMemoryUsage(group.first, group.second);
+    }
+
+    // Partitions that have spilled already are cold: they will be re-aggregated from disk
+    // anyway, so their groups go first. Only then are more partitions given up, largest first.
+    vector<bool> flush(numPartitions, false);
+    size_t bytesReleased = 0;
+    for (size_t i = 0; i < numPartitions; i++) {
+        if (_partitions[i].writer) {
+            flush[i] = true;
+            bytesReleased += partitionBytes[i];
+        }
+    }
+    while (spillHotPartitions && bytesReleased < _memoryUsageBytes / 2) {
+        size_t largest = numPartitions;
+        for (size_t i = 0; i < numPartitions; i++) {
+            if (!flush[i] && partitionBytes[i] > 0 &&
+                (largest == numPartitions || partitionBytes[i] > partitionBytes[largest])) {
+                largest = i;
             }
+        }
+        if (largest == numPartitions) {
             break;
+        }
+        flush[largest] = true;
+        bytesReleased += partitionBytes[largest];
+        _partitions[largest].writer = stdx::make_unique<SortedFileWriter<Value, Value>>(
+            SortOptions().TempDir(pExpCtx->tempDir));
+    }
+
+    vector<long long> groupsFlushed(numPartitions, 0);
+    size_t groupIndex = 0;
+    for (auto it = _groups->begin(); it != _groups->end(); ++groupIndex) {
+        const size_t partition = partitionOfGroup[groupIndex];
+        if (!flush[partition]) {
+            ++it;
+            continue;
+        }
+        writePartialGroup(_partitions[partition].writer.get(), it->first, it->second);
+        ++groupsFlushed[partition];
+        it = _groups->erase(it);
+    }
+
+    for (size_t i = 0; i < numPartitions; i++) {
+        if (groupsFlushed[i] == 0) {
+            continue;
+        }
+        if (_partitionDepth == 0) {
+            _spillStats[i].numSpills++;
+            _spillStats[i].groupsSpilled += groupsFlushed[i];
+        }
+        noteBytesSpilled(i);
+    }
+
+    _memoryUsageBytes -= std::min(bytesReleased, _memoryUsageBytes);
+    chargeStageMemory(true);
+    _numSpills++;
+    _spilled = true;
+}
+
+void DocumentSourceGroup::finishSpilledPartitions() {
+    spillPartitions(false);
+
+    for (size_t i = 0; i < _partitions.size(); i++) {
+        auto& part = _partitions[i];
+        if (!part.writer) {
+            continue;
+        }
+        SpilledPartitionIterator file(part.writer->done());
+        noteBytesSpilled(i);
+        _pendingPartitions.emplace_back(std::move(file), _partitionDepth);
     }
+    _partitions.clear();
+}
+
+void DocumentSourceGroup::loadSpilledPartition() {
+    invariant(!_pendingPartitions.empty());
+    SpilledPartitionIterator file = std::move(_pendingPartitions.back().first);
+    _partitionDepth = _pendingPartitions.back().second + 1;
+    _pendingPartitions.pop_back();
 
     _groups->clear();
+    _memoryUsageBytes = 0;
+    chargeStageMemory(true);
+
+    // Sub-partitions are only created if this partition turns out not to fit in memory.
+    invariant(_partitions.empty());
+    while (file->more()) {
+        if (_partitionDepth < kMaxSpillDepth &&
+            (_memoryUsageBytes > _maxMemoryUsageBytes || shouldSpillOnGlobalLimit())) {
+            spillPartitions(true);
+        }
+
+        const auto partialGroup = file->next();
+        bool inserted;
+        Accumulators& group = findGroup(partialGroup.first, &inserted);
+        mergePartialGroup(partialGroup.second, group);
+        for (auto&& accum : group) {
+            _memoryUsageBytes += accum->memUsageForSorter();
+        }
+        chargeStageMemory();
+    }
+    file.reset();
+
+    if (!_partitions.empty()) {
+        _numRepartitions++;
+        finishSpilledPartitions();
+    }
+    groupsIterator = _groups->begin();
+}
 
-    return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+void DocumentSourceGroup::chargeStageMemory(bool force) {
+    if (_partialClone) {
+        return;
+    }
+    const int64_t delta = static_cast<int64_t>(_memoryUsageBytes) - _chargedMemoryBytes;
+    if (delta == 0) {
+        return;
+    }
+    if (!force && std::abs(delta) < internalQueryStageMemReserveChunkBytes.load()) {
+        return;
+    }
+    globalStageMemCounters.reserveGroupMemSize(delta);
+    _chargedMemoryBytes += delta;
+}
+
+bool DocumentSourceGroup::shouldSpillOnGlobalLimit() const {
+    if (!_allowDiskUse || !internalQueryStageMemSpillOnGlobalLimit.load() || _groups->empty()) {
+        return false;
+    }
+    return globalStageMemCounters.chkCachedMemOversize(_memoryUsageBytes, nullptr, nullptr) ==
+        StageMemCounter::LimitLevel::kGlobal;
 }
 
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
@@ -691,31 +980,28 @@ boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
 BSONObjSet DocumentSourceGroup::getOutputSorts() {
     if (!_initialized) {
         initialize();  // Note this might not finish initializing, but that's OK. We just want to
-                       // do some initialization to try to determine if we are streaming or spilled.
-                       // False negatives are OK.
+                       // do some initialization to try to determine if we are streaming. False
+                       // negatives are OK.
     }
 
-    if (!(_streaming || _spilled)) {
+    // Spilled partitions are output one after the other in hash order, so only a streaming $group
+    // produces sorted output.
+    if (!_streaming) {
         return SimpleBSONObjComparator::kInstance.makeBSONObjSet();
     }
 
     BSONObjBuilder sortOrder;
 
     if (_idFieldNames.empty()) {
-        if (_spilled) {
-            sortOrder.append("_id", 1);
-        } else {
-            // We have an expression like {_id: "$a"}. Check if this is a FieldPath, and if it is,
-            // get the sort order out of it.
-            if (auto obj = dynamic_cast<ExpressionFieldPath*>(_idExpressions[0].get())) {
-                FieldPath _idSort = obj->getFieldPath();
-
-                sortOrder.append(
-                    "_id",
-                    _inputSort.getIntField(_idSort.getFieldName(_idSort.getPathLength() - 1)));
-            }
+        // We have an expression like {_id: "$a"}. Check if this is a FieldPath, and if it is,
+        // get the sort order out of it.
+        if (auto obj = dynamic_cast<ExpressionFieldPath*>(_idExpressions[0].get())) {
+            FieldPath _idSort = obj->getFieldPath();
+
+            sortOrder.append(
+                "_id", _inputSort.getIntField(_idSort.getFieldName(_idSort.getPathLength() - 1)));
         }
-    } else if (_streaming) {
+    } else {
         // At this point, we know that _streaming is true, so _id must have only contained
         // ExpressionObjects, ExpressionConstants or ExpressionFieldPaths. We now process each
         // '_idExpression'.
@@ -749,21 +1035,6 @@ BSONObjSet DocumentSourceGroup::getOutputSorts() {
 
             sortOrder.append(itr->second, _inputSort.getIntField(sortString));
         }
-    } else {
-        // We are blocking and have spilled to disk.
-        std::vector<std::string> outputSort;
-        for (size_t i = 0; i < _idFieldNames.size(); i++) {
-            intrusive_ptr<Expression> exp = _idExpressions[i];
-            if (auto obj = dynamic_cast<ExpressionObject*>(exp.get())) {
-                // _id is an object containing a nested document, such as: {_id: {x: {y: "$b"}}}.
-                getFieldPathListForSpilled(obj, "_id." + _idFieldNames[i], &outputSort);
-            } else {
-                outputSort.push_back("_id." + _idFieldNames[i]);
-            }
-        }
-        for (auto&& field : outputSort) {
-            sortOrder.append(field, 1);
-        }
     }
 
     return allPrefixes(sortOrder.obj());
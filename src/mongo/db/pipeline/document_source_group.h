@@ -45,6 +45,24 @@ public:
 
     static const size_t kDefaultMaxMemoryUsageBytes = 100 * 1024 * 1024;
 
+    // A spilled partition that still does not fit in memory is split again, at most this many
+    // times. Past that its groups are aggregated in memory regardless of the limit.
+    static const unsigned kMaxSpillDepth = 8;
+
+    /**
+     * What happened to one top-level hash partition while spilling. Reported by explain.
+     */
+    struct SpillPartitionStats {
+        // Number of times the partition's resident groups were flushed to disk.
+        long long numSpills = 0;
+        // Number of partial group states written.
+        long long groupsSpilled = 0;
+        // Bytes written to the partition's file, after compression.
+        long long bytesSpilled = 0;
+    };
+
+    ~DocumentSourceGroup();
+
     // Virtuals from DocumentSource.
     boost::intrusive_ptr<DocumentSource> optimize() final;
     GetDepsReturn getDependencies(DepsTracker* deps) const final;
@@ -99,6 +117,50 @@ public:
         return _streaming;
     }
 
+    /**
+     * Per-partition spill statistics, indexed by top-level partition. Empty if nothing spilled.
+     */
+    const std::vector<SpillPartitionStats>& getSpillStats() const {
+        return _spillStats;
+    }
+
+    /**
+     * Number of spilled partitions that were too large to re-aggregate in memory and were split
+     * into sub-partitions.
+     */
+    long long getNumRepartitions() const {
+        return _numRepartitions;
+    }
+
+    /**
+     * Returns a new $group with the same specification and its own ExpressionContext, for another
+     * thread to build partial groups with. Its groups are released rather than spilled once they
+     * use more than 'maxMemoryUsageBytes', and merged by the stage from getMergeSources(). The
+     * clone does not charge globalStageMemCounters itself; whoever runs it charges
+     * getMemoryUsageBytes().
+     */
+    boost::intrusive_ptr<DocumentSourceGroup> clonePartial(size_t maxMemoryUsageBytes) const;
+
+    /**
+     * Adds 'root' to the groups held in memory, instead of pulling input with getNext(). Returns
+     * true once they use more memory than allowed and should be taken with
+     * releasePartialGroups().
+     */
+    bool addToPartialGroups(const Document& root);
+
+    /**
+     * Returns the groups held in memory, as documents the stage from getMergeSources() can merge,
+     * and forgets them.
+     */
+    std::vector<Document> releasePartialGroups();
+
+    /**
+     * Returns roughly how many bytes the groups held in memory use.
+     */
+    size_t getMemoryUsageBytes() const {
+        return _memoryUsageBytes;
+    }
+
     // Virtuals for NeedsMergerDocumentSource.
     boost::intrusive_ptr<DocumentSource> getShardSource() final;
     std::list<boost::intrusive_ptr<DocumentSource>> getMergeSources() final;
@@ -110,13 +172,23 @@ private:
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx,
                                  size_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes);
 
+    using SpilledPartitionIterator = std::shared_ptr<Sorter<Value, Value>::Iterator>;
+
+    /**
+     * A hash partition of '_groups'. Once spilled, the partition owns a file that receives the
+     * partial states of its groups whenever they are flushed out of memory.
+     */
+    struct SpillPartition {
+        std::unique_ptr<SortedFileWriter<Value, Value>> writer;
+        uint64_t bytesAccounted = 0;  // Part of writer->bytesWritten() already in the stats.
+    };
+
     /**
-     * getNext() dispatches to one of these three depending on what type of $group it is. All three
-     * of these methods expect '_currentAccumulators' to have been reset before being called, and
+     * getNext() dispatches to one of these two depending on what type of $group it is. Both of
+     * these methods expect '_currentAccumulators' to have been reset before being called, and
      * also expect initialize() to have been called already.
      */
     GetNextResult getNextStreaming();
-    GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
 
     /**
@@ -138,11 +210,86 @@ private:
     GetNextResult initialize();
 
     /**
-     * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
-     * does not exhaust the previous stage before returning, and thus does not maintain as large a
-     * store of documents at any one time, only an unsorted group can spill to disk.
+     * Adds 'root' to its group in '_groups'. Returns true if the group is new.
+     */
+    bool accumulate(const Document& root);
+
+    /**
+     * Returns true if the _id and every accumulator argument are constants or top-level fields, so
+     * that they can be read straight from column batches. Other expressions, such as $$ROOT, need
+     * the input documents as the stages before this one build them, including their field order.
+     */
+    bool canAccumulateColumnBatches() const;
+
+    /**
+     * Adds the selected rows of 'batch' to their groups, reading the _id and accumulator arguments
+     * from the columns. Only called if canAccumulateColumnBatches() returned true.
+     */
+    void accumulateColumnBatch(const ColumnBatch& batch);
+
+    /**
+     * Called before each input is added. Spills once the group is over its memory limit, or fails
+     * if it may not spill.
+     */
+    void spillIfOverMemoryLimit();
+
+    /**
+     * In debug builds, spills every time an input was added to an existing group, to stress the
+     * merge logic.
+     */
+    void spillOnDuplicateForTesting(bool inserted);
+
+    /**
+     * Returns the accumulators of the group 'id', creating them if needed, and sets '*inserted'
+     * accordingly. The memory used by the group's accumulators is subtracted from
+     * '_memoryUsageBytes'; the caller adds it back once it has updated them.
+     */
+    Accumulators& findGroup(const Value& id, bool* inserted);
+
+    /**
+     * Releases memory by writing groups to their partitions' files as partial states. Groups of
+     * partitions that have already spilled are always written out. If 'spillHotPartitions' is
+     * set, the largest partitions still held in memory are spilled too, until at least half of
+     * '_memoryUsageBytes' has been released. Note: Since a sorted $group does not exhaust the
+     * previous stage before returning, and thus does not maintain as large a store of documents
+     * at any one time, only an unsorted group can spill to disk.
+     */
+    void spillPartitions(bool spillHotPartitions);
+
+    /**
+     * Called once the input of the current level is exhausted. Writes the remaining groups of
+     * spilled partitions to disk and queues their files for re-aggregation, leaving in '_groups'
+     * only the groups of partitions that never spilled.
+     */
+    void finishSpilledPartitions();
+
+    /**
+     * Re-aggregates the next queued partition into '_groups' by merging its partial states. A
+     * partition that does not fit in memory is split again with a differently salted hash.
+     */
+    void loadSpilledPartition();
+
+    /**
+     * Which of '_partitions' the group 'id' belongs to at the current '_partitionDepth'.
+     */
+    size_t partitionFor(const Value& id) const;
+
+    /**
+     * Adds what the partition's file has grown by to the stats and to globalStageMemCounters.
+     */
+    void noteBytesSpilled(size_t partition);
+
+    /// OOM feature
+    /**
+     * Brings the charge against globalStageMemCounters in line with '_memoryUsageBytes'. Unless
+     * 'force' is set, the charge only moves once it is off by a whole reservation chunk.
+     */
+    void chargeStageMemory(bool force = false);
+
+    /**
+     * True if the process-wide stage memory limit is exceeded and this $group may spill instead.
      */
-    std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
+    bool shouldSpillOnGlobalLimit() const;
 
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
@@ -162,6 +309,10 @@ private:
     bool _doingMerge;
     size_t _memoryUsageBytes = 0;
     size_t _maxMemoryUsageBytes;
+    // The part of '_memoryUsageBytes' currently charged to globalStageMemCounters.
+    int64_t _chargedMemoryBytes = 0;
+    // Set on clones from clonePartial(), whose memory the stage running them charges instead.
+    bool _partialClone = false;
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
@@ -177,17 +328,23 @@ private:
     // definition of equality.
     boost::optional<GroupsMap> _groups;
 
-    std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _sortedFiles;
+    // Hash partitions of the groups being built. Empty until the first spill.
+    std::vector<SpillPartition> _partitions;
+    // How many times the groups in '_partitions' have been partitioned already. Used to salt the
+    // hash so that a partition split again spreads over all of its sub-partitions.
+    unsigned _partitionDepth = 0;
+    // Files of spilled partitions waiting to be re-aggregated, with their '_partitionDepth'.
+    std::vector<std::pair<SpilledPartitionIterator, unsigned>> _pendingPartitions;
+    std::vector<SpillPartitionStats> _spillStats;
+    long long _numSpills = 0;
+    long long _numRepartitions = 0;
     bool _spilled;
 
-    // Only used when '_spilled' is false.
+    // Only used when '_streaming' is false.
     GroupsMap::iterator groupsIterator;
 
-    // Only used when '_spilled' is true.
-    std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     const bool _allowDiskUse;
 
-    std::pair<Value, Value> _firstPartOfNextGroup;
     // Only used when '_sorted' is true.
     boost::optional<Document> _firstDocOfNextGroup;
 };
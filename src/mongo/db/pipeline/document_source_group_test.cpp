@@ -189,6 +189,342 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+/**
+ * Groups 'numIds' ids, each seen 'copies' times, under a memory limit of 'maxMemoryUsageBytes'
+ * with spilling allowed. Each group sums its documents and averages and collects their copy
+ * numbers, which are checked for every id.
+ */
+intrusive_ptr<DocumentSourceGroup> runSpillingGroup(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    int numIds,
+    int copies,
+    size_t maxMemoryUsageBytes) {
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement avgStatement{"avg",
+                                       ExpressionFieldPath::parse(expCtx, "$copy", vps),
+                                       AccumulationStatement::getFactory("$avg")};
+    AccumulationStatement pushStatement{"copies",
+                                        ExpressionFieldPath::parse(expCtx, "$copy", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto group = DocumentSourceGroup::create(expCtx,
+                                             ExpressionFieldPath::parse(expCtx, "$_id", vps),
+                                             {countStatement, avgStatement, pushStatement},
+                                             maxMemoryUsageBytes);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int copy = 0; copy < copies; copy++) {
+        for (int id = 0; id < numIds; id++) {
+            inputs.push_back(Document{{"_id", id}, {"copy", copy}});
+        }
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    vector<Value> expectedCopies;
+    for (int copy = 0; copy < copies; copy++) {
+        expectedCopies.push_back(Value(copy));
+    }
+
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        Document doc = result.releaseDocument();
+        ASSERT_TRUE(idSet.insert(doc["_id"].coerceToInt()).second);
+        ASSERT_VALUE_EQ(doc["count"], Value(copies));
+        ASSERT_VALUE_EQ(doc["avg"], Value((copies - 1) / 2.0));
+
+        // Partial states are merged in the order they were spilled, which follows the input.
+        ASSERT_VALUE_EQ(doc["copies"], Value(expectedCopies));
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    ASSERT_EQ(idSet.size(), static_cast<size_t>(numIds));
+    return group;
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldReaggregateSpilledPartitions) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    auto group = runSpillingGroup(expCtx, 200, 3, 16 * 1024);
+
+    const auto& stats = group->getSpillStats();
+    ASSERT_EQ(stats.size(), 16UL);
+    for (auto&& partition : stats) {
+        if (partition.numSpills > 0) {
+            ASSERT_GT(partition.groupsSpilled, 0);
+            ASSERT_GT(partition.bytesSpilled, 0);
+        }
+    }
+    ASSERT_EQ(group->getNumRepartitions(), 0);
+
+    // Output of a spilled $group is not sorted on _id.
+    ASSERT_TRUE(group->getOutputSorts().empty());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldKeepSomePartitionsInMemoryWhenSlightlyOverMemoryLimit) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 56 * 1024;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, maxMemoryUsageBytes);
+
+    // 64 groups of a little over 1KB each only just exceed the limit.
+    string largeStr(1000, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int id = 0; id < 64; id++) {
+        inputs.push_back(Document{{"_id", id}, {"largeStr", largeStr}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        idSet.insert(result.releaseDocument()["_id"].coerceToInt());
+    }
+    ASSERT_EQ(idSet.size(), 64UL);
+
+    size_t spilledPartitions = 0;
+    for (auto&& partition : group->getSpillStats()) {
+        spilledPartitions += partition.numSpills > 0;
+    }
+    ASSERT_GT(spilledPartitions, 0UL);
+    ASSERT_LT(spilledPartitions, 16UL);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSplitPartitionsThatDoNotFitInMemory) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    // Each of the 16 top-level partitions holds about 250 groups, far more than fit in 4KB.
+    auto group = runSpillingGroup(expCtx, 4000, 2, 4 * 1024);
+    ASSERT_GT(group->getNumRepartitions(), 0);
+}
+
+TEST_F(DocumentSourceGroupTest, ExplainShouldReportSpilledPartitions) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    auto group = runSpillingGroup(expCtx, 200, 2, 4 * 1024);
+
+    vector<Value> explained;
+    group->serializeToArray(explained, ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(explained.size(), 1UL);
+    Document spillStats = explained[0]["spillStats"].getDocument();
+    ASSERT_VALUE_EQ(spillStats["numPartitions"], Value(16LL));
+    ASSERT_FALSE(spillStats["spilledPartitions"].getArray().empty());
+
+    // Query planner verbosity does not run anything, so there is nothing to report.
+    explained.clear();
+    group->serializeToArray(explained, ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_TRUE(explained[0]["spillStats"].missing());
+}
+
+TEST_F(DocumentSourceGroupTest, PartialGroupsFromClonesMergeToTheSameResult) {
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement avgStatement{"avg",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$avg")};
+    auto group = DocumentSourceGroup::create(expCtx,
+                                             ExpressionFieldPath::parse(expCtx, "$key", vps),
+                                             {sumStatement, avgStatement});
+
+    // Two clones, as if on two threads, each see half of the input. The tiny memory limit makes
+    // them release their groups after every document, so the same group is released repeatedly.
+    auto even = group->clonePartial(1);
+    auto odd = group->clonePartial(1);
+
+    deque<DocumentSource::GetNextResult> partialGroups;
+    for (int i = 0; i < 100; i++) {
+        auto clone = i % 2 ? odd : even;
+        if (clone->addToPartialGroups(Document{{"key", i % 3}, {"x", i}})) {
+            for (auto&& partialGroup : clone->releasePartialGroups()) {
+                partialGroups.emplace_back(std::move(partialGroup));
+            }
+        }
+    }
+    for (auto&& clone : {even, odd}) {
+        ASSERT_TRUE(clone->releasePartialGroups().empty());
+    }
+    ASSERT_EQ(partialGroups.size(), 100UL);
+
+    auto mergeSources = group->getMergeSources();
+    ASSERT_EQ(mergeSources.size(), 1UL);
+    auto merger = mergeSources.front();
+    auto mock = DocumentSourceMock::create(partialGroups);
+    merger->setSource(mock.get());
+
+    map<int, Document> results;
+    for (auto result = merger->getNext(); result.isAdvanced(); result = merger->getNext()) {
+        Document doc = result.releaseDocument();
+        results[doc["_id"].coerceToInt()] = doc;
+    }
+    ASSERT_EQ(results.size(), 3UL);
+    for (int key = 0; key < 3; key++) {
+        int total = 0;
+        int count = 0;
+        for (int i = key; i < 100; i += 3) {
+            total += i;
+            count++;
+        }
+        ASSERT_VALUE_EQ(results[key]["total"], Value(total));
+        ASSERT_VALUE_EQ(results[key]["avg"], Value(static_cast<double>(total) / count));
+    }
+}
+
+/**
+ * Runs 'stageSpecs' and then 'groupSpec' over 'inputs' and returns the groups sorted on _id. If
+ * 'columnBatchFields' is set the stages pass column batches with those columns to the $group.
+ */
+vector<Document> runGroupPipeline(const intrusive_ptr<ExpressionContext>& expCtx,
+                                  const vector<BSONObj>& inputs,
+                                  const vector<BSONObj>& stageSpecs,
+                                  const BSONObj& groupSpec,
+                                  boost::optional<vector<string>> columnBatchFields) {
+    deque<DocumentSource::GetNextResult> queue;
+    for (auto&& input : inputs) {
+        queue.push_back(Document(input));
+    }
+    auto mock = DocumentSourceMock::create(queue);
+    mock->columnBatchFields = columnBatchFields;
+    mock->columnBatchSize = 64;
+
+    vector<intrusive_ptr<DocumentSource>> stages{mock};
+    for (auto&& spec : stageSpecs) {
+        for (auto&& stage : DocumentSource::parse(expCtx, spec)) {
+            stage->setSource(stages.back().get());
+            stages.push_back(stage);
+        }
+    }
+    ASSERT_EQ(stages.back()->canProduceColumnBatches(), columnBatchFields.is_initialized());
+
+    auto group = DocumentSourceGroup::createFromBson(groupSpec.firstElement(), expCtx);
+    group->setSource(stages.back().get());
+
+    vector<Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        results.push_back(result.releaseDocument());
+    }
+    ValueComparator comparator;
+    std::sort(results.begin(), results.end(), [&](const Document& lhs, const Document& rhs) {
+        return comparator.evaluate(lhs["_id"] < rhs["_id"]);
+    });
+    return results;
+}
+
+TEST_F(DocumentSourceGroupTest, ColumnBatchesShouldGiveTheSameGroupsAsDocuments) {
+    vector<BSONObj> inputs;
+    for (int i = 0; i < 1000; i++) {
+        BSONObjBuilder bob;
+        bob.append("_id", i);
+        // Column 'a' mixes types, nulls and missing values; 'b' mixes ints and doubles.
+        if (i % 11 == 0) {
+            bob.appendNull("a");
+        } else if (i % 13 == 0) {
+            bob.append("a", "str");
+        } else if (i % 17 != 0) {
+            bob.append("a", i % 7);
+        }
+        if (i % 5 == 0) {
+            bob.append("b", i + 0.5);
+        } else {
+            bob.append("b", i);
+        }
+        bob.append("c", "s" + std::to_string(i % 3));
+        bob.append("d", BSON("x" << i % 4));
+        bob.append("unused", BSON_ARRAY(i));
+        inputs.push_back(bob.obj());
+    }
+
+    const vector<BSONObj> stageSpecs{
+        fromjson("{$match: {b: {$gte: 10}}}"),
+        fromjson("{$project: {a: 1, x: '$b', c: 1, d: 1}}"),
+        fromjson("{$match: {c: {$ne: 's1'}}}"),
+    };
+    const BSONObj groupSpec = fromjson(
+        "{$group: {_id: '$c', total: {$sum: '$x'}, count: {$sum: 1}, maxD: {$max: '$d'},"
+        " firstId: {$first: '$_id'}, as: {$push: '$a'}, missing: {$push: '$b'}}}");
+
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+    auto expected = runGroupPipeline(expCtx, inputs, stageSpecs, groupSpec, boost::none);
+    auto actual = runGroupPipeline(
+        expCtx, inputs, stageSpecs, groupSpec, vector<string>{"_id", "a", "b", "c", "d"});
+
+    ASSERT_GT(expected.size(), 10UL);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_DOCUMENT_EQ(actual[i], expected[i]);
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ColumnBatchesShouldGroupOnAConstant) {
+    vector<BSONObj> inputs;
+    for (int i = 0; i < 300; i++) {
+        inputs.push_back(BSON("_id" << i));
+    }
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+    auto results = runGroupPipeline(expCtx,
+                                    inputs,
+                                    {},
+                                    fromjson("{$group: {_id: null, count: {$sum: 1}}}"),
+                                    vector<string>{});
+    ASSERT_EQ(results.size(), 1UL);
+    ASSERT_DOCUMENT_EQ(results[0], Document(fromjson("{_id: null, count: 300}")));
+}
+
+TEST_F(DocumentSourceGroupTest, ColumnBatchesShouldNotChangeGroupsOnWholeOrComputedDocuments) {
+    vector<BSONObj> inputs;
+    for (int i = 0; i < 300; i++) {
+        // The fields are not in the order the $project lists them.
+        inputs.push_back(BSON("_id" << i % 5 << "c" << i % 2 << "b" << BSON("x" << i % 3) << "a"
+                                    << i % 4));
+    }
+    const vector<BSONObj> stageSpecs{fromjson("{$project: {a: 1, b: 1, c: 1}}")};
+    const vector<BSONObj> groupSpecs{
+        fromjson("{$group: {_id: '$$ROOT', count: {$sum: 1}}}"),
+        fromjson("{$group: {_id: '$$CURRENT', count: {$sum: 1}}}"),
+        fromjson("{$group: {_id: '$a', docs: {$push: '$$ROOT'}}}"),
+        fromjson("{$group: {_id: {a: '$a', c: '$c'}, maxB: {$max: '$b.x'},"
+                 " plusOne: {$sum: {$add: ['$a', 1]}}}}"),
+    };
+
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+    for (auto&& groupSpec : groupSpecs) {
+        auto expected = runGroupPipeline(expCtx, inputs, stageSpecs, groupSpec, boost::none);
+        auto actual = runGroupPipeline(
+            expCtx, inputs, stageSpecs, groupSpec, vector<string>{"_id", "a", "b", "c"});
+
+        ASSERT_GT(expected.size(), 1UL) << groupSpec;
+        ASSERT_EQ(actual.size(), expected.size()) << groupSpec;
+        for (size_t i = 0; i < expected.size(); i++) {
+            ASSERT_DOCUMENT_EQ(actual[i], expected[i]);
+        }
+    }
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -30,7 +30,11 @@
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <cmath>
+#include <limits>
+
 #include "mongo/base/init.h"
+#include "mongo/db/exec/stage_spill_file.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/document.h"
@@ -63,6 +67,16 @@ std::string pipelineToString(const vector<BSONObj>& pipeline) {
     sb << "]";
     return sb.str();
 }
+
+/**
+ * The directory a $lookup hash table may spill to, or an empty string if it may not spill.
+ */
+std::string hashJoinSpillDir(const ExpressionContext& expCtx) {
+    if (!expCtx.allowDiskUse || expCtx.inMongos || !canWriteStageSpillFiles()) {
+        return std::string();
+    }
+    return expCtx.tempDir;
+}
 }  // namespace
 
 constexpr size_t DocumentSourceLookUp::kMaxSubPipelineDepth;
@@ -221,27 +235,40 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
+    std::vector<Value> results;
+    int objsize = 0;
+    auto appendResult = [&](Document&& result) {
+        objsize += result.getApproximateSize();
+        uassert(4568,
+                str::stream() << "Total size of documents in " << _fromNs.coll()
+                              << " matching pipeline "
+                              << getUserPipelineDefinition()
+                              << " exceeds maximum document size",
+                objsize <= BSONObjMaxInternalSize);
+        results.emplace_back(std::move(result));
+    };
+
     if (!wasConstructedWithPipelineSyntax()) {
         auto matchStage =
             makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
         // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
         _resolvedPipeline.back() = matchStage;
+
+        if (auto matches = hashJoin(inputDoc)) {
+            for (auto&& match : *matches) {
+                appendResult(std::move(match));
+            }
+
+            MutableDocument output(std::move(inputDoc));
+            output.setNestedField(_as, Value(std::move(results)));
+            return output.freeze();
+        }
     }
 
     auto pipeline = buildPipeline(inputDoc);
 
-    std::vector<Value> results;
-    int objsize = 0;
-
     while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
-        uassert(4568,
-                str::stream() << "Total size of documents in " << _fromNs.coll()
-                              << " matching pipeline "
-                              << getUserPipelineDefinition()
-                              << " exceeds maximum document size",
-                objsize <= BSONObjMaxInternalSize);
-        results.emplace_back(std::move(*result));
+        appendResult(std::move(*result));
     }
 
     MutableDocument output(std::move(inputDoc));
@@ -433,6 +460,8 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashJoinMatches.reset();
+    _hashTable.reset();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -525,7 +554,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
+    while (!_nextValue) {
         auto nextInput = pSource->getNext();
         if (!nextInput.isAdvanced()) {
             return nextInput;
@@ -533,27 +562,34 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
         _input = nextInput.releaseDocument();
 
+        _hashJoinMatches.reset();
         if (!wasConstructedWithPipelineSyntax()) {
             BSONObj filter = _additionalFilter.value_or(BSONObj());
             auto matchStage =
                 makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
             // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
             _resolvedPipeline.back() = matchStage;
+
+            _hashJoinMatches = hashJoin(*_input);
+            _hashJoinMatchIndex = 0;
         }
 
         if (_pipeline) {
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        if (!_hashJoinMatches) {
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextForeignMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -571,7 +607,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextForeignMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -585,6 +621,133 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+boost::optional<Document> DocumentSourceLookUp::getNextForeignMatch() {
+    if (!_hashJoinMatches) {
+        return _pipeline->getNext();
+    }
+    if (_hashJoinMatchIndex == _hashJoinMatches->size()) {
+        return boost::none;
+    }
+    return std::move((*_hashJoinMatches)[_hashJoinMatchIndex++]);
+}
+
+void DocumentSourceLookUp::chooseJoinStrategy() {
+    invariant(!wasConstructedWithPipelineSyntax());
+    _joinStrategy = JoinStrategy::kNestedLoop;
+    _numQueriesBeforeHashJoin = std::numeric_limits<long long>::max();
+
+    const auto maxMemoryBytes = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    if (maxMemoryBytes == 0 || pExpCtx->inMongos) {
+        return;
+    }
+
+    // If the foreign collection does not exist, each query returns right away.
+    auto estimate = pExpCtx->mongoProcessInterface->getCollectionSizeEstimate(pExpCtx->opCtx,
+                                                                              _resolvedNs);
+    if (!estimate) {
+        return;
+    }
+
+    // Don't start a build that is going to be dropped half way through.
+    if (estimate->dataSizeBytes > maxMemoryBytes && hashJoinSpillDir(*pExpCtx).empty()) {
+        return;
+    }
+
+    if (!foreignFieldIsIndexed()) {
+        // Every query scans the foreign collection, so one query costs as much as the build.
+        _numQueriesBeforeHashJoin = 1;
+        return;
+    }
+
+    _numQueriesBeforeHashJoin = static_cast<long long>(
+        std::ceil(internalDocumentSourceLookupHashJoinIndexedRatio.load() * estimate->numRecords));
+}
+
+bool DocumentSourceLookUp::foreignFieldIsIndexed() {
+    // The per-document $match follows the view pipeline, if 'from' is a view. Only a plain
+    // collection is queried through its indexes.
+    if (_resolvedPipeline.size() > 1) {
+        return false;
+    }
+
+    const auto foreignField = _foreignField->fullPath();
+    for (auto&& index :
+         pExpCtx->mongoProcessInterface->getIndexStats(pExpCtx->opCtx, _resolvedNs)) {
+        auto firstField = index.second.indexKey.firstElement();
+        if (firstField.fieldNameStringData() != foreignField) {
+            continue;
+        }
+        if (firstField.isNumber() ||
+            (firstField.type() == BSONType::String && firstField.valueStringData() == "hashed")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DocumentSourceLookUp::buildHashTable() {
+    // '_resolvedPipeline' ends with the placeholder for the per-document $match. The build side
+    // keeps any view pipeline before it, and the predicates of an absorbed $match.
+    std::vector<BSONObj> buildSide(_resolvedPipeline.begin(), std::prev(_resolvedPipeline.end()));
+    if (_additionalFilter) {
+        buildSide.push_back(BSON("$match" << *_additionalFilter));
+    }
+
+    copyVariablesToExpCtx(_variables, _variablesParseState, _fromExpCtx.get());
+    auto pipeline =
+        uassertStatusOK(pExpCtx->mongoProcessInterface->makePipeline(buildSide, _fromExpCtx));
+
+    auto hashTable = stdx::make_unique<LookupHashTable>(
+        _fromExpCtx->getValueComparator(),
+        _foreignField->fullPath(),
+        static_cast<size_t>(internalDocumentSourceLookupHashJoinMaxMemoryBytes.load()),
+        hashJoinSpillDir(*pExpCtx),
+        pExpCtx->mongoProcessInterface->getOperationStageMemCounter(pExpCtx->opCtx));
+    while (auto next = pipeline->getNext()) {
+        if (!hashTable->add(std::move(*next))) {
+            return false;
+        }
+    }
+
+    _hashTable = std::move(hashTable);
+    return true;
+}
+
+boost::optional<std::vector<Document>> DocumentSourceLookUp::hashJoin(const Document& input) {
+    if (_joinStrategy == JoinStrategy::kUndecided) {
+        chooseJoinStrategy();
+    }
+
+    if (_joinStrategy == JoinStrategy::kNestedLoop) {
+        if (_numQueries < _numQueriesBeforeHashJoin) {
+            ++_numQueries;
+            return boost::none;
+        }
+        if (!buildHashTable()) {
+            _numQueriesBeforeHashJoin = std::numeric_limits<long long>::max();
+            return boost::none;
+        }
+        _joinStrategy = JoinStrategy::kHashJoin;
+    }
+
+    // Collect the values makeMatchStageFromInput() would put in the query.
+    std::vector<Value> localValues;
+    bool hasUndefined = false;
+    document_path_support::visitAllValuesAtPath(input, *_localField, [&](const Value& nextValue) {
+        hasUndefined = hasUndefined || nextValue.getType() == BSONType::Undefined;
+        localValues.push_back(nextValue);
+    });
+    if (hasUndefined) {
+        // An equality to undefined is an error; leave it to the query to report.
+        return boost::none;
+    }
+    if (localValues.empty()) {
+        localValues.push_back(Value(BSONNULL));
+    }
+
+    return _hashTable->probe(localValues);
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
@@ -718,6 +881,9 @@ void DocumentSourceLookUp::detachFromOperationContext() {
     } else if (_fromExpCtx) {
         _fromExpCtx->opCtx = nullptr;
     }
+    if (_hashTable) {
+        _hashTable->setOperationMemCounter(nullptr);
+    }
 }
 
 void DocumentSourceLookUp::reattachToOperationContext(OperationContext* opCtx) {
@@ -729,6 +895,10 @@ void DocumentSourceLookUp::reattachToOperationContext(OperationContext* opCtx) {
     } else if (_fromExpCtx) {
         _fromExpCtx->opCtx = opCtx;
     }
+    if (_hashTable) {
+        _hashTable->setOperationMemCounter(
+            pExpCtx->mongoProcessInterface->getOperationStageMemCounter(opCtx));
+    }
 }
 
 intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
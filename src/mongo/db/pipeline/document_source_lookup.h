@@ -36,6 +36,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -97,7 +98,8 @@ public:
     GetModPathsReturn getModifiedPaths() const final;
 
     StageConstraints constraints(Pipeline::SplitState pipeState) const final {
-        const bool mayUseDisk = wasConstructedWithPipelineSyntax() &&
+        // With localField/foreignField syntax, the hash table of a hash join may spill.
+        const bool mayUseDisk = !wasConstructedWithPipelineSyntax() ||
             std::any_of(_parsedIntrospectionPipeline->getSources().begin(),
                         _parsedIntrospectionPipeline->getSources().end(),
                         [](const auto& source) {
@@ -187,6 +189,10 @@ public:
         return buildPipeline(inputDoc);
     }
 
+    bool isUsingHashJoin_forTest() const {
+        return _joinStrategy == JoinStrategy::kHashJoin;
+    }
+
 protected:
     void doDispose() final;
 
@@ -198,6 +204,20 @@ protected:
                                                      Pipeline::SourceContainer* container) final;
 
 private:
+    /**
+     * How a $lookup with localField/foreignField syntax finds the foreign documents of an input
+     * document.
+     */
+    enum class JoinStrategy {
+        // No input document has been joined yet.
+        kUndecided,
+        // A query against the foreign collection per input document. Switches to kHashJoin after
+        // '_numQueriesBeforeHashJoin' queries.
+        kNestedLoop,
+        // A probe of '_hashTable', built once from the foreign collection.
+        kHashJoin,
+    };
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -244,6 +264,37 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Sets '_joinStrategy' and '_numQueriesBeforeHashJoin' from the size of the foreign collection
+     * and whether foreignField is indexed: a hash join pays one scan of the foreign collection, so
+     * it is worth building once the queries run so far have cost about as much.
+     */
+    void chooseJoinStrategy();
+
+    /**
+     * Returns true if an index of the foreign collection can answer an equality on foreignField.
+     */
+    bool foreignFieldIsIndexed();
+
+    /**
+     * Runs the foreign pipeline, without the per-document $match, into '_hashTable'. Returns false
+     * if the table doesn't fit in memory and can't spill.
+     */
+    bool buildHashTable();
+
+    /**
+     * Returns the foreign documents that match 'input', if the hash join is the strategy in use,
+     * building the hash table when it is time to switch to it. Returns boost::none if 'input' has
+     * to be joined with a query instead.
+     */
+    boost::optional<std::vector<Document>> hashJoin(const Document& input);
+
+    /**
+     * Returns the next foreign document that matches '_input', from '_hashJoinMatches' if it is
+     * set, or from '_pipeline' otherwise.
+     */
+    boost::optional<Document> getNextForeignMatch();
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -323,6 +374,11 @@ private:
 
     std::vector<LetVariable> _letVariables;
 
+    JoinStrategy _joinStrategy = JoinStrategy::kUndecided;
+    long long _numQueriesBeforeHashJoin = 0;
+    long long _numQueries = 0;
+    std::unique_ptr<LookupHashTable> _hashTable;
+
     boost::intrusive_ptr<DocumentSourceMatch> _matchSrc;
     boost::intrusive_ptr<DocumentSourceUnwind> _unwindSrc;
 
@@ -332,6 +388,9 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+    // The matches of '_input' when it was joined through '_hashTable', and the next one to return.
+    boost::optional<std::vector<Document>> _hashJoinMatches;
+    size_t _hashJoinMatchIndex = 0;
 };
 
 }  // namespace mongo
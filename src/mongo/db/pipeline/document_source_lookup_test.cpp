@@ -532,9 +532,31 @@ public:
         return Status::OK();
     }
 
+    boost::optional<CollectionSizeEstimate> getCollectionSizeEstimate(
+        OperationContext* opCtx, const NamespaceString& nss) const final {
+        return _sizeEstimate;
+    }
+
+    CollectionIndexUsageMap getIndexStats(OperationContext* opCtx,
+                                          const NamespaceString& ns) final {
+        return _indexStats;
+    }
+
+    /**
+     * Makes the foreign collection report 'sizeEstimate' and 'indexStats', which lets $lookup
+     * consider a hash join.
+     */
+    void setForeignCollectionStats(CollectionSizeEstimate sizeEstimate,
+                                   CollectionIndexUsageMap indexStats = {}) {
+        _sizeEstimate = sizeEstimate;
+        _indexStats = std::move(indexStats);
+    }
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    boost::optional<CollectionSizeEstimate> _sizeEstimate;
+    CollectionIndexUsageMap _indexStats;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -641,6 +663,191 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+/**
+ * Runs {$lookup: {from: "foreign", localField: "l", foreignField: "a", as: "joined"}} over
+ * 'inputs', against a foreign collection holding 'foreignContents'. If 'sizeEstimate' is set, the
+ * foreign collection reports it. Sets 'usedHashJoin', if given, to whether the stage ended up
+ * joining through a hash table.
+ */
+std::vector<Document> runLookup(const intrusive_ptr<ExpressionContext>& expCtx,
+                                std::deque<DocumentSource::GetNextResult> inputs,
+                                std::deque<DocumentSource::GetNextResult> foreignContents,
+                                boost::optional<MongoProcessInterface::CollectionSizeEstimate>
+                                    sizeEstimate,
+                                CollectionIndexUsageMap indexStats = {},
+                                bool* usedHashJoin = nullptr) {
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec = BSON("$lookup" << BSON("from" << fromNs.coll() << "localField"
+                                                    << "l"
+                                                    << "foreignField"
+                                                    << "a"
+                                                    << "as"
+                                                    << "joined"));
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    auto mockLocalSource = DocumentSourceMock::create(std::move(inputs));
+    lookup->setSource(mockLocalSource.get());
+
+    auto mongoProcessInterface = std::make_shared<MockMongoInterface>(std::move(foreignContents));
+    if (sizeEstimate) {
+        mongoProcessInterface->setForeignCollectionStats(*sizeEstimate, std::move(indexStats));
+    }
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    std::vector<Document> results;
+    for (auto next = lookup->getNext(); next.isAdvanced(); next = lookup->getNext()) {
+        results.push_back(next.releaseDocument());
+    }
+    if (usedHashJoin) {
+        *usedHashJoin = lookup->isUsingHashJoin_forTest();
+    }
+    lookup->dispose();
+    return results;
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinReturnsTheSameDocumentsAsQueries) {
+    std::deque<DocumentSource::GetNextResult> inputs{Document(fromjson("{l: 1}")),
+                                                     Document(fromjson("{l: [2, 'x']}")),
+                                                     Document(fromjson("{}")),
+                                                     Document(fromjson("{l: null}")),
+                                                     Document(fromjson("{l: 5}")),
+                                                     Document(fromjson("{l: [1, 2]}"))};
+    std::deque<DocumentSource::GetNextResult> foreignContents{
+        Document(fromjson("{_id: 0, a: 1}")),
+        Document(fromjson("{_id: 1, a: [1, 2]}")),
+        Document(fromjson("{_id: 2}")),
+        Document(fromjson("{_id: 3, a: null}")),
+        Document(fromjson("{_id: 4, a: 'x'}")),
+        Document(fromjson("{_id: 5, a: {$numberLong: '2'}}"))};
+
+    auto expected = runLookup(getExpCtx(), inputs, foreignContents, boost::none);
+
+    bool usedHashJoin = false;
+    MongoProcessInterface::CollectionSizeEstimate sizeEstimate;
+    sizeEstimate.numRecords = 6;
+    sizeEstimate.dataSizeBytes = 200;
+    auto results =
+        runLookup(getExpCtx(), inputs, foreignContents, sizeEstimate, {}, &usedHashJoin);
+
+    ASSERT_TRUE(usedHashJoin);
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_DOCUMENT_EQ(results[i], expected[i]);
+    }
+}
+
+TEST_F(DocumentSourceLookUpTest, IndexedForeignFieldIsQueriedBeforeSwitchingToHashJoin) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec = BSON("$lookup" << BSON("from" << fromNs.coll() << "localField"
+                                                    << "l"
+                                                    << "foreignField"
+                                                    << "a"
+                                                    << "as"
+                                                    << "joined"));
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"l", 0}}, Document{{"l", 1}}, Document{{"l", 0}}, Document{{"l", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    // With 20 foreign records and the default ratio of 0.1, two input documents are joined with a
+    // query each before the hash table is built.
+    auto mongoProcessInterface = std::make_shared<MockMongoInterface>(
+        deque<DocumentSource::GetNextResult>{Document{{"_id", 0}, {"a", 0}}});
+    MongoProcessInterface::CollectionSizeEstimate sizeEstimate;
+    sizeEstimate.numRecords = 20;
+    sizeEstimate.dataSizeBytes = 1000;
+    CollectionIndexUsageMap indexStats;
+    indexStats["a_1"] = CollectionIndexUsageTracker::IndexUsageStats(Date_t(), BSON("a" << 1));
+    mongoProcessInterface->setForeignCollectionStats(sizeEstimate, std::move(indexStats));
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    for (bool expectHashJoin : {false, false, true, true}) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_EQ(lookup->isUsingHashJoin_forTest(), expectHashJoin);
+
+        auto result = next.releaseDocument();
+        const size_t numJoined = result["l"].getInt() == 0 ? 1 : 0;
+        ASSERT_EQ(result["joined"].getArray().size(), numJoined);
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinWorksWhileUnwinding) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec = BSON("$lookup" << BSON("from" << fromNs.coll() << "localField"
+                                                    << "l"
+                                                    << "foreignField"
+                                                    << "a"
+                                                    << "as"
+                                                    << "joined"));
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    const bool preserveNullAndEmptyArrays = true;
+    const boost::optional<std::string> includeArrayIndex = std::string("i");
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "joined", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"l", 0}}, Document{{"l", 1}}, Document{{"l", 2}}, Document{{"l", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(deque<DocumentSource::GetNextResult>{
+            Document{{"_id", 0}, {"a", 1}}, Document{{"_id", 1}, {"a", 1}}});
+    MongoProcessInterface::CollectionSizeEstimate sizeEstimate;
+    sizeEstimate.numRecords = 2;
+    sizeEstimate.dataSizeBytes = 100;
+    mongoProcessInterface->setForeignCollectionStats(sizeEstimate);
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    std::vector<Document> expected{
+        Document{{"l", 0}, {"i", BSONNULL}},
+        Document{{"l", 1}, {"joined", Document{{"_id", 0}, {"a", 1}}}, {"i", 0LL}},
+        Document{{"l", 1}, {"joined", Document{{"_id", 1}, {"a", 1}}}, {"i", 1LL}},
+        Document{{"l", 2}, {"i", BSONNULL}},
+        Document{{"l", 1}, {"joined", Document{{"_id", 0}, {"a", 1}}}, {"i", 0LL}},
+        Document{{"l", 1}, {"joined", Document{{"_id", 1}, {"a", 1}}}, {"i", 1LL}}};
+    for (auto&& expectedDoc : expected) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), expectedDoc);
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->isUsingHashJoin_forTest());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, DoesNotBuildHashTableThatCannotFitOrSpill) {
+    std::deque<DocumentSource::GetNextResult> inputs{
+        Document{{"l", 0}}, Document{{"l", 1}}, Document{{"l", 0}}};
+    std::deque<DocumentSource::GetNextResult> foreignContents{Document{{"_id", 0}, {"a", 0}}};
+
+    bool usedHashJoin = true;
+    MongoProcessInterface::CollectionSizeEstimate sizeEstimate;
+    sizeEstimate.numRecords = 1;
+    sizeEstimate.dataSizeBytes =
+        static_cast<long long>(internalDocumentSourceLookupHashJoinMaxMemoryBytes.load()) + 1;
+    ASSERT_FALSE(getExpCtx()->allowDiskUse);
+    auto results =
+        runLookup(getExpCtx(), inputs, foreignContents, sizeEstimate, {}, &usedHashJoin);
+
+    ASSERT_FALSE(usedHashJoin);
+    ASSERT_EQ(results.size(), 3U);
+    ASSERT_EQ(results[0]["joined"].getArray().size(), 1U);
+    ASSERT_EQ(results[1]["joined"].getArray().size(), 0U);
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
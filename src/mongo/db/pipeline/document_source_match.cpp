@@ -40,6 +40,7 @@
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/stringutils.h"
 
@@ -108,6 +109,38 @@ DocumentSource::GetNextResult DocumentSourceMatch::getNext() {
     return nextInput;
 }
 
+std::unique_ptr<ColumnBatch> DocumentSourceMatch::getNextColumnBatch() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_compiledForColumnBatches) {
+        _compiledForColumnBatches = true;
+        if (internalQueryCompileMatchExpressions.load()) {
+            _compiledExpression = CompiledMatchExpression::compile(_expression.get());
+        }
+    }
+
+    while (auto batch = pSource->getNextColumnBatch()) {
+        std::vector<uint32_t> selection;
+        selection.reserve(batch->getSelection().size());
+        for (auto row : batch->getSelection()) {
+            // Until a $project changes them, the rows read from the collection hold exactly the
+            // fields of the columns along with others that the match can't depend on.
+            BSONObj toMatch =
+                batch->hasSourceRows() ? batch->getSourceRow(row) : batch->toBson(row);
+            if (_compiledExpression ? _compiledExpression->matchesBSON(toMatch)
+                                    : _expression->matchesBSON(toMatch)) {
+                selection.push_back(row);
+            }
+        }
+
+        if (!selection.empty()) {
+            batch->setSelection(std::move(selection));
+            return batch;
+        }
+    }
+    return nullptr;
+}
+
 Pipeline::SourceContainer::iterator DocumentSourceMatch::doOptimizeAt(
     Pipeline::SourceContainer::iterator itr, Pipeline::SourceContainer* container) {
     invariant(*itr == this);
@@ -32,6 +32,7 @@
 #include <utility>
 
 #include "mongo/client/connpool.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/matcher.h"
 #include "mongo/db/pipeline/document_source.h"
 
@@ -42,6 +43,10 @@ public:
     virtual ~DocumentSourceMatch() = default;
 
     GetNextResult getNext() override;
+    bool canProduceColumnBatches() const override {
+        return !_isTextQuery && pSource && pSource->canProduceColumnBatches();
+    }
+    std::unique_ptr<ColumnBatch> getNextColumnBatch() override;
     boost::intrusive_ptr<DocumentSource> optimize() final;
     BSONObjSet getOutputSorts() final {
         return pSource ? pSource->getOutputSorts()
@@ -167,6 +172,10 @@ private:
 
     // Cache the dependencies so that we know what fields we need to serialize to BSON for matching.
     DepsTracker _dependencies;
+
+    // '_expression' compiled for matching the rows of column batches, once the first is asked for.
+    std::unique_ptr<CompiledMatchExpression> _compiledExpression;
+    bool _compiledForColumnBatches = false;
 };
 
 }  // namespace mongo
@@ -210,6 +210,40 @@ TEST_F(DocumentSourceMatchTest, RedactSafePortion) {
     }
 }
 
+TEST_F(DocumentSourceMatchTest, ShouldNarrowTheSelectionOfColumnBatches) {
+    auto match = DocumentSourceMatch::create(fromjson("{a: {$gte: 2}, 'x.y': 1}"), getExpCtx());
+    auto source = DocumentSourceMock::create({"{a: 1, x: {y: 1}}",
+                                              "{a: 2, x: {y: 1}}",
+                                              "{a: 3, x: {y: 2}}",
+                                              "{a: 4, x: [{y: 1}]}",
+                                              "{a: 5, x: {y: 1}}"});
+    source->columnBatchFields = std::vector<std::string>{"a", "x"};
+    source->columnBatchSize = 3;
+    match->setSource(source.get());
+    ASSERT_TRUE(match->canProduceColumnBatches());
+
+    auto batch = match->getNextColumnBatch();
+    ASSERT(batch);
+    ASSERT(batch->getSelection() == std::vector<uint32_t>({1}));
+    batch = match->getNextColumnBatch();
+    ASSERT(batch);
+    ASSERT(batch->getSelection() == std::vector<uint32_t>({0, 1}));
+    ASSERT_FALSE(match->getNextColumnBatch());
+}
+
+TEST_F(DocumentSourceMatchTest, ShouldSkipColumnBatchesWithoutMatches) {
+    auto match = DocumentSourceMatch::create(fromjson("{a: 5}"), getExpCtx());
+    auto source = DocumentSourceMock::create({"{a: 1}", "{a: 2}", "{a: 3}", "{a: 5}"});
+    source->columnBatchFields = std::vector<std::string>{"a"};
+    source->columnBatchSize = 2;
+    match->setSource(source.get());
+
+    auto batch = match->getNextColumnBatch();
+    ASSERT(batch);
+    ASSERT_VALUE_EQ(batch->getColumn(0).getValue(batch->getSelection()[0]), Value(5));
+    ASSERT_FALSE(match->getNextColumnBatch());
+}
+
 TEST_F(DocumentSourceMatchTest, ShouldAddDependenciesOfAllBranchesOfOrClause) {
     auto match =
         DocumentSourceMatch::create(fromjson("{$or: [{a: 1}, {'x.y': {$gt: 4}}]}"), getExpCtx());
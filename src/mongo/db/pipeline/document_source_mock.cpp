@@ -33,6 +33,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/stdx/memory.h"
 
 namespace mongo {
 
@@ -104,4 +105,22 @@ DocumentSource::GetNextResult DocumentSourceMock::getNext() {
     queue.pop_front();
     return next;
 }
+
+std::unique_ptr<ColumnBatch> DocumentSourceMock::getNextColumnBatch() {
+    invariant(!isDisposed);
+    invariant(!isDetachedFromOpCtx);
+    invariant(columnBatchFields);
+
+    if (queue.empty()) {
+        return nullptr;
+    }
+
+    auto batch = stdx::make_unique<ColumnBatch>(*columnBatchFields);
+    while (!queue.empty() && batch->numRows() < columnBatchSize) {
+        invariant(queue.front().isAdvanced());
+        batch->appendRow(queue.front().releaseDocument().toBson());
+        queue.pop_front();
+    }
+    return batch;
+}
 }
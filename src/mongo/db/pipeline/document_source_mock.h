@@ -45,6 +45,10 @@ public:
                        const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     GetNextResult getNext() override;
+    bool canProduceColumnBatches() const override {
+        return columnBatchFields.is_initialized();
+    }
+    std::unique_ptr<ColumnBatch> getNextColumnBatch() override;
     const char* getSourceName() const override;
     Value serialize(
         boost::optional<ExplainOptions::Verbosity> explain = boost::none) const override;
@@ -99,6 +103,11 @@ public:
 
     BSONObjSet sorts;
 
+    // If set, the queued documents, which must all be advanced results, may also be read in column
+    // batches of up to 'columnBatchSize' rows with one column for each of these fields.
+    boost::optional<std::vector<std::string>> columnBatchFields;
+    size_t columnBatchSize = 128;
+
 protected:
     void doDispose() override;
 };
@@ -73,6 +73,31 @@ TEST_F(ProjectStageTest, InclusionProjectionShouldRemoveUnspecifiedFields) {
     ASSERT_EQUALS(1, next.getDocument()["c"]["d"].getInt());
 }
 
+TEST_F(ProjectStageTest, ShouldIncludeAndRenameTopLevelColumns) {
+    auto project = DocumentSourceProject::create(fromjson("{_id: 0, a: 1, x: '$b'}"), getExpCtx());
+    auto source = DocumentSourceMock::create({"{_id: 0, a: 1, b: 'one', c: 1}", "{_id: 1, c: 2}"});
+    source->columnBatchFields = std::vector<std::string>{"_id", "a", "b", "c"};
+    project->setSource(source.get());
+    ASSERT_TRUE(project->canProduceColumnBatches());
+
+    auto batch = project->getNextColumnBatch();
+    ASSERT(batch);
+    ASSERT_EQ(batch->numColumns(), 2U);
+    ASSERT_DOCUMENT_EQ(batch->getDocument(0), Document(fromjson("{a: 1, x: 'one'}")));
+    ASSERT_DOCUMENT_EQ(batch->getDocument(1), Document());
+    ASSERT_FALSE(project->getNextColumnBatch());
+}
+
+TEST_F(ProjectStageTest, ShouldNotProduceColumnBatchesForComputedOrNestedFields) {
+    auto source = DocumentSourceMock::create("{_id: 0, a: 1}");
+    source->columnBatchFields = std::vector<std::string>{"_id", "a"};
+    for (auto&& spec : {"{x: {$add: ['$a', 1]}}", "{x: '$a.b'}", "{a: {b: 1}}", "{a: 0}"}) {
+        auto project = DocumentSourceProject::create(fromjson(spec), getExpCtx());
+        project->setSource(source.get());
+        ASSERT_FALSE(project->canProduceColumnBatches()) << spec;
+    }
+}
+
 TEST_F(ProjectStageTest, ShouldOptimizeInnerExpressions) {
     auto project = DocumentSourceProject::create(
         BSON("a" << BSON("$and" << BSON_ARRAY(BSON("$const" << true)))), getExpCtx());
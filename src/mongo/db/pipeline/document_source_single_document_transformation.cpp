@@ -69,6 +69,67 @@ DocumentSource::GetNextResult DocumentSourceSingleDocumentTransformation::getNex
     return _parsedTransform->applyTransformation(input.releaseDocument());
 }
 
+bool DocumentSourceSingleDocumentTransformation::canProduceColumnBatches() const {
+    return _parsedTransform && pSource && pSource->canProduceColumnBatches() &&
+        getColumnProjection();
+}
+
+std::unique_ptr<ColumnBatch> DocumentSourceSingleDocumentTransformation::getNextColumnBatch() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_columnProjection) {
+        _columnProjection = getColumnProjection();
+        invariant(_columnProjection);
+    }
+
+    auto batch = pSource->getNextColumnBatch();
+    if (!batch) {
+        return nullptr;
+    }
+
+    std::vector<std::pair<std::string, size_t>> outputs;
+    outputs.reserve(_columnProjection->size());
+    for (auto&& field : *_columnProjection) {
+        // The batch has a column for every field that this stage depends on.
+        auto column = batch->findColumn(field.second);
+        invariant(column);
+        outputs.emplace_back(field.first, *column);
+    }
+    batch->projectColumns(outputs);
+    return batch;
+}
+
+boost::optional<DocumentSourceSingleDocumentTransformation::ColumnProjection>
+DocumentSourceSingleDocumentTransformation::getColumnProjection() const {
+    if (getType() != TransformerInterface::TransformerType::kInclusionProjection) {
+        return boost::none;
+    }
+
+    ColumnProjection fields;
+    const Document spec = _parsedTransform->serializeStageOptions(boost::none);
+    for (auto it = spec.fieldIterator(); it.more();) {
+        auto field = it.next();
+        if (field.second.getType() == Bool) {
+            // Only _id can be excluded from an inclusion projection.
+            if (field.second.getBool()) {
+                fields.emplace_back(field.first.toString(), field.first.toString());
+            }
+            continue;
+        }
+
+        // Constants serialize as {$const: ...}, so a string is a field path.
+        if (field.second.getType() == String) {
+            StringData path = field.second.getStringData();
+            if (path.size() > 1 && path[1] != '$' && path.find('.') == std::string::npos) {
+                fields.emplace_back(field.first.toString(), path.substr(1).toString());
+                continue;
+            }
+        }
+        return boost::none;
+    }
+    return fields;
+}
+
 intrusive_ptr<DocumentSource> DocumentSourceSingleDocumentTransformation::optimize() {
     _parsedTransform->optimize();
     return this;
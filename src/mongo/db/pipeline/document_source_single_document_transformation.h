@@ -99,6 +99,8 @@ public:
     // virtuals from DocumentSource
     const char* getSourceName() const final;
     GetNextResult getNext() final;
+    bool canProduceColumnBatches() const final;
+    std::unique_ptr<ColumnBatch> getNextColumnBatch() final;
     boost::intrusive_ptr<DocumentSource> optimize() final;
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
     DocumentSource::GetDepsReturn getDependencies(DepsTracker* deps) const final;
@@ -134,6 +136,15 @@ protected:
                                                      Pipeline::SourceContainer* container) final;
 
 private:
+    // Pairs of an output field and the input field it takes its value from.
+    using ColumnProjection = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * Returns the fields of an inclusion projection that only includes or renames top-level
+     * fields, in output order, or boost::none for any other transformation.
+     */
+    boost::optional<ColumnProjection> getColumnProjection() const;
+
     // Stores transformation logic.
     std::unique_ptr<TransformerInterface> _parsedTransform;
 
@@ -146,6 +157,9 @@ private:
     // Cached stage options in case this DocumentSource is disposed before serialized (e.g. explain
     // with a sort which will auto-dispose of the pipeline).
     Document _cachedStageOptions;
+
+    // Set by the first call to getNextColumnBatch().
+    boost::optional<ColumnProjection> _columnProjection;
 };
 
 }  // namespace mongo
@@ -817,6 +817,13 @@ public:
         return cmpOp;
     }
 
+    /**
+     * The comparator, aware of any collation, which evaluate() compares its operands with.
+     */
+    const ValueComparator& getValueComparator() const {
+        return getExpressionContext()->getValueComparator();
+    }
+
     static boost::intrusive_ptr<Expression> parse(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         BSONElement bsonExpr,
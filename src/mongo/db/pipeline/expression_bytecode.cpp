@@ -0,0 +1,577 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/expression_bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/platform/overflow_arithmetic.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/summation.h"
+
+namespace mongo {
+
+namespace {
+
+bool isCompiledOperator(const Expression* expr) {
+    return dynamic_cast<const ExpressionAdd*>(expr) ||
+        dynamic_cast<const ExpressionSubtract*>(expr) ||
+        dynamic_cast<const ExpressionMultiply*>(expr) ||
+        dynamic_cast<const ExpressionDivide*>(expr) ||
+        dynamic_cast<const ExpressionCompare*>(expr) || dynamic_cast<const ExpressionAnd*>(expr) ||
+        dynamic_cast<const ExpressionOr*>(expr) || dynamic_cast<const ExpressionNot*>(expr) ||
+        dynamic_cast<const ExpressionCond*>(expr) || dynamic_cast<const ExpressionIfNull*>(expr);
+}
+
+const ExpressionFieldPath* asRootFieldPath(const Expression* expr) {
+    auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expr);
+    return fieldPath && fieldPath->isRootFieldPath() ? fieldPath : nullptr;
+}
+
+/**
+ * The types handled by the arithmetic and comparison instructions.
+ */
+bool isNumber(const Value& value) {
+    switch (value.getType()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename T>
+int compareNumbers(T lhs, T rhs) {
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+const std::vector<boost::intrusive_ptr<Expression>>& operandsOf(const Expression* expr) {
+    return static_cast<const ExpressionNary*>(expr)->getOperandList();
+}
+
+}  // namespace
+
+std::unique_ptr<ExpressionBytecode> ExpressionBytecode::compile(const Expression* expr) {
+    if (!isCompiledOperator(expr)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<ExpressionBytecode> compiled(new ExpressionBytecode());
+    compiled->_result = compiled->compileNode(expr);
+    return compiled;
+}
+
+uint32_t ExpressionBytecode::compileNode(const Expression* expr) {
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(expr)) {
+        return constantRegister(constant->getValue());
+    }
+
+    if (auto fieldPath = asRootFieldPath(expr)) {
+        const std::string path = fieldPath->getFieldPath().fullPath();
+        auto it = std::find_if(
+            _fieldRegisters.begin(), _fieldRegisters.end(), [&](const auto& fieldRegister) {
+                return fieldRegister.first == path;
+            });
+        if (it != _fieldRegisters.end()) {
+            return it->second;
+        }
+
+        Instruction load(OpCode::kLoadField, expr);
+        load.dst = newRegister();
+        _fieldLoads.push_back(load);
+        _fieldRegisters.emplace_back(path, load.dst);
+        ++_numFieldLoads;
+        return load.dst;
+    }
+
+    if (isCompiledOperator(expr)) {
+        return compileOperator(expr);
+    }
+
+    Instruction evaluateTree(OpCode::kEvaluateTree, expr);
+    evaluateTree.dst = newRegister();
+    emit(evaluateTree);
+    ++_numTreeEvaluations;
+    return evaluateTree.dst;
+}
+
+uint32_t ExpressionBytecode::compileOperator(const Expression* expr) {
+    if (dynamic_cast<const ExpressionAdd*>(expr)) {
+        return compileVariadicArithmetic(expr, OpCode::kAdd);
+    } else if (dynamic_cast<const ExpressionMultiply*>(expr)) {
+        return compileVariadicArithmetic(expr, OpCode::kMultiply);
+    } else if (dynamic_cast<const ExpressionAnd*>(expr)) {
+        return compileLogical(expr, true);
+    } else if (dynamic_cast<const ExpressionOr*>(expr)) {
+        return compileLogical(expr, false);
+    } else if (dynamic_cast<const ExpressionCond*>(expr)) {
+        return compileCond(expr);
+    } else if (dynamic_cast<const ExpressionIfNull*>(expr)) {
+        return compileIfNull(expr);
+    }
+
+    const auto& operands = operandsOf(expr);
+    const size_t codeStart = _program.size();
+    std::vector<uint32_t> registers;
+    for (auto&& operand : operands) {
+        registers.push_back(compileNode(operand.get()));
+    }
+
+    uint32_t result;
+    if (foldConstant(expr, registers, codeStart, &result)) {
+        return result;
+    }
+
+    Instruction instruction(OpCode::kNot, expr);
+    if (dynamic_cast<const ExpressionSubtract*>(expr)) {
+        instruction.op = OpCode::kSubtract;
+    } else if (dynamic_cast<const ExpressionDivide*>(expr)) {
+        instruction.op = OpCode::kDivide;
+    } else if (auto comparison = dynamic_cast<const ExpressionCompare*>(expr)) {
+        instruction.op = OpCode::kCompare;
+        instruction.cmpOp = comparison->getOp();
+    }
+    instruction.dst = newRegister();
+    instruction.a = registers[0];
+    if (registers.size() > 1) {
+        instruction.b = registers[1];
+    }
+    emit(instruction);
+    return instruction.dst;
+}
+
+uint32_t ExpressionBytecode::compileVariadicArithmetic(const Expression* expr, OpCode op) {
+    const auto& operands = operandsOf(expr);
+    const size_t codeStart = _program.size();
+
+    // The expression tree returns null or throws at the first operand that is not a number,
+    // without evaluating the operands after it. So before any operand whose code could throw or
+    // take time, the operands computed so far are checked.
+    std::vector<uint32_t> registers;
+    std::vector<size_t> guards;
+    size_t numChecked = 0;
+    for (auto&& operand : operands) {
+        const size_t guardStart = _program.size();
+        for (size_t i = numChecked; i < registers.size(); ++i) {
+            if (!isConstant(registers[i]) || !isNumber(_registers[registers[i]])) {
+                Instruction guard(OpCode::kGuardNumber, expr);
+                guard.a = registers[i];
+                emit(guard);
+            }
+        }
+
+        const size_t operandStart = _program.size();
+        registers.push_back(compileNode(operand.get()));
+        if (_program.size() == operandStart) {
+            _program.erase(_program.begin() + guardStart, _program.end());
+            continue;
+        }
+        for (size_t guard = guardStart; guard < operandStart; ++guard) {
+            guards.push_back(guard);
+        }
+        numChecked = registers.size() - 1;
+    }
+
+    uint32_t result;
+    if (foldConstant(expr, registers, codeStart, &result)) {
+        return result;
+    }
+
+    Instruction instruction(op, expr);
+    instruction.dst = newRegister();
+    instruction.a = _operands.size();
+    instruction.b = registers.size();
+    _operands.insert(_operands.end(), registers.begin(), registers.end());
+    emit(instruction);
+
+    for (auto guard : guards) {
+        _program[guard].dst = instruction.dst;
+        _program[guard].target = _program.size();
+    }
+    return instruction.dst;
+}
+
+uint32_t ExpressionBytecode::compileLogical(const Expression* expr, bool isAnd) {
+    const auto& operands = operandsOf(expr);
+    const size_t codeStart = _program.size();
+
+    // $and stops at the first false operand, and $or at the first true one.
+    std::vector<uint32_t> registers;
+    std::vector<size_t> shortCircuits;
+    for (auto&& operand : operands) {
+        const uint32_t reg = compileNode(operand.get());
+        registers.push_back(reg);
+        if (!isConstant(reg)) {
+            Instruction jump(isAnd ? OpCode::kJumpIfFalse : OpCode::kJumpIfTrue);
+            jump.a = reg;
+            shortCircuits.push_back(emit(jump));
+        } else if (_registers[reg].coerceToBool() != isAnd) {
+            shortCircuits.push_back(emit(Instruction(OpCode::kJump)));
+            break;
+        }
+    }
+
+    uint32_t result;
+    if (foldConstant(expr, registers, codeStart, &result)) {
+        return result;
+    }
+
+    Instruction noShortCircuit(OpCode::kMove);
+    noShortCircuit.dst = newRegister();
+    noShortCircuit.a = constantRegister(Value(isAnd));
+    emit(noShortCircuit);
+    const size_t jumpToEnd = emit(Instruction(OpCode::kJump));
+
+    Instruction shortCircuit(OpCode::kMove);
+    shortCircuit.dst = noShortCircuit.dst;
+    shortCircuit.a = constantRegister(Value(!isAnd));
+    for (auto jump : shortCircuits) {
+        _program[jump].target = _program.size();
+    }
+    emit(shortCircuit);
+
+    _program[jumpToEnd].target = _program.size();
+    return noShortCircuit.dst;
+}
+
+uint32_t ExpressionBytecode::compileCond(const Expression* expr) {
+    const auto& operands = operandsOf(expr);
+
+    const uint32_t condition = compileNode(operands[0].get());
+    if (isConstant(condition)) {
+        return compileNode(operands[_registers[condition].coerceToBool() ? 1 : 2].get());
+    }
+
+    const uint32_t dst = newRegister();
+    Instruction jumpToElse(OpCode::kJumpIfFalse);
+    jumpToElse.a = condition;
+    const size_t jumpToElseIndex = emit(jumpToElse);
+
+    Instruction moveThen(OpCode::kMove);
+    moveThen.dst = dst;
+    moveThen.a = compileNode(operands[1].get());
+    emit(moveThen);
+    const size_t jumpToEnd = emit(Instruction(OpCode::kJump));
+
+    _program[jumpToElseIndex].target = _program.size();
+    Instruction moveElse(OpCode::kMove);
+    moveElse.dst = dst;
+    moveElse.a = compileNode(operands[2].get());
+    emit(moveElse);
+
+    _program[jumpToEnd].target = _program.size();
+    return dst;
+}
+
+uint32_t ExpressionBytecode::compileIfNull(const Expression* expr) {
+    const auto& operands = operandsOf(expr);
+
+    const uint32_t left = compileNode(operands[0].get());
+    if (isConstant(left)) {
+        return _registers[left].nullish() ? compileNode(operands[1].get()) : left;
+    }
+
+    Instruction moveLeft(OpCode::kMove);
+    moveLeft.dst = newRegister();
+    moveLeft.a = left;
+    emit(moveLeft);
+
+    Instruction jumpToEnd(OpCode::kJumpIfNotNullish);
+    jumpToEnd.a = left;
+    const size_t jumpToEndIndex = emit(jumpToEnd);
+
+    Instruction moveRight(OpCode::kMove);
+    moveRight.dst = moveLeft.dst;
+    moveRight.a = compileNode(operands[1].get());
+    emit(moveRight);
+
+    _program[jumpToEndIndex].target = _program.size();
+    return moveLeft.dst;
+}
+
+uint32_t ExpressionBytecode::newRegister() {
+    _registers.emplace_back();
+    _isConstant.push_back(false);
+    return _registers.size() - 1;
+}
+
+uint32_t ExpressionBytecode::constantRegister(Value value) {
+    const uint32_t reg = newRegister();
+    _registers[reg] = std::move(value);
+    _isConstant[reg] = true;
+    return reg;
+}
+
+size_t ExpressionBytecode::emit(Instruction instruction) {
+    _program.push_back(instruction);
+    return _program.size() - 1;
+}
+
+bool ExpressionBytecode::foldConstant(const Expression* expr,
+                                      const std::vector<uint32_t>& operands,
+                                      size_t codeStart,
+                                      uint32_t* result) {
+    if (!std::all_of(
+            operands.begin(), operands.end(), [&](uint32_t reg) { return isConstant(reg); })) {
+        return false;
+    }
+
+    Value value;
+    try {
+        value = expr->evaluate(Document());
+    } catch (const DBException&) {
+        // Leave the error to be raised if, and only if, the expression tree would raise it.
+        return false;
+    }
+
+    _program.erase(_program.begin() + codeStart, _program.end());
+    *result = constantRegister(std::move(value));
+    return true;
+}
+
+Value ExpressionBytecode::evaluate(const Document& root) const {
+    // Each call works on its own copy of the register file, which holds the constants.
+    std::vector<Value> registers(_registers);
+    for (auto&& load : _fieldLoads) {
+        registers[load.dst] = load.expr->evaluate(root);
+    }
+
+    size_t pc = 0;
+    while (pc < _program.size()) {
+        const Instruction& instruction = _program[pc++];
+        switch (instruction.op) {
+            case OpCode::kLoadField:
+            case OpCode::kEvaluateTree:
+                registers[instruction.dst] = instruction.expr->evaluate(root);
+                break;
+            case OpCode::kMove:
+                registers[instruction.dst] = registers[instruction.a];
+                break;
+            case OpCode::kJump:
+                pc = instruction.target;
+                break;
+            case OpCode::kJumpIfFalse:
+                if (!registers[instruction.a].coerceToBool()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kJumpIfTrue:
+                if (registers[instruction.a].coerceToBool()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kJumpIfNotNullish:
+                if (!registers[instruction.a].nullish()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kGuardNumber:
+                if (!isNumber(registers[instruction.a])) {
+                    registers[instruction.dst] = instruction.expr->evaluate(root);
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kNot:
+                registers[instruction.dst] = Value(!registers[instruction.a].coerceToBool());
+                break;
+            case OpCode::kAdd:
+            case OpCode::kMultiply: {
+                auto result = instruction.op == OpCode::kAdd ? add(registers, instruction)
+                                                             : multiply(registers, instruction);
+                registers[instruction.dst] =
+                    result ? std::move(*result) : instruction.expr->evaluate(root);
+                break;
+            }
+            case OpCode::kSubtract:
+            case OpCode::kDivide: {
+                const Value& lhs = registers[instruction.a];
+                const Value& rhs = registers[instruction.b];
+                auto result = instruction.op == OpCode::kSubtract ? subtract(lhs, rhs)
+                                                                  : divide(lhs, rhs);
+                registers[instruction.dst] =
+                    result ? std::move(*result) : instruction.expr->evaluate(root);
+                break;
+            }
+            case OpCode::kCompare:
+                registers[instruction.dst] =
+                    compare(instruction, registers[instruction.a], registers[instruction.b]);
+                break;
+        }
+    }
+    return registers[_result];
+}
+
+boost::optional<Value> ExpressionBytecode::add(const std::vector<Value>& registers,
+                                               const Instruction& instruction) const {
+    // As in ExpressionAdd::evaluate(), minus the decimal and date cases.
+    DoubleDoubleSummation total;
+    BSONType totalType = NumberInt;
+    for (uint32_t i = 0; i < instruction.b; ++i) {
+        const Value& value = registers[_operands[instruction.a + i]];
+        switch (value.getType()) {
+            case NumberDouble:
+                total.addDouble(value.getDouble());
+                totalType = NumberDouble;
+                break;
+            case NumberLong:
+                total.addLong(value.getLong());
+                if (totalType == NumberInt)
+                    totalType = NumberLong;
+                break;
+            case NumberInt:
+                total.addDouble(value.getInt());
+                break;
+            default:
+                if (value.nullish()) {
+                    return Value(BSONNULL);
+                }
+                return boost::none;
+        }
+    }
+
+    switch (totalType) {
+        case NumberLong:
+            if (total.fitsLong())
+                return Value(total.getLong());
+        // Fallthrough.
+        case NumberInt:
+            if (total.fitsLong())
+                return Value::createIntOrLong(total.getLong());
+        // Fallthrough.
+        default:
+            return Value(total.getDouble());
+    }
+}
+
+boost::optional<Value> ExpressionBytecode::subtract(const Value& lhs, const Value& rhs) const {
+    // As in ExpressionSubtract::evaluate(), minus the decimal and date cases.
+    if (isNumber(lhs) && isNumber(rhs)) {
+        switch (Value::getWidestNumeric(rhs.getType(), lhs.getType())) {
+            case NumberDouble:
+                return Value(lhs.coerceToDouble() - rhs.coerceToDouble());
+            case NumberLong:
+                return Value(lhs.coerceToLong() - rhs.coerceToLong());
+            default:
+                return Value::createIntOrLong(lhs.coerceToLong() - rhs.coerceToLong());
+        }
+    } else if (!(lhs.numeric() && rhs.numeric()) && (lhs.nullish() || rhs.nullish())) {
+        return Value(BSONNULL);
+    }
+    return boost::none;
+}
+
+boost::optional<Value> ExpressionBytecode::multiply(const std::vector<Value>& registers,
+                                                    const Instruction& instruction) const {
+    // As in ExpressionMultiply::evaluate(), minus the decimal case.
+    double doubleProduct = 1;
+    long long longProduct = 1;
+    BSONType productType = NumberInt;
+    for (uint32_t i = 0; i < instruction.b; ++i) {
+        const Value& value = registers[_operands[instruction.a + i]];
+        if (isNumber(value)) {
+            productType = Value::getWidestNumeric(productType, value.getType());
+            doubleProduct *= value.coerceToDouble();
+            if (mongoSignedMultiplyOverflow64(longProduct, value.coerceToLong(), &longProduct)) {
+                productType = NumberDouble;
+            }
+        } else if (value.nullish()) {
+            return Value(BSONNULL);
+        } else {
+            return boost::none;
+        }
+    }
+
+    if (productType == NumberDouble)
+        return Value(doubleProduct);
+    else if (productType == NumberLong)
+        return Value(longProduct);
+    return Value::createIntOrLong(longProduct);
+}
+
+boost::optional<Value> ExpressionBytecode::divide(const Value& lhs, const Value& rhs) const {
+    // As in ExpressionDivide::evaluate(), minus the decimal case. Division by zero is left to the
+    // expression tree, which raises the error.
+    if (isNumber(lhs) && isNumber(rhs)) {
+        const double denom = rhs.coerceToDouble();
+        if (denom == 0.0) {
+            return boost::none;
+        }
+        return Value(lhs.coerceToDouble() / denom);
+    } else if (!(lhs.numeric() && rhs.numeric()) && (lhs.nullish() || rhs.nullish())) {
+        return Value(BSONNULL);
+    }
+    return boost::none;
+}
+
+Value ExpressionBytecode::compare(const Instruction& instruction,
+                                  const Value& lhs,
+                                  const Value& rhs) const {
+    // Numbers of the same type compare directly, except NaN, which sorts below all other numbers.
+    // Collations only affect strings, so the tree's comparator handles everything else.
+    int cmp;
+    const BSONType type = lhs.getType();
+    if (type == rhs.getType() && type == NumberInt) {
+        cmp = compareNumbers(lhs.getInt(), rhs.getInt());
+    } else if (type == rhs.getType() && type == NumberLong) {
+        cmp = compareNumbers(lhs.getLong(), rhs.getLong());
+    } else if (type == rhs.getType() && type == NumberDouble && !std::isnan(lhs.getDouble()) &&
+               !std::isnan(rhs.getDouble())) {
+        cmp = compareNumbers(lhs.getDouble(), rhs.getDouble());
+    } else {
+        cmp = static_cast<const ExpressionCompare*>(instruction.expr)
+                  ->getValueComparator()
+                  .compare(lhs, rhs);
+        cmp = cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+    }
+
+    switch (static_cast<ExpressionCompare::CmpOp>(instruction.cmpOp)) {
+        case ExpressionCompare::EQ:
+            return Value(cmp == 0);
+        case ExpressionCompare::NE:
+            return Value(cmp != 0);
+        case ExpressionCompare::GT:
+            return Value(cmp > 0);
+        case ExpressionCompare::GTE:
+            return Value(cmp >= 0);
+        case ExpressionCompare::LT:
+            return Value(cmp < 0);
+        case ExpressionCompare::LTE:
+            return Value(cmp <= 0);
+        case ExpressionCompare::CMP:
+            return Value(cmp);
+    }
+    MONGO_UNREACHABLE;
+}
+
+}  // namespace mongo
@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+class Expression;
+
+/**
+ * An aggregation expression flattened into a program over a file of Value registers. Top-level
+ * paths of the document being evaluated are each loaded into a register once, at the start of the
+ * program, however many times the expression refers to them. $add, $subtract, $multiply and
+ * $divide over ints, longs and doubles, comparisons, $and, $or, $not, $cond and $ifNull run as
+ * instructions, and any of these whose operands are all constant is folded when compiling.
+ * Every other node is evaluated through the expression tree, as is a supported operator whose
+ * operands at run time are of a type its instruction does not handle (dates, decimals, or an
+ * error), so results and errors are those of Expression::evaluate().
+ *
+ * The Expression it was compiled from must outlive it and must not change. Each call to
+ * evaluate() works on its own registers, so a compiled expression may be evaluated on several
+ * threads at once, as far as the nodes it evaluates through the tree allow.
+ */
+class ExpressionBytecode {
+    MONGO_DISALLOW_COPYING(ExpressionBytecode);
+
+public:
+    /**
+     * Returns nullptr if 'expr' does not start with an operator that compilation would speed up.
+     */
+    static std::unique_ptr<ExpressionBytecode> compile(const Expression* expr);
+
+    /**
+     * Equivalent to Expression::evaluate() on the expression this was compiled from.
+     */
+    Value evaluate(const Document& root) const;
+
+    size_t numInstructions() const {
+        return _program.size();
+    }
+
+    size_t numFieldLoads() const {
+        return _numFieldLoads;
+    }
+
+    size_t numTreeEvaluations() const {
+        return _numTreeEvaluations;
+    }
+
+private:
+    enum class OpCode : uint8_t {
+        kLoadField,
+        kEvaluateTree,
+        kMove,
+        kJump,
+        kJumpIfFalse,
+        kJumpIfTrue,
+        kJumpIfNotNullish,
+        kGuardNumber,
+        kNot,
+        kAdd,
+        kSubtract,
+        kMultiply,
+        kDivide,
+        kCompare,
+    };
+
+    /**
+     * 'a' and 'b' are the operand registers, or the first operand and number of operands in
+     * '_operands' for $add and $multiply. 'expr' is the node to evaluate through the tree if this
+     * instruction cannot produce its result itself.
+     */
+    struct Instruction {
+        explicit Instruction(OpCode op, const Expression* expr = nullptr) : op(op), expr(expr) {}
+
+        OpCode op;
+        uint32_t dst = 0;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t target = 0;
+        int cmpOp = 0;
+        const Expression* expr = nullptr;
+    };
+
+    ExpressionBytecode() = default;
+
+    /**
+     * Emits the code for 'expr' and returns the register holding its result.
+     */
+    uint32_t compileNode(const Expression* expr);
+
+    uint32_t compileOperator(const Expression* expr);
+    uint32_t compileVariadicArithmetic(const Expression* expr, OpCode op);
+    uint32_t compileLogical(const Expression* expr, bool isAnd);
+    uint32_t compileCond(const Expression* expr);
+    uint32_t compileIfNull(const Expression* expr);
+
+    uint32_t newRegister();
+    uint32_t constantRegister(Value value);
+    size_t emit(Instruction instruction);
+
+    bool isConstant(uint32_t reg) const {
+        return _isConstant[reg];
+    }
+
+    /**
+     * Replaces the code emitted for 'expr' since 'codeStart' with the constant it evaluates to, if
+     * all of 'operands' are constants and evaluating it does not throw.
+     */
+    bool foldConstant(const Expression* expr,
+                      const std::vector<uint32_t>& operands,
+                      size_t codeStart,
+                      uint32_t* result);
+
+    /**
+     * Each returns boost::none where the expression tree must produce the result instead.
+     * 'registers' are those of the call to evaluate().
+     */
+    boost::optional<Value> add(const std::vector<Value>& registers,
+                               const Instruction& instruction) const;
+    boost::optional<Value> subtract(const Value& lhs, const Value& rhs) const;
+    boost::optional<Value> multiply(const std::vector<Value>& registers,
+                                    const Instruction& instruction) const;
+    boost::optional<Value> divide(const Value& lhs, const Value& rhs) const;
+    Value compare(const Instruction& instruction, const Value& lhs, const Value& rhs) const;
+
+    // Field loads, which come first, then the body of the program.
+    std::vector<Instruction> _fieldLoads;
+    std::vector<Instruction> _program;
+
+    // Registers holding operands of $add and $multiply instructions.
+    std::vector<uint32_t> _operands;
+
+    // The register file evaluate() starts from. Registers of constants are filled in when
+    // compiling, and the others are left missing.
+    std::vector<Value> _registers;
+    std::vector<bool> _isConstant;
+
+    // Maps each top-level path loaded by a kLoadField instruction to its register.
+    std::vector<std::pair<std::string, uint32_t>> _fieldRegisters;
+
+    uint32_t _result = 0;
+    size_t _numFieldLoads = 0;
+    size_t _numTreeEvaluations = 0;
+};
+
+}  // namespace mongo
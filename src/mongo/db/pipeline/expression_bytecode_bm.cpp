@@ -0,0 +1,129 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_bytecode.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const size_t kNumDocs = 1000;
+
+/**
+ * Order lines: {price: double, qty: int, tax: double, discount: double or missing, score: int,
+ * status: string, name: string}.
+ */
+std::vector<Document> makeDocs() {
+    const std::vector<std::string> statuses = {"active", "inactive", "pending"};
+    std::vector<Document> docs;
+    docs.reserve(kNumDocs);
+    for (size_t i = 0; i < kNumDocs; ++i) {
+        MutableDocument doc;
+        doc.addField("price", Value(0.25 * (i % 400)));
+        doc.addField("qty", Value(static_cast<int>(i % 12)));
+        doc.addField("tax", Value(0.05 + 0.01 * (i % 4)));
+        if (i % 3) {
+            doc.addField("discount", Value(0.5 * (i % 5)));
+        }
+        doc.addField("score", Value(static_cast<int>(i % 101)));
+        doc.addField("status", Value(statuses[i % statuses.size()]));
+        doc.addField("name", Value("item" + std::to_string(i)));
+        docs.push_back(doc.freeze());
+    }
+    return docs;
+}
+
+/**
+ * Evaluates 'spec' over each document, through the expression tree if state.range(0) is 0 and
+ * through its compiled bytecode otherwise.
+ */
+void runExpression(benchmark::State& state, const char* spec) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    BSONObj wrapped = BSON("expr" << fromjson(spec));
+    auto expr =
+        Expression::parseOperand(expCtx, wrapped.firstElement(), expCtx->variablesParseState);
+    expr = expr->optimize();
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    invariant(compiled);
+    const bool useBytecode = state.range(0);
+
+    const std::vector<Document> docs = makeDocs();
+    for (auto keepRunning : state) {
+        for (auto&& doc : docs) {
+            benchmark::DoNotOptimize(useBytecode ? compiled->evaluate(doc) : expr->evaluate(doc));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * docs.size());
+}
+
+// A computed $project field: the line total with tax.
+void BM_ComputedProject(benchmark::State& state) {
+    runExpression(state, "{$multiply: ['$price', '$qty', {$add: [1, '$tax']}]}");
+}
+
+// An $addFields field over an optional input.
+void BM_AddFields(benchmark::State& state) {
+    runExpression(state,
+                  "{$subtract: [{$multiply: ['$price', '$qty']},"
+                  " {$multiply: [{$ifNull: ['$discount', 0]}, '$qty']}]}");
+}
+
+// Bucketing through nested $cond, as in a grading or tiering $project.
+void BM_CondHeavy(benchmark::State& state) {
+    runExpression(state,
+                  "{$cond: [{$gte: ['$score', 90]}, 'A',"
+                  " {$cond: [{$gte: ['$score', 75]}, 'B',"
+                  " {$cond: [{$and: [{$gte: ['$score', 50]}, {$ne: ['$status', 'inactive']}]},"
+                  " 'C', 'D']}]}]}");
+}
+
+// A mix in which one operand, $strLenCP, is left to the expression tree.
+void BM_MixedWithTreeOperand(benchmark::State& state) {
+    runExpression(state,
+                  "{$cond: [{$or: [{$gt: [{$strLenCP: '$name'}, 6]}, {$lt: ['$price', 10]}]},"
+                  " {$divide: [{$multiply: ['$price', '$qty']}, 100]}, null]}");
+}
+
+BENCHMARK(BM_ComputedProject)->Arg(0)->Arg(1);
+BENCHMARK(BM_AddFields)->Arg(0)->Arg(1);
+BENCHMARK(BM_CondHeavy)->Arg(0)->Arg(1);
+BENCHMARK(BM_MixedWithTreeOperand)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mongo
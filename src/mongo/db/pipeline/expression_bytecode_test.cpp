@@ -0,0 +1,330 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cmath>
+#include <limits>
+
+#include "mongo/bson/bsonmisc.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_bytecode.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using boost::intrusive_ptr;
+
+intrusive_ptr<Expression> parseExpression(const intrusive_ptr<ExpressionContext>& expCtx,
+                                          const BSONObj& spec) {
+    BSONObj wrapped = BSON("expr" << spec);
+    return Expression::parseOperand(
+        expCtx, wrapped.firstElement(), expCtx->variablesParseState);
+}
+
+/**
+ * Asserts that the compiled form of 'spec' returns a value of the same type and value, or fails
+ * with the same error code, as the expression tree for each of 'docs'.
+ */
+void assertMatchesTree(const intrusive_ptr<ExpressionContext>& expCtx,
+                       const BSONObj& spec,
+                       const std::vector<Document>& docs) {
+    auto expr = parseExpression(expCtx, spec);
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled) << spec;
+
+    for (auto&& doc : docs) {
+        boost::optional<Value> expected;
+        int expectedCode = 0;
+        try {
+            expected = expr->evaluate(doc);
+        } catch (const DBException& ex) {
+            expectedCode = ex.code();
+        }
+
+        if (!expected) {
+            ASSERT_THROWS_CODE(compiled->evaluate(doc), AssertionException, expectedCode);
+            continue;
+        }
+        Value actual = compiled->evaluate(doc);
+        ASSERT_EQ(expected->getType(), actual.getType()) << spec << " on " << doc.toString();
+        ASSERT_VALUE_EQ(*expected, actual);
+    }
+}
+
+std::vector<Document> mixedTypeDocuments() {
+    std::vector<Document> docs;
+    docs.push_back(Document{{"a", 1}, {"b", 2}});
+    docs.push_back(Document{{"a", 7}, {"b", -3}, {"c", "c"_sd}});
+    docs.push_back(Document{{"a", std::numeric_limits<int>::max()}, {"b", 2}});
+    docs.push_back(Document{{"a", std::numeric_limits<long long>::max()}, {"b", 2LL}});
+    docs.push_back(Document{{"a", std::numeric_limits<long long>::max()}, {"b", 0.5}});
+    docs.push_back(Document{{"a", 1.5}, {"b", 3}});
+    docs.push_back(Document{{"a", std::nan("")}, {"b", 1.0}});
+    docs.push_back(Document{{"a", 10}, {"b", 0}});
+    docs.push_back(Document{{"a", Decimal128("1.1")}, {"b", 2}});
+    docs.push_back(Document{{"a", Date_t::fromMillisSinceEpoch(1000)}, {"b", 5}});
+    docs.push_back(Document{{"a", BSONNULL}, {"b", 1}});
+    docs.push_back(Document{{"b", 4LL}});
+    docs.push_back(Document{{"a", "x"_sd}, {"b", "y"_sd}});
+    docs.push_back(Document{{"a", true}, {"b", BSONArray()}});
+    docs.push_back(Document{{"a", Document{{"x", 1}}}, {"b", 1}});
+    return docs;
+}
+
+TEST(ExpressionBytecodeTest, MatchesTreeOnMixedTypes) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const std::vector<BSONObj> specs = {
+        fromjson("{$add: ['$a', '$b', 1]}"),
+        fromjson("{$add: ['$a', {$multiply: ['$b', 2]}, '$b']}"),
+        fromjson("{$add: ['$c', {$divide: ['$a', 0]}]}"),
+        fromjson("{$subtract: ['$a', '$b']}"),
+        fromjson("{$multiply: ['$a', '$b', '$a']}"),
+        fromjson("{$multiply: ['$c', {$divide: ['$a', 0]}]}"),
+        fromjson("{$divide: ['$a', '$b']}"),
+        fromjson("{$cmp: ['$a', '$b']}"),
+        fromjson("{$eq: ['$a', '$b']}"),
+        fromjson("{$ne: ['$a', 1]}"),
+        fromjson("{$gt: ['$a', '$b']}"),
+        fromjson("{$gte: ['$a', 1.5]}"),
+        fromjson("{$lt: ['$a', '$b']}"),
+        fromjson("{$lte: ['$b', 2]}"),
+        fromjson("{$and: ['$a', {$lt: ['$b', 3]}]}"),
+        fromjson("{$or: [{$eq: ['$a', null]}, {$gt: ['$b', '$a']}]}"),
+        fromjson("{$not: ['$a']}"),
+        fromjson("{$ifNull: ['$a', {$add: ['$b', 1]}]}"),
+        fromjson("{$cond: [{$gt: ['$a', '$b']}, {$subtract: ['$a', '$b']},"
+                 " {$ifNull: ['$c', 'none']}]}"),
+        fromjson("{$cond: {if: {$and: ['$a', '$b']}, then: {$divide: ['$a', '$b']},"
+                 " else: {$abs: '$b'}}}"),
+        fromjson("{$add: [{$abs: '$b'}, '$a.x', {$size: {$ifNull: [[], []]}}]}"),
+    };
+
+    for (auto&& spec : specs) {
+        assertMatchesTree(expCtx, spec, mixedTypeDocuments());
+    }
+}
+
+/**
+ * Documents with every combination of these values for 'a' and 'b', including leaving either out.
+ * Unless 'extremeLongs' is true, the longs are small enough that subtracting any two numbers here
+ * stays in range.
+ */
+std::vector<Document> operandCombinations(bool extremeLongs = true) {
+    const long long largeLong = extremeLongs ? std::numeric_limits<long long>::max() : 1LL << 40;
+    const std::vector<boost::optional<Value>> values = {
+        boost::none,
+        Value(BSONNULL),
+        Value(BSONUndefined),
+        Value(0),
+        Value(-1),
+        Value(std::numeric_limits<int>::max()),
+        Value(std::numeric_limits<int>::min()),
+        Value(largeLong),
+        Value(-largeLong - 1),
+        Value(-0.0),
+        Value(2.5),
+        Value(std::numeric_limits<double>::infinity()),
+        Value(std::nan("")),
+        Value(Decimal128("-3.25")),
+        Value(Date_t::fromMillisSinceEpoch(-1)),
+        Value("s"_sd),
+        Value(false),
+        Value(std::vector<Value>{}),
+        Value(std::vector<Value>{Value(1), Value(2)}),
+        Value(std::vector<Value>{Value(std::vector<Value>{Value(BSONNULL)})}),
+        Value(Document{{"x", 1}}),
+    };
+
+    std::vector<Document> docs;
+    for (auto&& a : values) {
+        for (auto&& b : values) {
+            MutableDocument doc;
+            if (a) {
+                doc.addField("a", *a);
+            }
+            if (b) {
+                doc.addField("b", *b);
+            }
+            docs.push_back(doc.freeze());
+        }
+    }
+    return docs;
+}
+
+TEST(ExpressionBytecodeTest, MatchesTreeOnEveryCombinationOfOperands) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const std::vector<BSONObj> specs = {
+        fromjson("{$add: ['$a', '$b']}"),
+        fromjson("{$add: ['$a', '$b', '$a']}"),
+        fromjson("{$add: ['$a', 1, {$multiply: ['$b', '$b']}]}"),
+        fromjson("{$multiply: ['$a', '$b']}"),
+        fromjson("{$multiply: ['$a', '$b', -1]}"),
+        fromjson("{$divide: ['$a', '$b']}"),
+        fromjson("{$cmp: ['$a', '$b']}"),
+        fromjson("{$eq: ['$a', '$b']}"),
+        fromjson("{$ne: ['$a', '$b']}"),
+        fromjson("{$lt: ['$a', '$b']}"),
+        fromjson("{$lte: ['$a', '$b']}"),
+        fromjson("{$gt: ['$a', '$b']}"),
+        fromjson("{$gte: ['$a', '$b']}"),
+        fromjson("{$and: ['$a', '$b']}"),
+        fromjson("{$or: ['$a', {$not: ['$b']}]}"),
+        fromjson("{$ifNull: ['$a', '$b']}"),
+        fromjson("{$cond: ['$a', '$b', {$ifNull: ['$b', '$a']}]}"),
+        fromjson("{$cond: [{$lt: ['$a', '$b']}, {$add: ['$a', '$b']}, {$divide: ['$b', '$a']}]}"),
+    };
+
+    const auto docs = operandCombinations();
+    for (auto&& spec : specs) {
+        assertMatchesTree(expCtx, spec, docs);
+    }
+}
+
+TEST(ExpressionBytecodeTest, SubtractMatchesTreeOnEveryCombinationOfOperands) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    // The tree's own long subtraction overflows on the extreme longs, so they are left out here.
+    const std::vector<BSONObj> specs = {
+        fromjson("{$subtract: ['$a', '$b']}"),
+        fromjson("{$subtract: ['$b', '$a']}"),
+        fromjson("{$subtract: ['$a', 1]}"),
+        fromjson("{$subtract: [{$multiply: ['$a', 2]}, {$subtract: ['$b', '$a']}]}"),
+        fromjson("{$cond: [{$gt: ['$a', '$b']}, {$subtract: ['$a', '$b']}, {$ifNull: ['$b', 0]}]}"),
+    };
+
+    const auto docs = operandCombinations(false);
+    for (auto&& spec : specs) {
+        assertMatchesTree(expCtx, spec, docs);
+    }
+}
+
+TEST(ExpressionBytecodeTest, EvaluatesOnSeveralThreadsAtOnce) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = parseExpression(expCtx,
+                                fromjson("{$cond: [{$gt: ['$a', '$b']},"
+                                         " {$add: ['$a', {$multiply: ['$b', 2]}]},"
+                                         " {$subtract: ['$b', '$a']}]}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+
+    std::vector<Document> docs;
+    std::vector<Value> expected;
+    for (int i = 0; i < 100; ++i) {
+        docs.push_back(Document{{"a", i}, {"b", 50}});
+        expected.push_back(expr->evaluate(docs.back()));
+    }
+
+    const ValueComparator comparator{nullptr};
+    AtomicInt32 mismatches{0};
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int rep = 0; rep < 200; ++rep) {
+                for (size_t i = 0; i < docs.size(); ++i) {
+                    if (comparator.evaluate(compiled->evaluate(docs[i]) != expected[i])) {
+                        mismatches.fetchAndAdd(1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, mismatches.load());
+}
+
+TEST(ExpressionBytecodeTest, ConstantOperandsAreFolded) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = parseExpression(
+        expCtx, fromjson("{$add: ['$a', {$multiply: [2, 3]}, {$cond: [true, 1, '$b']}]}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+
+    // Only the $add remains, and '$b' is never loaded.
+    ASSERT_EQ(compiled->numInstructions(), 1U);
+    ASSERT_EQ(compiled->numFieldLoads(), 1U);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1}}), Value(8));
+}
+
+TEST(ExpressionBytecodeTest, RepeatedFieldPathsAreLoadedOnce) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = parseExpression(
+        expCtx, fromjson("{$cond: [{$gt: ['$a', '$b']}, {$subtract: ['$a', '$b']}, '$a']}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(compiled->numFieldLoads(), 2U);
+    ASSERT_EQ(compiled->numTreeEvaluations(), 0U);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 5}, {"b", 2}}), Value(3));
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1}, {"b", 2}}), Value(1));
+}
+
+TEST(ExpressionBytecodeTest, UnsupportedOperatorsAreEvaluatedThroughTheTree) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto abs = parseExpression(expCtx, fromjson("{$abs: '$a'}"));
+    ASSERT_FALSE(ExpressionBytecode::compile(abs.get()));
+
+    auto expr = parseExpression(expCtx, fromjson("{$add: [{$abs: '$a'}, 1]}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_EQ(compiled->numTreeEvaluations(), 1U);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", -2}}), Value(3));
+}
+
+TEST(ExpressionBytecodeTest, ErrorsAreNotRaisedByFoldingConstants) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = parseExpression(expCtx, fromjson("{$cond: ['$a', 1, {$divide: [1, 0]}]}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", true}}), Value(1));
+    ASSERT_THROWS_CODE(
+        compiled->evaluate(Document{{"a", false}}), AssertionException, 16608);
+}
+
+TEST(ExpressionBytecodeTest, ComparisonsRespectTheCollation) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    expCtx->setCollator(&collator);
+    auto expr = parseExpression(expCtx, fromjson("{$eq: ['$a', '$b']}"));
+    auto compiled = ExpressionBytecode::compile(expr.get());
+    ASSERT(compiled);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", "x"_sd}, {"b", "y"_sd}}), Value(true));
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1}, {"b", 2}}), Value(false));
+}
+
+}  // namespace
+}  // namespace mongo
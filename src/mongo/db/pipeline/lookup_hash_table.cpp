@@ -0,0 +1,253 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// Rough cost of a hash table node and its vector of entry ordinals, on top of the key itself.
+const size_t kPerKeyOverheadBytes = 64;
+
+/**
+ * Missing and undefined values match an equality to null, so they are indexed as null.
+ */
+Value keyFromElement(BSONElement elem) {
+    if (elem.eoo() || elem.type() == BSONType::Undefined) {
+        return Value(BSONNULL);
+    }
+    return Value(elem);
+}
+
+}  // namespace
+
+constexpr size_t LookupHashTable::kNumPartitions;
+
+LookupHashTable::LookupHashTable(const ValueComparator& comparator,
+                                 StringData joinField,
+                                 size_t maxMemoryUsageBytes,
+                                 std::string spillDir,
+                                 std::shared_ptr<OperationStageMemCounter> memCounter)
+    : _comparator(comparator),
+      _joinPath(joinField),
+      _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _spillDir(std::move(spillDir)),
+      _index(_comparator.makeUnorderedValueMap<std::vector<uint32_t>>()),
+      _memOperation(std::move(memCounter)) {
+    if (_memOperation) {
+        _memTenant = _memOperation->getTenant();
+    }
+}
+
+LookupHashTable::~LookupHashTable() {
+    _memoryUsageBytes = 0;
+    reserveMemory(true);
+}
+
+bool LookupHashTable::add(Document doc) {
+    invariant(!_abandoned);
+
+    const uint32_t ordinal = _entries.size();
+    const BSONObj obj = doc.toBson();
+
+    size_t partitionNo = 0;
+    bool firstKey = true;
+    BSONElementIterator it(&_joinPath, obj);
+    while (it.more()) {
+        Value key = keyFromElement(it.next().element());
+        if (firstKey) {
+            partitionNo = _comparator.getHasher()(key) % kNumPartitions;
+            firstKey = false;
+        }
+
+        auto& ordinals = _index[key];
+        if (ordinals.empty()) {
+            _memoryUsageBytes += key.getApproximateSize() + kPerKeyOverheadBytes;
+        } else if (ordinals.back() == ordinal) {
+            // The document holds this key more than once, e.g. both as an array element and as the
+            // array itself.
+            continue;
+        }
+        ordinals.push_back(ordinal);
+        _memoryUsageBytes += sizeof(uint32_t);
+    }
+
+    _entries.emplace_back();
+    auto& entry = _entries.back();
+    auto& partition = _partitions[partitionNo];
+    _memoryUsageBytes += sizeof(Entry);
+    if (partition.spilled) {
+        entry.doc = std::move(doc);
+        spillEntry(&entry);
+    } else {
+        const size_t docSize = doc.getApproximateSize();
+        entry.doc = std::move(doc);
+        partition.residentEntries.push_back(ordinal);
+        partition.residentBytes += docSize;
+        _memoryUsageBytes += docSize;
+    }
+
+    reserveMemory();
+    if (!fitInMemoryLimits()) {
+        _abandoned = true;
+        return false;
+    }
+    return true;
+}
+
+bool LookupHashTable::fitInMemoryLimits() {
+    while (true) {
+        auto level = StageMemLimitLevel::kNone;
+        if (_memoryUsageBytes <= _maxMemoryUsageBytes) {
+            level = globalStageMemCounters.chkCachedMemOversize(
+                _memoryUsageBytes, _memOperation.get(), _memTenant.get());
+            if (level == StageMemLimitLevel::kNone) {
+                return true;
+            }
+        }
+
+        const bool maySpill = !_spillDir.empty() &&
+            (level == StageMemLimitLevel::kNone ||
+             (level == StageMemLimitLevel::kGlobal &&
+              internalQueryStageMemSpillOnGlobalLimit.load()));
+        if (!maySpill || !spillLargestPartition()) {
+            if (level != StageMemLimitLevel::kNone) {
+                globalStageMemCounters.noteRejected(level, _memTenant.get());
+            }
+            return false;
+        }
+        reserveMemory(true);
+    }
+}
+
+void LookupHashTable::setOperationMemCounter(std::shared_ptr<OperationStageMemCounter> memCounter) {
+    if (_memOperation) {
+        _memOperation->reserve(-_reservedMemoryBytes);
+    }
+    _memOperation = std::move(memCounter);
+    if (_memOperation) {
+        _memOperation->reserve(_reservedMemoryBytes);
+    }
+}
+
+void LookupHashTable::reserveMemory(bool force) {
+    const int64_t delta = static_cast<int64_t>(_memoryUsageBytes) - _reservedMemoryBytes;
+    if (delta == 0) {
+        return;
+    }
+    if (!force && std::abs(delta) < internalQueryStageMemReserveChunkBytes.load()) {
+        return;
+    }
+    globalStageMemCounters.reserveLookupMemSize(delta);
+    if (_memOperation) {
+        _memOperation->reserve(delta);
+    }
+    if (_memTenant) {
+        _memTenant->reserve(delta);
+    }
+    _reservedMemoryBytes += delta;
+}
+
+std::vector<Document> LookupHashTable::probe(const std::vector<Value>& localValues) {
+    invariant(!_abandoned);
+
+    std::vector<uint32_t> matches;
+    for (auto&& value : localValues) {
+        auto it = _index.find(value);
+        if (it != _index.end()) {
+            matches.insert(matches.end(), it->second.begin(), it->second.end());
+        }
+    }
+    if (localValues.size() > 1) {
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    }
+
+    std::vector<Document> results;
+    results.reserve(matches.size());
+    for (auto ordinal : matches) {
+        const auto& entry = _entries[ordinal];
+        if (entry.spilled) {
+            results.push_back(Document::fromBsonWithMetaData(_spillFile->read(entry.location)));
+        } else {
+            results.push_back(entry.doc);
+        }
+    }
+    return results;
+}
+
+size_t LookupHashTable::numSpilledPartitions() const {
+    return std::count_if(_partitions.begin(), _partitions.end(), [](const Partition& partition) {
+        return partition.spilled;
+    });
+}
+
+bool LookupHashTable::spillLargestPartition() {
+    Partition* largest = nullptr;
+    for (auto&& partition : _partitions) {
+        if (!partition.spilled && (!largest || partition.residentBytes > largest->residentBytes)) {
+            largest = &partition;
+        }
+    }
+    if (!largest) {
+        return false;
+    }
+
+    if (!_spillFile) {
+        _spillFile = stdx::make_unique<StageSpillFile>(_spillDir);
+    }
+    for (auto ordinal : largest->residentEntries) {
+        spillEntry(&_entries[ordinal]);
+    }
+    _memoryUsageBytes -= largest->residentBytes;
+    largest->residentEntries.clear();
+    largest->residentEntries.shrink_to_fit();
+    largest->residentBytes = 0;
+    largest->spilled = true;
+    return true;
+}
+
+void LookupHashTable::spillEntry(Entry* entry) {
+    invariant(_spillFile);
+    entry->location = _spillFile->append(entry->doc.toBsonWithMetaData());
+    entry->doc = Document();
+    entry->spilled = true;
+}
+
+}  // namespace mongo
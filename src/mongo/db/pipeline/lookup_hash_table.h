@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/exec/stage_spill_file.h"
+#include "mongo/db/matcher/path.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+
+namespace mongo {
+
+class OperationStageMemCounter;
+class TenantStageMemCounter;
+
+/**
+ * The build side of a hash join $lookup: the documents of the foreign collection, indexed by the
+ * values they hold at the join field. Probing with the local values of an input document returns
+ * the documents that match {<joinField>: {$eq: <value>}} for any of those values, in the order they
+ * were added. Keys are taken with the same path traversal as the match expression, so arrays along
+ * and at the end of the path, null and missing fields, and the collation of 'comparator' behave as
+ * they do for the per-document query.
+ *
+ * Documents are assigned to one of kNumPartitions partitions by the hash of their first key. When
+ * the table exceeds its memory budget, the documents of the largest resident partition are moved to
+ * a spill file, as are all documents added to that partition later. Keys always stay in memory, and
+ * a probe that hits a spilled document reads it back.
+ *
+ * The table's memory is also reserved against the stage memory limits of the process, and of the
+ * operation and its database if it has a counter for them, like a plan stage's. Over the global
+ * limit it spills, if it may; over any other limit it gives up, as over its budget.
+ */
+class LookupHashTable {
+    MONGO_DISALLOW_COPYING(LookupHashTable);
+
+public:
+    static constexpr size_t kNumPartitions = 16;
+
+    /**
+     * 'spillDir' is where spill files are written, or empty if the table may not spill.
+     * 'memCounter' is the operation the table's memory is reserved against, or null.
+     */
+    LookupHashTable(const ValueComparator& comparator,
+                    StringData joinField,
+                    size_t maxMemoryUsageBytes,
+                    std::string spillDir,
+                    std::shared_ptr<OperationStageMemCounter> memCounter = nullptr);
+
+    /**
+     * Releases the table's memory reservations.
+     */
+    ~LookupHashTable();
+
+    /**
+     * Adds 'doc' to the table. Returns false if the table no longer fits in its budget and can't
+     * spill; it must not be used after that.
+     */
+    bool add(Document doc);
+
+    /**
+     * Returns the documents added to the table that match any of 'localValues'. Each document is
+     * returned once, however many of the values it matches.
+     */
+    std::vector<Document> probe(const std::vector<Value>& localValues);
+
+    size_t numDocuments() const {
+        return _entries.size();
+    }
+
+    size_t memoryUsageBytes() const {
+        return _memoryUsageBytes;
+    }
+
+    size_t numSpilledPartitions() const;
+
+    /**
+     * Moves the table's reservation from the operation it was reserved against to 'memCounter',
+     * which may be null, as the table is used by another operation.
+     */
+    void setOperationMemCounter(std::shared_ptr<OperationStageMemCounter> memCounter);
+
+    uint64_t spilledBytes() const {
+        return _spillFile ? _spillFile->bytesWritten() : 0;
+    }
+
+private:
+    struct Entry {
+        Document doc;
+        StageSpillFile::Location location;
+        bool spilled = false;
+    };
+
+    struct Partition {
+        std::vector<uint32_t> residentEntries;
+        size_t residentBytes = 0;
+        bool spilled = false;
+    };
+
+    /**
+     * Moves the resident documents of the largest resident partition to the spill file. Returns
+     * false if there is no resident partition left to spill.
+     */
+    bool spillLargestPartition();
+
+    void spillEntry(Entry* entry);
+
+    /**
+     * Brings the reservation against the stage memory limits in line with '_memoryUsageBytes'.
+     * Unless 'force' is set, the reservation only moves once it is off by a whole chunk.
+     */
+    void reserveMemory(bool force = false);
+
+    /**
+     * Returns false, once the table has spilled what it can, if it is over its budget or a stage
+     * memory limit.
+     */
+    bool fitInMemoryLimits();
+
+    const ValueComparator _comparator;
+    const ElementPath _joinPath;
+    const size_t _maxMemoryUsageBytes;
+    const std::string _spillDir;
+
+    std::vector<Entry> _entries;
+    ValueUnorderedMap<std::vector<uint32_t>> _index;
+    std::array<Partition, kNumPartitions> _partitions;
+    std::unique_ptr<StageSpillFile> _spillFile;
+
+    size_t _memoryUsageBytes = 0;
+    bool _abandoned = false;
+
+    // The reservation against the stage memory limits, and the counters it is held against.
+    int64_t _reservedMemoryBytes = 0;
+    std::shared_ptr<OperationStageMemCounter> _memOperation;
+    std::shared_ptr<TenantStageMemCounter> _memTenant;
+};
+
+}  // namespace mongo
@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const ValueComparator defaultComparator{nullptr};
+
+std::vector<int> probeIds(LookupHashTable* table, std::vector<Value> localValues) {
+    std::vector<int> ids;
+    for (auto&& doc : table->probe(localValues)) {
+        ids.push_back(doc["_id"].getInt());
+    }
+    return ids;
+}
+
+TEST(LookupHashTableTest, ProbeReturnsMatchesInInsertionOrder) {
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: 1}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: 2}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 2, a: 1}"))));
+
+    ASSERT_EQ(table.numDocuments(), 3U);
+    ASSERT(probeIds(&table, {Value(1)}) == std::vector<int>({0, 2}));
+    ASSERT(probeIds(&table, {Value(2)}) == std::vector<int>({1}));
+    ASSERT(probeIds(&table, {Value(3)}).empty());
+}
+
+TEST(LookupHashTableTest, NumericTypesCompareEqual) {
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: 1}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: {$numberLong: '1'}}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 2, a: 1.0}"))));
+
+    ASSERT(probeIds(&table, {Value(1LL)}) == std::vector<int>({0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, ArraysMatchByElementAndAsAWhole) {
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: [1, 2]}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: [[1, 2], 3]}"))));
+
+    ASSERT(probeIds(&table, {Value(1)}) == std::vector<int>({0}));
+    ASSERT(probeIds(&table, {Value(3)}) == std::vector<int>({1}));
+    ASSERT(probeIds(&table, {Value(std::vector<Value>{Value(1), Value(2)})}) ==
+           std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, TraversesArraysAlongThePath) {
+    LookupHashTable table(defaultComparator, "a.b", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: [{b: 1}, {b: 2}]}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: {b: 2}}"))));
+
+    ASSERT(probeIds(&table, {Value(1)}) == std::vector<int>({0}));
+    ASSERT(probeIds(&table, {Value(2)}) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, NullMatchesNullMissingAndUndefined) {
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: null}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 2, a: {$undefined: true}}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 3, a: 0}"))));
+
+    ASSERT(probeIds(&table, {Value(BSONNULL)}) == std::vector<int>({0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, DocumentMatchingSeveralValuesIsReturnedOnce) {
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: [1, 2]}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: 2}"))));
+
+    ASSERT(probeIds(&table, {Value(2), Value(1)}) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, RespectsCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    LookupHashTable table(ValueComparator(&collator), "a", 1024 * 1024, "");
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: 'foo'}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: 'bar'}"))));
+
+    ASSERT(probeIds(&table, {Value("baz"_sd)}) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, ReportsFailureOverBudgetWithoutSpillDir) {
+    LookupHashTable table(defaultComparator, "a", 1024, "");
+    bool fits = true;
+    for (int i = 0; fits && i < 100; ++i) {
+        fits = table.add(Document{{"_id", i}, {"a", i}, {"pad", std::string(100, 'x')}});
+    }
+    ASSERT_FALSE(fits);
+}
+
+TEST(LookupHashTableTest, SpillsPartitionsOverBudget) {
+    unittest::TempDir tempDir("lookup_hash_table_test");
+    LookupHashTable table(defaultComparator, "a", 64 * 1024, tempDir.path());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(table.add(Document{{"_id", i}, {"a", i % 10}, {"pad", std::string(100, 'x')}}));
+    }
+
+    ASSERT_GT(table.numSpilledPartitions(), 0U);
+    ASSERT_GT(table.spilledBytes(), 0U);
+    ASSERT_LTE(table.memoryUsageBytes(), 64U * 1024);
+
+    auto matches = table.probe({Value(3)});
+    ASSERT_EQ(matches.size(), 100U);
+    for (size_t i = 0; i < matches.size(); ++i) {
+        ASSERT_DOCUMENT_EQ(matches[i],
+                           (Document{{"_id", static_cast<int>(i * 10 + 3)},
+                                     {"a", 3},
+                                     {"pad", std::string(100, 'x')}}));
+    }
+}
+
+class LookupHashTableMemLimitTest : public unittest::Test {
+protected:
+    void setUp() override {
+        _savedSwitch = internalQueryStageMemUsageSwitch.load();
+        _savedMin = internalQueryStageMemUsageMIN.load();
+        _savedOpMax = internalQueryStageMemUsageOpMAX.load();
+        _savedChunk = internalQueryStageMemReserveChunkBytes.load();
+
+        internalQueryStageMemUsageSwitch.store(true);
+        internalQueryStageMemUsageMIN.store(0);
+        internalQueryStageMemUsageOpMAX.store(0);
+        internalQueryStageMemReserveChunkBytes.store(1);
+    }
+
+    void tearDown() override {
+        internalQueryStageMemUsageSwitch.store(_savedSwitch);
+        internalQueryStageMemUsageMIN.store(_savedMin);
+        internalQueryStageMemUsageOpMAX.store(_savedOpMax);
+        internalQueryStageMemReserveChunkBytes.store(_savedChunk);
+    }
+
+    std::shared_ptr<OperationStageMemCounter> _op = std::make_shared<OperationStageMemCounter>(
+        globalStageMemCounters.getTenantCounter("lookup_hash_table_test"));
+
+private:
+    bool _savedSwitch;
+    long long _savedMin;
+    long long _savedOpMax;
+    long long _savedChunk;
+};
+
+TEST_F(LookupHashTableMemLimitTest, ReservesAgainstTheOperationUntilDestroyed) {
+    {
+        LookupHashTable table(defaultComparator, "a", 1024 * 1024, "", _op);
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_TRUE(table.add(Document{{"_id", i}, {"a", i}}));
+        }
+        ASSERT_EQ(_op->getReservedMemSize(), static_cast<int64_t>(table.memoryUsageBytes()));
+        ASSERT_EQ(_op->getTenant()->getReservedMemSize(), _op->getReservedMemSize());
+
+        // Moving to another operation moves the reservation with it.
+        auto other = std::make_shared<OperationStageMemCounter>(_op->getTenant());
+        table.setOperationMemCounter(other);
+        ASSERT_EQ(0, _op->getReservedMemSize());
+        ASSERT_EQ(other->getReservedMemSize(), static_cast<int64_t>(table.memoryUsageBytes()));
+        table.setOperationMemCounter(_op);
+    }
+    ASSERT_EQ(0, _op->getReservedMemSize());
+    ASSERT_EQ(0, _op->getTenant()->getReservedMemSize());
+}
+
+TEST_F(LookupHashTableMemLimitTest, GivesUpOverTheOperationLimitEvenIfItMaySpill) {
+    internalQueryStageMemUsageOpMAX.store(4 * 1024);
+    unittest::TempDir tempDir("lookup_hash_table_test");
+    LookupHashTable table(defaultComparator, "a", 1024 * 1024, tempDir.path(), _op);
+    bool fits = true;
+    for (int i = 0; fits && i < 100; ++i) {
+        fits = table.add(Document{{"_id", i}, {"a", i}, {"pad", std::string(100, 'x')}});
+    }
+    ASSERT_FALSE(fits);
+    ASSERT_EQ(0U, table.numSpilledPartitions());
+}
+
+}  // namespace
+}  // namespace mongo
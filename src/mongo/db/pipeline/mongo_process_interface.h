@@ -48,6 +48,7 @@
 namespace mongo {
 
 class ExpressionContext;
+class OperationStageMemCounter;
 class Pipeline;
 class PipelineDeleter;
 
@@ -72,6 +73,11 @@ public:
         bool attachCursorSource = true;
     };
 
+    struct CollectionSizeEstimate {
+        long long numRecords = 0;
+        long long dataSizeBytes = 0;
+    };
+
     virtual ~MongoProcessInterface(){};
 
     /**
@@ -127,6 +133,21 @@ public:
                                      const NamespaceString& nss,
                                      BSONObjBuilder* builder) const = 0;
 
+    /**
+     * Returns the record count and data size the storage engine keeps for collection "nss", or
+     * boost::none if it does not exist. The values are cheap to get but may be approximate.
+     */
+    virtual boost::optional<CollectionSizeEstimate> getCollectionSizeEstimate(
+        OperationContext* opCtx, const NamespaceString& nss) const = 0;
+
+    /**
+     * Returns the per-operation stage memory counter of "opCtx", which aggregation stages holding
+     * large amounts of memory reserve against like plan stages do, or null if this process does
+     * not govern stage memory per operation.
+     */
+    virtual std::shared_ptr<OperationStageMemCounter> getOperationStageMemCounter(
+        OperationContext* opCtx) const = 0;
+
     /**
      * Gets the collection options for the collection given by 'nss'.
      */
@@ -266,6 +266,28 @@ TEST(ParsedAddFieldsOptimize, ShouldOptimizeNestedExpressions) {
                        addition.serializeStageOptions(ExplainOptions::Verbosity::kExecAllPlans));
 }
 
+// Verify that computed fields evaluated through compiled bytecode after optimize() produce the
+// same documents as the expression tree.
+TEST(ParsedAddFieldsOptimize, OptimizedComputedFieldsMatchUnoptimized) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const BSONObj spec = fromjson(
+        "{total: {$multiply: ['$price', {$ifNull: ['$qty', 1]}]},"
+        " 'tier.name': {$cond: [{$gte: ['$price', 10]}, 'high', 'low']},"
+        " flag: {$and: ['$price', {$not: ['$hidden']}]}}");
+    ParsedAddFields unoptimized(expCtx);
+    unoptimized.parse(spec);
+    ParsedAddFields optimized(expCtx);
+    optimized.parse(spec);
+    optimized.optimize();
+
+    for (auto&& doc : {Document{{"price", 12}, {"qty", 3}},
+                       Document{{"price", 2.5}, {"hidden", true}},
+                       Document{{"price", 1LL << 40}, {"qty", 1LL << 40}},
+                       Document{{"qty", 2}, {"tier", Document{{"id", 1}}}}}) {
+        ASSERT_DOCUMENT_EQ(optimized.applyProjection(doc), unoptimized.applyProjection(doc));
+    }
+}
+
 //
 // Top-level only.
 //
@@ -49,6 +49,7 @@
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_iterator.h"
 #include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/index/index_access_method.h"
@@ -58,6 +59,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
 #include "mongo/db/pipeline/document_source_sample.h"
@@ -68,6 +70,7 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/sharding_state.h"
@@ -218,6 +221,33 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     return getExecutorFind(opCtx, collection, nss, std::move(cq.getValue()), plannerOpts);
 }
 
+/**
+ * Builds partial groups for one range of a parallel collection scan, on the range's thread.
+ */
+class PartialGroupReducer final : public ParallelScanRangeReducer {
+public:
+    PartialGroupReducer(intrusive_ptr<DocumentSourceGroup> group, boost::optional<ParsedDeps> deps)
+        : _group(std::move(group)), _deps(std::move(deps)) {}
+
+    bool add(const BSONObj& obj) final {
+        return _group->addToPartialGroups(_deps ? _deps->extractFields(obj) : Document(obj));
+    }
+
+    void flush(std::vector<BSONObj>* out) final {
+        for (auto&& partialGroup : _group->releasePartialGroups()) {
+            out->push_back(partialGroup.toBson());
+        }
+    }
+
+    size_t getMemoryUsageBytes() const final {
+        return _group->getMemoryUsageBytes();
+    }
+
+private:
+    const intrusive_ptr<DocumentSourceGroup> _group;
+    const boost::optional<ParsedDeps> _deps;
+};
+
 BSONObj removeSortKeyMetaProjection(BSONObj projectionObj) {
     if (!projectionObj[Document::metaFieldSortKey]) {
         return projectionObj;
@@ -322,6 +352,15 @@ void PipelineD::prepareCursorSource(Collection* collection,
                                                 &sortObj,
                                                 &projForQuery));
 
+    if (projForQuery.isEmpty()) {
+        // A $group straight over a collection scan may build partial groups on several threads.
+        const DocumentSource* firstSource = sources.empty() ? nullptr : sources.front().get();
+        exec = parallelizeGroup(collection, pipeline, std::move(exec));
+        if (!sources.empty() && sources.front().get() != firstSource) {
+            // The merging $group reads whole partial groups.
+            deps = pipeline->getDependencies(DepsTracker::MetadataAvailable::kNoMetadata);
+        }
+    }
 
     if (!projForQuery.isEmpty() && !sources.empty()) {
         // Check for redundant $project in query with the same specification as the inclusion
@@ -337,6 +376,60 @@ void PipelineD::prepareCursorSource(Collection* collection,
         collection, pipeline, expCtx, std::move(exec), deps, queryObj, sortObj, projForQuery);
 }
 
+unique_ptr<PlanExecutor, PlanExecutor::Deleter> PipelineD::parallelizeGroup(
+    Collection* collection,
+    Pipeline* pipeline,
+    unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec) {
+    auto expCtx = pipeline->getContext();
+    Pipeline::SourceContainer& sources = pipeline->_sources;
+
+    const size_t numRanges = internalDocumentSourceGroupParallelism.load();
+    intrusive_ptr<DocumentSourceGroup> group =
+        sources.empty() ? nullptr : dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+    if (!group || numRanges < 2 || !collection ||
+        expCtx->tailableMode != TailableModeEnum::kNormal) {
+        return exec;
+    }
+
+    // Only a collection scan that feeds the pipeline directly, with no fetch, projection or
+    // shard filter above it, is replaced.
+    const StageType rootType = exec->getRootStage()->stageType();
+    const CanonicalQuery* baseQuery = exec->getCanonicalQuery();
+    if ((STAGE_COLLSCAN != rootType && STAGE_PARALLEL_COLLSCAN != rootType) || !baseQuery ||
+        !ParallelCollectionScan::canScanInParallel(
+            expCtx->opCtx, collection, baseQuery->root(), numRanges)) {
+        return exec;
+    }
+
+    auto cq = uassertStatusOK(
+        CanonicalQuery::canonicalize(expCtx->opCtx, *baseQuery, baseQuery->root()));
+
+    DepsTracker deps;
+    group->getDependencies(&deps);
+    const boost::optional<ParsedDeps> parsedDeps = deps.toParsedDeps();
+    const size_t maxMemoryUsageBytes = DocumentSourceGroup::kDefaultMaxMemoryUsageBytes / numRanges;
+
+    auto ws = stdx::make_unique<WorkingSet>();
+    auto scan = stdx::make_unique<ParallelCollectionScan>(
+        expCtx->opCtx, collection, numRanges, /*ordered=*/false, ws.get(), cq->root());
+    scan->setRangeReducer([group, parsedDeps, maxMemoryUsageBytes] {
+        return stdx::make_unique<PartialGroupReducer>(group->clonePartial(maxMemoryUsageBytes),
+                                                      parsedDeps);
+    });
+    auto parallelExec = uassertStatusOK(PlanExecutor::make(expCtx->opCtx,
+                                                           std::move(ws),
+                                                           std::move(scan),
+                                                           std::move(cq),
+                                                           collection,
+                                                           PlanExecutor::YIELD_AUTO));
+
+    // The partial groups are merged the way mongos merges those of the shards.
+    auto mergeSources = group->getMergeSources();
+    sources.pop_front();
+    sources.insert(sources.begin(), mergeSources.begin(), mergeSources.end());
+    return parallelExec;
+}
+
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prepareExecutor(
     OperationContext* opCtx,
     Collection* collection,
@@ -534,10 +627,30 @@ void PipelineD::addCursorSource(Collection* collection,
         }
 
         pSource->setProjection(deps.toProjection(), deps.toParsedDeps());
+
+        if (auto fieldNames = getColumnBatchFields(expCtx, deps)) {
+            pSource->setColumnBatchFields(std::move(*fieldNames));
+        }
     }
     pipeline->addInitialSource(pSource);
 }
 
+boost::optional<std::vector<std::string>> PipelineD::getColumnBatchFields(
+    const intrusive_ptr<ExpressionContext>& expCtx, const DepsTracker& deps) {
+    if (internalDocumentSourceColumnBatchSize.load() <= 0 || deps.needWholeDocument ||
+        deps.getNeedTextScore() || deps.getNeedSortKey() ||
+        expCtx->tailableMode != TailableModeEnum::kNormal) {
+        return boost::none;
+    }
+
+    // A column holds a whole top-level field, which covers any dotted paths within it.
+    std::set<std::string> topLevelFields;
+    for (auto&& field : deps.fields) {
+        topLevelFields.insert(FieldPath(field).getFieldName(0).toString());
+    }
+    return std::vector<std::string>(topLevelFields.begin(), topLevelFields.end());
+}
+
 Timestamp PipelineD::getLatestOplogTimestamp(const Pipeline* pipeline) {
     if (auto docSourceCursor =
             dynamic_cast<DocumentSourceCursor*>(pipeline->_sources.front().get())) {
@@ -634,6 +747,27 @@ Status PipelineD::MongoDInterface::appendRecordCount(OperationContext* opCtx,
     return appendCollectionRecordCount(opCtx, nss, builder);
 }
 
+boost::optional<MongoProcessInterface::CollectionSizeEstimate>
+PipelineD::MongoDInterface::getCollectionSizeEstimate(OperationContext* opCtx,
+                                                      const NamespaceString& nss) const {
+    AutoGetCollectionForReadCommand autoColl(opCtx, nss);
+
+    Collection* collection = autoColl.getCollection();
+    if (!collection) {
+        return boost::none;
+    }
+
+    CollectionSizeEstimate estimate;
+    estimate.numRecords = collection->numRecords(opCtx);
+    estimate.dataSizeBytes = collection->dataSize(opCtx);
+    return estimate;
+}
+
+std::shared_ptr<OperationStageMemCounter> PipelineD::MongoDInterface::getOperationStageMemCounter(
+    OperationContext* opCtx) const {
+    return PlanStage::getOperationMemCounter(opCtx);
+}
+
 BSONObj PipelineD::MongoDInterface::getCollectionOptions(const NamespaceString& nss) {
     const auto infos = _client.getCollectionInfos(nss.db().toString(), BSON("name" << nss.coll()));
     return infos.empty() ? BSONObj() : infos.front().getObjectField("options").getOwned();
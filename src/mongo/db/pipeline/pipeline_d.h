@@ -84,6 +84,10 @@ public:
         Status appendRecordCount(OperationContext* opCtx,
                                  const NamespaceString& nss,
                                  BSONObjBuilder* builder) const final;
+        boost::optional<CollectionSizeEstimate> getCollectionSizeEstimate(
+            OperationContext* opCtx, const NamespaceString& nss) const final;
+        std::shared_ptr<OperationStageMemCounter> getOperationStageMemCounter(
+            OperationContext* opCtx) const final;
         BSONObj getCollectionOptions(const NamespaceString& nss) final;
         Status renameIfOptionsAndIndexesHaveNotChanged(
             OperationContext* opCtx,
@@ -190,6 +194,25 @@ private:
         BSONObj* sortObj,
         BSONObj* projectionObj);
 
+    /**
+     * If the pipeline starts with a $group, 'exec' is a plain collection scan, and
+     * internalDocumentSourceGroupParallelism asks for more than one range, returns an executor
+     * that builds partial groups on the threads of a parallel collection scan, and replaces the
+     * $group with the stage that merges them. Otherwise returns 'exec'.
+     */
+    static std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> parallelizeGroup(
+        Collection* collection,
+        Pipeline* pipeline,
+        std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec);
+
+    /**
+     * Returns the fields the cursor source should read into column batches, one per top-level field
+     * in 'deps', or boost::none if internalDocumentSourceColumnBatchSize is 0 or the pipeline needs
+     * whole documents or metadata.
+     */
+    static boost::optional<std::vector<std::string>> getColumnBatchFields(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx, const DepsTracker& deps);
+
     /**
      * Creates a DocumentSourceCursor from the given PlanExecutor and adds it to the front of the
      * Pipeline.
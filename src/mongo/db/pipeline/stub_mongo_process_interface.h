@@ -88,6 +88,16 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    boost::optional<CollectionSizeEstimate> getCollectionSizeEstimate(
+        OperationContext* opCtx, const NamespaceString& nss) const override {
+        return boost::none;
+    }
+
+    std::shared_ptr<OperationStageMemCounter> getOperationStageMemCounter(
+        OperationContext* opCtx) const override {
+        return nullptr;
+    }
+
     BSONObj getCollectionOptions(const NamespaceString& nss) override {
         MONGO_UNREACHABLE;
     }
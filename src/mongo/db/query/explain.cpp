@@ -172,6 +172,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -339,6 +343,8 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendNumber("spilledMembers", spec->spilledMembers);
+            bob->appendNumber("spilledBytes", spec->spilledBytes);
 
             bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
             bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
@@ -365,6 +371,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        bob->append("ordered", spec->ordered);
+        if (spec->reduced) {
+            bob->append("reduced", true);
+        }
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("ranges", spec->ranges);
+            bob->appendNumber("docsExamined", spec->docsTested);
+            if (spec->reduced) {
+                bob->appendNumber("reducedResults", spec->reducedResults);
+            }
+        }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
@@ -538,6 +558,8 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendNumber("spills", spec->spills);
+            bob->appendNumber("spilledBytes", spec->spilledBytes);
         }
 
         if (spec->limit > 0) {
@@ -791,10 +813,34 @@ void Explain::generateExecutionInfo(PlanExecutor* exec,
 
         BSONArrayBuilder allPlansBob(execBob.subarrayStart("allPlansExecution"));
 
+        // If the trial periods ran in parallel, each plan also reports how long its own trial
+        // took. The winner comes first, then the rejected plans in candidate order.
+        std::vector<long long> trialWallTimes;
+        if (const auto mps = getMultiPlanStage(exec->getRootStage())) {
+            const auto mpsStats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+            const size_t bestIdx = static_cast<size_t>(mps->bestPlanIdx());
+            if (bestIdx < mpsStats->trialWallTimeMicros.size()) {
+                trialWallTimes.push_back(mpsStats->trialWallTimeMicros[bestIdx]);
+                for (size_t i = 0; i < mpsStats->trialWallTimeMicros.size(); ++i) {
+                    if (i != bestIdx) {
+                        trialWallTimes.push_back(mpsStats->trialWallTimeMicros[i]);
+                    }
+                }
+            }
+        }
+        size_t planIdx = 0;
+        const auto appendTrialWallTime = [&](BSONObjBuilder* planBob) {
+            if (planIdx < trialWallTimes.size()) {
+                planBob->appendNumber("trialWallTimeMicros", trialWallTimes[planIdx]);
+            }
+            ++planIdx;
+        };
+
         if (winningPlanTrialStats) {
             BSONObjBuilder planBob(allPlansBob.subobjStart());
             generateSinglePlanExecutionInfo(
                 winningPlanTrialStats, verbosity, boost::none, &planBob);
+            appendTrialWallTime(&planBob);
             planBob.doneFast();
         }
 
@@ -803,6 +849,7 @@ void Explain::generateExecutionInfo(PlanExecutor* exec,
             BSONObjBuilder planBob(allPlansBob.subobjStart());
             generateSinglePlanExecutionInfo(
                 rejectedStats[i].get(), verbosity, boost::none, &planBob);
+            appendTrialWallTime(&planBob);
             planBob.doneFast();
         }
 
@@ -143,6 +143,8 @@ void fillOutPlannerParams(OperationContext* opCtx,
                                                     ice->getFilterExpression(),
                                                     desc->infoObj(),
                                                     ice->getCollator()));
+        plannerParams->indices.back().cardinalityStats =
+            collection->infoCache()->getIndexCardinalityStats()->get(opCtx, collection, desc);
     }
 
     // If query supports index filters, filter params.indices by indices in query settings.
@@ -688,6 +690,11 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> _getExecutorFind(
     if (ShardingState::get(opCtx)->needCollectionMetadata(opCtx, nss.ns())) {
         plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
+
+    // Finds and aggregations only read, so their collection scans may run on other threads.
+    if (internalQueryParallelCollectionScanThreads.load() > 1) {
+        plannerOptions |= QueryPlannerParams::PARALLEL_COLLSCAN;
+    }
     return getExecutor(opCtx, collection, std::move(canonicalQuery), yieldPolicy, plannerOptions);
 }
 
@@ -1567,6 +1574,8 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
                                                        ice->getFilterExpression(),
                                                        desc->infoObj(),
                                                        ice->getCollator()));
+            plannerParams.indices.back().cardinalityStats =
+                collection->infoCache()->getIndexCardinalityStats()->get(opCtx, collection, desc);
         }
     }
 
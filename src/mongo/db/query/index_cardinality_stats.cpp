@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_cardinality_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/interval.h"
+
+namespace mongo {
+
+namespace {
+
+// Index key order. Sampled keys of collated indexes already hold comparison keys, as do the
+// bounds they are compared with, so no collator is involved.
+bool keyValueLess(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.woCompare(rhs, false) < 0;
+}
+
+}  // namespace
+
+IndexCardinalityStats::IndexCardinalityStats(std::vector<BSONObj> sample,
+                                             long long numDocsSampled,
+                                             long long numRecords)
+    : _sample(std::move(sample)) {
+    _values.reserve(_sample.size());
+    for (auto&& key : _sample) {
+        _values.push_back(key.firstElement());
+    }
+    std::sort(_values.begin(), _values.end(), keyValueLess);
+
+    if (numDocsSampled <= 0 || _values.empty()) {
+        return;
+    }
+    _totalKeys = static_cast<double>(numRecords) * _values.size() / numDocsSampled;
+
+    // Guaranteed-error estimator: values seen once in the sample stand for sqrt(N/n) values each,
+    // values seen more than once are assumed to be all there is of them.
+    double distinct = 0;
+    double singletons = 0;
+    for (size_t i = 0; i < _values.size();) {
+        size_t next = i + 1;
+        while (next < _values.size() && _values[i].woCompare(_values[next], false) == 0) {
+            ++next;
+        }
+        ++distinct;
+        if (next - i == 1) {
+            ++singletons;
+        }
+        i = next;
+    }
+    const double scale = std::sqrt(std::max(1.0, _totalKeys / _values.size()));
+    _distinctValues =
+        std::max(distinct, std::min(_totalKeys, scale * singletons + distinct - singletons));
+}
+
+double IndexCardinalityStats::estimateKeys(const IndexBounds& bounds) const {
+    if (bounds.isSimpleRange) {
+        BSONElement low = bounds.startKey.firstElement();
+        BSONElement high = bounds.endKey.firstElement();
+        if (low.eoo() || high.eoo()) {
+            return _totalKeys;
+        }
+        if (low.woCompare(high, false) > 0) {
+            std::swap(low, high);
+        }
+        // Inclusion of the endpoints depends on later fields, so count them in.
+        return estimateRange(low, true, high, true, false);
+    }
+
+    if (bounds.fields.empty()) {
+        return _totalKeys;
+    }
+
+    double keys = 0;
+    for (auto&& interval : bounds.fields[0].intervals) {
+        keys += estimateKeys(interval);
+    }
+    return std::min(keys, _totalKeys);
+}
+
+double IndexCardinalityStats::estimateKeys(const Interval& interval) const {
+    if (interval.start.woCompare(interval.end, false) > 0) {
+        return estimateRange(
+            interval.end, interval.endInclusive, interval.start, interval.startInclusive, false);
+    }
+    return estimateRange(interval.start,
+                         interval.startInclusive,
+                         interval.end,
+                         interval.endInclusive,
+                         interval.isPoint());
+}
+
+double IndexCardinalityStats::estimateKeysPerValue() const {
+    return _distinctValues > 0 ? _totalKeys / _distinctValues : 0;
+}
+
+double IndexCardinalityStats::estimateRange(BSONElement low,
+                                            bool lowInclusive,
+                                            BSONElement high,
+                                            bool highInclusive,
+                                            bool isPoint) const {
+    if (_values.empty()) {
+        return 0;
+    }
+
+    auto begin = lowInclusive
+        ? std::lower_bound(_values.begin(), _values.end(), low, keyValueLess)
+        : std::upper_bound(_values.begin(), _values.end(), low, keyValueLess);
+    auto end = highInclusive
+        ? std::upper_bound(_values.begin(), _values.end(), high, keyValueLess)
+        : std::lower_bound(_values.begin(), _values.end(), high, keyValueLess);
+
+    double sampledKeys = end > begin ? end - begin : 0;
+    if (sampledKeys == 0) {
+        // The range fell between sampled keys. A point is given an average value's share, capped
+        // below one sampled key since it was not seen, and a range half a sampled key.
+        sampledKeys = isPoint ? std::min(1.0, _values.size() / _distinctValues) : 0.5;
+    }
+    return sampledKeys * _totalKeys / _values.size();
+}
+
+}  // namespace mongo
@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+class IndexBounds;
+struct Interval;
+
+/**
+ * Sampled statistics on the leading field of an index, used for cardinality estimates.
+ *
+ * The sample is the leading field of the index keys generated for randomly chosen documents,
+ * kept sorted in index key order. An estimate is the fraction of sampled keys that fall in a
+ * range, scaled up to the index's estimated number of keys, so ranges narrower than the sample's
+ * resolution come out as a fraction of one sampled key.
+ *
+ * Instances are immutable and shared between planning threads.
+ */
+class IndexCardinalityStats {
+public:
+    /**
+     * 'sample' holds one single-element object per sampled index key, in any order.
+     * 'numDocsSampled' documents produced those keys, out of 'numRecords' in the collection.
+     */
+    IndexCardinalityStats(std::vector<BSONObj> sample,
+                          long long numDocsSampled,
+                          long long numRecords);
+
+    /**
+     * Estimated number of index keys whose leading field falls inside 'bounds'. Fields after the
+     * first are not looked at, so this is an upper bound for compound bounds.
+     */
+    double estimateKeys(const IndexBounds& bounds) const;
+
+    /**
+     * Estimated number of index keys whose leading field falls inside 'interval'. The interval may
+     * be in either direction.
+     */
+    double estimateKeys(const Interval& interval) const;
+
+    /**
+     * Estimated number of distinct values of the leading field.
+     */
+    double estimateDistinctValues() const {
+        return _distinctValues;
+    }
+
+    /**
+     * Estimated average number of index keys per distinct value of the leading field.
+     */
+    double estimateKeysPerValue() const;
+
+    double estimateTotalKeys() const {
+        return _totalKeys;
+    }
+
+    size_t sampleSize() const {
+        return _sample.size();
+    }
+
+private:
+    double estimateRange(BSONElement low,
+                         bool lowInclusive,
+                         BSONElement high,
+                         bool highInclusive,
+                         bool isPoint) const;
+
+    // Owns the sampled keys. '_values' points into these and is sorted.
+    std::vector<BSONObj> _sample;
+    std::vector<BSONElement> _values;
+
+    double _totalKeys = 0;
+    double _distinctValues = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_cardinality_stats_cache.h"
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/clock_source.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+std::shared_ptr<const IndexCardinalityStats> sampleIndex(OperationContext* opCtx,
+                                                         const Collection* collection,
+                                                         const IndexDescriptor* desc,
+                                                         int sampleSize) {
+    // Keys of partial indexes would have to be filtered, and other index types have keys that
+    // don't correspond to the leading field's values.
+    if (desc->isPartial() ||
+        IndexNames::BTREE != IndexNames::findPluginName(desc->keyPattern())) {
+        return nullptr;
+    }
+
+    auto cursor = collection->getRecordStore()->getRandomCursor(opCtx);
+    if (!cursor) {
+        return nullptr;
+    }
+    const IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex(desc);
+
+    std::vector<BSONObj> sample;
+    long long numDocsSampled = 0;
+    try {
+        for (; numDocsSampled < sampleSize; ++numDocsSampled) {
+            auto record = cursor->next();
+            if (!record) {
+                break;
+            }
+
+            BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+            iam->getKeys(record->data.releaseToBson(),
+                         IndexAccessMethod::GetKeysMode::kRelaxConstraints,
+                         &keys,
+                         nullptr);
+            for (auto&& key : keys) {
+                BSONObjBuilder leading;
+                leading.appendAs(key.firstElement(), "");
+                sample.push_back(leading.obj());
+            }
+        }
+    } catch (const WriteConflictException&) {
+        // Go without statistics for this index until they are next due for a rebuild.
+        return nullptr;
+    }
+
+    LOG(1) << "Sampled " << numDocsSampled << " documents of " << collection->ns()
+           << " for cardinality statistics of index " << desc->indexName();
+    return std::make_shared<IndexCardinalityStats>(
+        std::move(sample), numDocsSampled, collection->numRecords(opCtx));
+}
+
+}  // namespace
+
+std::shared_ptr<const IndexCardinalityStats> IndexCardinalityStatsCache::get(
+    OperationContext* opCtx, const Collection* collection, const IndexDescriptor* desc) {
+    const int sampleSize = internalQueryIndexStatsSampleSize.load();
+    if (sampleSize <= 0) {
+        return nullptr;
+    }
+
+    const Date_t now = opCtx->getServiceContext()->getFastClockSource()->now();
+    const Seconds maxAge(internalQueryIndexStatsRefreshSecs.load());
+    uint64_t generation;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _entries.find(desc->indexName());
+        if (it != _entries.end() && (it->second.sampling || now - it->second.builtAt < maxAge)) {
+            // Fresh, or another planner is sampling and we make do with what there is.
+            return it->second.stats;
+        }
+        _entries[desc->indexName()].sampling = true;
+        generation = _generation;
+    }
+
+    // Sample without the mutex held, so that planners of other indexes are not held up.
+    std::shared_ptr<const IndexCardinalityStats> stats;
+    try {
+        stats = sampleIndex(opCtx, collection, desc, sampleSize);
+    } catch (...) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (generation == _generation) {
+            _entries[desc->indexName()].sampling = false;
+        }
+        throw;
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (generation == _generation) {
+        _entries[desc->indexName()] = {stats, now};
+    }
+    return stats;
+}
+
+void IndexCardinalityStatsCache::clear() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _entries.clear();
+    ++_generation;
+}
+
+}  // namespace mongo
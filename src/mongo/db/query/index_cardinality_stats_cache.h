@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/db/query/index_cardinality_stats.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class Collection;
+class IndexDescriptor;
+class OperationContext;
+
+/**
+ * Holds the IndexCardinalityStats of one collection's indexes, keyed by index name. Statistics are
+ * built from a random sample of documents the first time an index is asked for, and rebuilt once
+ * they are older than internalQueryIndexStatsRefreshSecs. Only one thread samples an index at a
+ * time; others asking meanwhile get the previous statistics, or none. Owned by the
+ * CollectionInfoCache, which clears it whenever the set of indexes changes.
+ */
+class IndexCardinalityStatsCache {
+public:
+    /**
+     * Returns the statistics for 'desc', sampling 'collection' if needed. Returns null if
+     * statistics are turned off (internalQueryIndexStatsSampleSize is 0), the index is not a plain
+     * btree index, or the storage engine cannot pick documents at random.
+     *
+     * The caller must hold at least an intent shared lock on the collection.
+     */
+    std::shared_ptr<const IndexCardinalityStats> get(OperationContext* opCtx,
+                                                     const Collection* collection,
+                                                     const IndexDescriptor* desc);
+
+    void clear();
+
+private:
+    struct Entry {
+        std::shared_ptr<const IndexCardinalityStats> stats;
+        Date_t builtAt;
+        bool sampling = false;
+    };
+
+    stdx::mutex _mutex;
+    StringMap<Entry> _entries;
+
+    // Bumped by clear(), so that a sample taken across it is dropped.
+    uint64_t _generation = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,135 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_cardinality_stats.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/interval.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+// 1000 documents sampled out of 100000, one key each, holding 0..99 ten times each.
+IndexCardinalityStats makeUniformStats() {
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < 1000; ++i) {
+        sample.push_back(BSON("" << (i * 37) % 100));
+    }
+    return IndexCardinalityStats(std::move(sample), 1000, 100000);
+}
+
+Interval makeInterval(BSONObj bounds, bool startInclusive, bool endInclusive) {
+    return Interval(bounds, startInclusive, endInclusive);
+}
+
+TEST(IndexCardinalityStatsTest, TotalKeysScaleWithKeysPerDocument) {
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < 30; ++i) {
+        sample.push_back(BSON("" << i));
+    }
+    // An array field: 10 documents produced the 30 keys.
+    IndexCardinalityStats stats(std::move(sample), 10, 1000);
+    ASSERT_EQ(3000, stats.estimateTotalKeys());
+}
+
+TEST(IndexCardinalityStatsTest, RangeEstimateIsSampledFraction) {
+    auto stats = makeUniformStats();
+    // [0, 10) holds 100 of the 1000 sampled keys.
+    ASSERT_EQ(10000, stats.estimateKeys(makeInterval(BSON("" << 0 << "" << 10), true, false)));
+    // (0, 10] as well.
+    ASSERT_EQ(10000, stats.estimateKeys(makeInterval(BSON("" << 0 << "" << 10), false, true)));
+    // [0, 10] one more value.
+    ASSERT_EQ(11000, stats.estimateKeys(makeInterval(BSON("" << 0 << "" << 10), true, true)));
+}
+
+TEST(IndexCardinalityStatsTest, DescendingIntervalMatchesAscending) {
+    auto stats = makeUniformStats();
+    ASSERT_EQ(stats.estimateKeys(makeInterval(BSON("" << 20 << "" << 40), true, false)),
+              stats.estimateKeys(makeInterval(BSON("" << 40 << "" << 20), false, true)));
+}
+
+TEST(IndexCardinalityStatsTest, PointEstimates) {
+    auto stats = makeUniformStats();
+    ASSERT_EQ(1000, stats.estimateKeys(makeInterval(BSON("" << 5 << "" << 5), true, true)));
+    // Not in the sample: less than one sampled key's worth.
+    double unseen = stats.estimateKeys(makeInterval(BSON("" << 500 << "" << 500), true, true));
+    ASSERT_GT(unseen, 0);
+    ASSERT_LTE(unseen, 100);
+}
+
+TEST(IndexCardinalityStatsTest, DistinctValuesOfRepeatedSample) {
+    auto stats = makeUniformStats();
+    // Every value was seen ten times, so the sample is taken to have all of them.
+    ASSERT_EQ(100, stats.estimateDistinctValues());
+    ASSERT_EQ(1000, stats.estimateKeysPerValue());
+}
+
+TEST(IndexCardinalityStatsTest, DistinctValuesOfUniqueSample) {
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < 100; ++i) {
+        sample.push_back(BSON("" << i));
+    }
+    IndexCardinalityStats stats(std::move(sample), 100, 10000);
+    // Each value seen once stands for sqrt(10000 / 100) of them.
+    ASSERT_EQ(1000, stats.estimateDistinctValues());
+    ASSERT_EQ(10, stats.estimateKeysPerValue());
+}
+
+TEST(IndexCardinalityStatsTest, IndexBoundsUseLeadingField) {
+    auto stats = makeUniformStats();
+
+    IndexBounds bounds;
+    OrderedIntervalList leading("a");
+    leading.intervals.push_back(makeInterval(BSON("" << 0 << "" << 10), true, false));
+    leading.intervals.push_back(makeInterval(BSON("" << 50 << "" << 50), true, true));
+    OrderedIntervalList trailing("b");
+    trailing.intervals.push_back(makeInterval(BSON("" << 0 << "" << 0), true, true));
+    bounds.fields.push_back(leading);
+    bounds.fields.push_back(trailing);
+    ASSERT_EQ(11000, stats.estimateKeys(bounds));
+
+    IndexBounds simpleRange;
+    simpleRange.isSimpleRange = true;
+    simpleRange.startKey = BSON("" << 90 << "" << MINKEY);
+    simpleRange.endKey = BSON("" << MAXKEY << "" << MAXKEY);
+    ASSERT_EQ(10000, stats.estimateKeys(simpleRange));
+}
+
+TEST(IndexCardinalityStatsTest, EmptySample) {
+    IndexCardinalityStats stats({}, 0, 0);
+    ASSERT_EQ(0, stats.estimateTotalKeys());
+    ASSERT_EQ(0, stats.estimateKeys(makeInterval(BSON("" << 0 << "" << 10), true, true)));
+    ASSERT_EQ(0, stats.estimateKeysPerValue());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "mongo/db/index/multikey_paths.h"
@@ -38,6 +39,7 @@
 namespace mongo {
 
 class CollatorInterface;
+class IndexCardinalityStats;
 class MatchExpression;
 
 /**
@@ -138,6 +140,9 @@ struct IndexEntry {
     // Null if this index orders strings according to the simple binary compare. If non-null,
     // represents the collator used to generate index keys for indexed strings.
     const CollatorInterface* collator = nullptr;
+
+    // Sampled statistics on the index's leading field, if any have been collected.
+    std::shared_ptr<const IndexCardinalityStats> cardinalityStats;
 };
 
 }  // namespace mongo
@@ -87,9 +87,10 @@ public:
      * kv-store is full prior to the add() operation.
      *
      * If an entry is evicted, it will be returned in
-     * an unique_ptr for the caller to use before disposing.
+     * an unique_ptr for the caller to use before disposing,
+     * and its key is stored in 'evictedKeyOut' if provided.
      */
-    std::unique_ptr<V> add(const K& key, V* entry) {
+    std::unique_ptr<V> add(const K& key, V* entry, K* evictedKeyOut = nullptr) {
         // If the key already exists, delete it first.
         KVMapConstIt i = _kvMap.find(key);
         if (i != _kvMap.end()) {
@@ -109,6 +110,9 @@ public:
         if (_currentSize > _maxSize) {
             V* evictedEntry = _kvList.back().second;
             invariant(evictedEntry);
+            if (evictedKeyOut) {
+                *evictedKeyOut = _kvList.back().first;
+            }
 
             _kvMap.erase(_kvList.back().first);
             _kvList.pop_back();
@@ -112,10 +112,12 @@ TEST(LRUKeyValueTest, EvictionTest) {
     }
 
     // Adding another entry causes an eviction.
-    std::unique_ptr<int> evicted = cache.add(maxSize + 1, new int(maxSize + 1));
+    int evictedKey = -1;
+    std::unique_ptr<int> evicted = cache.add(maxSize + 1, new int(maxSize + 1), &evictedKey);
     ASSERT_EQUALS(cache.size(), (size_t)maxSize);
     ASSERT(NULL != evicted.get());
     ASSERT_EQUALS(*evicted, evictKey);
+    ASSERT_EQUALS(evictedKey, evictKey);
 
     // Check that the least recently accessed has been evicted.
     for (int i = 0; i < maxSize; ++i) {
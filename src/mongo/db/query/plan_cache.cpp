@@ -393,8 +393,12 @@ CachedSolution::~CachedSolution() {
 
 PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                PlanRankingDecision* why)
-    : plannerData(solutions.size()), decision(why) {
+    : plannerData(solutions.size()),
+      decision(why),
+      shapeStats(std::make_shared<PlanCacheShapeStats>()),
+      _numFeedbackSlots(std::max(0, internalQueryCacheFeedbacksStored.load())) {
     invariant(why);
+    _feedbackSlots.reset(new FeedbackSlot[_numFeedbackSlots]);
 
     // The caller of this constructor is responsible for ensuring
     // that the QuerySolution 's' has valid cacheData. If there's no
@@ -434,15 +438,44 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->timeOfCreation = timeOfCreation;
 
     // Copy performance stats.
-    for (size_t i = 0; i < feedback.size(); ++i) {
+    auto copyFeedback = [entry](const PlanCacheEntryFeedback& source) {
         PlanCacheEntryFeedback* fb = new PlanCacheEntryFeedback();
-        fb->stats.reset(feedback[i]->stats->clone());
-        fb->score = feedback[i]->score;
+        fb->stats.reset(source.stats->clone());
+        fb->score = source.score;
         entry->feedback.push_back(fb);
+    };
+    for (size_t i = 0; i < feedback.size(); ++i) {
+        copyFeedback(*feedback[i]);
+    }
+    const size_t claimed = std::min<size_t>(_feedbackClaimed.load(), _numFeedbackSlots);
+    for (size_t i = 0; i < claimed; ++i) {
+        if (_feedbackSlots[i].ready.load()) {
+            copyFeedback(*_feedbackSlots[i].feedback);
+        }
     }
+    entry->shapeStats = shapeStats;
     return entry;
 }
 
+void PlanCacheEntry::addFeedback(std::unique_ptr<PlanCacheEntryFeedback> fb) {
+    // Check before claiming, so that the claim counter stops growing once the slots are full.
+    if (_feedbackClaimed.load() >= _numFeedbackSlots) {
+        return;
+    }
+    const size_t slot = _feedbackClaimed.fetchAndAdd(1);
+    if (slot >= _numFeedbackSlots) {
+        return;
+    }
+    _feedbackSlots[slot].feedback = std::move(fb);
+    _feedbackSlots[slot].ready.store(true);
+}
+
+BSONObj PlanCacheShapeStats::toBSON() const {
+    return BSON("hits" << hits.load() << "misses" << misses.load() << "replans" << replans.load()
+                       << "evictions"
+                       << evictions.load());
+}
+
 std::string PlanCacheEntry::toString() const {
     return str::stream() << "(query: " << query.toString() << ";sort: " << sort.toString()
                          << ";projection: " << projection.toString()
@@ -554,9 +587,58 @@ std::string SolutionCacheData::toString() const {
 // PlanCache
 //
 
-PlanCache::PlanCache() : _cache(internalQueryCacheSize.load()) {}
+/**
+ * A slice of the plan cache holding the keys that hash to it. The mutex protects the LRU lists,
+ * not the entries themselves, which readers keep alive through their shared_ptr after unlocking.
+ */
+class PlanCache::Partition {
+public:
+    explicit Partition(size_t capacity) : entries(capacity), retiredShapes(capacity) {}
 
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+    stdx::mutex mutex;
+
+    LRUKeyValue<PlanCacheKey, std::shared_ptr<PlanCacheEntry>> entries;
+
+    // Statistics of shapes that have been removed or evicted, so that they carry on if the
+    // shape is cached again. Bounded like 'entries' and dropped least recently used first.
+    LRUKeyValue<PlanCacheKey, std::shared_ptr<PlanCacheShapeStats>> retiredShapes;
+
+    /**
+     * Remembers the statistics of 'entry', which is leaving the cache.
+     */
+    void retire(const PlanCacheKey& key, const PlanCacheEntry& entry) {
+        retiredShapes.add(key, new std::shared_ptr<PlanCacheShapeStats>(entry.shapeStats));
+    }
+
+    /**
+     * Returns the statistics kept for 'key', whether it is cached or retired, or nullptr.
+     */
+    PlanCacheShapeStats* findShapeStats(const PlanCacheKey& key) {
+        std::shared_ptr<PlanCacheEntry>* entry;
+        if (entries.get(key, &entry).isOK()) {
+            return (*entry)->shapeStats.get();
+        }
+        std::shared_ptr<PlanCacheShapeStats>* stats;
+        if (retiredShapes.get(key, &stats).isOK()) {
+            return stats->get();
+        }
+        return nullptr;
+    }
+};
+
+PlanCache::PlanCache() : PlanCache("") {}
+
+PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+    // Each partition gets an equal share of the cache, rounded up, so the cache as a whole may
+    // hold a few more entries than internalQueryCacheSize.
+    const size_t cacheSize = std::max(0, internalQueryCacheSize.load());
+    const size_t numPartitions = std::max<size_t>(
+        1, std::min<size_t>(std::max(1, internalQueryCachePartitions.load()), cacheSize));
+    const size_t partitionSize = (cacheSize + numPartitions - 1) / numPartitions;
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.push_back(stdx::make_unique<Partition>(partitionSize));
+    }
+}
 
 PlanCache::~PlanCache() {}
 
@@ -726,7 +808,7 @@ Status PlanCache::add(const CanonicalQuery& query,
                       "candidate ordering entries in decision must match solutions");
     }
 
-    PlanCacheEntry* entry = new PlanCacheEntry(solns, why);
+    auto entry = std::make_shared<PlanCacheEntry>(solns, why);
     const QueryRequest& qr = query.getQueryRequest();
     entry->query = qr.getFilter().getOwned();
     entry->sort = qr.getSort().getOwned();
@@ -747,14 +829,63 @@ Status PlanCache::add(const CanonicalQuery& query,
     }
     entry->projection = projBuilder.obj();
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+    const PlanCacheKey key = computeKey(query);
+    Partition& partition = partitionFor(key);
+
+    // Destroyed after the partition lock is released.
+    std::unique_ptr<std::shared_ptr<PlanCacheEntry>> evictedEntry;
+    {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+
+        // Carry on the statistics of the entry being replaced, or of the retired shape.
+        std::shared_ptr<PlanCacheEntry>* existing;
+        std::shared_ptr<PlanCacheShapeStats>* retired;
+        if (partition.entries.get(key, &existing).isOK()) {
+            entry->shapeStats = (*existing)->shapeStats;
+        } else if (partition.retiredShapes.get(key, &retired).isOK()) {
+            entry->shapeStats = *retired;
+            partition.retiredShapes.remove(key).transitional_ignore();
+        }
+
+        PlanCacheKey evictedKey;
+        evictedEntry = partition.entries.add(
+            key, new std::shared_ptr<PlanCacheEntry>(std::move(entry)), &evictedKey);
+        if (evictedEntry) {
+            (*evictedEntry)->shapeStats->evictions.fetchAndAdd(1);
+            partition.retire(evictedKey, **evictedEntry);
+        }
+    }
 
-    if (NULL != evictedEntry.get()) {
+    if (evictedEntry) {
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
-               << "removed least recently used entry " << redact(evictedEntry->toString());
+               << "removed least recently used entry " << redact((*evictedEntry)->toString());
+    }
+
+    return Status::OK();
+}
+
+PlanCache::Partition& PlanCache::partitionFor(const PlanCacheKey& key) const {
+    return *_partitions[std::hash<PlanCacheKey>()(key) % _partitions.size()];
+}
+
+Status PlanCache::lookup(const PlanCacheKey& key,
+                         bool countMiss,
+                         std::shared_ptr<PlanCacheEntry>* entryOut) const {
+    Partition& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+
+    std::shared_ptr<PlanCacheEntry>* entry;
+    Status cacheStatus = partition.entries.get(key, &entry);
+    if (!cacheStatus.isOK()) {
+        std::shared_ptr<PlanCacheShapeStats>* stats;
+        if (countMiss && partition.retiredShapes.get(key, &stats).isOK()) {
+            (*stats)->misses.fetchAndAdd(1);
+        }
+        return cacheStatus;
     }
+    invariant(*entry);
 
+    *entryOut = *entry;
     return Status::OK();
 }
 
@@ -762,13 +893,12 @@ Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const
     PlanCacheKey key = computeKey(query);
     verify(crOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    std::shared_ptr<PlanCacheEntry> entry;
+    Status cacheStatus = lookup(key, true, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
-    invariant(entry);
+    entry->shapeStats->hits.fetchAndAdd(1);
 
     *crOut = new CachedSolution(key, *entry);
 
@@ -782,30 +912,47 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    std::shared_ptr<PlanCacheEntry> entry;
+    Status cacheStatus = lookup(ck, false, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
-    invariant(entry);
 
     // We store up to a constant number of feedback entries.
-    if (entry->feedback.size() < static_cast<size_t>(internalQueryCacheFeedbacksStored.load())) {
-        entry->feedback.push_back(autoFeedback.release());
-    }
+    entry->addFeedback(std::move(autoFeedback));
 
     return Status::OK();
 }
 
+void PlanCache::recordReplan(const CanonicalQuery& cq) {
+    const PlanCacheKey key = computeKey(cq);
+    Partition& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+    if (PlanCacheShapeStats* stats = partition.findShapeStats(key)) {
+        stats->replans.fetchAndAdd(1);
+    }
+}
+
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const PlanCacheKey key = computeKey(canonicalQuery);
+    Partition& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+
+    std::shared_ptr<PlanCacheEntry>* entry;
+    Status cacheStatus = partition.entries.get(key, &entry);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
+    }
+    partition.retire(key, **entry);
+    return partition.entries.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        partition->entries.clear();
+        partition->retiredShapes.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -820,13 +967,11 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
     PlanCacheKey key = computeKey(query);
     verify(entryOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    std::shared_ptr<PlanCacheEntry> entry;
+    Status cacheStatus = lookup(key, false, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
-    invariant(entry);
 
     *entryOut = entry->clone();
 
@@ -834,11 +979,17 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
 }
 
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    // Hold each partition's lock only long enough to take references to its entries.
+    std::vector<std::shared_ptr<PlanCacheEntry>> cached;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        for (auto i = partition->entries.begin(); i != partition->entries.end(); i++) {
+            cached.push_back(*i->second);
+        }
+    }
+
     std::vector<PlanCacheEntry*> entries;
-    typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
+    for (auto&& entry : cached) {
         entries.push_back(entry->clone());
     }
 
@@ -846,13 +997,19 @@ std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
 }
 
 bool PlanCache::contains(const CanonicalQuery& cq) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.hasKey(computeKey(cq));
+    const PlanCacheKey key = computeKey(cq);
+    Partition& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> partitionLock(partition.mutex);
+    return partition.entries.hasKey(key);
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> partitionLock(partition->mutex);
+        size += partition->entries.size();
+    }
+    return size;
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
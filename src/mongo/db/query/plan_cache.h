@@ -29,7 +29,9 @@
 #pragma once
 
 #include <boost/optional/optional.hpp>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
@@ -62,6 +64,27 @@ struct PlanCacheEntryFeedback {
     double score;
 };
 
+/**
+ * Statistics kept for each query shape the plan cache has seen cached. They are shared by the
+ * successive cache entries for the shape, so they survive replanning and eviction for as long as
+ * the cache remembers the shape, and are updated without taking the cache's locks.
+ */
+struct PlanCacheShapeStats {
+    // Lookups that found a cached plan.
+    AtomicInt64 hits;
+
+    // Lookups that found no cached plan, counted from the first time the shape was cached.
+    AtomicInt64 misses;
+
+    // Cached plans that turned out to be inefficient, or failed, and were replanned.
+    AtomicInt64 replans;
+
+    // Times the shape was evicted to make room for another one.
+    AtomicInt64 evictions;
+
+    BSONObj toBSON() const;
+};
+
 // TODO: Replace with opaque type.
 typedef std::string PlanID;
 
@@ -246,6 +269,12 @@ public:
      */
     PlanCacheEntry* clone() const;
 
+    /**
+     * Records 'fb' unless the entry already holds internalQueryCacheFeedbacksStored feedback
+     * objects. Safe to call without a lock while other threads read or add to the entry.
+     */
+    void addFeedback(std::unique_ptr<PlanCacheEntryFeedback> fb);
+
     // For debugging.
     std::string toString() const;
 
@@ -278,8 +307,24 @@ public:
     std::unique_ptr<PlanRankingDecision> decision;
 
     // Annotations from cached runs.  The CachedPlanStage provides these stats about its
-    // runs when they complete.
+    // runs when they complete. An entry in the cache collects them through addFeedback(); this
+    // holds them in the copies made by clone().
     std::vector<PlanCacheEntryFeedback*> feedback;
+
+    // Statistics for the entry's query shape, shared with the copies made by clone().
+    std::shared_ptr<PlanCacheShapeStats> shapeStats;
+
+private:
+    struct FeedbackSlot {
+        std::unique_ptr<PlanCacheEntryFeedback> feedback;
+        AtomicBool ready{false};
+    };
+
+    // Feedback added to the entry, in slots claimed by bumping '_feedbackClaimed'. A slot's
+    // contents may only be read once its 'ready' flag is set.
+    std::unique_ptr<FeedbackSlot[]> _feedbackSlots;
+    size_t _numFeedbackSlots;
+    AtomicUInt32 _feedbackClaimed;
 };
 
 /**
@@ -287,6 +332,10 @@ public:
  * mapping, the cache contains information on why that mapping was made and statistics on the
  * cache entry's actual performance on subsequent runs.
  *
+ * The cache is split into internalQueryCachePartitions partitions by hash of the cache key,
+ * each with its own lock and LRU list, so that lookups of different shapes do not contend.
+ * Entries are immutable once cached apart from their feedback and statistics, which are
+ * updated without locking; readers copy an entry after releasing the partition lock.
  */
 class PlanCache {
 private:
@@ -353,6 +402,13 @@ public:
      */
     Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
+    /**
+     * Counts a replan of 'cq' in the statistics for its shape, if the cache knows the shape.
+     * Called by the CachedPlanStage when it decides to replan a query that was planned from the
+     * cache.
+     */
+    void recordReplan(const CanonicalQuery& cq);
+
     /**
      * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
      * was present and removed and an error status otherwise.
@@ -415,14 +471,23 @@ public:
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
 private:
+    class Partition;
+
     void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+    Partition& partitionFor(const PlanCacheKey& key) const;
+
+    /**
+     * Looks up the entry for 'key' and promotes it to most recently used in its partition. If
+     * there is none and 'countMiss' is true, counts a miss for the shape if it is known.
+     */
+    Status lookup(const PlanCacheKey& key,
+                  bool countMiss,
+                  std::shared_ptr<PlanCacheEntry>* entryOut) const;
 
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Full namespace of collection.
     std::string _ns;
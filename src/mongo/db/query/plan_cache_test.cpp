@@ -446,6 +446,126 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+/**
+ * Adds a single-solution entry for 'cq' to 'planCache'.
+ */
+void addToCache(PlanCache* planCache, const CanonicalQuery& cq) {
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    ASSERT_OK(planCache->add(cq, solns, createDecision(1U), Date_t{}));
+}
+
+/**
+ * Returns a copy of the statistics kept for the shape of 'cq', which must be cached.
+ */
+BSONObj getShapeStats(const PlanCache& planCache, const CanonicalQuery& cq) {
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> entry(rawEntry);
+    return entry->shapeStats->toBSON();
+}
+
+TEST(PlanCacheTest, ShapeStatsSurviveRemoval) {
+    QueryTestServiceContext serviceContext;
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+    // Misses are not counted before the shape is first cached.
+    CachedSolution* rawCS;
+    ASSERT_NOT_OK(planCache.get(*cq, &rawCS));
+    addToCache(&planCache, *cq);
+
+    ASSERT_OK(planCache.get(*cq, &rawCS));
+    delete rawCS;
+    ASSERT_OK(planCache.get(*cq, &rawCS));
+    delete rawCS;
+
+    // Replanning removes the entry, after which lookups miss until the shape is cached again.
+    planCache.recordReplan(*cq);
+    ASSERT_OK(planCache.remove(*cq));
+    ASSERT_NOT_OK(planCache.get(*cq, &rawCS));
+    addToCache(&planCache, *cq);
+
+    ASSERT_BSONOBJ_EQ(getShapeStats(planCache, *cq),
+                      BSON("hits" << 2LL << "misses" << 1LL << "replans" << 1LL << "evictions"
+                                  << 0LL));
+
+    // Clearing the cache forgets the shape.
+    planCache.clear();
+    addToCache(&planCache, *cq);
+    ASSERT_BSONOBJ_EQ(getShapeStats(planCache, *cq),
+                      BSON("hits" << 0LL << "misses" << 0LL << "replans" << 0LL << "evictions"
+                                  << 0LL));
+}
+
+TEST(PlanCacheTest, ShapeStatsCountEvictions) {
+    const int oldCacheSize = internalQueryCacheSize.load();
+    const int oldPartitions = internalQueryCachePartitions.load();
+    ON_BLOCK_EXIT([oldCacheSize, oldPartitions] {
+        internalQueryCacheSize.store(oldCacheSize);
+        internalQueryCachePartitions.store(oldPartitions);
+    });
+    internalQueryCacheSize.store(1);
+    internalQueryCachePartitions.store(1);
+
+    QueryTestServiceContext serviceContext;
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+
+    addToCache(&planCache, *cqA);
+    addToCache(&planCache, *cqB);
+    ASSERT_FALSE(planCache.contains(*cqA));
+    ASSERT_EQUALS(planCache.size(), 1U);
+
+    addToCache(&planCache, *cqA);
+    ASSERT_EQUALS(getShapeStats(planCache, *cqA)["evictions"].numberLong(), 1LL);
+}
+
+TEST(PlanCacheTest, PartitionedCacheHoldsAllShapes) {
+    QueryTestServiceContext serviceContext;
+    PlanCache planCache;
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (int i = 0; i < 100; ++i) {
+        queries.push_back(canonicalize(BSON("a" << 1 << ("f" + std::to_string(i)) << 1)));
+        addToCache(&planCache, *queries.back());
+    }
+
+    ASSERT_EQUALS(planCache.size(), 100U);
+    std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+    ASSERT_EQUALS(entries.size(), 100U);
+    for (auto entry : entries) {
+        delete entry;
+    }
+    for (auto&& cq : queries) {
+        ASSERT_TRUE(planCache.contains(*cq));
+    }
+}
+
+TEST(PlanCacheTest, FeedbackIsCapped) {
+    QueryTestServiceContext serviceContext;
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    addToCache(&planCache, *cq);
+
+    const int feedbacksStored = internalQueryCacheFeedbacksStored.load();
+    for (int i = 0; i < feedbacksStored + 5; ++i) {
+        auto fb = stdx::make_unique<PlanCacheEntryFeedback>();
+        fb->stats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+        fb->score = i;
+        ASSERT_OK(planCache.feedback(*cq, fb.release()));
+    }
+
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(*cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> entry(rawEntry);
+    ASSERT_EQUALS(entry->feedback.size(), static_cast<size_t>(feedbacksStored));
+    ASSERT_EQUALS(entry->feedback[0]->score, 0.0);
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
@@ -50,6 +50,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
@@ -277,6 +278,19 @@ Status PlanExecutor::pickBestPlan(const Collection* collection) {
     return Status::OK();
 }
 
+struct PlanExecutor::Batch {
+    bool hasResults() const {
+        return pos < ids.size();
+    }
+
+    std::vector<WorkingSetID> ids;
+    size_t pos = 0;
+
+    // The state that ended the batch, handled once its results have been returned.
+    boost::optional<PlanStage::StageState> endState;
+    WorkingSetID endId = WorkingSet::INVALID_ID;
+};
+
 PlanExecutor::~PlanExecutor() {
     invariant(_currentState == kDisposed);
 }
@@ -401,6 +415,30 @@ void PlanExecutor::invalidate(OperationContext* opCtx, const RecordId& dl, Inval
     if (!isMarkedAsKilled()) {
         _root->invalidate(opCtx, dl, type);
     }
+
+    // Batched results are returned as they were when they were produced, but must not hand
+    // out a RecordId that no longer refers to them.
+    if (_batch) {
+        for (size_t i = _batch->pos; i < _batch->ids.size(); ++i) {
+            const WorkingSetID id = _batch->ids[i];
+            if (WorkingSet::INVALID_ID == id) {
+                continue;
+            }
+
+            WorkingSetMember* member = _workingSet->get(id);
+            if (!member->hasRecordId() || member->recordId != dl) {
+                continue;
+            }
+
+            if (member->hasObj()) {
+                member->obj.setValue(member->obj.value().getOwned());
+                _workingSet->transitionToOwnedObj(id);
+            } else {
+                _workingSet->free(id);
+                _batch->ids[i] = WorkingSet::INVALID_ID;
+            }
+        }
+    }
 }
 
 PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -539,6 +577,16 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         cappedInsertNotifierData.notifier = getCappedInsertNotifier();
     }
     for (;;) {
+        // Results left over from the last batch are owned, so there is no need to check for a
+        // yield before returning them.
+        if (_batch && _batch->hasResults()) {
+            const WorkingSetID id = _batch->ids[_batch->pos++];
+            if (WorkingSet::INVALID_ID != id && extractResult(id, objOut, dlOut)) {
+                return PlanExecutor::ADVANCED;
+            }
+            continue;
+        }
+
         // These are the conditions which can cause us to yield:
         //   1) The yield policy's timer elapsed, or
         //   2) some stage requested a yield due to a document fetch, or
@@ -560,44 +608,38 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         fetcher.reset();
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code;
+        const int batchSize = internalQueryExecBatchSize.load();
+
+        if (_batch && _batch->endState) {
+            code = *_batch->endState;
+            id = _batch->endId;
+            _batch->endState = boost::none;
+        } else if (batchSize > 1 && _root->supportsBatchedWork()) {
+            if (!_batch) {
+                _batch = stdx::make_unique<Batch>();
+            }
+            _batch->ids.clear();
+            _batch->pos = 0;
+
+            code = _root->workBatch(_workingSet.get(), batchSize, &_batch->ids, &id);
+            if (_batch->hasResults()) {
+                writeConflictsInARow = 0;
+                if (PlanStage::ADVANCED != code && PlanStage::NEED_TIME != code) {
+                    _batch->endState = code;
+                    _batch->endId = id;
+                }
+                continue;
+            }
+        } else {
+            code = _root->work(&id);
+        }
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
 
         if (PlanStage::ADVANCED == code) {
-            WorkingSetMember* member = _workingSet->get(id);
-            bool hasRequestedData = true;
-
-            if (NULL != objOut) {
-                if (WorkingSetMember::RID_AND_IDX == member->getState()) {
-                    if (1 != member->keyData.size()) {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    } else {
-                        // TODO: currently snapshot ids are only associated with documents, and
-                        // not with index keys.
-                        *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
-                    }
-                } else if (member->hasObj()) {
-                    *objOut = member->obj;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (NULL != dlOut) {
-                if (member->hasRecordId()) {
-                    *dlOut = member->recordId;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (hasRequestedData) {
-                _workingSet->free(id);
+            if (extractResult(id, objOut, dlOut)) {
                 return PlanExecutor::ADVANCED;
             }
             // This result didn't have the data the caller wanted, try again.
@@ -653,9 +695,44 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
     }
 }
 
+bool PlanExecutor::extractResult(WorkingSetID id,
+                                 Snapshotted<BSONObj>* objOut,
+                                 RecordId* dlOut) {
+    WorkingSetMember* member = _workingSet->get(id);
+    bool hasRequestedData = true;
+
+    if (NULL != objOut) {
+        if (WorkingSetMember::RID_AND_IDX == member->getState()) {
+            if (1 != member->keyData.size()) {
+                hasRequestedData = false;
+            } else {
+                // TODO: currently snapshot ids are only associated with documents, and
+                // not with index keys.
+                *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
+            }
+        } else if (member->hasObj()) {
+            *objOut = member->obj;
+        } else {
+            hasRequestedData = false;
+        }
+    }
+
+    if (NULL != dlOut) {
+        if (member->hasRecordId()) {
+            *dlOut = member->recordId;
+        } else {
+            hasRequestedData = false;
+        }
+    }
+
+    _workingSet->free(id);
+    return hasRequestedData;
+}
+
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    const bool batchDone = !_batch || (!_batch->hasResults() && !_batch->endState);
+    return isMarkedAsKilled() || (_stash.empty() && batchDone && _root->isEOF());
 }
 
 void PlanExecutor::markAsKilled(Status killStatus) {
@@ -33,6 +33,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/db/catalog/util/partitioned.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/storage/snapshot.h"
@@ -502,6 +503,12 @@ private:
 
     ExecState getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Copies the parts of the result 'id' that the caller of getNext() asked for into 'objOut'
+     * and 'dlOut', and frees it. Returns false if the result lacks any of them.
+     */
+    bool extractResult(WorkingSetID id, Snapshotted<BSONObj>* objOut, RecordId* dlOut);
+
     /**
      * New PlanExecutor instances are created with the static make() methods above.
      */
@@ -576,6 +583,11 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results taken from the plan a batch at a time that have not been returned yet. Only
+    // allocated once the plan is run in batches, see internalQueryExecBatchSize.
+    struct Batch;
+    std::unique_ptr<Batch> _batch;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     // Set if this PlanExecutor is registered with the CursorManager.
@@ -40,6 +40,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/index_cardinality_stats.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/server_options.h"
@@ -64,6 +65,76 @@ namespace mongo {
 using std::endl;
 using std::vector;
 
+namespace {
+
+// Scores closer than this are a tie.
+const double kScoreEpsilon = 1e-10;
+
+/**
+ * Estimated number of index keys the plan rooted at 'node' examines, going by the sampled
+ * statistics of the indexes it scans. Returns boost::none if any leaf is not an index scan with
+ * statistics.
+ */
+boost::optional<double> estimateKeysExamined(const QuerySolutionNode* node) {
+    if (STAGE_IXSCAN == node->getType()) {
+        const IndexScanNode* ixn = static_cast<const IndexScanNode*>(node);
+        if (!ixn->index.cardinalityStats) {
+            return boost::none;
+        }
+        return ixn->index.cardinalityStats->estimateKeys(ixn->bounds);
+    }
+
+    if (node->children.empty()) {
+        return boost::none;
+    }
+
+    double keys = 0;
+    for (const QuerySolutionNode* child : node->children) {
+        auto childKeys = estimateKeysExamined(child);
+        if (!childKeys) {
+            return boost::none;
+        }
+        keys += *childKeys;
+    }
+    return keys;
+}
+
+/**
+ * Reorders the plans tied for the best score at the front of 'scoresAndCandidateIndices' so that
+ * those estimated to examine the fewest index keys come first. Leaves the order alone unless
+ * every tied plan has an estimate.
+ */
+void breakTieByEstimatedKeys(const vector<CandidatePlan>& candidates,
+                             vector<std::pair<double, size_t>>* scoresAndCandidateIndices) {
+    const double bestScore = scoresAndCandidateIndices->front().first;
+
+    // Holds (estimated keys, (score, candidateIndex)) for each tied plan.
+    vector<std::pair<double, std::pair<double, size_t>>> tied;
+    for (auto&& scoreAndIndex : *scoresAndCandidateIndices) {
+        if (std::abs(bestScore - scoreAndIndex.first) >= kScoreEpsilon) {
+            break;
+        }
+        const QuerySolution* solution = candidates[scoreAndIndex.second].solution.get();
+        auto keys = solution && solution->root ? estimateKeysExamined(solution->root.get())
+                                               : boost::none;
+        if (!keys) {
+            return;
+        }
+        tied.emplace_back(*keys, scoreAndIndex);
+    }
+
+    std::stable_sort(tied.begin(), tied.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    for (size_t i = 0; i < tied.size(); ++i) {
+        LOG(2) << "Tied plan " << tied[i].second.second << " estimated to examine "
+               << tied[i].first << " index keys";
+        (*scoresAndCandidateIndices)[i] = tied[i].second;
+    }
+}
+
+}  // namespace
+
 // static
 size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRankingDecision* why) {
     invariant(!candidates.empty());
@@ -115,8 +186,13 @@ size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRan
     if (scoresAndCandidateindices.size() > 1U) {
         double bestScore = scoresAndCandidateindices[0].first;
         double runnerUpScore = scoresAndCandidateindices[1].first;
-        const double epsilon = 1e-10;
-        why->tieForBest = std::abs(bestScore - runnerUpScore) < epsilon;
+        why->tieForBest = std::abs(bestScore - runnerUpScore) < kScoreEpsilon;
+    }
+
+    // The trial period could not tell the best plans apart. Fall back on index statistics, if
+    // there are any, rather than on the order the planner produced the plans in.
+    if (why->tieForBest) {
+        breakTieByEstimatedKeys(candidates, &scoresAndCandidateindices);
     }
 
     // Update results in 'why'
@@ -157,11 +157,13 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         params.options & QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
+    bool naturalOrderRequested = false;
     if (!query.getQueryRequest().getHint().isEmpty()) {
         BSONElement natural =
             dps::extractElementAtPath(query.getQueryRequest().getHint(), "$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrderRequested = true;
         }
     }
 
@@ -172,9 +174,17 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         BSONElement natural = dps::extractElementAtPath(sortObj, "$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrderRequested = true;
         }
     }
 
+    // Only a plain forward scan can be split into ranges. The ranges are merged back in RecordId
+    // order only if the query asked for natural order.
+    csn->parallelAllowed = (params.options & QueryPlannerParams::PARALLEL_COLLSCAN) &&
+        1 == csn->direction && !tailable && 0 == csn->maxScan &&
+        !csn->shouldTrackLatestOplogTimestamp && !csn->shouldWaitForOplogVisibility;
+    csn->parallelOrdered = naturalOrderRequested;
+
     return std::move(csn);
 }
 
@@ -39,6 +39,8 @@
 #include "mongo/db/index/s2_common.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/log.h"
@@ -290,6 +292,42 @@ void geoSkipValidationOn(const std::set<StringData>& twoDSphereFields,
     }
 }
 
+/**
+ * Returns true if a blocking sort by 'sortObj' with a limit can run on the index keys coming out
+ * of 'solnRoot', with documents fetched above the sort. Only the top-k winners are then fetched
+ * instead of every document the index scan produces.
+ */
+bool canSortOnIndexKeys(const CanonicalQuery& query,
+                        const QuerySolutionNode* solnRoot,
+                        const BSONObj& sortObj) {
+    if (!internalQueryPlannerSortOnIndexKeysWithLimit.load() || solnRoot->fetched()) {
+        return false;
+    }
+
+    const QuerySolutionNode* leaf = solnRoot;
+    if (STAGE_SHARDING_FILTER == leaf->getType()) {
+        leaf = leaf->children[0];
+    }
+    if (STAGE_IXSCAN != leaf->getType()) {
+        return false;
+    }
+
+    // Collated index keys hold comparison keys, which are only the sort keys the query wants if
+    // the index and the query use the same collation.
+    const IndexScanNode* ixn = static_cast<const IndexScanNode*>(leaf);
+    if (!CollatorInterface::collatorsMatch(ixn->index.collator, query.getCollator())) {
+        return false;
+    }
+
+    for (auto&& elt : sortObj) {
+        // $meta sorts need the document.
+        if (!elt.isNumber() || !solnRoot->hasField(elt.fieldName())) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }  // namespace
 
 // static
@@ -525,10 +563,11 @@ QuerySolutionNode* QueryPlannerAnalysis::analyzeSort(const CanonicalQuery& query
         return NULL;
     }
 
-    // Add a fetch stage so we have the full object when we hit the sort stage.  TODO: Can we
-    // pull the values that we sort by out of the key and if so in what cases?  Perhaps we can
-    // avoid a fetch.
-    if (!solnRoot->fetched()) {
+    // Add a fetch stage so we have the full object when we hit the sort stage, unless the sort is
+    // limited and the sort keys can be read from the index keys. In that case the sort keeps only
+    // index keys and RecordIds, and the fetch added above it touches just the winning documents.
+    const bool hasLimit = qr.getLimit() || qr.getNToReturn();
+    if (!solnRoot->fetched() && !(hasLimit && canSortOnIndexKeys(query, solnRoot, sortObj))) {
         FetchNode* fetch = new FetchNode();
         fetch->children.push_back(solnRoot);
         solnRoot = fetch;
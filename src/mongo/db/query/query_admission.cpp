@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_admission.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/clock_source.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+// Set once an operation has been admitted, so that an aggregation re-run against the namespace a
+// view resolves to does not queue a second time.
+const auto admittedDecoration = OperationContext::declareDecoration<bool>();
+
+bool stageMemoryUnderPressure() {
+    const int pct = internalQueryAdmissionMemoryPct.load();
+    if (!internalQueryStageMemUsageSwitch.load() || pct == 0) {
+        return false;
+    }
+    return globalStageMemCounters.getTotalMemSize() >=
+        internalQueryStageMemUsageMAX.load() / 100 * pct;
+}
+
+class QueryAdmissionStatSection : public ServerStatusSection {
+public:
+    QueryAdmissionStatSection() : ServerStatusSection("queryAdmission") {}
+
+    bool includeByDefault() const final {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const final {
+        BSONObjBuilder builder;
+        QueryAdmissionQueue::get().appendStats(&builder);
+        return builder.obj();
+    }
+} queryAdmissionStatSection;
+
+}  // namespace
+
+const Milliseconds QueryAdmissionQueue::kPollInterval{10};
+
+const std::array<int64_t, QueryAdmissionQueue::kHistogramBuckets>
+    QueryAdmissionQueue::kWaitLowerBoundsMicros = {0,
+                                                   1000,
+                                                   2000,
+                                                   5000,
+                                                   10 * 1000,
+                                                   20 * 1000,
+                                                   50 * 1000,
+                                                   100 * 1000,
+                                                   200 * 1000,
+                                                   500 * 1000,
+                                                   1000 * 1000,
+                                                   2000 * 1000,
+                                                   5000 * 1000,
+                                                   10000 * 1000};
+
+QueryAdmissionQueue::QueryAdmissionQueue(PressureProbe underPressure)
+    : _underPressure(std::move(underPressure)) {}
+
+QueryAdmissionQueue& QueryAdmissionQueue::get() {
+    static QueryAdmissionQueue queue(stageMemoryUnderPressure);
+    return queue;
+}
+
+Status QueryAdmissionQueue::admit(OperationContext* opCtx) {
+    bool& admitted = admittedDecoration(opCtx);
+    if (admitted || opCtx->getClient()->isInDirectClient() || opCtx->lockState()->isLocked()) {
+        return Status::OK();
+    }
+
+    // Nobody is waiting and memory is available: start without touching the mutex.
+    if (_depth.load() == 0 && !_underPressure()) {
+        _admittedImmediately.fetchAndAdd(1);
+        admitted = true;
+        return Status::OK();
+    }
+
+    Status status = _wait(opCtx);
+    admitted = status.isOK();
+    return status;
+}
+
+Status QueryAdmissionQueue::_wait(OperationContext* opCtx) {
+    Client* client = opCtx->getClient();
+    ClockSource* clock = opCtx->getServiceContext()->getPreciseClockSource();
+
+    {
+        stdx::lock_guard<Client> clientLock(*client);
+        CurOp::get(opCtx)->beginAdmissionWait_inlock();
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Client> clientLock(*client);
+        CurOp::get(opCtx)->endAdmissionWait_inlock();
+    });
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    const int maxDepth = internalQueryAdmissionMaxQueueDepth.load();
+    if (_waiters.size() >= static_cast<size_t>(maxDepth)) {
+        _rejectedQueueFull.fetchAndAdd(1);
+        return {ErrorCodes::ExceededMemoryLimit,
+                str::stream() << "Query stage memory is exhausted and " << _waiters.size()
+                              << " operations are already waiting to start"};
+    }
+
+    const Date_t start = clock->now();
+    const int maxWaitMS = internalQueryAdmissionMaxWaitMS.load();
+    const Date_t deadline = maxWaitMS > 0 ? start + Milliseconds(maxWaitMS) : Date_t::max();
+
+    const auto self = _waiters.insert(_waiters.end(), opCtx);
+    _depth.fetchAndAdd(1);
+    ON_BLOCK_EXIT([&] {
+        if (!lk.owns_lock()) {
+            lk.lock();
+        }
+        const bool wasHead = self == _waiters.begin();
+        _waiters.erase(self);
+        _depth.fetchAndSubtract(1);
+        _recordWait(clock->now() - start);
+        if (wasHead) {
+            // Let the next waiter check straight away rather than at its next poll.
+            _cv.notify_all();
+        }
+    });
+
+    while (true) {
+        if (self == _waiters.begin() && !_underPressure()) {
+            _admittedAfterWait.fetchAndAdd(1);
+            return Status::OK();
+        }
+
+        const Date_t now = clock->now();
+        if (now >= deadline) {
+            _rejectedTimeout.fetchAndAdd(1);
+            return {ErrorCodes::ExceededMemoryLimit,
+                    str::stream() << "Query stage memory is exhausted; gave up waiting to start "
+                                  << "after "
+                                  << maxWaitMS
+                                  << "ms"};
+        }
+
+        try {
+            opCtx->waitForConditionOrInterruptUntil(
+                _cv, lk, std::min(now + kPollInterval, deadline));
+        } catch (const DBException& ex) {
+            if (ex.code() == ErrorCodes::ExceededTimeLimit) {
+                _rejectedMaxTimeMS.fetchAndAdd(1);
+            } else {
+                _interrupted.fetchAndAdd(1);
+            }
+            throw;
+        }
+    }
+}
+
+void QueryAdmissionQueue::_recordWait(Microseconds waited) {
+    const int64_t micros = std::max<int64_t>(durationCount<Microseconds>(waited), 0);
+    const auto bucket =
+        std::upper_bound(kWaitLowerBoundsMicros.begin(), kWaitLowerBoundsMicros.end(), micros) -
+        kWaitLowerBoundsMicros.begin() - 1;
+    _waitHistogram[bucket].fetchAndAdd(1);
+    _totalWaitMicros.fetchAndAdd(micros);
+}
+
+void QueryAdmissionQueue::appendStats(BSONObjBuilder* builder) const {
+    builder->appendNumber("depth", static_cast<long long>(_depth.load()));
+    builder->appendNumber("admittedImmediately",
+                          static_cast<long long>(_admittedImmediately.load()));
+    builder->appendNumber("admittedAfterWait", static_cast<long long>(_admittedAfterWait.load()));
+    {
+        BSONObjBuilder rejected(builder->subobjStart("rejected"));
+        rejected.appendNumber("queueFull", static_cast<long long>(_rejectedQueueFull.load()));
+        rejected.appendNumber("timedOut", static_cast<long long>(_rejectedTimeout.load()));
+        rejected.appendNumber("maxTimeMSExpired",
+                              static_cast<long long>(_rejectedMaxTimeMS.load()));
+        rejected.appendNumber("interrupted", static_cast<long long>(_interrupted.load()));
+    }
+    builder->appendNumber("totalWaitMicros", static_cast<long long>(_totalWaitMicros.load()));
+
+    BSONArrayBuilder histogram(builder->subarrayStart("waitHistogram"));
+    for (size_t i = 0; i < kHistogramBuckets; ++i) {
+        const uint64_t count = _waitHistogram[i].load();
+        if (count == 0) {
+            continue;
+        }
+        BSONObjBuilder entry(histogram.subobjStart());
+        entry.append("micros", static_cast<long long>(kWaitLowerBoundsMicros[i]));
+        entry.append("count", static_cast<long long>(count));
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <list>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class OperationContext;
+
+/// OOM feature
+/**
+ * Holds back new find and aggregate operations while the stage memory in use is close to
+ * internalQueryStageMemUsageMAX, so that they start once memory is available instead of doing
+ * work that is thrown away when the global limit fails them.
+ *
+ * Operations are admitted in arrival order. Only the operation at the head of the queue is
+ * admitted when memory is available, so a burst of waiters does not all start at once. A waiter
+ * gives up when its maxTimeMS or internalQueryAdmissionMaxWaitMS expires, and an operation is
+ * turned away immediately if internalQueryAdmissionMaxQueueDepth operations are already queued.
+ *
+ * Stage memory is released without notifying the queue, so waiters poll it; the head is also
+ * woken whenever another waiter leaves.
+ */
+class QueryAdmissionQueue {
+    MONGO_DISALLOW_COPYING(QueryAdmissionQueue);
+
+public:
+    /**
+     * Returns true if new operations should wait.
+     */
+    using PressureProbe = stdx::function<bool()>;
+
+    static const Milliseconds kPollInterval;
+
+    static const size_t kHistogramBuckets = 14;
+
+    // Inclusive lower bounds of the wait time histogram buckets.
+    static const std::array<int64_t, kHistogramBuckets> kWaitLowerBoundsMicros;
+
+    explicit QueryAdmissionQueue(PressureProbe underPressure);
+
+    /**
+     * The queue in front of find and aggregate, driven by globalStageMemCounters.
+     */
+    static QueryAdmissionQueue& get();
+
+    /**
+     * Returns once "opCtx" may start. An operation that has already been admitted passes straight
+     * through, as does one run through DBDirectClient or holding locks. Returns
+     * ExceededMemoryLimit if the queue is full or internalQueryAdmissionMaxWaitMS expires, and
+     * throws if the operation is killed or its maxTimeMS expires while queued.
+     */
+    Status admit(OperationContext* opCtx);
+
+    /**
+     * Number of operations waiting.
+     */
+    int64_t depth() const {
+        return _depth.load();
+    }
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    Status _wait(OperationContext* opCtx);
+
+    void _recordWait(Microseconds waited);
+
+    const PressureProbe _underPressure;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    // Waiting operations, oldest first.
+    std::list<OperationContext*> _waiters;
+    AtomicInt64 _depth{0};
+
+    AtomicUInt64 _admittedImmediately{0};
+    AtomicUInt64 _admittedAfterWait{0};
+    AtomicUInt64 _rejectedQueueFull{0};
+    AtomicUInt64 _rejectedTimeout{0};
+    AtomicUInt64 _rejectedMaxTimeMS{0};
+    AtomicUInt64 _interrupted{0};
+    AtomicUInt64 _totalWaitMicros{0};
+    std::array<AtomicUInt64, kHistogramBuckets> _waitHistogram;
+};
+
+}  // namespace mongo
@@ -0,0 +1,189 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_admission.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_test_service_context.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+class QueryAdmissionQueueTest : public unittest::Test {
+public:
+    QueryAdmissionQueueTest()
+        : _queue([this] {
+              // Each call that sees memory available consumes one admission from the budget.
+              return _budget.fetchAndSubtract(1) <= 0;
+          }) {}
+
+protected:
+    void setUp() final {
+        _savedMaxDepth = internalQueryAdmissionMaxQueueDepth.load();
+        _savedMaxWaitMS = internalQueryAdmissionMaxWaitMS.load();
+    }
+
+    void tearDown() final {
+        internalQueryAdmissionMaxQueueDepth.store(_savedMaxDepth);
+        internalQueryAdmissionMaxWaitMS.store(_savedMaxWaitMS);
+    }
+
+    void setPressure(bool underPressure) {
+        _budget.store(underPressure ? 0 : 1 << 30);
+    }
+
+    void allowOne() {
+        _budget.store(1);
+    }
+
+    void waitForDepth(int64_t depth) {
+        while (_queue.depth() != depth) {
+            sleepmillis(1);
+        }
+    }
+
+    BSONObj stats() {
+        BSONObjBuilder builder;
+        _queue.appendStats(&builder);
+        return builder.obj();
+    }
+
+    QueryTestServiceContext _serviceContext;
+    AtomicInt64 _budget{0};
+    QueryAdmissionQueue _queue;
+
+private:
+    int _savedMaxDepth;
+    int _savedMaxWaitMS;
+};
+
+TEST_F(QueryAdmissionQueueTest, AdmitsImmediatelyWithoutPressure) {
+    setPressure(false);
+    auto opCtx = _serviceContext.makeOperationContext();
+
+    ASSERT_OK(_queue.admit(opCtx.get()));
+    ASSERT_EQ(0, _queue.depth());
+    ASSERT_EQ(1, stats()["admittedImmediately"].numberLong());
+    ASSERT_EQ(0, stats()["admittedAfterWait"].numberLong());
+}
+
+TEST_F(QueryAdmissionQueueTest, AdmittedOperationIsNotQueuedAgain) {
+    setPressure(false);
+    auto opCtx = _serviceContext.makeOperationContext();
+    ASSERT_OK(_queue.admit(opCtx.get()));
+
+    setPressure(true);
+    ASSERT_OK(_queue.admit(opCtx.get()));
+    ASSERT_EQ(1, stats()["admittedImmediately"].numberLong());
+}
+
+TEST_F(QueryAdmissionQueueTest, RejectsWhenQueueIsFull) {
+    setPressure(true);
+    internalQueryAdmissionMaxQueueDepth.store(0);
+    auto opCtx = _serviceContext.makeOperationContext();
+
+    ASSERT_EQ(ErrorCodes::ExceededMemoryLimit, _queue.admit(opCtx.get()));
+    ASSERT_EQ(1, stats()["rejected"]["queueFull"].numberLong());
+    ASSERT_EQ(0, _queue.depth());
+}
+
+TEST_F(QueryAdmissionQueueTest, GivesUpAfterMaxWait) {
+    setPressure(true);
+    internalQueryAdmissionMaxWaitMS.store(20);
+    auto opCtx = _serviceContext.makeOperationContext();
+
+    ASSERT_EQ(ErrorCodes::ExceededMemoryLimit, _queue.admit(opCtx.get()));
+    ASSERT_EQ(1, stats()["rejected"]["timedOut"].numberLong());
+    ASSERT_EQ(0, _queue.depth());
+    ASSERT_EQ(1, stats()["waitHistogram"].Array().size());
+
+    // currentOp reports the time spent queued.
+    BSONObjBuilder builder;
+    {
+        stdx::lock_guard<Client> lk(*opCtx->getClient());
+        CurOp::get(opCtx.get())->reportState(&builder);
+    }
+    BSONObj report = builder.obj();
+    ASSERT_FALSE(report["admissionQueue"]["waiting"].trueValue());
+    ASSERT_GTE(report["admissionQueue"]["waitMicros"].numberLong(), 20 * 1000);
+}
+
+TEST_F(QueryAdmissionQueueTest, MaxTimeMSExpiresWhileQueued) {
+    setPressure(true);
+    internalQueryAdmissionMaxWaitMS.store(0);
+    auto opCtx = _serviceContext.makeOperationContext();
+    opCtx->setDeadlineAfterNowBy(Milliseconds(20), ErrorCodes::ExceededTimeLimit);
+
+    ASSERT_THROWS_CODE(_queue.admit(opCtx.get()), DBException, ErrorCodes::ExceededTimeLimit);
+    ASSERT_EQ(1, stats()["rejected"]["maxTimeMSExpired"].numberLong());
+    ASSERT_EQ(0, _queue.depth());
+}
+
+TEST_F(QueryAdmissionQueueTest, AdmitsInArrivalOrder) {
+    setPressure(true);
+    internalQueryAdmissionMaxWaitMS.store(0);
+
+    auto runWaiter = [this](AtomicBool* admitted) {
+        auto client = _serviceContext.getServiceContext()->makeClient("admissionWaiter");
+        auto opCtx = client->makeOperationContext();
+        ASSERT_OK(_queue.admit(opCtx.get()));
+        admitted->store(true);
+    };
+
+    AtomicBool firstAdmitted{false};
+    AtomicBool secondAdmitted{false};
+    stdx::thread first(runWaiter, &firstAdmitted);
+    waitForDepth(1);
+    stdx::thread second(runWaiter, &secondAdmitted);
+    waitForDepth(2);
+
+    // Memory for one operation frees up: it goes to the operation that has waited longest.
+    allowOne();
+    first.join();
+    ASSERT_TRUE(firstAdmitted.load());
+    ASSERT_FALSE(secondAdmitted.load());
+    ASSERT_EQ(1, _queue.depth());
+
+    setPressure(false);
+    second.join();
+    ASSERT_TRUE(secondAdmitted.load());
+    ASSERT_EQ(0, _queue.depth());
+    ASSERT_EQ(2, stats()["admittedAfterWait"].numberLong());
+}
+
+}  // namespace
+}  // namespace mongo
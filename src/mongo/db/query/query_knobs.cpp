@@ -38,8 +38,30 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationCollFraction, double, 0
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationParallel, bool, false);
+
+// Read when the trial thread pool is first used.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxThreads, int, 4)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryPlanEvaluationMaxThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
+// Read when a collection's plan cache is created; the cache size is split evenly between them.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCachePartitions, int, 16)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 256) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryCachePartitions must be between 1 and 256");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
@@ -66,6 +88,50 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+// The thread pool is sized from this when it is first used.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanThreads, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollectionScanThreads must be between 0 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMinRecords, int, 100000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollectionScanMinRecords must be non-negative");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMaxThreadsPerQuery, int, 4)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(
+                ErrorCodes::BadValue,
+                "internalQueryParallelCollectionScanMaxThreadsPerQuery must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMaxBufferedBytes,
+                              int,
+                              4 * 1024 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollectionScanMaxBufferedBytes must be positive");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileMatchExpressions, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileAggregationExpressions, bool, false);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalInsertMaxBatchSize,
@@ -76,8 +142,75 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupCacheSizeBytes, int, 100 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinMaxMemoryBytes,
+                              int,
+                              100 * 1024 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceLookupHashJoinMaxMemoryBytes must be >= 0");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinIndexedRatio, double, 0.1)
+    ->withValidator([](const double& newVal) {
+        if (newVal < 0.0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceLookupHashJoinIndexedRatio must be >= 0");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupSpillPartitions, int, 16)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 2 || newVal > 256) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceGroupSpillPartitions must be between 2 and 256");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupParallelism, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceGroupParallelism must be between 0 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceColumnBatchSize, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 64 * 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceColumnBatchSize must be between 0 and 65536");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateCoveredWholeIndexScans, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSortOnIndexKeysWithLimit, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryIndexStatsSampleSize, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1000000) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryIndexStatsSampleSize must be between 0 and 1000000");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryIndexStatsRefreshSecs, int, 600)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryIndexStatsRefreshSecs must be non-negative");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryProhibitBlockingMergeOnMongoS, bool, false);
@@ -88,4 +221,73 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageMAX, long long, 0x7fffff
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageMIN, long long, 3 * 1024);
 
+// Per-operation and per-database stage memory limits. 0 means unlimited.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageOpMAX, long long, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemUsageTenantMAX, long long, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemReserveChunkBytes, long long, 256 * 1024)
+    ->withValidator([](const long long& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryStageMemReserveChunkBytes must be greater than 0");
+        }
+        return Status::OK();
+    });
+
+// When the global stage memory limit is hit, blocking stages that can spill to disk do so instead
+// of failing, buffering at most internalQueryStageMemSpillBufferBytes in memory afterwards.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemSpillOnGlobalLimit, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStageMemSpillBufferBytes, long long, 8 * 1024 * 1024)
+    ->withValidator([](const long long& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryStageMemSpillBufferBytes must be greater than 0");
+        }
+        return Status::OK();
+    });
+
+// New find and aggregate operations queue while the stage memory in use is at or above
+// internalQueryAdmissionMemoryPct percent of internalQueryStageMemUsageMAX. 0 disables queueing.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryAdmissionMemoryPct, int, 90)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryAdmissionMemoryPct must be between 0 and 100");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryAdmissionMaxQueueDepth, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryAdmissionMaxQueueDepth must be at least 0");
+        }
+        return Status::OK();
+    });
+
+// Longest an operation without a sooner maxTimeMS waits to be admitted. 0 means no limit.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryAdmissionMaxWaitMS, int, 30 * 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryAdmissionMaxWaitMS must be at least 0");
+        }
+        return Status::OK();
+    });
+
+// When greater than 1, plans whose root stage supports it are run this many units of work at a
+// time (see PlanStage::workBatch()). Batched results are copied out of the storage engine's
+// buffers, so this pays off mostly for selective filters. 0 or 1 runs plans one result at a time.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 4096) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryExecBatchSize must be between 0 and 4096");
+        }
+        return Status::OK();
+    });
+
 }  // namespace mongo
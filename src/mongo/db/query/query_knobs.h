@@ -48,6 +48,12 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 // Stop working plans once a plan returns this many results.
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// Do we run the trial periods of candidate plans concurrently, each on its own thread?
+extern AtomicBool internalQueryPlanEvaluationParallel;
+
+// How many threads may run candidate plan trial periods at once, across all queries?
+extern AtomicInt32 internalQueryPlanEvaluationMaxThreads;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -64,6 +70,9 @@ extern AtomicBool internalQueryPlannerEnableHashIntersection;
 // How many entries in the cache?
 extern AtomicInt32 internalQueryCacheSize;
 
+// How many independently locked partitions is each collection's plan cache split into?
+extern AtomicInt32 internalQueryCachePartitions;
+
 // How many feedback entries do we collect before possibly evicting from the cache based on bad
 // performance?
 extern AtomicInt32 internalQueryCacheFeedbacksStored;
@@ -95,6 +104,15 @@ extern AtomicInt32 internalQueryMaxScansToExplode;
 // Allow the planner to generate covered whole index scans, rather than falling back to a COLLSCAN.
 extern AtomicBool internalQueryPlannerGenerateCoveredWholeIndexScans;
 
+// Can a blocking sort with a limit run on index keys, fetching only the documents it returns?
+extern AtomicBool internalQueryPlannerSortOnIndexKeysWithLimit;
+
+// How many documents are sampled to build an index's cardinality statistics? 0 turns them off.
+extern AtomicInt32 internalQueryIndexStatsSampleSize;
+
+// How many seconds until an index's cardinality statistics are rebuilt from a new sample?
+extern AtomicInt32 internalQueryIndexStatsRefreshSecs;
+
 // Ignore unknown JSON Schema keywords.
 extern AtomicBool internalQueryIgnoreUnknownJSONSchemaKeywords;
 
@@ -110,6 +128,30 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// How many RecordId ranges is an unindexed collection scan split into, each scanned on its own
+// thread? 0 or 1 scans on the query's own thread.
+extern AtomicInt32 internalQueryParallelCollectionScanThreads;
+
+// Collections with fewer records than this are always scanned on the query's own thread.
+extern AtomicInt32 internalQueryParallelCollectionScanMinRecords;
+
+// How many threads of the parallel collection scan pool may one query use at a time? Ranges past
+// this wait for one of the query's threads to finish or park.
+extern AtomicInt32 internalQueryParallelCollectionScanMaxThreadsPerQuery;
+
+// How many bytes of results may a range buffer? A range whose buffer is full gives its thread
+// back to the pool until the query has taken some of them.
+extern AtomicInt32 internalQueryParallelCollectionScanMaxBufferedBytes;
+
+// Do collection scans match documents against a filter compiled to dispatch on top-level field
+// names in one pass, rather than walking the expression tree?
+extern AtomicBool internalQueryCompileMatchExpressions;
+
+// Do $project and $addFields evaluate computed fields through bytecode compiled from their
+// expressions, rather than by walking the expression tree? Off by default: each evaluation copies
+// the register file, which may cost more than the bytecode saves on small expressions.
+extern AtomicBool internalQueryCompileAggregationExpressions;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -122,6 +164,28 @@ extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// The memory a localField/foreignField $lookup may use for the hash table of the foreign
+// collection. Beyond it the table spills to disk if allowDiskUse is set, and is otherwise dropped
+// in favour of one query per input document. 0 disables the hash join.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxMemoryBytes;
+
+// When the foreign collection has an index on foreignField, $lookup joins this many input documents
+// per foreign record with one query each before it builds a hash table.
+extern AtomicDouble internalDocumentSourceLookupHashJoinIndexedRatio;
+
+// Number of hash partitions a $group splits its groups into once it has to spill. Each spilled
+// partition keeps one temporary file open until it is read back.
+extern AtomicInt32 internalDocumentSourceGroupSpillPartitions;
+
+// How many RecordId ranges does a $group directly over an unindexed collection scan split the scan
+// into, building partial groups for each range on its own thread? 0 or 1 groups on the query's
+// own thread.
+extern AtomicInt32 internalDocumentSourceGroupParallelism;
+
+// Number of documents a $cursor stage reads into one column batch for a $group that consumes
+// batches through $match and $project stages. 0 passes one Document at a time.
+extern AtomicInt32 internalDocumentSourceColumnBatchSize;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 
 extern AtomicBool internalQueryStageMemUsageSwitch;  // NOLINT
@@ -129,4 +193,22 @@ extern AtomicBool internalQueryStageMemUsageSwitch;  // NOLINT
 extern AtomicInt64 internalQueryStageMemUsageMAX;  // NOLINT
 
 extern AtomicInt64 internalQueryStageMemUsageMIN;  // NOLINT
+
+extern AtomicInt64 internalQueryStageMemUsageOpMAX;  // NOLINT
+
+extern AtomicInt64 internalQueryStageMemUsageTenantMAX;  // NOLINT
+
+extern AtomicInt64 internalQueryStageMemReserveChunkBytes;  // NOLINT
+
+extern AtomicBool internalQueryStageMemSpillOnGlobalLimit;  // NOLINT
+
+extern AtomicInt64 internalQueryStageMemSpillBufferBytes;  // NOLINT
+
+extern AtomicInt32 internalQueryAdmissionMemoryPct;  // NOLINT
+
+extern AtomicInt32 internalQueryAdmissionMaxQueueDepth;  // NOLINT
+
+extern AtomicInt32 internalQueryAdmissionMaxWaitMS;  // NOLINT
+
+extern AtomicInt32 internalQueryExecBatchSize;  // NOLINT
 }  // namespace mongo
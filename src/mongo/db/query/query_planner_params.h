@@ -99,6 +99,10 @@ struct QueryPlannerParams {
 
         // Set this so that collection scans on the oplog wait for visibility before reading.
         OPLOG_SCAN_WAIT_FOR_VISIBLE = 1 << 13,
+
+        // Set this if a forward collection scan may be split into RecordId ranges scanned on
+        // other threads. Only for read-only plans.
+        PARALLEL_COLLSCAN = 1 << 14,
     };
 
     // See Options enum above.
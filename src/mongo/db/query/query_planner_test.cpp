@@ -1826,8 +1826,41 @@ TEST_F(QueryPlannerTest, TooManyToExplode) {
         "{sort: {pattern: {d: 1}, limit: 1, node: {sortKeyGen: "
         "{node: {cscan: {dir: 1}}}}}}");
     assertSolutionExists(
-        "{sort: {pattern: {d: 1}, limit: 1, node: {sortKeyGen: {node: "
-        "{fetch: {node: {ixscan: {pattern: {a: 1, b: 1, c:1, d:1}}}}}}}}}");
+        "{fetch: {filter: null, node: {sort: {pattern: {d: 1}, limit: 1, node: {sortKeyGen: "
+        "{node: {ixscan: {pattern: {a: 1, b: 1, c:1, d:1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, LimitedSortOnIndexKeysFetchesAboveSort) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {a: {$gt: 0}}, sort: {b: 1}, limit: 20}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: 1}, limit: 20, node: {sortKeyGen: "
+        "{node: {cscan: {dir: 1}}}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {sort: {pattern: {b: 1}, limit: 20, node: {sortKeyGen: "
+        "{node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, UnlimitedSortOnIndexKeysFetchesBelowSort) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {a: {$gt: 0}}, sort: {b: 1}}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: 1}, limit: 0, node: {sortKeyGen: "
+        "{node: {fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, LimitedSortOnFieldMissingFromIndexFetchesBelowSort) {
+    addIndex(BSON("a" << 1));
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {a: {$gt: 0}}, sort: {b: 1}, limit: 20}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: 1}, limit: 20, node: {sortKeyGen: "
+        "{node: {fetch: {filter: null, node: {ixscan: {pattern: {a: 1}}}}}}}}}");
 }
 
 TEST_F(QueryPlannerTest, CantExplodeMetaSort) {
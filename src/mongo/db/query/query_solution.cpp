@@ -249,6 +249,8 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->maxScan = this->maxScan;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
     copy->shouldWaitForOplogVisibility = this->shouldWaitForOplogVisibility;
+    copy->parallelAllowed = this->parallelAllowed;
+    copy->parallelOrdered = this->parallelOrdered;
 
     return copy;
 }
@@ -308,6 +308,13 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // Whether or not to wait for oplog visibility on oplog collection scans.
     bool shouldWaitForOplogVisibility = false;
+
+    // May the scan be split into ranges scanned on other threads? Whether it is depends on the
+    // collection, and is decided when the plan is built.
+    bool parallelAllowed = false;
+
+    // If split, must the records still come out in RecordId order?
+    bool parallelOrdered = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
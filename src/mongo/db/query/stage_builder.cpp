@@ -32,6 +32,8 @@
 
 #include "mongo/db/query/stage_builder.h"
 
+#include <cmath>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/index_catalog.h"
@@ -49,6 +51,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
@@ -57,6 +60,8 @@
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/query/index_cardinality_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
@@ -66,6 +71,13 @@ namespace mongo {
 using std::unique_ptr;
 using stdx::make_unique;
 
+namespace {
+
+// Above this many keys per value, a DISTINCT_SCAN seeks straight to the next value.
+const double kMaxKeysPerValueToStep = 8;
+
+}  // namespace
+
 PlanStage* buildStages(OperationContext* opCtx,
                        Collection* collection,
                        const CanonicalQuery& cq,
@@ -83,6 +95,13 @@ PlanStage* buildStages(OperationContext* opCtx,
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
             params.shouldWaitForOplogVisibility = csn->shouldWaitForOplogVisibility;
+            const size_t numRanges = internalQueryParallelCollectionScanThreads.load();
+            if (csn->parallelAllowed &&
+                ParallelCollectionScan::canScanInParallel(
+                    opCtx, collection, csn->filter.get(), numRanges)) {
+                return new ParallelCollectionScan(
+                    opCtx, collection, numRanges, csn->parallelOrdered, ws, csn->filter.get());
+            }
             return new CollectionScan(opCtx, params, ws, csn->filter.get());
         }
         case STAGE_IXSCAN: {
@@ -325,6 +344,14 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.direction = dn->direction;
             params.bounds = dn->bounds;
             params.fieldNo = dn->fieldNo;
+            // Statistics only describe the leading field. When its values average only a few
+            // keys each, step over them rather than seeking past every value.
+            if (dn->index.cardinalityStats && 0 == dn->fieldNo) {
+                const double keysPerValue = dn->index.cardinalityStats->estimateKeysPerValue();
+                if (keysPerValue > 0 && keysPerValue <= kMaxKeysPerValueToStep) {
+                    params.maxStepsBeforeSeek = static_cast<int>(std::ceil(keysPerValue)) + 1;
+                }
+            }
             return new DistinctScan(opCtx, params, ws);
         }
         case STAGE_COUNT_SCAN: {
@@ -101,7 +101,10 @@ struct ServerGlobalParams {
     bool isHttpInterfaceEnabled = false;  // True if the dbwebserver should be enabled.
     bool limitVerifyTimes = true;
     std::string auditLogpath;  // Path to audit log file, if logging to a file; otherwise, empty.
-    std::string auditLogFormat = "JSON";  // Format of audit log
+    std::string auditLogFormat = "JSON";  // Format of audit log: JSON, HWDDS or BSON
+    bool auditLogAsync = false;           // True if audit events are written by a writer thread.
+    int auditLogAsyncBufferSize = 65536;  // Capacity, in events, of the async audit queue.
+    std::string auditLogAsyncOverflowPolicy = "block";  // block|drop|spill when queue is full.
     std::string auditOpFilterStr;         // Filter ops that need to be audited, string format.
     std::map<std::string, std::string>
         auditNsFilterMap;  // Filter namespace and op that need to be audited, map format.
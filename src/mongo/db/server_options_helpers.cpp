@@ -46,6 +46,7 @@
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/config.h"
+#include "mongo/db/audit_ns_filter.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/logger/log_component.h"
@@ -248,7 +249,28 @@ Status addBaseServerOptions(moe::OptionSection* options) {
 
     options
         ->addOptionChaining(
-            "auditLog.format", "", moe::String, "Desired audit log format, JSON or HWDDS")
+            "auditLog.format", "", moe::String, "Desired audit log format, JSON, HWDDS or BSON")
+        .setSources(moe::SourceYAMLConfig);
+
+    options
+        ->addOptionChaining("auditLog.async",
+                            "",
+                            moe::Bool,
+                            "encode and write audit events on a dedicated writer thread")
+        .setSources(moe::SourceYAMLConfig);
+
+    options
+        ->addOptionChaining("auditLog.asyncBufferSize",
+                            "",
+                            moe::Int,
+                            "number of audit events the async writer queue can hold")
+        .setSources(moe::SourceYAMLConfig);
+
+    options
+        ->addOptionChaining("auditLog.asyncOverflowPolicy",
+                            "",
+                            moe::String,
+                            "what to do when the async audit queue is full: block, drop or spill")
         .setSources(moe::SourceYAMLConfig);
 
     options
@@ -655,10 +677,38 @@ Status storeBaseOptions(const moe::Environment& params) {
     if (params.count("auditLog.format")) {
         serverGlobalParams.auditLogFormat = params["auditLog.format"].as<std::string>();
         if (serverGlobalParams.auditLogFormat != "JSON" &&
-            serverGlobalParams.auditLogFormat != "HWDDS") {
+            serverGlobalParams.auditLogFormat != "HWDDS" &&
+            serverGlobalParams.auditLogFormat != "BSON") {
             StringBuilder sb;
-            sb << "Value of auditLogFormat must be one of JSON "
-               << "or HWDDS; not \"" << serverGlobalParams.auditLogFormat << "\".";
+            sb << "Value of auditLogFormat must be one of JSON, "
+               << "HWDDS or BSON; not \"" << serverGlobalParams.auditLogFormat << "\".";
+            return Status(ErrorCodes::BadValue, sb.str());
+        }
+    }
+
+    if (params.count("auditLog.async")) {
+        serverGlobalParams.auditLogAsync = params["auditLog.async"].as<bool>();
+    }
+
+    if (params.count("auditLog.asyncBufferSize")) {
+        serverGlobalParams.auditLogAsyncBufferSize = params["auditLog.asyncBufferSize"].as<int>();
+        if (serverGlobalParams.auditLogAsyncBufferSize <= 0) {
+            StringBuilder sb;
+            sb << "Value of auditLog.asyncBufferSize must be positive; not "
+               << serverGlobalParams.auditLogAsyncBufferSize << ".";
+            return Status(ErrorCodes::BadValue, sb.str());
+        }
+    }
+
+    if (params.count("auditLog.asyncOverflowPolicy")) {
+        serverGlobalParams.auditLogAsyncOverflowPolicy =
+            params["auditLog.asyncOverflowPolicy"].as<std::string>();
+        if (serverGlobalParams.auditLogAsyncOverflowPolicy != "block" &&
+            serverGlobalParams.auditLogAsyncOverflowPolicy != "drop" &&
+            serverGlobalParams.auditLogAsyncOverflowPolicy != "spill") {
+            StringBuilder sb;
+            sb << "Value of auditLog.asyncOverflowPolicy must be one of block, drop "
+               << "or spill; not \"" << serverGlobalParams.auditLogAsyncOverflowPolicy << "\".";
             return Status(ErrorCodes::BadValue, sb.str());
         }
     }
@@ -773,6 +823,7 @@ bool parseAuditNsFilter(const std::map<std::string, std::string>& auditNsFilterM
             return false;
         }
     }
+    AuditNsFilter::OpNsMap opNsFilterMap;
     for (auto& opType : logger::auditOpList) {
         if (opType == "all") {
             continue;
@@ -787,9 +838,14 @@ bool parseAuditNsFilter(const std::map<std::string, std::string>& auditNsFilterM
         for (auto& ns : tmpSet) {
             nsIsDBMap.insert({ns, ns.find(".") == std::string::npos ? true : false});
         }
-        serverGlobalParams.auditOpNsFilterMap.insert({opType, nsIsDBMap});
+        opNsFilterMap.insert({opType, nsIsDBMap});
         tmpSet.clear();
     }
+
+    // Readers never look at auditOpNsFilterMap; they use the compiled filter, which is swapped
+    // in atomically so that a reload racing with audited operations is safe.
+    publishAuditNsFilter(opNsFilterMap);
+    serverGlobalParams.auditOpNsFilterMap = std::move(opNsFilterMap);
     return true;
 }
 
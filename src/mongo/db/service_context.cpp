@@ -191,6 +191,16 @@ transport::ServiceExecutor* ServiceContext::getServiceExecutor() const {
     return _serviceExecutor.get();
 }
 
+transport::ServiceExecutor* ServiceContext::getAdminServiceExecutor() const {
+    if (_adminServiceExecutor)
+        return _adminServiceExecutor.get();
+    return _serviceExecutor.get();
+}
+
+bool ServiceContext::hasAdminServiceExecutor() const {
+    return static_cast<bool>(_adminServiceExecutor);
+}
+
 void ServiceContext::setStorageEngine(std::unique_ptr<StorageEngine> engine) {
     invariant(engine);
     invariant(!_storageEngine);
@@ -225,6 +235,10 @@ void ServiceContext::setServiceExecutor(std::unique_ptr<transport::ServiceExecut
     _serviceExecutor = std::move(exec);
 }
 
+void ServiceContext::setAdminServiceExecutor(std::unique_ptr<transport::ServiceExecutor> exec) {
+    _adminServiceExecutor = std::move(exec);
+}
+
 void ServiceContext::ClientDeleter::operator()(Client* client) const {
     ServiceContext* const service = client->getServiceContext();
     {
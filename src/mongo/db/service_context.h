@@ -417,6 +417,19 @@ public:
      */
     transport::ServiceExecutor* getServiceExecutor() const;
 
+    /**
+     * Get the service executor that runs sessions from the admin whitelist.
+     *
+     * Falls back to getServiceExecutor() when no dedicated admin executor has been registered,
+     * so callers never need to special-case configurations without one.
+     */
+    transport::ServiceExecutor* getAdminServiceExecutor() const;
+
+    /**
+     * Returns true if a dedicated admin service executor has been registered.
+     */
+    bool hasAdminServiceExecutor() const;
+
     /**
      * Waits for the ServiceContext to be fully initialized and for all TransportLayers to have been
      * added/started.
@@ -501,6 +514,11 @@ public:
      */
     void setServiceExecutor(std::unique_ptr<transport::ServiceExecutor> exec);
 
+    /**
+     * Binds the service executor for admin whitelist sessions to the service context
+     */
+    void setAdminServiceExecutor(std::unique_ptr<transport::ServiceExecutor> exec);
+
 private:
     class ClientObserverHolder {
     public:
@@ -550,6 +568,11 @@ private:
      */
     std::unique_ptr<transport::ServiceExecutor> _serviceExecutor;
 
+    /**
+     * The ServiceExecutor for admin whitelist sessions, may be null
+     */
+    std::unique_ptr<transport::ServiceExecutor> _adminServiceExecutor;
+
     /**
      * Vector of registered observers.
      */
@@ -439,6 +439,9 @@ public:
     size_t memUsed() const {
         return _memUsed;
     }
+    uint64_t spilledBytes() const {
+        return _spilledBytes;
+    }
 
 private:
     class STLComparator {
@@ -487,6 +490,7 @@ private:
         }
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        _spilledBytes += writer.bytesWritten();
 
         _memUsed = 0;
     }
@@ -495,6 +499,7 @@ private:
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
+    uint64_t _spilledBytes = 0;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
 };
@@ -541,6 +546,9 @@ public:
     size_t memUsed() const {
         return _best.first.memUsageForSorter() + _best.second.memUsageForSorter();
     }
+    uint64_t spilledBytes() const {
+        return 0;
+    }
 
 private:
     const Comparator _comp;
@@ -638,6 +646,9 @@ public:
     size_t memUsed() const {
         return _memUsed;
     }
+    uint64_t spilledBytes() const {
+        return _spilledBytes;
+    }
 
 private:
     class STLComparator {
@@ -772,6 +783,7 @@ private:
         std::vector<Data>().swap(_data);
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        _spilledBytes += writer.bytesWritten();
 
         _memUsed = 0;
     }
@@ -780,6 +792,7 @@ private:
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
+    uint64_t _spilledBytes = 0;
     std::vector<Data> _data;  // the "current" data. Organized as max-heap if size == limit.
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
 
@@ -889,6 +902,7 @@ void SortedFileWriter<Key, Value>::spill() {
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
         _file.write(outBuffer, std::abs(size));
+        _bytesWritten += sizeof(size) + std::abs(size);
 
     } catch (const std::exception&) {
         msgasserted(16821,
@@ -175,6 +175,7 @@ public:
     // TEMP these are here for compatibility. Will be replaced with a general stats API
     virtual int numFiles() const = 0;
     virtual size_t memUsed() const = 0;
+    virtual uint64_t spilledBytes() const = 0;
 
 protected:
     Sorter() {}  // can only be constructed as a base
@@ -196,6 +197,11 @@ public:
     void addAlreadySorted(const Key&, const Value&);
     Iterator* done();  /// Can't add more data after calling done()
 
+    /// Bytes written to the file so far, after compression.
+    uint64_t bytesWritten() const {
+        return _bytesWritten;
+    }
+
 private:
     void spill();
 
@@ -204,6 +210,7 @@ private:
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
     BufBuilder _buffer;
+    uint64_t _bytesWritten = 0;
 };
 }
 
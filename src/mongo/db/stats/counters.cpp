@@ -33,6 +33,8 @@
 
 #include "mongo/db/stats/counters.h"
 
+#include <vector>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
@@ -160,6 +162,21 @@ void NetworkCounter::hitPhysicalOut(long long bytes) {
     }
 }
 
+void NetworkCounter::hitPhysicalWrite(long long messages) {
+    static const int64_t MAX = 1ULL << 60;
+
+    // don't care about the race as its just a counter
+    const bool overflow = _physicalWrites.messages.loadRelaxed() > MAX;
+
+    if (overflow) {
+        _physicalWrites.messages.store(messages);
+        _physicalWrites.writes.store(1);
+    } else {
+        _physicalWrites.messages.fetchAndAdd(messages);
+        _physicalWrites.writes.fetchAndAdd(1);
+    }
+}
+
 void NetworkCounter::hitLogicalIn(long long bytes) {
     static const int64_t MAX = 1ULL << 60;
 
@@ -197,6 +214,14 @@ void NetworkCounter::append(BSONObjBuilder& b) {
     b.append("physicalBytesIn", static_cast<long long>(_physicalBytesIn.loadRelaxed()));
     b.append("physicalBytesOut", static_cast<long long>(_physicalBytesOut.loadRelaxed()));
     b.append("numRequests", static_cast<long long>(_together.requests.loadRelaxed()));
+
+    const auto writes = static_cast<long long>(_physicalWrites.writes.loadRelaxed());
+    const auto messages = static_cast<long long>(_physicalWrites.messages.loadRelaxed());
+    BSONObjBuilder sendBuilder(b.subobjStart("sendCoalescing"));
+    sendBuilder.append("writes", writes);
+    sendBuilder.append("messages", messages);
+    sendBuilder.append("writesPerMessage", messages ? double(writes) / messages : 0.0);
+    sendBuilder.done();
 }
 
 
@@ -225,6 +250,7 @@ const StringData stageName[] = {
     "MultiPlanStage",           /// STAGE_MULTI_PLAN,
     "OplogStart",               /// STAGE_OPLOG_START,
     "OrStage",                  /// STAGE_OR,
+    "ParallelCollectionScan",   /// STAGE_PARALLEL_COLLSCAN,
     "ProjectionStage",          /// STAGE_PROJECTION,
     "PipelineProxyStage",       /// STAGE_PIPELINE_PROXY,
     "QueuedDataStage",          /// STAGE_QUEUED_DATA,
@@ -252,36 +278,168 @@ BSONObj StageMemCounter::getObj() const {
         BSONObjBuilder sub;
         sub.append("objectCount", _stageMap[i]._objectCount.get());
         sub.append("StageMem", _stageMap[i]._memSize.get());
+        sub.append("spills", _stageMap[i]._spills.get());
+        sub.append("spilledBytes", _stageMap[i]._spilledBytes.get());
         b.append(stageName[i], sub.obj());
     }
+    {
+        BSONObjBuilder sub(b.subobjStart("GroupStage"));
+        sub.append("StageMem", _groupCounter._memSize.get());
+        sub.append("spills", _groupCounter._spills.get());
+        sub.append("spilledBytes", _groupCounter._spilledBytes.get());
+    }
+    {
+        BSONObjBuilder sub(b.subobjStart("LookupStage"));
+        sub.append("StageMem", _lookupCounter._memSize.get());
+    }
+    {
+        BSONObjBuilder sub(b.subobjStart("rejected"));
+        sub.append("operation", _rejectedByOperation.get());
+        sub.append("tenant", _rejectedByTenant.get());
+        sub.append("global", _rejectedByGlobal.get());
+    }
+    {
+        // The references are dropped after '_tenantsMutex' is released, since dropping the last
+        // one takes the mutex.
+        std::vector<std::shared_ptr<TenantStageMemCounter>> tenants;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tenantsMutex);
+            for (const auto& entry : _tenants) {
+                if (auto tenant = entry.second.lock()) {
+                    tenants.push_back(std::move(tenant));
+                }
+            }
+        }
+
+        BSONObjBuilder sub(b.subobjStart("tenants"));
+        for (const auto& tenant : tenants) {
+            if (tenant->getReservedMemSize() == 0 && tenant->getRejectedCount() == 0) {
+                continue;
+            }
+            BSONObjBuilder tenantBuilder(sub.subobjStart(tenant->getDB()));
+            tenantBuilder.append("StageMem", tenant->getReservedMemSize());
+            tenantBuilder.append("rejected", tenant->getRejectedCount());
+        }
+    }
     return b.obj();
 }
 
-void StageMemCounter::incCachedMemSize(const StageType& type, const size_t& size) {
-    _totalMem.increment(size);
-    _stageMap[type]._memSize.increment(size);
+void StageMemCounter::reserveMemSize(const StageType& type, int64_t size) {
+    if (size >= 0) {
+        _totalMem.increment(size);
+        _stageMap[type]._memSize.increment(size);
+    } else {
+        _totalMem.decrement(-size);
+        _stageMap[type]._memSize.decrement(-size);
+    }
 }
 
-void StageMemCounter::incMemObj(const StageType& type) {
-    _stageMap[type]._objectCount.increment();
+void StageMemCounter::reserveGroupMemSize(int64_t size) {
+    if (size >= 0) {
+        _totalMem.increment(size);
+        _groupCounter._memSize.increment(size);
+    } else {
+        _totalMem.decrement(-size);
+        _groupCounter._memSize.decrement(-size);
+    }
+}
+
+void StageMemCounter::reserveLookupMemSize(int64_t size) {
+    if (size >= 0) {
+        _totalMem.increment(size);
+        _lookupCounter._memSize.increment(size);
+    } else {
+        _totalMem.decrement(-size);
+        _lookupCounter._memSize.decrement(-size);
+    }
 }
 
-void StageMemCounter::decCachedMemSize(const StageType& type, const size_t& size) {
-    _totalMem.decrement(size);
-    _stageMap[type]._memSize.decrement(size);
+void StageMemCounter::noteSpill(const StageType& type, uint64_t bytes) {
+    _stageMap[type]._spills.increment();
+    _stageMap[type]._spilledBytes.increment(bytes);
+}
+
+void StageMemCounter::noteGroupSpill(uint64_t bytes) {
+    _groupCounter._spills.increment();
+    _groupCounter._spilledBytes.increment(bytes);
+}
+
+void StageMemCounter::incMemObj(const StageType& type) {
+    _stageMap[type]._objectCount.increment();
 }
 
 void StageMemCounter::decMemObj(const StageType& type) {
     _stageMap[type]._objectCount.decrement();
 }
 
-bool StageMemCounter::chkCachedMemOversize(const size_t& cachedMemSize) const {
-    if (internalQueryStageMemUsageSwitch.load() &&
-        (cachedMemSize > static_cast<size_t>(internalQueryStageMemUsageMIN.load())) &&
-        (_totalMem.get() > static_cast<int64_t>(internalQueryStageMemUsageMAX.load()))) {
-        return true;
+StageMemCounter::LimitLevel StageMemCounter::chkCachedMemOversize(
+    const size_t& cachedMemSize,
+    const OperationStageMemCounter* op,
+    const TenantStageMemCounter* tenant) const {
+    if (!internalQueryStageMemUsageSwitch.load() ||
+        (cachedMemSize <= static_cast<size_t>(internalQueryStageMemUsageMIN.load()))) {
+        return LimitLevel::kNone;
+    }
+
+    // A limit of 0 disables the operation and tenant levels.
+    const int64_t opMax = internalQueryStageMemUsageOpMAX.load();
+    if (op && opMax > 0 && op->getReservedMemSize() > opMax) {
+        return LimitLevel::kOperation;
+    }
+    const int64_t tenantMax = internalQueryStageMemUsageTenantMAX.load();
+    if (tenant && tenantMax > 0 && tenant->getReservedMemSize() > tenantMax) {
+        return LimitLevel::kTenant;
+    }
+    if (_totalMem.get() > static_cast<int64_t>(internalQueryStageMemUsageMAX.load())) {
+        return LimitLevel::kGlobal;
+    }
+    return LimitLevel::kNone;
+}
+
+void StageMemCounter::noteRejected(LimitLevel level, TenantStageMemCounter* tenant) {
+    switch (level) {
+        case LimitLevel::kOperation:
+            _rejectedByOperation.increment();
+            break;
+        case LimitLevel::kTenant:
+            _rejectedByTenant.increment();
+            break;
+        case LimitLevel::kGlobal:
+            _rejectedByGlobal.increment();
+            break;
+        case LimitLevel::kNone:
+            return;
+    }
+    if (tenant) {
+        tenant->noteRejected();
+    }
+}
+
+std::shared_ptr<TenantStageMemCounter> StageMemCounter::getTenantCounter(StringData db) {
+    if (db.empty()) {
+        return nullptr;
+    }
+    stdx::lock_guard<stdx::mutex> lk(_tenantsMutex);
+    auto& entry = _tenants[db];
+    auto tenant = entry.lock();
+    if (!tenant) {
+        tenant = std::shared_ptr<TenantStageMemCounter>(
+            new TenantStageMemCounter(db.toString()), [this](TenantStageMemCounter* expired) {
+                _forgetTenant(expired);
+                delete expired;
+            });
+        entry = tenant;
+    }
+    return tenant;
+}
+
+void StageMemCounter::_forgetTenant(const TenantStageMemCounter* tenant) {
+    stdx::lock_guard<stdx::mutex> lk(_tenantsMutex);
+    auto it = _tenants.find(tenant->getDB());
+    // getTenantCounter() may already have replaced the entry with a new counter.
+    if (it != _tenants.end() && it->second.expired()) {
+        _tenants.erase(it);
     }
-    return false;
 }
 
 OpCounters globalOpCounters;
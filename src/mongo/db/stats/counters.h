@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -37,8 +40,10 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/basic.h"
 #include "mongo/rpc/message.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/processinfo.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/with_alignment.h"
 
 namespace mongo {
@@ -102,6 +107,10 @@ public:
     void hitPhysicalIn(long long bytes);
     void hitPhysicalOut(long long bytes);
 
+    // Increment the counters for a single write handed to the socket, which may carry several
+    // coalesced messages
+    void hitPhysicalWrite(long long messages);
+
     // Increment the counters for the number of bytes passed out of the TransportLayer to the
     // server
     void hitLogicalIn(long long bytes);
@@ -124,27 +133,140 @@ private:
                   "cache line spill");
 
     CacheAligned<AtomicInt64> _logicalBytesOut{0};
+
+    // Also always incremented together.
+    struct Writes {
+        AtomicInt64 writes{0};
+        AtomicInt64 messages{0};
+    };
+    CacheAligned<Writes> _physicalWrites{};
 };
 
 extern NetworkCounter networkCounter;
 
+/// OOM feature
+// Stage memory reserved on behalf of one database. Shared by every operation on that database, so
+// it is only touched when a stage grows or shrinks its reservation, never per allocation.
+class TenantStageMemCounter {
+public:
+    explicit TenantStageMemCounter(std::string db) : _db(std::move(db)) {}
+
+    const std::string& getDB() const {
+        return _db;
+    }
+
+    void reserve(int64_t size) {
+        _reservedMem.fetchAndAdd(size);
+    }
+    int64_t getReservedMemSize() const {
+        return _reservedMem.load();
+    }
+
+    void noteRejected() {
+        _rejected.fetchAndAdd(1);
+    }
+    int64_t getRejectedCount() const {
+        return _rejected.load();
+    }
+
+private:
+    const std::string _db;
+    CacheAligned<AtomicInt64> _reservedMem{0};
+    AtomicInt64 _rejected{0};
+};
+
+/// OOM feature
+// Stage memory reserved by the plan stages attached to one operation. Besides the thread running
+// the operation, multi-planner trial threads and parallel collection scan threads reserve against
+// it concurrently.
+class OperationStageMemCounter {
+public:
+    explicit OperationStageMemCounter(std::shared_ptr<TenantStageMemCounter> tenant)
+        : _tenant(std::move(tenant)) {}
+
+    /**
+     * The database the operation runs against, or null if it has none.
+     */
+    const std::shared_ptr<TenantStageMemCounter>& getTenant() const {
+        return _tenant;
+    }
+
+    void reserve(int64_t size) {
+        _reservedMem.fetchAndAdd(size);
+    }
+    int64_t getReservedMemSize() const {
+        return _reservedMem.load();
+    }
+
+private:
+    const std::shared_ptr<TenantStageMemCounter> _tenant;
+    AtomicInt64 _reservedMem{0};
+};
+
+/// OOM feature
+// Which level of the stage memory limits is exceeded. See StageMemCounter.
+enum class StageMemLimitLevel { kNone, kOperation, kTenant, kGlobal };
+
 // Provide a memory usage limitation for the stage object.
+//
+// Memory is governed at three levels: the operation, the database it runs against, and the whole
+// process, limited by internalQueryStageMemUsageOpMAX, internalQueryStageMemUsageTenantMAX and
+// internalQueryStageMemUsageMAX respectively. A PlanStage counts its own memory exactly and
+// charges it to all three levels as a reservation that grows or shrinks in chunks of up to
+// internalQueryStageMemReserveChunkBytes, so the shared counters below move once per chunk
+// rather than once per cached record.
 class StageMemCounter {
 public:
+    using LimitLevel = StageMemLimitLevel;
+
     StageMemCounter() {}
     ~StageMemCounter() {}
 
-    void incCachedMemSize(const StageType& type, const size_t& size);
-    void decCachedMemSize(const StageType& type, const size_t& size);
+    /**
+     * Moves "size" bytes (negative to release) of reservation for a stage of type "type".
+     */
+    void reserveMemSize(const StageType& type, int64_t size);
 
     void incMemObj(const StageType& type);
     void decMemObj(const StageType& type);
 
-    bool chkCachedMemOversize(const size_t& cachedMemSize) const;
+    /**
+     * Records that a stage of type "type" spilled "bytes" bytes to disk after hitting the global
+     * limit.
+     */
+    void noteSpill(const StageType& type, uint64_t bytes);
+
+    /**
+     * Accounting for $group, which is not a PlanStage but competes for the same memory.
+     */
+    void reserveGroupMemSize(int64_t size);
+    void noteGroupSpill(uint64_t bytes);
+
+    /**
+     * Accounting for the hash table of a $lookup hash join, likewise.
+     */
+    void reserveLookupMemSize(int64_t size);
+
+    /**
+     * Returns the innermost level whose limit is exceeded, or kNone. A stage holding no more than
+     * internalQueryStageMemUsageMIN bytes is never over the limit. "op" and "tenant" may be null.
+     */
+    LimitLevel chkCachedMemOversize(const size_t& cachedMemSize,
+                                    const OperationStageMemCounter* op,
+                                    const TenantStageMemCounter* tenant) const;
+    void noteRejected(LimitLevel level, TenantStageMemCounter* tenant);
+
     int64_t getTotalMemSize() const {
         return _totalMem.get();
     };
 
+    /**
+     * Returns the shared counter for "db", creating it if no one holds it. Returns null for an
+     * empty database name. A counter is forgotten, along with its rejection count, once the last
+     * reference to it is released; by then all of its reservations have been released too.
+     */
+    std::shared_ptr<TenantStageMemCounter> getTenantCounter(StringData db);
+
     BSONObj getObj() const;
 
 private:
@@ -153,8 +275,24 @@ private:
     struct StageTypeCounter {
         Counter64 _objectCount;
         Counter64 _memSize;
+        Counter64 _spills;
+        Counter64 _spilledBytes;
     };
     StageTypeCounter _stageMap[STAGE_INVALID];
+    StageTypeCounter _groupCounter;
+    StageTypeCounter _lookupCounter;
+
+    Counter64 _rejectedByOperation;
+    Counter64 _rejectedByTenant;
+    Counter64 _rejectedByGlobal;
+
+    /**
+     * Called as the last reference to "tenant" is released.
+     */
+    void _forgetTenant(const TenantStageMemCounter* tenant);
+
+    mutable stdx::mutex _tenantsMutex;
+    StringMap<std::weak_ptr<TenantStageMemCounter>> _tenants;
 };
 
 extern StageMemCounter globalStageMemCounters;
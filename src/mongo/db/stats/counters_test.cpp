@@ -0,0 +1,184 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/counters.h"
+
+#include <vector>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using LimitLevel = StageMemCounter::LimitLevel;
+
+class StageMemCounterTest : public unittest::Test {
+protected:
+    void setUp() override {
+        _savedSwitch = internalQueryStageMemUsageSwitch.load();
+        _savedMax = internalQueryStageMemUsageMAX.load();
+        _savedMin = internalQueryStageMemUsageMIN.load();
+        _savedOpMax = internalQueryStageMemUsageOpMAX.load();
+        _savedTenantMax = internalQueryStageMemUsageTenantMAX.load();
+
+        internalQueryStageMemUsageSwitch.store(true);
+        internalQueryStageMemUsageMAX.store(1000);
+        internalQueryStageMemUsageMIN.store(10);
+        internalQueryStageMemUsageOpMAX.store(0);
+        internalQueryStageMemUsageTenantMAX.store(0);
+    }
+
+    void tearDown() override {
+        internalQueryStageMemUsageSwitch.store(_savedSwitch);
+        internalQueryStageMemUsageMAX.store(_savedMax);
+        internalQueryStageMemUsageMIN.store(_savedMin);
+        internalQueryStageMemUsageOpMAX.store(_savedOpMax);
+        internalQueryStageMemUsageTenantMAX.store(_savedTenantMax);
+    }
+
+    StageMemCounter _counter;
+
+private:
+    bool _savedSwitch;
+    long long _savedMax;
+    long long _savedMin;
+    long long _savedOpMax;
+    long long _savedTenantMax;
+};
+
+TEST_F(StageMemCounterTest, GlobalLimit) {
+    _counter.reserveMemSize(STAGE_SORT, 1001);
+    ASSERT(LimitLevel::kGlobal == _counter.chkCachedMemOversize(11, nullptr, nullptr));
+
+    // Stages at or below internalQueryStageMemUsageMIN are never failed.
+    ASSERT(LimitLevel::kNone == _counter.chkCachedMemOversize(10, nullptr, nullptr));
+
+    _counter.reserveMemSize(STAGE_SORT, -2);
+    ASSERT_EQ(999, _counter.getTotalMemSize());
+    ASSERT(LimitLevel::kNone == _counter.chkCachedMemOversize(11, nullptr, nullptr));
+}
+
+TEST_F(StageMemCounterTest, SwitchOffDisablesAllLevels) {
+    internalQueryStageMemUsageSwitch.store(false);
+    internalQueryStageMemUsageOpMAX.store(1);
+    auto tenant = _counter.getTenantCounter("test");
+    OperationStageMemCounter op(tenant);
+    op.reserve(2000);
+    _counter.reserveMemSize(STAGE_SORT, 2000);
+    ASSERT(LimitLevel::kNone == _counter.chkCachedMemOversize(2000, &op, tenant.get()));
+}
+
+TEST_F(StageMemCounterTest, TenantLimitOnlyAffectsThatTenant) {
+    internalQueryStageMemUsageTenantMAX.store(500);
+    auto noisy = _counter.getTenantCounter("noisy");
+    auto quiet = _counter.getTenantCounter("quiet");
+    ASSERT(noisy != quiet);
+    ASSERT(noisy == _counter.getTenantCounter("noisy"));
+
+    noisy->reserve(600);
+    quiet->reserve(100);
+    _counter.reserveMemSize(STAGE_AND_HASH, 700);
+
+    ASSERT(LimitLevel::kTenant == _counter.chkCachedMemOversize(600, nullptr, noisy.get()));
+    ASSERT(LimitLevel::kNone == _counter.chkCachedMemOversize(100, nullptr, quiet.get()));
+
+    _counter.noteRejected(LimitLevel::kTenant, noisy.get());
+    ASSERT_EQ(1, noisy->getRejectedCount());
+    ASSERT_EQ(0, quiet->getRejectedCount());
+}
+
+TEST_F(StageMemCounterTest, OperationLimitIsCheckedFirst) {
+    internalQueryStageMemUsageOpMAX.store(100);
+    internalQueryStageMemUsageTenantMAX.store(100);
+    auto tenant = _counter.getTenantCounter("test");
+    OperationStageMemCounter op(tenant);
+    ASSERT(tenant == op.getTenant());
+
+    op.reserve(2000);
+    tenant->reserve(2000);
+    _counter.reserveMemSize(STAGE_SORT, 2000);
+    ASSERT(LimitLevel::kOperation == _counter.chkCachedMemOversize(2000, &op, tenant.get()));
+    ASSERT(LimitLevel::kTenant == _counter.chkCachedMemOversize(2000, nullptr, tenant.get()));
+    ASSERT(LimitLevel::kGlobal == _counter.chkCachedMemOversize(2000, nullptr, nullptr));
+}
+
+TEST_F(StageMemCounterTest, NoTenantForEmptyDatabase) {
+    ASSERT(nullptr == _counter.getTenantCounter(""));
+}
+
+TEST_F(StageMemCounterTest, ReportsTenantsAndRejections) {
+    auto tenant = _counter.getTenantCounter("test");
+    tenant->reserve(64);
+    _counter.getTenantCounter("idle");
+    _counter.reserveMemSize(STAGE_SORT, 64);
+    _counter.noteRejected(LimitLevel::kGlobal, tenant.get());
+
+    BSONObj obj = _counter.getObj();
+    ASSERT_EQ(64, obj["Total Stage Memory"].numberLong());
+    ASSERT_EQ(64, obj["SortStage"]["StageMem"].numberLong());
+    ASSERT_EQ(1, obj["rejected"]["global"].numberLong());
+    ASSERT_EQ(64, obj["tenants"]["test"]["StageMem"].numberLong());
+    ASSERT_EQ(1, obj["tenants"]["test"]["rejected"].numberLong());
+    ASSERT(obj["tenants"]["idle"].eoo());
+}
+
+TEST_F(StageMemCounterTest, ForgetsTenantsNoOneHolds) {
+    std::weak_ptr<TenantStageMemCounter> released = _counter.getTenantCounter("released");
+    ASSERT(released.expired());
+
+    auto held = _counter.getTenantCounter("held");
+    held->noteRejected();
+    ASSERT(held == _counter.getTenantCounter("held"));
+    ASSERT_EQ(1, _counter.getObj()["tenants"]["held"]["rejected"].numberLong());
+
+    held.reset();
+    ASSERT(_counter.getObj()["tenants"]["held"].eoo());
+    ASSERT_EQ(0, _counter.getTenantCounter("held")->getRejectedCount());
+}
+
+TEST_F(StageMemCounterTest, ConcurrentOperationReservationsAreNotLost) {
+    OperationStageMemCounter op(nullptr);
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 100000; ++j) {
+                op.reserve(1);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(400000, op.getReservedMemSize());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -346,7 +346,11 @@ void KeyString::_appendAllElementsForIndexing(const BSONObj& obj,
         const int elemIdx = elemCount++;
         const bool invert = (ord.get(elemIdx) == -1);
 
-        _appendBsonValue(elem, invert, NULL);
+        const bool appended =
+            invert ? _appendCommonValue<true>(elem) : _appendCommonValue<false>(elem);
+        if (!appended) {
+            _appendBsonValue(elem, invert, NULL);
+        }
 
         dassert(elem.fieldNameSize() < 3);  // fieldNameSize includes the NUL
 
@@ -1059,6 +1063,103 @@ void KeyString::_appendPreshiftedIntegerPortion(uint64_t value, bool isNegative,
     }
 }
 
+// Fast paths for the values most index keys are made of. Each writes its bytes with a single
+// reservation in the buffer and produces exactly the bytes of the generic path. 'Invert' is
+// chosen per key field from the index Ordering.
+
+namespace {
+template <bool Invert>
+char ctypeByte(uint8_t ctype) {
+    return Invert ? ~ctype : ctype;
+}
+
+template <bool Invert>
+void copyBytes(char* dst, const void* src, size_t bytes) {
+    if (Invert) {
+        memcpy_flipBits(dst, src, bytes);
+    } else {
+        memcpy(dst, src, bytes);
+    }
+}
+}  // namespace
+
+template <bool Invert>
+bool KeyString::_appendCommonValue(const BSONElement& elem) {
+    switch (elem.type()) {
+        case NumberInt:
+            _typeBits.appendNumberInt();
+            _appendIntegerFast<Invert>(elem._numberInt());
+            return true;
+
+        case NumberLong: {
+            const long long num = elem._numberLong();
+            if (num == std::numeric_limits<long long>::min()) {
+                return false;  // Encoded as a double.
+            }
+            _typeBits.appendNumberLong();
+            _appendIntegerFast<Invert>(num);
+            return true;
+        }
+
+        case jstOID: {
+            char* const out = _buffer.skip(1 + OID::kOIDSize);
+            out[0] = ctypeByte<Invert>(CType::kOID);
+            copyBytes<Invert>(out + 1, elem.value(), OID::kOIDSize);
+            return true;
+        }
+
+        case Date: {
+            uint64_t encoded = static_cast<uint64_t>(elem.date().asInt64());
+            encoded = endian::nativeToBig(encoded ^ (1ULL << 63));
+            char* const out = _buffer.skip(1 + sizeof(encoded));
+            out[0] = ctypeByte<Invert>(CType::kDate);
+            copyBytes<Invert>(out + 1, &encoded, sizeof(encoded));
+            return true;
+        }
+
+        case String: {
+            const StringData str = elem.valueStringData();
+            if (memchr(str.rawData(), 0, str.size())) {
+                return false;  // NUL bytes need escaping.
+            }
+            _typeBits.appendString();
+            char* const out = _buffer.skip(str.size() + 2);
+            out[0] = ctypeByte<Invert>(CType::kStringLike);
+            copyBytes<Invert>(out + 1, str.rawData(), str.size());
+            out[str.size() + 1] = ctypeByte<Invert>(0);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+template <bool Invert>
+void KeyString::_appendIntegerFast(long long num) {
+    dassert(num != std::numeric_limits<long long>::min());
+    if (num == 0) {
+        *_buffer.skip(1) = ctypeByte<Invert>(CType::kNumericZero);
+        return;
+    }
+
+    const bool isNegative = num < 0;
+    const uint64_t value = static_cast<uint64_t>(isNegative ? -num : num) << 1;
+    const size_t bytesNeeded = (64 - countLeadingZeros64(value) + 7) / 8;
+    const uint64_t bigEndian = endian::nativeToBig(value);
+    const char* const firstUsedByte =
+        reinterpret_cast<const char*>(&bigEndian + 1) - bytesNeeded;
+
+    char* const out = _buffer.skip(1 + bytesNeeded);
+    if (isNegative) {
+        out[0] = ctypeByte<Invert>(CType::kNumericNegative1ByteInt - (bytesNeeded - 1));
+        copyBytes<!Invert>(out + 1, firstUsedByte, bytesNeeded);
+    } else {
+        out[0] = ctypeByte<Invert>(CType::kNumericPositive1ByteInt + (bytesNeeded - 1));
+        copyBytes<Invert>(out + 1, firstUsedByte, bytesNeeded);
+    }
+}
+
 template <typename T>
 void KeyString::_append(const T& thing, bool invert) {
     _appendBytes(&thing, sizeof(thing), invert);
@@ -2110,6 +2211,16 @@ int KeyString::compare(const KeyString& other) const {
 
     int min = std::min(a, b);
 
+    // Keys mostly differ within their first word, which one big-endian load compares without a
+    // call into memcmp.
+    if (min >= 8) {
+        const uint64_t x = ConstDataView(getBuffer()).read<BigEndian<uint64_t>>();
+        const uint64_t y = ConstDataView(other.getBuffer()).read<BigEndian<uint64_t>>();
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+
     int cmp = memcmp(getBuffer(), other.getBuffer(), min);
 
     if (cmp) {
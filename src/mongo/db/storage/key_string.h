@@ -415,6 +415,15 @@ private:
     void _appendHugeDecimalWithoutTypeBits(const Decimal128 dec, bool invert);
     void _appendTinyDecimalWithoutTypeBits(const Decimal128 dec, const double bin, bool invert);
 
+    /**
+     * Appends 'elem' without going through _appendBsonValue() if it is one of the types most
+     * index keys are made of. Returns false, having appended nothing, for any other value.
+     */
+    template <bool Invert>
+    bool _appendCommonValue(const BSONElement& elem);
+    template <bool Invert>
+    void _appendIntegerFast(long long num);
+
     template <typename T>
     void _append(const T& thing, bool invert);
     void _appendBytes(const void* source, size_t bytes, bool invert);
@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/oid.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const int kNumKeys = 1000;
+
+/**
+ * The key shapes, chosen by state.range(0).
+ */
+enum Shape { kInt, kLong, kOID, kString, kCompoundNumeric, kCompoundMixedDescending };
+
+std::vector<BSONObj> makeKeys(int shape) {
+    std::vector<BSONObj> keys;
+    for (int i = 0; i < kNumKeys; ++i) {
+        switch (shape) {
+            case kInt:
+                keys.push_back(BSON("" << i * 7919));
+                break;
+            case kLong:
+                keys.push_back(BSON("" << (1LL << 40) + i));
+                break;
+            case kOID:
+                keys.push_back(BSON("" << OID::gen()));
+                break;
+            case kString:
+                keys.push_back(BSON("" << std::string("user_") + std::to_string(i * 31)));
+                break;
+            case kCompoundNumeric:
+                keys.push_back(BSON("" << i % 100 << "" << i));
+                break;
+            case kCompoundMixedDescending:
+                keys.push_back(BSON("" << i % 100 << "" << Date_t::fromMillisSinceEpoch(i) << ""
+                                       << std::string("status")));
+                break;
+            default:
+                MONGO_UNREACHABLE;
+        }
+    }
+    return keys;
+}
+
+Ordering makeOrdering(int shape) {
+    switch (shape) {
+        case kCompoundNumeric:
+            return Ordering::make(BSON("a" << 1 << "b" << 1));
+        case kCompoundMixedDescending:
+            return Ordering::make(BSON("a" << 1 << "b" << -1 << "c" << 1));
+        default:
+            return Ordering::make(BSON("a" << 1));
+    }
+}
+
+void BM_KeyStringEncode(benchmark::State& state) {
+    const auto keys = makeKeys(state.range(0));
+    const Ordering ord = makeOrdering(state.range(0));
+    KeyString ks(KeyString::Version::V1);
+    for (auto keepRunning : state) {
+        for (auto&& key : keys) {
+            ks.resetToKey(key, ord, RecordId(1));
+            benchmark::DoNotOptimize(ks.getBuffer());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+
+void BM_KeyStringDecode(benchmark::State& state) {
+    const auto keys = makeKeys(state.range(0));
+    const Ordering ord = makeOrdering(state.range(0));
+    std::vector<std::unique_ptr<KeyString>> encoded;
+    for (auto&& key : keys) {
+        encoded.push_back(std::make_unique<KeyString>(KeyString::Version::V1, key, ord));
+    }
+    for (auto keepRunning : state) {
+        for (auto&& ks : encoded) {
+            benchmark::DoNotOptimize(
+                KeyString::toBson(ks->getBuffer(), ks->getSize(), ord, ks->getTypeBits()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+
+// The end-of-range check an index cursor makes after every step.
+void BM_KeyStringCompareToBound(benchmark::State& state) {
+    const auto keys = makeKeys(state.range(0));
+    const Ordering ord = makeOrdering(state.range(0));
+    std::vector<std::unique_ptr<KeyString>> encoded;
+    for (auto&& key : keys) {
+        encoded.push_back(
+            std::make_unique<KeyString>(KeyString::Version::V1, key, ord, RecordId(1)));
+    }
+    const KeyString bound(
+        KeyString::Version::V1, keys[kNumKeys / 2], ord, KeyString::kExclusiveAfter);
+    for (auto keepRunning : state) {
+        int past = 0;
+        for (auto&& ks : encoded) {
+            past += ks->compare(bound) > 0;
+        }
+        benchmark::DoNotOptimize(past);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+
+void keyShapes(benchmark::internal::Benchmark* bm) {
+    for (int shape = kInt; shape <= kCompoundMixedDescending; ++shape) {
+        bm->Arg(shape);
+    }
+}
+
+BENCHMARK(BM_KeyStringEncode)->Apply(keyShapes);
+BENCHMARK(BM_KeyStringDecode)->Apply(keyShapes);
+BENCHMARK(BM_KeyStringCompareToBound)->Apply(keyShapes);
+
+}  // namespace
+}  // namespace mongo
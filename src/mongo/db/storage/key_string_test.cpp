@@ -145,6 +145,52 @@ TEST_F(KeyStringTest, Simple1) {
         }                                                                  \
     } while (0)
 
+TEST_F(KeyStringTest, CommonTypesEncodeLikeArrayElements) {
+    // Array elements always go through the generic encoding, so a value wrapped in an array
+    // must produce the bytes of the top-level fast path between the array's ctype and end bytes.
+    const std::vector<BSONObj> values = {
+        BSON("" << 0),
+        BSON("" << 1),
+        BSON("" << -1),
+        BSON("" << 127),
+        BSON("" << -129),
+        BSON("" << std::numeric_limits<int>::max()),
+        BSON("" << std::numeric_limits<int>::min()),
+        BSON("" << 0LL),
+        BSON("" << (1LL << 40)),
+        BSON("" << -(1LL << 40)),
+        BSON("" << std::numeric_limits<long long>::max()),
+        BSON("" << std::numeric_limits<long long>::min()),
+        BSON("" << OID("5a1b2c3d4e5f60718293a4b5")),
+        BSON("" << Date_t::fromMillisSinceEpoch(0)),
+        BSON("" << Date_t::fromMillisSinceEpoch(-1)),
+        BSON("" << Date_t::fromMillisSinceEpoch(1500000000000LL)),
+        BSON("" << ""),
+        BSON("" << "abc"),
+        BSON("" << StringData("a\0b", 3)),
+    };
+
+    for (auto ord : {ONE_ASCENDING, ONE_DESCENDING}) {
+        for (auto&& value : values) {
+            const KeyString plain(version, value, ord);
+            const KeyString wrapped(version, BSON("" << BSON_ARRAY(value.firstElement())), ord);
+            const std::string plainBytes(plain.getBuffer(), plain.getSize());
+            const std::string wrappedBytes(wrapped.getBuffer(), wrapped.getSize());
+
+            // Drop the trailing kEnd byte of both, and the array's ctype and terminator.
+            ASSERT_EQ(plainBytes.substr(0, plainBytes.size() - 1),
+                      wrappedBytes.substr(1, wrappedBytes.size() - 3))
+                << value;
+            ASSERT_EQ(toHex(plain.getTypeBits().getBuffer(),
+                                      plain.getTypeBits().getSize()),
+                      toHex(wrapped.getTypeBits().getBuffer(),
+                                      wrapped.getTypeBits().getSize()))
+                << value;
+            ROUNDTRIP_ORDER(version, value, ord);
+        }
+    }
+}
+
 TEST_F(KeyStringTest, ActualBytesDouble) {
     // just one test like this for utter sanity
 
@@ -39,14 +39,17 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_set.h"
 #include "mongo/util/fail_point_service.h"
 
 namespace QueryStageCollectionScan {
@@ -200,6 +203,298 @@ public:
     }
 };
 
+//
+// Work a filtered scan in batches and get the matching objects in order, owned.
+//
+
+class QueryStageCollscanBatchedWithMatch : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        CollectionScanParams params;
+        params.collection = ctx.getCollection();
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, nullptr));
+        auto statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$lt" << 25)), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan =
+            make_unique<CollectionScan>(&_opCtx, params, &ws, filterExpr.get());
+
+        vector<WorkingSetID> batch;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = scan->workBatch(&ws, 7, &batch, &stateId);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+        }
+
+        ASSERT_EQUALS(25U, batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            WorkingSetMember* member = ws.get(batch[i]);
+            ASSERT_TRUE(member->hasObj());
+            ASSERT_TRUE(member->obj.value().isOwned());
+            ASSERT_EQUALS(static_cast<int>(i), member->obj.value()["foo"].numberInt());
+        }
+
+        const CommonStats* stats = scan->getCommonStats();
+        ASSERT_EQUALS(25U, stats->advanced);
+        ASSERT_TRUE(scan->isEOF());
+    }
+};
+
+//
+// Scan in parallel ranges and get every matching object exactly once, in order when asked.
+//
+
+class QueryStageCollscanParallelRanges : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, nullptr));
+        auto statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10)), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        for (bool ordered : {true, false}) {
+            WorkingSet ws;
+            auto scan = make_unique<ParallelCollectionScan>(
+                &_opCtx, ctx.getCollection(), 4, ordered, &ws, filterExpr.get());
+
+            vector<int> values;
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = ws.get(id);
+                    ASSERT_TRUE(member->hasRecordId());
+                    ASSERT_TRUE(member->obj.value().isOwned());
+                    values.push_back(member->obj.value()["foo"].numberInt());
+                    ws.free(id);
+                }
+            }
+
+            ASSERT_EQUALS(static_cast<size_t>(numObj() - 10), values.size());
+            stdx::unordered_set<int> distinct(values.begin(), values.end());
+            ASSERT_EQUALS(values.size(), distinct.size());
+            if (ordered) {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    ASSERT_EQUALS(static_cast<int>(i) + 10, values[i]);
+                }
+            }
+
+            auto stats = scan->getStats();
+            auto specific = static_cast<const ParallelCollectionScanStats*>(stats->specific.get());
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), specific->docsTested);
+            ASSERT_EQUALS(ordered, specific->ordered);
+        }
+    }
+};
+
+//
+// With one thread per query and room for one result per range, ranges give their thread back
+// whenever their buffer fills, and are scanned again once their results are taken.
+//
+
+class QueryStageCollscanParallelRangesParked : public QueryStageCollectionScanBase {
+public:
+    QueryStageCollscanParallelRangesParked()
+        : _maxThreadsPerQuery(internalQueryParallelCollectionScanMaxThreadsPerQuery.load()),
+          _maxBufferedBytes(internalQueryParallelCollectionScanMaxBufferedBytes.load()) {
+        internalQueryParallelCollectionScanMaxThreadsPerQuery.store(1);
+        internalQueryParallelCollectionScanMaxBufferedBytes.store(1);
+    }
+
+    ~QueryStageCollscanParallelRangesParked() {
+        internalQueryParallelCollectionScanMaxThreadsPerQuery.store(_maxThreadsPerQuery);
+        internalQueryParallelCollectionScanMaxBufferedBytes.store(_maxBufferedBytes);
+    }
+
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        for (bool ordered : {true, false}) {
+            WorkingSet ws;
+            auto scan = make_unique<ParallelCollectionScan>(
+                &_opCtx, ctx.getCollection(), 4, ordered, &ws, nullptr);
+
+            vector<int> values;
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                if (PlanStage::ADVANCED == state) {
+                    values.push_back(ws.get(id)->obj.value()["foo"].numberInt());
+                    ws.free(id);
+                }
+            }
+
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), values.size());
+            stdx::unordered_set<int> distinct(values.begin(), values.end());
+            ASSERT_EQUALS(values.size(), distinct.size());
+            if (ordered) {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    ASSERT_EQUALS(static_cast<int>(i), values[i]);
+                }
+            }
+        }
+    }
+
+private:
+    const int _maxThreadsPerQuery;
+    const int _maxBufferedBytes;
+};
+
+//
+// Reduce the matching objects of each range on the range's thread.
+//
+
+class SumReducer final : public ParallelScanRangeReducer {
+public:
+    bool add(const BSONObj& obj) final {
+        _sum += obj["foo"].numberInt();
+        return ++_count == 7;
+    }
+
+    void flush(std::vector<BSONObj>* out) final {
+        if (_count > 0) {
+            out->push_back(BSON("count" << _count << "sum" << _sum));
+        }
+        _count = 0;
+        _sum = 0;
+    }
+
+    size_t getMemoryUsageBytes() const final {
+        return 0;
+    }
+
+private:
+    int _count = 0;
+    long long _sum = 0;
+};
+
+class QueryStageCollscanParallelRangesReduced : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, nullptr));
+        auto statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10)), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        auto scan = make_unique<ParallelCollectionScan>(
+            &_opCtx, ctx.getCollection(), 4, false, &ws, filterExpr.get());
+        scan->setRangeReducer([] { return make_unique<SumReducer>(); });
+
+        size_t numResults = 0;
+        int count = 0;
+        long long sum = 0;
+        while (!scan->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_FALSE(member->hasRecordId());
+                ASSERT_TRUE(member->obj.value().isOwned());
+                const int reducedCount = member->obj.value()["count"].numberInt();
+                ASSERT_LTE(reducedCount, 7);
+                count += reducedCount;
+                sum += member->obj.value()["sum"].numberLong();
+                ++numResults;
+                ws.free(id);
+            }
+        }
+
+        // Every matching object was reduced exactly once.
+        ASSERT_EQUALS(numObj() - 10, count);
+        long long expectedSum = 0;
+        for (int i = 10; i < numObj(); ++i) {
+            expectedSum += i;
+        }
+        ASSERT_EQUALS(expectedSum, sum);
+
+        auto stats = scan->getStats();
+        auto specific = static_cast<const ParallelCollectionScanStats*>(stats->specific.get());
+        ASSERT_TRUE(specific->reduced);
+        ASSERT_EQUALS(numResults, specific->reducedResults);
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), specific->docsTested);
+    }
+};
+
+//
+// A write conflict right after a range claims its start doesn't lose the rest of the range.
+//
+
+class QueryStageCollscanParallelRangesWriteConflictAfterClaim
+    : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        FailPointEnableBlock failPoint("parallelCollectionScanWriteConflictAfterClaim");
+
+        for (bool ordered : {true, false}) {
+            WorkingSet ws;
+            auto scan = make_unique<ParallelCollectionScan>(
+                &_opCtx, ctx.getCollection(), 4, ordered, &ws, nullptr);
+
+            vector<int> values;
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                if (PlanStage::ADVANCED == state) {
+                    values.push_back(ws.get(id)->obj.value()["foo"].numberInt());
+                    ws.free(id);
+                }
+            }
+
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), values.size());
+            stdx::unordered_set<int> distinct(values.begin(), values.end());
+            ASSERT_EQUALS(values.size(), distinct.size());
+            if (ordered) {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    ASSERT_EQUALS(static_cast<int>(i), values[i]);
+                }
+            }
+        }
+
+        // The same holds when the ranges are reduced.
+        WorkingSet ws;
+        auto scan = make_unique<ParallelCollectionScan>(
+            &_opCtx, ctx.getCollection(), 4, false, &ws, nullptr);
+        scan->setRangeReducer([] { return make_unique<SumReducer>(); });
+
+        int count = 0;
+        while (!scan->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                count += ws.get(id)->obj.value()["count"].numberInt();
+                ws.free(id);
+            }
+        }
+        ASSERT_EQUALS(numObj(), count);
+    }
+};
+
 //
 // Get objects in the order we inserted them.
 //
@@ -410,6 +705,11 @@ public:
         add<QueryStageCollscanBasicBackward>();
         add<QueryStageCollscanBasicForwardWithMatch>();
         add<QueryStageCollscanBasicBackwardWithMatch>();
+        add<QueryStageCollscanBatchedWithMatch>();
+        add<QueryStageCollscanParallelRanges>();
+        add<QueryStageCollscanParallelRangesParked>();
+        add<QueryStageCollscanParallelRangesReduced>();
+        add<QueryStageCollscanParallelRangesWriteConflictAfterClaim>();
         add<QueryStageCollscanObjectsInOrderForward>();
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
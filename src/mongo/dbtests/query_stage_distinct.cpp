@@ -306,6 +306,59 @@ public:
     }
 };
 
+// Stepping over a value's keys with next() finds the same values as seeking, including when the
+// step leaves an interval or runs past a value with more keys than the step limit.
+class QueryStageDistinctStepsBeforeSeek : public DistinctBase {
+public:
+    void run() {
+        // Two keys for each of 0..49, then fifty keys of 1000.
+        for (int i = 0; i < 100; ++i) {
+            insert(BSON("a" << i / 2));
+        }
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("a" << 1000));
+        }
+        addIndex(BSON("a" << 1));
+
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        Collection* coll = ctx.getCollection();
+
+        std::vector<IndexDescriptor*> indexes;
+        coll->getIndexCatalog()->findIndexesByKeyPattern(&_opCtx, BSON("a" << 1), false, &indexes);
+        ASSERT_EQ(indexes.size(), 1U);
+
+        DistinctParams params;
+        params.descriptor = indexes[0];
+        params.direction = 1;
+        params.fieldNo = 0;
+        params.maxStepsBeforeSeek = 3;
+        params.bounds.isSimpleRange = false;
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(Interval(BSON("" << 10 << "" << 20), true, false));
+        oil.intervals.push_back(Interval(BSON("" << 1000 << "" << MAXKEY), true, true));
+        params.bounds.fields.push_back(oil);
+
+        WorkingSet ws;
+        DistinctScan distinct(&_opCtx, params, &ws);
+
+        std::vector<int> seen;
+        WorkingSetID wsid;
+        PlanStage::StageState state;
+        while (PlanStage::IS_EOF != (state = distinct.work(&wsid))) {
+            if (PlanStage::ADVANCED == state) {
+                seen.push_back(getIntFieldDotted(ws, wsid, "a"));
+            }
+        }
+
+        std::vector<int> expected;
+        for (int i = 10; i < 20; ++i) {
+            expected.push_back(i);
+        }
+        expected.push_back(1000);
+        ASSERT(expected == seen);
+    }
+};
+
 // XXX: add a test case with bounds where skipping to the next key gets us a result that's not
 // valid w.r.t. our query.
 
@@ -317,6 +370,7 @@ public:
         add<QueryStageDistinctBasic>();
         add<QueryStageDistinctMultiKey>();
         add<QueryStageDistinctCompoundIndex>();
+        add<QueryStageDistinctStepsBeforeSeek>();
     }
 };
 
@@ -54,6 +54,7 @@
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -415,6 +416,65 @@ TEST_F(QueryStageMultiPlanTest, MPSSummaryStats) {
     ASSERT_LTE(stats.totalKeysExamined, static_cast<size_t>(N));
 }
 
+// With parallel trials enabled the query returns the same results, and on storage engines that
+// can run them, explain reports the wall time of each plan's trial.
+TEST_F(QueryStageMultiPlanTest, MPSParallelTrials) {
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10) << "bar" << i));
+    }
+
+    addIndex(BSON("foo" << 1));
+    addIndex(BSON("foo" << -1 << "bar" << 1));
+
+    const bool parallelOldValue = internalQueryPlanEvaluationParallel.load();
+    internalQueryPlanEvaluationParallel.store(true);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationParallel.store(parallelOldValue); });
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    Collection* coll = ctx.getCollection();
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(BSON("foo" << 7));
+    auto cq = uassertStatusOK(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+    auto exec =
+        uassertStatusOK(getExecutor(opCtx(), coll, std::move(cq), PlanExecutor::NO_YIELD, 0));
+    ASSERT_EQ(exec->getRootStage()->stageType(), STAGE_MULTI_PLAN);
+
+    int results = 0;
+    BSONObj obj;
+    PlanExecutor::ExecState state;
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+        ASSERT_EQUALS(obj["foo"].numberInt(), 7);
+        ++results;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(results, N / 10);
+
+    auto mps = static_cast<MultiPlanStage*>(exec->getRootStage());
+    auto mpsStats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+    if (!supportsDocLocking()) {
+        ASSERT_TRUE(mpsStats->trialWallTimeMicros.empty());
+        return;
+    }
+    ASSERT_EQ(mpsStats->trialWallTimeMicros.size(), 2U);
+
+    BSONObjBuilder bob;
+    auto winningPlanTrialStats = std::move(mps->getStats()->children[mps->bestPlanIdx()]);
+    Explain::explainStages(exec.get(),
+                           coll,
+                           ExplainOptions::Verbosity::kExecAllPlans,
+                           Status::OK(),
+                           winningPlanTrialStats.get(),
+                           &bob);
+    BSONObj explained = bob.done();
+    auto allPlansStats = explained["executionStats"]["allPlansExecution"].Array();
+    ASSERT_EQ(allPlansStats.size(), 2UL);
+    for (auto&& planStats : allPlansStats) {
+        ASSERT_TRUE(planStats["trialWallTimeMicros"].isNumber());
+    }
+}
+
 TEST_F(QueryStageMultiPlanTest, ShouldReportErrorIfExceedsTimeLimitDuringPlanning) {
     const int N = 5000;
     for (int i = 0; i < N; ++i) {
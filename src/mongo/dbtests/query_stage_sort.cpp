@@ -578,6 +578,80 @@ public:
     }
 };
 
+// A limited sort fed index keys only, with the fetch above it, returns the smallest
+// (key, RecordId) pairs in order.
+class QueryStageSortIndexKeysWithLimit : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 100;
+    }
+
+    virtual int limit() const {
+        return 25;
+    }
+
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        // Lots of ties, so the RecordId decides which of the documents with foo == 2 make it.
+        for (int i = 0; i < numObj(); ++i) {
+            insert(BSON("foo" << (numObj() - i - 1) % 10));
+        }
+
+        auto ws = make_unique<WorkingSet>();
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        std::vector<std::pair<int, RecordId>> expected;
+
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        for (auto&& recordId : recordIds) {
+            const int foo = coll->docFor(&_opCtx, recordId).value()["foo"].numberInt();
+            expected.emplace_back(foo, recordId);
+
+            WorkingSetID id = ws->allocate();
+            WorkingSetMember* member = ws->get(id);
+            member->recordId = recordId;
+            member->keyData.push_back(IndexKeyDatum(BSON("foo" << 1), BSON("" << foo), nullptr));
+            ws->transitionToRecordIdAndIdx(id);
+            queuedDataStage->pushBack(id);
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.resize(limit());
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("foo" << 1);
+        params.limit = limit();
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+        auto sortStage = make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        auto fetchStage =
+            make_unique<FetchStage>(&_opCtx, ws.get(), sortStage.release(), nullptr, coll);
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(fetchStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        BSONObj obj;
+        RecordId recordId;
+        for (auto&& want : expected) {
+            ASSERT_EQUALS(PlanExecutor::ADVANCED, exec->getNext(&obj, &recordId));
+            ASSERT_EQUALS(want.first, obj["foo"].numberInt());
+            ASSERT_EQUALS(want.second, recordId);
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, exec->getNext(&obj, &recordId));
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_sort") {}
@@ -595,6 +669,7 @@ public:
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
         add<QueryStageSortDeletionInvalidationWithLimit<1>>();
         add<QueryStageSortParallelArrays>();
+        add<QueryStageSortIndexKeysWithLimit>();
     }
 };
 
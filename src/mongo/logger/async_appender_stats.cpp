@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_appender_stats.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+namespace logger {
+
+void AsyncAppenderStats::append(BSONObjBuilder* builder) const {
+    builder->append("queueCapacity", queueCapacity.load());
+    builder->append("queueDepth", queueDepth.load());
+    builder->append("written", written.get());
+    builder->append("dropped", dropped.get());
+    builder->append("spilled", spilled.get());
+    builder->append("blocked", blocked.get());
+    builder->append("batches", batches.get());
+    builder->append("bytesWritten", bytesWritten.get());
+    builder->append("writeMicros", writeMicros.get());
+    builder->append("maxWriteMicros", maxWriteMicros.load());
+    builder->append("writeErrors", writeErrors.get());
+}
+
+void AsyncAppenderStats::recordBatch(long long records, long long bytes, long long micros) {
+    written.increment(records);
+    batches.increment();
+    bytesWritten.increment(bytes);
+    writeMicros.increment(micros);
+
+    long long currentMax = maxWriteMicros.load();
+    while (micros > currentMax) {
+        const long long observed = maxWriteMicros.compareAndSwap(currentMax, micros);
+        if (observed == currentMax) {
+            break;
+        }
+        currentMax = observed;
+    }
+}
+
+AsyncAppenderStats* globalAuditAsyncAppenderStats() {
+    static AsyncAppenderStats stats;
+    return &stats;
+}
+
+}  // namespace logger
+}  // namespace mongo
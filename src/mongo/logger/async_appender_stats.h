@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/counter.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+namespace logger {
+
+/**
+ * Counters describing the queue and writer thread of an asynchronous file appender.
+ *
+ * Producers only touch these on the overflow path, so the common case of enqueueing a record
+ * never writes to a shared counter.
+ */
+class AsyncAppenderStats {
+public:
+    /**
+     * Appends the counters as fields of "builder".
+     */
+    void append(BSONObjBuilder* builder) const;
+
+    /**
+     * Records one batch written by the writer thread.
+     */
+    void recordBatch(long long records, long long bytes, long long writeMicros);
+
+    AtomicInt64 queueCapacity{0};
+    AtomicInt64 queueDepth{0};
+    Counter64 written;
+    Counter64 dropped;
+    Counter64 spilled;
+    Counter64 blocked;
+    Counter64 batches;
+    Counter64 bytesWritten;
+    Counter64 writeMicros;
+    AtomicInt64 maxWriteMicros{0};
+    Counter64 writeErrors;
+};
+
+/**
+ * Statistics for the appender attached to the global audit log domain when auditLog.async is
+ * enabled. Reported in serverStatus as "auditLog".
+ */
+AsyncAppenderStats* globalAuditAsyncAppenderStats();
+
+}  // namespace logger
+}  // namespace mongo
@@ -45,6 +45,8 @@ class RoleName;
 
 namespace logger {
 
+class AuditEventOwned;
+
 /**
  * Free form text log message object that does not own the storage behind its message and
  * contextName.
@@ -53,6 +55,12 @@ namespace logger {
  */
 class AuditEventEphemeral {
 public:
+    /**
+     * Owning counterpart used by appenders that encode events off the calling thread.
+     * Defined in audit_event_owned.h.
+     */
+    typedef AuditEventOwned Owned;
+
     AuditEventEphemeral(StringData atype,
                         Date_t ts,
                         const std::string& localHost,
@@ -77,6 +85,31 @@ public:
           _param(param),
           _result(result) {}
 
+    AuditEventEphemeral(stdx::thread::id threadId,
+                        StringData atype,
+                        Date_t ts,
+                        const std::string& localHost,
+                        int localPort,
+                        const std::string& remoteHost,
+                        int remotePort,
+                        std::vector<UserName>* userNames,
+                        std::vector<RoleName>* roleNames,
+                        long long latencyMicros,
+                        BSONObj* param,
+                        ErrorCodes::Error result)
+        : _threadId(threadId),
+          _atype(atype),
+          _ts(ts),
+          _localHost(localHost),
+          _localPort(localPort),
+          _remoteHost(remoteHost),
+          _remotePort(remotePort),
+          _userNames(userNames),
+          _roleNames(roleNames),
+          _latencyMicros(latencyMicros),
+          _param(param),
+          _result(result) {}
+
     // Auditing does not need severity but syslog_appender.h requires event.getSeverity()
     LogSeverity getSeverity() const {
         return LogSeverity::Log();
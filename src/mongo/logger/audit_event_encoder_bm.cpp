@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/auth/role_name.h"
+#include "mongo/db/auth/user_name.h"
+#include "mongo/logger/audit_event_utf8_encoder.h"
+
+namespace mongo {
+namespace logger {
+namespace {
+
+/**
+ * Measures the per-event cost of each audit log encoder on a typical authCheck event for an
+ * insert command. The output stream is reset, not reallocated, between iterations, so the
+ * numbers reflect encoding work rather than stream growth.
+ */
+template <typename EncoderType>
+void BM_AuditEventEncode(benchmark::State& state) {
+    std::vector<UserName> users{UserName("rwuser", "admin")};
+    std::vector<RoleName> roles{RoleName("readWriteAnyDatabase", "admin"),
+                                RoleName("clusterMonitor", "admin")};
+    BSONObjBuilder docs;
+    for (int i = 0; i < state.range(0); ++i) {
+        docs.append(BSONObjBuilder::numStr(i),
+                    BSON("_id" << i << "name"
+                               << "document name"
+                               << "value"
+                               << i * 1.5));
+    }
+    BSONObj param = BSON("command"
+                         << "insert"
+                         << "ns"
+                         << "test.coll"
+                         << "args"
+                         << BSON("insert"
+                                 << "coll"
+                                 << "documents"
+                                 << BSONArray(docs.obj())));
+
+    AuditEventEphemeral event("authCheck",
+                              Date_t::now(),
+                              "192.168.0.1",
+                              27017,
+                              "192.168.0.2",
+                              40000,
+                              &users,
+                              &roles,
+                              0,
+                              &param,
+                              ErrorCodes::OK);
+
+    EncoderType encoder;
+    std::stringstream out;
+    for (auto keepRunning : state) {
+        out.seekp(0);
+        encoder.encode(event, out);
+        benchmark::DoNotOptimize(out.tellp());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_AuditEventEncode, AuditEventJSONEncoder)->ArgName("docs")->Arg(1)->Arg(16);
+BENCHMARK_TEMPLATE(BM_AuditEventEncode, AuditEventHWDDSEncoder)->ArgName("docs")->Arg(1)->Arg(16);
+BENCHMARK_TEMPLATE(BM_AuditEventEncode, AuditEventBSONEncoder)->ArgName("docs")->Arg(1)->Arg(16);
+
+}  // namespace
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/auth/role_name.h"
+#include "mongo/db/auth/user_name.h"
+#include "mongo/logger/audit_event.h"
+
+namespace mongo {
+namespace logger {
+
+/**
+ * Copy of an AuditEventEphemeral that owns all of its storage, so that it can outlive the
+ * audited operation and be encoded later on another thread.
+ */
+class AuditEventOwned {
+public:
+    explicit AuditEventOwned(const AuditEventEphemeral& event)
+        : _threadId(event.getThreadId()),
+          _atype(event.getAtype().toString()),
+          _ts(event.getTs()),
+          _localHost(event.getLocalHost()),
+          _localPort(event.getLocalPort()),
+          _remoteHost(event.getRemoteHost()),
+          _remotePort(event.getRemotePort()),
+          _userNames(*event.getUserNames()),
+          _roleNames(*event.getRoleNames()),
+          _latencyMicros(event.getLatencyMicros()),
+          _param(event.getParam()->getOwned()),
+          _result(event.getResult()) {}
+
+    /**
+     * Returns an ephemeral view of this event. The view is only valid while this object is
+     * alive and unmodified.
+     */
+    AuditEventEphemeral ephemeral() {
+        return AuditEventEphemeral(_threadId,
+                                   _atype,
+                                   _ts,
+                                   _localHost,
+                                   _localPort,
+                                   _remoteHost,
+                                   _remotePort,
+                                   &_userNames,
+                                   &_roleNames,
+                                   _latencyMicros,
+                                   &_param,
+                                   _result);
+    }
+
+private:
+    stdx::thread::id _threadId;
+    std::string _atype;
+    Date_t _ts;
+    std::string _localHost;
+    int _localPort;
+    std::string _remoteHost;
+    int _remotePort;
+    std::vector<UserName> _userNames;
+    std::vector<RoleName> _roleNames;
+    long long _latencyMicros;
+    BSONObj _param;
+    ErrorCodes::Error _result;
+};
+
+}  // namespace logger
+}  // namespace mongo
@@ -31,6 +31,7 @@
 #include "mongo/logger/audit_event_utf8_encoder.h"
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "mongo/bson/bsonobjbuilder.h"
@@ -46,29 +47,54 @@ const std::string USER_DB_FIELD_NAME = "db";
 const std::string ROLE_NAME_FIELD_NAME = "role";
 const std::string ROLE_DB_FIELD_NAME = "db";
 
-BSONArray usersVectorToBSONArray(const std::vector<UserName>& users) {
-    BSONArrayBuilder usersArrayBuilder;
-    for (std::vector<UserName>::const_iterator it = users.begin(); it != users.end(); ++it) {
-        const UserName& user = *it;
-        usersArrayBuilder.append(BSON(USER_NAME_FIELD_NAME
-                                      << user.getUser() << USER_DB_FIELD_NAME
-                                      << user.getDB()));
+namespace {
+
+// Reused by every BSON encode on a thread, so that steady-state encoding does not allocate.
+thread_local std::unique_ptr<BufBuilder> bsonEncodeBuffer;
+
+BufBuilder& getBSONEncodeBuffer() {
+    if (!bsonEncodeBuffer) {
+        bsonEncodeBuffer = std::make_unique<BufBuilder>();
     }
-    return usersArrayBuilder.arr();
+    bsonEncodeBuffer->reset();
+    return *bsonEncodeBuffer;
 }
 
-// TODO: audit lib should not dependent on serveronly lib,
-// so duplicate code here(copied from db/commands/user_management_commands.cpp),
-// should put it elsewhere
-BSONArray rolesVectorToBSONArray(const std::vector<RoleName>& roles) {
-    BSONArrayBuilder rolesArrayBuilder;
-    for (std::vector<RoleName>::const_iterator it = roles.begin(); it != roles.end(); ++it) {
-        const RoleName& role = *it;
-        rolesArrayBuilder.append(BSON(ROLE_NAME_FIELD_NAME
-                                      << role.getRole() << ROLE_DB_FIELD_NAME
-                                      << role.getDB()));
+}  // namespace
+
+void appendAuditEventFields(const AuditEventEphemeral& event, BSONObjBuilder* builder) {
+    builder->append("atype", event.getAtype());
+    builder->append("ts", event.getTs());
+
+    {
+        BSONObjBuilder local(builder->subobjStart("local"));
+        local.append("ip", event.getLocalHost());
+        local.append("port", event.getLocalPort());
+    }
+    {
+        BSONObjBuilder remote(builder->subobjStart("remote"));
+        remote.append("ip", event.getRemoteHost());
+        remote.append("port", event.getRemotePort());
+    }
+    {
+        BSONArrayBuilder users(builder->subarrayStart("users"));
+        for (const UserName& user : *event.getUserNames()) {
+            BSONObjBuilder userBuilder(users.subobjStart());
+            userBuilder.append(USER_NAME_FIELD_NAME, user.getUser());
+            userBuilder.append(USER_DB_FIELD_NAME, user.getDB());
+        }
+    }
+    {
+        BSONArrayBuilder roles(builder->subarrayStart("roles"));
+        for (const RoleName& role : *event.getRoleNames()) {
+            BSONObjBuilder roleBuilder(roles.subobjStart());
+            roleBuilder.append(ROLE_NAME_FIELD_NAME, role.getRole());
+            roleBuilder.append(ROLE_DB_FIELD_NAME, role.getDB());
+        }
     }
-    return rolesArrayBuilder.arr();
+
+    builder->append("param", *(event.getParam()));
+    builder->append("result", event.getResult());
 }
 
 AuditEventJSONEncoder::~AuditEventJSONEncoder() {}
@@ -76,22 +102,7 @@ AuditEventJSONEncoder::~AuditEventJSONEncoder() {}
 std::ostream& AuditEventJSONEncoder::encode(const AuditEventEphemeral& event,
                                             std::ostream& os) {
     BSONObjBuilder builder;
-    builder.append("atype", event.getAtype());
-    builder.append("ts", event.getTs());
-
-    BSONObj local = BSON("ip" << event.getLocalHost() << "port" << event.getLocalPort());
-    BSONObj remote = BSON("ip" << event.getRemoteHost() << "port" << event.getRemotePort());
-
-    builder.append("local", local);
-    builder.append("remote", remote);
-
-    BSONArray userNameArr = usersVectorToBSONArray(*(event.getUserNames()));
-    BSONArray roleNameArr = rolesVectorToBSONArray(*(event.getRoleNames()));
-
-    builder.append("users", userNameArr);
-    builder.append("roles", roleNameArr);
-    builder.append("param", *(event.getParam()));
-    builder.append("result", event.getResult());
+    appendAuditEventFields(event, &builder);
 
     os << builder.obj().jsonString();
     os << '\n';
@@ -101,25 +112,33 @@ std::ostream& AuditEventJSONEncoder::encode(const AuditEventEphemeral& event,
 void AuditEventJSONEncoder::encode(const AuditEventEphemeral& event,
                                             std::stringstream& s) {
     BSONObjBuilder builder;
-    builder.append("atype", event.getAtype());
-    builder.append("ts", event.getTs());
+    appendAuditEventFields(event, &builder);
 
-    BSONObj local = BSON("ip" << event.getLocalHost() << "port" << event.getLocalPort());
-    BSONObj remote = BSON("ip" << event.getRemoteHost() << "port" << event.getRemotePort());
+    s << builder.obj().jsonString();
+    s << '\n';
+}
 
-    builder.append("local", local);
-    builder.append("remote", remote);
 
-    BSONArray userNameArr = usersVectorToBSONArray(*(event.getUserNames()));
-    BSONArray roleNameArr = rolesVectorToBSONArray(*(event.getRoleNames()));
+AuditEventBSONEncoder::~AuditEventBSONEncoder() {}
 
-    builder.append("users", userNameArr);
-    builder.append("roles", roleNameArr);
-    builder.append("param", *(event.getParam()));
-    builder.append("result", event.getResult());
+void AuditEventBSONEncoder::encodeInto(const AuditEventEphemeral& event, BufBuilder* buf) {
+    BSONObjBuilder builder(*buf);
+    appendAuditEventFields(event, &builder);
+    builder.doneFast();
+}
 
-    s << builder.obj().jsonString();
-    s << '\n';
+std::ostream& AuditEventBSONEncoder::encode(const AuditEventEphemeral& event,
+                                            std::ostream& os) {
+    BufBuilder& buf = getBSONEncodeBuffer();
+    encodeInto(event, &buf);
+    os.write(buf.buf(), buf.len());
+    return os;
+}
+
+void AuditEventBSONEncoder::encode(const AuditEventEphemeral& event, std::stringstream& s) {
+    BufBuilder& buf = getBSONEncodeBuffer();
+    encodeInto(event, &buf);
+    s.write(buf.buf(), buf.len());
 }
 
 
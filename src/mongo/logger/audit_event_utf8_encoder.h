@@ -30,12 +30,22 @@
 
 #include <iosfwd>
 
+#include "mongo/bson/util/builder.h"
 #include "mongo/logger/encoder.h"
 #include "mongo/logger/audit_event.h"
 
 namespace mongo {
+
+class BSONObjBuilder;
+
 namespace logger {
 
+/**
+ * Appends the fields of "event" to "builder" in the layout shared by the JSON and BSON audit
+ * formats. Sub-documents are built in place, without intermediate objects.
+ */
+void appendAuditEventFields(const AuditEventEphemeral& event, BSONObjBuilder* builder);
+
 /**
  * Encoder that writes log messages of the style that MongoDB writes to console and files.
  */
@@ -46,6 +56,23 @@ public:
     virtual void encode(const AuditEventEphemeral& event, std::stringstream& s);
 };
 
+/**
+ * Encoder that writes each event as a single BSON document. A BSON document starts with its
+ * own int32 length, so the output is a stream of length-prefixed records that can be read back
+ * without any separator. See tools/auditdump.cpp for the matching decoder.
+ */
+class AuditEventBSONEncoder : public Encoder<AuditEventEphemeral> {
+public:
+    virtual ~AuditEventBSONEncoder();
+    virtual std::ostream& encode(const AuditEventEphemeral& event, std::ostream& os);
+    virtual void encode(const AuditEventEphemeral& event, std::stringstream& s);
+
+    /**
+     * Appends the BSON record for "event" to the end of "buf".
+     */
+    static void encodeInto(const AuditEventEphemeral& event, BufBuilder* buf);
+};
+
 /**
  * Encoder that generates log messages with AliCloudDB format.
  */
@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/auth/role_name.h"
+#include "mongo/db/auth/user_name.h"
+#include "mongo/logger/audit_event_utf8_encoder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace logger {
+namespace {
+
+class AuditEventEncoderTest : public unittest::Test {
+protected:
+    AuditEventEphemeral makeEvent(StringData atype) {
+        return AuditEventEphemeral(atype,
+                                   Date_t::fromMillisSinceEpoch(1500000000000LL),
+                                   "127.0.0.1",
+                                   27017,
+                                   "10.0.0.2",
+                                   51234,
+                                   &_users,
+                                   &_roles,
+                                   0,
+                                   &_param,
+                                   ErrorCodes::Unauthorized);
+    }
+
+    std::vector<UserName> _users{UserName("alice", "admin"), UserName("bob", "test")};
+    std::vector<RoleName> _roles{RoleName("readWrite", "test")};
+    BSONObj _param = BSON("command"
+                          << "insert"
+                          << "ns"
+                          << "test.coll");
+};
+
+TEST_F(AuditEventEncoderTest, BSONRecordMatchesJSONLayout) {
+    AuditEventEphemeral event = makeEvent("authCheck");
+
+    std::stringstream bsonOut;
+    AuditEventBSONEncoder().encode(event, bsonOut);
+    const std::string bytes = bsonOut.str();
+    BSONObj decoded(bytes.data());
+    ASSERT_EQ(static_cast<size_t>(decoded.objsize()), bytes.size());
+
+    BSONObjBuilder expected;
+    appendAuditEventFields(event, &expected);
+    ASSERT_BSONOBJ_EQ(expected.obj(), decoded);
+
+    ASSERT_EQ("authCheck", decoded["atype"].str());
+    ASSERT_EQ(27017, decoded["local"]["port"].numberInt());
+    ASSERT_EQ("10.0.0.2", decoded["remote"]["ip"].str());
+    ASSERT_EQ(2U, decoded["users"].Array().size());
+    ASSERT_EQ("bob", decoded["users"].Array()[1]["user"].str());
+    ASSERT_EQ("readWrite", decoded["roles"].Array()[0]["role"].str());
+    ASSERT_BSONOBJ_EQ(_param, decoded["param"].Obj());
+    ASSERT_EQ(ErrorCodes::Unauthorized, decoded["result"].numberInt());
+
+    std::stringstream jsonOut;
+    AuditEventJSONEncoder().encode(event, jsonOut);
+    ASSERT_EQ(decoded.jsonString() + "\n", jsonOut.str());
+}
+
+TEST_F(AuditEventEncoderTest, BSONRecordsAreLengthPrefixed) {
+    std::stringstream out;
+    AuditEventBSONEncoder encoder;
+    encoder.encode(makeEvent("authenticate"), out);
+    encoder.encode(makeEvent("createUser"), out);
+    encoder.encode(makeEvent("dropUser"), out);
+
+    const std::string bytes = out.str();
+    std::vector<std::string> atypes;
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        const int32_t size = ConstDataView(bytes.data() + offset).read<LittleEndian<int32_t>>();
+        ASSERT_LTE(offset + size, bytes.size());
+        atypes.push_back(BSONObj(bytes.data() + offset)["atype"].str());
+        offset += size;
+    }
+    ASSERT_EQ(offset, bytes.size());
+    ASSERT_EQ(3U, atypes.size());
+    ASSERT_EQ("authenticate", atypes[0]);
+    ASSERT_EQ("createUser", atypes[1]);
+    ASSERT_EQ("dropUser", atypes[2]);
+}
+
+TEST_F(AuditEventEncoderTest, EncodeIntoAppendsToExistingBuffer) {
+    BufBuilder buf;
+    AuditEventBSONEncoder::encodeInto(makeEvent("authenticate"), &buf);
+    const int first = buf.len();
+    AuditEventBSONEncoder::encodeInto(makeEvent("dropUser"), &buf);
+
+    ASSERT_EQ("authenticate", BSONObj(buf.buf())["atype"].str());
+    ASSERT_EQ("dropUser", BSONObj(buf.buf() + first)["atype"].str());
+}
+
+}  // namespace
+}  // namespace logger
+}  // namespace mongo
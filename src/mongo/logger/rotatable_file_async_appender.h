@@ -27,19 +27,43 @@
 
 #pragma once
 
+#include <memory>
+#include <sstream>
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
 #include "mongo/logger/appender.h"
+#include "mongo/logger/async_appender_stats.h"
 #include "mongo/logger/encoder.h"
 #include "mongo/logger/rotatable_file_writer.h"
-
-
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/bounded_mpsc_queue.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/duration.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 namespace logger {
 
+/**
+ * What an asynchronous appender does with an event when its queue is full.
+ */
+enum class AsyncOverflowPolicy {
+    kBlock,  // Wait for the writer thread to make room.
+    kDrop,   // Discard the event and count it.
+    kSpill,  // Encode and write the event synchronously on the calling thread.
+};
+
 /**
  * Appender for writing to instances of RotatableFileWriter.
+ *
+ * By default events are encoded and written on the calling thread. When constructed with a
+ * queue capacity, append() only copies the event into a bounded lock-free queue; a dedicated
+ * writer thread drains it, encodes the records and writes each batch with a single flush of
+ * the file stream. Event must provide an Owned type that can be built from a const Event& and
+ * exposes ephemeral().
  */
 template <typename Event>
 class RotatableFileAsyncAppender : public Appender<Event> {
@@ -47,6 +71,10 @@ class RotatableFileAsyncAppender : public Appender<Event> {
 
 public:
     typedef Encoder<Event> EventEncoder;
+    typedef typename Event::Owned OwnedEvent;
+
+    // Upper bound on the number of records encoded into one write.
+    static const size_t kMaxBatchRecords = 1024;
 
     /**
      * Constructs an appender, that owns "encoder", but not "writer."  Caller must
@@ -55,7 +83,90 @@ public:
     RotatableFileAsyncAppender(EventEncoder* encoder, RotatableFileWriter* writer)
         : _encoder(encoder), _writer(writer) {}
 
+    /**
+     * Constructs an appender that hands events to a writer thread through a queue of
+     * "queueCapacity" records. "stats" must outlive the appender.
+     */
+    RotatableFileAsyncAppender(EventEncoder* encoder,
+                               RotatableFileWriter* writer,
+                               size_t queueCapacity,
+                               AsyncOverflowPolicy overflowPolicy,
+                               AsyncAppenderStats* stats)
+        : _encoder(encoder),
+          _writer(writer),
+          _queue(new BoundedMPSCQueue<std::unique_ptr<OwnedEvent>>(queueCapacity)),
+          _overflowPolicy(overflowPolicy),
+          _stats(stats) {
+        _stats->queueCapacity.store(_queue->capacity());
+        _writerThread = stdx::thread([this] { _writerLoop(); });
+    }
+
+    virtual ~RotatableFileAsyncAppender() {
+        if (!_queue) {
+            return;
+        }
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _shutdown = true;
+            _wakeWriter.notify_one();
+        }
+        _writerThread.join();
+    }
+
     virtual Status append(const Event& event) {
+        if (!_queue) {
+            return _appendSync(event);
+        }
+
+        std::unique_ptr<OwnedEvent> record(new OwnedEvent(event));
+        if (!_queue->tryPush(std::move(record))) {
+            switch (_overflowPolicy) {
+                case AsyncOverflowPolicy::kDrop:
+                    _stats->dropped.increment();
+                    return Status::OK();
+                case AsyncOverflowPolicy::kSpill:
+                    _stats->spilled.increment();
+                    return _appendSync(event);
+                case AsyncOverflowPolicy::kBlock:
+                    _stats->blocked.increment();
+                    _waitAndPush(std::move(record));
+                    break;
+            }
+        }
+
+        if (_writerIdle.load()) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _wakeWriter.notify_one();
+        }
+        return Status::OK();
+    }
+
+    /**
+     * In synchronous mode flushes the file stream. In asynchronous mode additionally waits,
+     * up to a bound, for every event appended before the call to be written.
+     */
+    virtual void flush() {
+        if (_queue) {
+            const size_t target = _queue->enqueuedCount();
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            _wakeWriter.notify_one();
+            _drained.wait_for(lk, kFlushTimeout.toSystemDuration(), [&] {
+                return _shutdown || _writtenCount >= target;
+            });
+            return;
+        }
+
+        RotatableFileWriter::Use useWriter(_writer);
+        if (useWriter.status().isOK()) {
+            useWriter.stream().flush();
+        }
+    }
+
+private:
+    static constexpr Milliseconds kIdleWait{100};
+    static constexpr Milliseconds kFlushTimeout{5000};
+
+    Status _appendSync(const Event& event) {
         std::stringstream s;
         _encoder->encode(event, s);
         RotatableFileWriter::Use useWriter(_writer);
@@ -66,17 +177,117 @@ public:
         return Status::OK();
     }
 
-    virtual void flush() {
+    void _waitAndPush(std::unique_ptr<OwnedEvent> record) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        ++_blockedProducers;
+        while (!_queue->tryPush(std::move(record))) {
+            _wakeWriter.notify_one();
+            _spaceAvailable.wait_for(lk, kIdleWait.toSystemDuration());
+        }
+        --_blockedProducers;
+    }
+
+    /**
+     * Pops up to kMaxBatchRecords records into "_batch". Returns the number of records.
+     */
+    size_t _encodeBatch() {
+        _batch.str(std::string());
+        _batch.clear();
+
+        size_t records = 0;
+        std::unique_ptr<OwnedEvent> record;
+        while (records < kMaxBatchRecords && _queue->tryPop(&record)) {
+            _encoder->encode(record->ephemeral(), _batch);
+            record.reset();
+            ++records;
+        }
+        return records;
+    }
+
+    void _writeBatch(size_t records) {
+        const std::string buf = _batch.str();
+        Timer timer;
         RotatableFileWriter::Use useWriter(_writer);
-        if (useWriter.status().isOK()) {
-            useWriter.stream().flush();
+        Status status = useWriter.status();
+        if (!status.isOK()) {
+            _stats->writeErrors.increment();
+            return;
+        }
+        useWriter.stream().write(buf.data(), buf.size());
+        useWriter.stream().flush();
+        _stats->recordBatch(records, buf.size(), timer.micros());
+    }
+
+    void _writerLoop() {
+        setThreadName("AuditLogWriter");
+        while (true) {
+            const size_t records = _encodeBatch();
+            if (records > 0) {
+                _writeBatch(records);
+            }
+            _stats->queueDepth.store(_queue->size());
+
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            _writtenCount = _queue->dequeuedCount();
+            if (records > 0) {
+                if (_blockedProducers > 0) {
+                    _spaceAvailable.notify_all();
+                }
+                _drained.notify_all();
+                continue;
+            }
+
+            if (_shutdown && _queue->empty()) {
+                _drained.notify_all();
+                return;
+            }
+
+            if (!_queue->empty()) {
+                // A producer claimed a cell but has not published it yet.
+                lk.unlock();
+                stdx::this_thread::yield();
+                continue;
+            }
+
+            _drained.notify_all();
+            _writerIdle.store(true);
+            if (_queue->empty() && !_shutdown) {
+                _wakeWriter.wait_for(lk, kIdleWait.toSystemDuration());
+            }
+            _writerIdle.store(false);
         }
     }
 
-private:
     std::unique_ptr<EventEncoder> _encoder;
     RotatableFileWriter* _writer;
+
+    // Only set in asynchronous mode.
+    std::unique_ptr<BoundedMPSCQueue<std::unique_ptr<OwnedEvent>>> _queue;
+    AsyncOverflowPolicy _overflowPolicy = AsyncOverflowPolicy::kBlock;
+    AsyncAppenderStats* _stats = nullptr;
+
+    // Owned by the writer thread.
+    std::stringstream _batch;
+
+    // Set while the writer thread sleeps, so that producers only take _mutex to wake it.
+    AtomicBool _writerIdle{false};
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _wakeWriter;
+    stdx::condition_variable _spaceAvailable;
+    stdx::condition_variable _drained;
+    int _blockedProducers = 0;
+    size_t _writtenCount = 0;  // Records popped and handed to the file stream.
+    bool _shutdown = false;
+
+    stdx::thread _writerThread;
 };
 
+template <typename Event>
+constexpr Milliseconds RotatableFileAsyncAppender<Event>::kIdleWait;
+
+template <typename Event>
+constexpr Milliseconds RotatableFileAsyncAppender<Event>::kFlushTimeout;
+
 }  // namespace logger
 }  // namespace mongo
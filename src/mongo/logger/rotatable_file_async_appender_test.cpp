@@ -0,0 +1,270 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mongo/logger/async_appender_stats.h"
+#include "mongo/logger/encoder.h"
+#include "mongo/logger/rotatable_file_async_appender.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace logger {
+namespace {
+
+const std::string logFileName("LogTest_RotatableFileAsyncAppender.txt");
+
+struct TestEvent;
+
+/**
+ * The copy of a TestEvent that the appender queues.
+ */
+class OwnedTestEvent {
+public:
+    explicit OwnedTestEvent(const TestEvent& event);
+    TestEvent ephemeral() const;
+
+private:
+    std::string _text;
+};
+
+struct TestEvent {
+    typedef OwnedTestEvent Owned;
+
+    std::string text;
+};
+
+OwnedTestEvent::OwnedTestEvent(const TestEvent& event) : _text(event.text) {}
+
+TestEvent OwnedTestEvent::ephemeral() const {
+    return TestEvent{_text};
+}
+
+/**
+ * Holds the appender's writer thread inside its first encode() until release() is called, so
+ * that the test controls when the queue drains. Encoding on the test's own thread, as spilling
+ * does, is never held.
+ */
+class WriterGate {
+public:
+    void waitIfWriterThread() {
+        if (stdx::this_thread::get_id() == _testThread) {
+            return;
+        }
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _writerWaiting = true;
+        _cv.notify_all();
+        _cv.wait(lk, [&] { return _open; });
+    }
+
+    void waitForWriterThread() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _writerWaiting; });
+    }
+
+    void release() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _open = true;
+        _cv.notify_all();
+    }
+
+private:
+    const stdx::thread::id _testThread = stdx::this_thread::get_id();
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    bool _writerWaiting = false;
+    bool _open = false;
+};
+
+class GatedEncoder : public Encoder<TestEvent> {
+public:
+    explicit GatedEncoder(WriterGate* gate) : _gate(gate) {}
+
+    std::ostream& encode(const TestEvent& event, std::ostream& os) override {
+        _gate->waitIfWriterThread();
+        return os << event.text << '\n';
+    }
+
+    void encode(const TestEvent& event, std::stringstream& s) override {
+        encode(event, static_cast<std::ostream&>(s));
+    }
+
+private:
+    WriterGate* _gate;
+};
+
+typedef RotatableFileAsyncAppender<TestEvent> TestAppender;
+
+class RotatableFileAsyncAppenderTest : public unittest::Test {
+public:
+    RotatableFileAsyncAppenderTest() {
+        unlink(logFileName.c_str());
+        RotatableFileWriter::Use writerUse(&_writer);
+        ASSERT_OK(writerUse.setFileName(logFileName, false));
+    }
+
+    ~RotatableFileAsyncAppenderTest() {
+        unlink(logFileName.c_str());
+    }
+
+protected:
+    std::unique_ptr<TestAppender> makeAppender(size_t capacity, AsyncOverflowPolicy policy) {
+        return stdx::make_unique<TestAppender>(
+            new GatedEncoder(&_gate), &_writer, capacity, policy, &_stats);
+    }
+
+    static Status append(TestAppender* appender, std::string text) {
+        return appender->append(TestEvent{std::move(text)});
+    }
+
+    /**
+     * Appends one record for the writer thread to hold in encode(), then fills the queue of
+     * 'capacity' records behind it.
+     */
+    void fillQueue(TestAppender* appender, size_t capacity) {
+        ASSERT_OK(append(appender, "held"));
+        _gate.waitForWriterThread();
+        for (size_t i = 0; i < capacity; ++i) {
+            ASSERT_OK(append(appender, "queued" + std::to_string(i)));
+        }
+    }
+
+    static std::vector<std::string> queuedLines(size_t capacity) {
+        std::vector<std::string> lines{"held"};
+        for (size_t i = 0; i < capacity; ++i) {
+            lines.push_back("queued" + std::to_string(i));
+        }
+        return lines;
+    }
+
+    static std::vector<std::string> readLines() {
+        std::ifstream ifs(logFileName.c_str());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(ifs, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    RotatableFileWriter _writer;
+    AsyncAppenderStats _stats;
+    WriterGate _gate;
+};
+
+TEST_F(RotatableFileAsyncAppenderTest, DropPolicyDiscardsRecordsWhenQueueIsFull) {
+    const size_t capacity = 4;
+    auto appender = makeAppender(capacity, AsyncOverflowPolicy::kDrop);
+    fillQueue(appender.get(), capacity);
+
+    ASSERT_OK(append(appender.get(), "overflow"));
+    ASSERT_EQ(1, _stats.dropped.get());
+
+    _gate.release();
+    appender.reset();
+    ASSERT(readLines() == queuedLines(capacity));
+    ASSERT_EQ(static_cast<long long>(capacity + 1), _stats.written.get());
+}
+
+TEST_F(RotatableFileAsyncAppenderTest, SpillPolicyWritesOnCallingThreadWhenQueueIsFull) {
+    const size_t capacity = 4;
+    auto appender = makeAppender(capacity, AsyncOverflowPolicy::kSpill);
+    fillQueue(appender.get(), capacity);
+
+    ASSERT_OK(append(appender.get(), "overflow"));
+    ASSERT_EQ(1, _stats.spilled.get());
+
+    _gate.release();
+    appender.reset();
+
+    // The spilled record reaches the file ahead of those still queued.
+    auto expected = queuedLines(capacity);
+    expected.insert(expected.begin(), "overflow");
+    ASSERT(readLines() == expected);
+    ASSERT_EQ(0, _stats.dropped.get());
+}
+
+TEST_F(RotatableFileAsyncAppenderTest, BlockPolicyWaitsForSpaceWhenQueueIsFull) {
+    const size_t capacity = 4;
+    auto appender = makeAppender(capacity, AsyncOverflowPolicy::kBlock);
+    fillQueue(appender.get(), capacity);
+
+    stdx::thread producer([&] { ASSERT_OK(append(appender.get(), "overflow")); });
+    while (_stats.blocked.get() == 0) {
+        sleepmillis(1);
+    }
+
+    _gate.release();
+    producer.join();
+    appender.reset();
+
+    auto expected = queuedLines(capacity);
+    expected.push_back("overflow");
+    ASSERT(readLines() == expected);
+    ASSERT_EQ(0, _stats.dropped.get());
+    ASSERT_EQ(0, _stats.spilled.get());
+}
+
+TEST_F(RotatableFileAsyncAppenderTest, FlushWaitsForQueuedRecordsToBeWritten) {
+    _gate.release();
+    auto appender = makeAppender(64, AsyncOverflowPolicy::kBlock);
+    std::vector<std::string> expected;
+    for (int i = 0; i < 50; ++i) {
+        expected.push_back("record" + std::to_string(i));
+        ASSERT_OK(append(appender.get(), expected.back()));
+    }
+
+    appender->flush();
+    ASSERT(readLines() == expected);
+}
+
+TEST_F(RotatableFileAsyncAppenderTest, ShutdownDrainsEveryQueuedRecord) {
+    const size_t capacity = 128;
+    auto appender = makeAppender(capacity, AsyncOverflowPolicy::kDrop);
+    fillQueue(appender.get(), capacity);
+
+    _gate.release();
+    appender.reset();
+    ASSERT(readLines() == queuedLines(capacity));
+    ASSERT_EQ(0, _stats.dropped.get());
+}
+
+}  // namespace
+}  // namespace logger
+}  // namespace mongo
@@ -815,10 +815,7 @@ public:
                     }
                 }
             }
-            serverGlobalParams.auditOpNsFilterMap.clear();
             if (!parseAuditNsFilter(auditNsFilterMap)) {
-                serverGlobalParams.auditOpNsFilterMap.clear();
-                parseAuditNsFilter(serverGlobalParams.auditNsFilterMap);
                 errmsg = "reload: invalid value " + value.toString();
                 return false;
             }
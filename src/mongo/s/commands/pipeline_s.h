@@ -100,6 +100,16 @@ public:
             MONGO_UNREACHABLE;
         }
 
+        boost::optional<CollectionSizeEstimate> getCollectionSizeEstimate(
+            OperationContext* opCtx, const NamespaceString& nss) const final {
+            MONGO_UNREACHABLE;
+        }
+
+        std::shared_ptr<OperationStageMemCounter> getOperationStageMemCounter(
+            OperationContext* opCtx) const final {
+            return nullptr;
+        }
+
         BSONObj getCollectionOptions(const NamespaceString& nss) final {
             MONGO_UNREACHABLE;
         }
@@ -248,6 +248,14 @@ void cleanupTask(ServiceContext* serviceContext) {
                     << "Service executor failed to shutdown within timelimit: " << status.reason();
             }
         }
+        if (serviceContext->hasAdminServiceExecutor()) {
+            Status status = serviceContext->getAdminServiceExecutor()->shutdown(Seconds(5));
+            if (!status.isOK()) {
+                log(LogComponent::kNetwork)
+                    << "Admin service executor failed to shutdown within timelimit: "
+                    << status.reason();
+            }
+        }
 #endif
 
         // Shutdown Full-Time Data Capture
@@ -255,6 +263,9 @@ void cleanupTask(ServiceContext* serviceContext) {
     }
 
     audit::logShutdown(Client::getCurrent());
+
+    // Drain the audit writer thread, if any, before the process exits.
+    logger::globalAuditLogDomain()->flush();
 }
 
 Status initializeSharding(OperationContext* opCtx) {
@@ -448,6 +459,14 @@ ExitCode runMongosServer(ServiceContext* serviceContext) {
         return EXIT_NET_ERROR;
     }
 
+    if (serviceContext->hasAdminServiceExecutor()) {
+        status = serviceContext->getAdminServiceExecutor()->start();
+        if (!status.isOK()) {
+            error() << "Failed to start the admin service executor: " << redact(status);
+            return EXIT_NET_ERROR;
+        }
+    }
+
     status = serviceContext->getTransportLayer()->start();
     if (!status.isOK()) {
         error() << "Failed to start the transport layer: " << redact(status);
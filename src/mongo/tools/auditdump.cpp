@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+/**
+ * auditdump: prints an audit log written with auditLog.format: BSON as one JSON document per
+ * line.
+ *
+ * Usage: auditdump [--pretty] <path|->
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/base/initializer.h"
+#include "mongo/bson/bson_validate.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/util/exit_code.h"
+#include "mongo/util/quick_exit.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace {
+
+void printUsage(const char* name) {
+    std::cerr << "usage: " << name << " [--pretty] <path to BSON audit log | ->" << std::endl;
+}
+
+/**
+ * Reads records from "in" until end of input. Returns EXIT_CLEAN if every record was complete
+ * and valid.
+ */
+int dumpRecords(std::istream& in, bool pretty) {
+    std::vector<char> record;
+    long long offset = 0;
+    long long count = 0;
+
+    while (true) {
+        char header[sizeof(int32_t)];
+        in.read(header, sizeof(header));
+        if (in.gcount() == 0) {
+            break;
+        }
+        if (in.gcount() != static_cast<std::streamsize>(sizeof(header))) {
+            std::cerr << "truncated record header at offset " << offset << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const int32_t size = ConstDataView(header).read<LittleEndian<int32_t>>();
+        if (size < BSONObj::kMinBSONLength || size > BSONObjMaxInternalSize) {
+            std::cerr << "invalid record size " << size << " at offset " << offset << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        record.resize(size);
+        std::copy(header, header + sizeof(header), record.begin());
+        in.read(record.data() + sizeof(header), size - sizeof(header));
+        if (in.gcount() != static_cast<std::streamsize>(size - sizeof(header))) {
+            std::cerr << "truncated record at offset " << offset << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        Status status = validateBSON(record.data(), size, BSONVersion::kLatest);
+        if (!status.isOK()) {
+            std::cerr << "invalid record at offset " << offset << ": " << status << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << BSONObj(record.data()).jsonString(Strict, pretty ? 1 : 0) << '\n';
+        offset += size;
+        ++count;
+    }
+
+    std::cerr << count << " audit records" << std::endl;
+    return EXIT_CLEAN;
+}
+
+int auditDumpMain(int argc, char** argv, char** envp) {
+    runGlobalInitializersOrDie(argc, argv, envp);
+
+    bool pretty = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--pretty") {
+            pretty = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return EXIT_CLEAN;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return EXIT_BADOPTIONS;
+        }
+    }
+
+    if (!path) {
+        printUsage(argv[0]);
+        return EXIT_BADOPTIONS;
+    }
+
+    if (std::string(path) == "-") {
+        return dumpRecords(std::cin, pretty);
+    }
+
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "failed to open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    return dumpRecords(in, pretty);
+}
+
+}  // namespace
+}  // namespace mongo
+
+#if defined(_WIN32)
+// In Windows, wmain() is an alternate entry point for main(), and receives the same parameters
+// as main() but encoded in Windows Unicode (UTF-16); "wide" 16-bit wchar_t characters.  The
+// WindowsCommandLine object converts these wide character strings to a UTF-8 coded equivalent
+// and makes them available through the argv() and envp() members.
+int wmain(int argc, wchar_t* argvW[], wchar_t* envpW[]) {
+    mongo::WindowsCommandLine wcl(argc, argvW, envpW);
+    int exitCode = mongo::auditDumpMain(argc, wcl.argv(), wcl.envp());
+    mongo::quickExit(exitCode);
+}
+#else
+int main(int argc, char* argv[], char** envp) {
+    int exitCode = mongo::auditDumpMain(argc, argv, envp);
+    mongo::quickExit(exitCode);
+}
+#endif
@@ -179,6 +179,18 @@ public:
         return _inExhaust;
     }
 
+    /**
+     * Returns 'response', a message received from 'dest', decompressed. Every compressed message
+     * from 'dest' must go through here, in order: compressors such as zlibdict only embed a
+     * dictionary in the first message of the connection that uses it.
+     */
+    Message decompressResponse(Message response) {
+        if (response.operation() != dbCompressed) {
+            return response;
+        }
+        return uassertStatusOK(_compressorMgr.decompressMessage(response));
+    }
+
     void extractHostInfo(OpMsgRequest request) {
         if (_seenFirstMessage)
             return;
@@ -213,6 +225,7 @@ private:
     boost::optional<HostAndPort> _host;
     bool _seenFirstMessage = false;
     bool _inExhaust = false;
+    MessageCompressorManager _compressorMgr;
 };
 
 const transport::Session::Decoration<ProxiedConnection> ProxiedConnection::_get =
@@ -267,11 +280,7 @@ DbResponse ServiceEntryPointBridge::handleRequest(OperationContext* opCtx, const
     if (dest.inExhaust()) {
         DbMessage dbm(request);
 
-        auto response = uassertStatusOK(dest->sourceMessage());
-        if (response.operation() == dbCompressed) {
-            MessageCompressorManager compressorMgr;
-            response = uassertStatusOK(compressorMgr.decompressMessage(response));
-        }
+        auto response = dest.decompressResponse(uassertStatusOK(dest->sourceMessage()));
 
         MsgData::View header = response.header();
         QueryResult::View qr = header.view2ptr();
@@ -356,7 +365,7 @@ DbResponse ServiceEntryPointBridge::handleRequest(OperationContext* opCtx, const
          request.operation() == dbCommand || request.operation() == dbMsg)) {
         // TODO dbMsg moreToCome
         // Forward the message to 'dest' and receive its reply in 'response'.
-        auto response = uassertStatusOK(dest->sourceMessage());
+        auto response = dest.decompressResponse(uassertStatusOK(dest->sourceMessage()));
         uassert(50765,
                 "Response ID did not match the sent message ID.",
                 response.header().getResponseToMsgId() == request.header().getId());
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/base/status.h"
 #include "mongo/base/system_error.h"
 #include "mongo/config.h"
@@ -172,6 +174,56 @@ StatusWith<EventsMask> pollASIOSocket(Socket& socket, EventsMask mask, Milliseco
     }
 }
 
+/**
+ * A ConstBufferSequence over several separately owned buffers, such as the payloads of a run of
+ * queued Messages, so that they can be handed to the socket as a single gathered (writev) write
+ * without being copied into one contiguous buffer.
+ *
+ * Advancing the sequence with += drops the buffers that have been fully written and trims the
+ * first partially written one, the same way asio::const_buffer::operator+= does for a single
+ * buffer, so that a short opportunistic write can be resumed asynchronously.
+ */
+class ConstBufferVector {
+public:
+    using value_type = asio::const_buffer;
+    using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+    void push_back(asio::const_buffer buffer) {
+        if (buffer.size()) {
+            _buffers.push_back(buffer);
+        }
+    }
+
+    const_iterator begin() const {
+        return _buffers.begin() + _first;
+    }
+
+    const_iterator end() const {
+        return _buffers.end();
+    }
+
+    size_t count() const {
+        return _buffers.size() - _first;
+    }
+
+    ConstBufferVector& operator+=(size_t bytes) {
+        while (bytes && _first < _buffers.size()) {
+            auto& front = _buffers[_first];
+            if (bytes < front.size()) {
+                front += bytes;
+                break;
+            }
+            bytes -= front.size();
+            ++_first;
+        }
+        return *this;
+    }
+
+private:
+    std::vector<asio::const_buffer> _buffers;
+    size_t _first = 0;
+};
+
 #ifdef MONGO_CONFIG_SSL
 /**
  * Peeks at a fragment of a client issued TLS handshake packet. Returns a TLS alert
@@ -33,6 +33,7 @@
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
 
+#include <memory>
 #include <type_traits>
 
 namespace mongo {
@@ -40,6 +41,8 @@ enum class MessageCompressor : uint8_t {
     kNoop = 0,
     kSnappy = 1,
     kZlib = 2,
+    // 3 is left free for upstream's zstd compressor.
+    kZlibDict = 4,
     kExtended = 255,
 };
 
@@ -86,6 +89,47 @@ public:
      */
     virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
 
+    /*
+     * Per-connection state for compressors that adapt to the traffic of a single connection. It
+     * is owned by the connection's MessageCompressorManager and is only ever used by one thread
+     * at a time.
+     */
+    class SessionState {
+    public:
+        virtual ~SessionState() = default;
+    };
+
+    /*
+     * Returns a new SessionState for a connection, or nullptr if this compressor keeps no
+     * per-connection state (the default).
+     */
+    virtual std::unique_ptr<SessionState> makeSessionState() {
+        return nullptr;
+    }
+
+    /*
+     * These are called by the MessageCompressorManager with the state returned by
+     * makeSessionState(), which may be null. 'originalOpCode' is the opcode of the message being
+     * compressed. The default implementations ignore the state and call getMaxCompressedSize,
+     * compressData and decompressData.
+     */
+    virtual std::size_t getMaxCompressedSizeForSession(SessionState* state, size_t inputSize) {
+        return getMaxCompressedSize(inputSize);
+    }
+
+    virtual StatusWith<std::size_t> compressDataForSession(SessionState* state,
+                                                           int32_t originalOpCode,
+                                                           ConstDataRange input,
+                                                           DataRange output) {
+        return compressData(input, output);
+    }
+
+    virtual StatusWith<std::size_t> decompressDataForSession(SessionState* state,
+                                                             ConstDataRange input,
+                                                             DataRange output) {
+        return decompressData(input, output);
+    }
+
     /*
      * This returns the number of bytes passed in the input for compressData
      */
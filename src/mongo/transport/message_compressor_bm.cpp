@@ -0,0 +1,268 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+#include "mongo/base/data_range_cursor.h"
+#include "mongo/base/data_type_endian.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_manager.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_snappy.h"
+#include "mongo/transport/message_compressor_zlib.h"
+#include "mongo/transport/message_compressor_zlib_dict.h"
+
+namespace mongo {
+namespace {
+
+Message makeOpMsg(const BSONObj& body, int32_t id) {
+    const auto size = MsgData::MsgDataHeaderSize + sizeof(uint32_t) + 1 + body.objsize();
+    auto buf = SharedBuffer::allocate(size);
+    MsgData::View view(buf.get());
+    view.setId(id);
+    view.setResponseToMsgId(0);
+    view.setOperation(dbMsg);
+    view.setLen(size);
+
+    DataRangeCursor cursor(view.data(), view.data() + view.dataLen());
+    uassertStatusOK(cursor.writeAndAdvance<LittleEndian<uint32_t>>(0));
+    uassertStatusOK(cursor.writeAndAdvance<LittleEndian<uint8_t>>(0));
+    memcpy(const_cast<char*>(cursor.data()), body.objdata(), body.objsize());
+    return Message(buf);
+}
+
+/**
+ * Reads back-to-back wire protocol messages, as captured from a connection, from the file named
+ * by MONGO_COMPRESSOR_BM_CORPUS.
+ */
+std::vector<Message> loadRecordedCorpus(const char* path) {
+    std::vector<Message> corpus;
+    std::ifstream in(path, std::ios::binary);
+    int32_t length;
+    while (in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+        length = endian::littleToNative(length);
+        if (length < MsgData::MsgDataHeaderSize || length > MaxMessageSizeBytes)
+            break;
+        auto buf = SharedBuffer::allocate(length);
+        memcpy(buf.get(), &length, sizeof(length));
+        if (!in.read(buf.get() + sizeof(length), length - sizeof(length)))
+            break;
+        corpus.emplace_back(buf);
+    }
+    return corpus;
+}
+
+/**
+ * Without a recorded corpus, generates the mix seen between a mongos and its shards: point finds
+ * and their replies, small insert batches and getMores.
+ */
+std::vector<Message> generateCorpus() {
+    std::vector<Message> corpus;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    const char hash[20] = {};
+
+    auto appendSessionFields = [&](BSONObjBuilder* bob) {
+        bob->append("lsid", BSON("id" << dist(gen)));
+        BSONObjBuilder clusterTime(bob->subobjStart("$clusterTime"));
+        clusterTime.append("clusterTime", Timestamp(1540000000 + dist(gen) % 1000, 1));
+        BSONObjBuilder signature(clusterTime.subobjStart("signature"));
+        signature.appendBinData("hash", sizeof(hash), BinDataGeneral, hash);
+        signature.append("keyId", 6614231281409294337LL);
+    };
+
+    for (int i = 0; i < 1024; i++) {
+        BSONObjBuilder bob;
+        switch (i % 4) {
+            case 0:
+                bob.append("find", "orders");
+                bob.append("filter", BSON("customerId" << dist(gen) << "status" << "shipped"));
+                bob.append("limit", 1);
+                bob.append("shardVersion", BSON_ARRAY(Timestamp(12, dist(gen) % 64) << OID()));
+                appendSessionFields(&bob);
+                bob.append("$db", "sales");
+                break;
+            case 1: {
+                BSONObjBuilder cursor(bob.subobjStart("cursor"));
+                BSONArrayBuilder batch(cursor.subarrayStart("firstBatch"));
+                batch.append(BSON("_id" << OID::gen() << "customerId" << dist(gen) << "status"
+                                        << "shipped"
+                                        << "total"
+                                        << dist(gen) / 100.0));
+                batch.doneFast();
+                cursor.append("id", 0LL);
+                cursor.append("ns", "sales.orders");
+                cursor.doneFast();
+                bob.append("ok", 1.0);
+                bob.append("operationTime", Timestamp(1540000000 + dist(gen) % 1000, 1));
+                appendSessionFields(&bob);
+                break;
+            }
+            case 2: {
+                bob.append("insert", "events");
+                BSONArrayBuilder docs(bob.subarrayStart("documents"));
+                for (int j = 0; j < 4; j++) {
+                    docs.append(BSON("_id" << OID::gen() << "type"
+                                           << "click"
+                                           << "userId"
+                                           << dist(gen)
+                                           << "ts"
+                                           << Date_t::fromMillisSinceEpoch(dist(gen))));
+                }
+                docs.doneFast();
+                bob.append("ordered", true);
+                appendSessionFields(&bob);
+                bob.append("$db", "analytics");
+                break;
+            }
+            case 3:
+                bob.append("getMore", static_cast<long long>(dist(gen)));
+                bob.append("collection", "oplog.rs");
+                bob.append("batchSize", 13981010);
+                bob.append("maxTimeMS", 5000);
+                bob.append("term", 3LL);
+                bob.append("lastKnownCommittedOpTime",
+                           BSON("ts" << Timestamp(1540000000 + dist(gen) % 1000, 1) << "t"
+                                     << 3LL));
+                bob.append("$db", "local");
+                break;
+        }
+        corpus.push_back(makeOpMsg(bob.obj(), i));
+    }
+    return corpus;
+}
+
+const std::vector<Message>& corpus() {
+    static const auto messages = [] {
+        const char* path = std::getenv("MONGO_COMPRESSOR_BM_CORPUS");
+        auto recorded = path ? loadRecordedCorpus(path) : std::vector<Message>();
+        return recorded.empty() ? generateCorpus() : recorded;
+    }();
+    return messages;
+}
+
+std::unique_ptr<MessageCompressorBase> makeCompressor(MessageCompressor id) {
+    switch (id) {
+        case MessageCompressor::kSnappy:
+            return stdx::make_unique<SnappyMessageCompressor>();
+        case MessageCompressor::kZlib:
+            return stdx::make_unique<ZlibMessageCompressor>();
+        case MessageCompressor::kZlibDict:
+            return stdx::make_unique<ZlibDictMessageCompressor>();
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+/**
+ * A registry holding only the compressor under test, and a manager that has negotiated it.
+ */
+struct Peer {
+    explicit Peer(MessageCompressor id) {
+        auto compressor = makeCompressor(id);
+        const auto name = compressor->getName();
+        registry.setSupportedCompressors({name});
+        registry.registerImplementation(std::move(compressor));
+        uassertStatusOK(registry.finalizeSupportedCompressors());
+
+        manager = stdx::make_unique<MessageCompressorManager>(&registry);
+        BSONObjBuilder out;
+        manager->serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY(name)),
+                                 &out);
+    }
+
+    MessageCompressorRegistry registry;
+    std::unique_ptr<MessageCompressorManager> manager;
+};
+
+/**
+ * Compresses the corpus in order, as one connection would send it. Reports the compression ratio
+ * next to the throughput.
+ */
+void BM_Compress(benchmark::State& state, MessageCompressor id) {
+    const auto& messages = corpus();
+    Peer sender(id);
+
+    size_t i = 0;
+    int64_t bytesIn = 0;
+    int64_t bytesOut = 0;
+    for (auto _ : state) {
+        const auto& msg = messages[i++ % messages.size()];
+        auto compressed = uassertStatusOK(sender.manager->compressMessage(msg));
+        bytesIn += msg.size();
+        bytesOut += compressed.size();
+        benchmark::DoNotOptimize(compressed);
+    }
+
+    state.SetBytesProcessed(bytesIn);
+    state.counters["ratio"] = bytesOut ? static_cast<double>(bytesIn) / bytesOut : 0;
+}
+
+/**
+ * Decompresses the corpus in the order it was compressed, so that a receiver sees dictionaries
+ * before the messages that use them.
+ */
+void BM_Decompress(benchmark::State& state, MessageCompressor id) {
+    const auto& messages = corpus();
+    Peer sender(id);
+    Peer receiver(id);
+
+    std::vector<Message> compressed;
+    for (auto&& msg : messages) {
+        compressed.push_back(uassertStatusOK(sender.manager->compressMessage(msg)));
+    }
+
+    size_t i = 0;
+    int64_t bytesOut = 0;
+    for (auto _ : state) {
+        auto decompressed = uassertStatusOK(
+            receiver.manager->decompressMessage(compressed[i++ % compressed.size()]));
+        bytesOut += decompressed.size();
+        benchmark::DoNotOptimize(decompressed);
+    }
+
+    state.SetBytesProcessed(bytesOut);
+}
+
+BENCHMARK_CAPTURE(BM_Compress, snappy, MessageCompressor::kSnappy);
+BENCHMARK_CAPTURE(BM_Compress, zlib, MessageCompressor::kZlib);
+BENCHMARK_CAPTURE(BM_Compress, zlibdict, MessageCompressor::kZlibDict);
+
+BENCHMARK_CAPTURE(BM_Decompress, snappy, MessageCompressor::kSnappy);
+BENCHMARK_CAPTURE(BM_Decompress, zlib, MessageCompressor::kZlib);
+BENCHMARK_CAPTURE(BM_Decompress, zlibdict, MessageCompressor::kZlibDict);
+
+}  // namespace
+}  // namespace mongo
@@ -105,7 +105,8 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     LOG(3) << "Compressing message with " << compressor->getName();
 
     auto inputHeader = msg.header();
-    size_t bufferSize = compressor->getMaxCompressedSize(msg.dataSize()) +
+    size_t bufferSize =
+        compressor->getMaxCompressedSizeForSession(_sessionState(compressor), msg.dataSize()) +
         CompressionHeader::size() + MsgData::MsgDataHeaderSize;
 
     CompressionHeader compressionHeader(
@@ -129,7 +130,8 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     compressionHeader.serialize(&output);
     ConstDataRange input(inputHeader.data(), inputHeader.data() + inputHeader.dataLen());
 
-    auto sws = compressor->compressData(input, output);
+    auto sws = compressor->compressDataForSession(
+        _sessionState(compressor), inputHeader.getNetworkOp(), input, output);
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -176,7 +178,7 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
 
     DataRangeCursor output(outMessage.data(), outMessage.data() + outMessage.dataLen());
 
-    auto sws = compressor->decompressData(input, output);
+    auto sws = compressor->decompressDataForSession(_sessionState(compressor), input, output);
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -190,6 +192,17 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
     return {Message(outputMessageBuffer)};
 }
 
+MessageCompressorBase::SessionState* MessageCompressorManager::_sessionState(
+    MessageCompressorBase* compressor) {
+    for (auto&& entry : _sessionStates) {
+        if (entry.first == compressor->getId())
+            return entry.second.get();
+    }
+
+    _sessionStates.emplace_back(compressor->getId(), compressor->makeSessionState());
+    return _sessionStates.back().second.get();
+}
+
 void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
     LOG(3) << "Starting client-side compression negotiation";
 
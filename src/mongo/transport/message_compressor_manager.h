@@ -126,8 +126,17 @@ public:
     static MessageCompressorManager& forSession(const transport::SessionHandle& session);
 
 private:
+    /*
+     * Returns this connection's state for 'compressor', creating it on first use. Returns nullptr
+     * for compressors that keep no per-connection state.
+     */
+    MessageCompressorBase::SessionState* _sessionState(MessageCompressorBase* compressor);
+
     std::vector<MessageCompressorBase*> _negotiated;
     MessageCompressorRegistry* _registry;
+    std::vector<
+        std::pair<MessageCompressorId, std::unique_ptr<MessageCompressorBase::SessionState>>>
+        _sessionStates;
 };
 
 }  // namespace mongo
@@ -38,8 +38,10 @@
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/message_compressor_snappy.h"
 #include "mongo/transport/message_compressor_zlib.h"
+#include "mongo/transport/message_compressor_zlib_dict.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 #include <string>
 #include <vector>
@@ -179,6 +181,47 @@ Message buildMessage() {
     return Message{buf};
 }
 
+// Builds an OP_MSG with a single body section holding 'body'.
+Message buildOpMsg(const BSONObj& body, int32_t id) {
+    const auto bufferSize = MsgData::MsgDataHeaderSize + sizeof(uint32_t) + 1 + body.objsize();
+    auto buf = SharedBuffer::allocate(bufferSize);
+    MsgData::View testView(buf.get());
+    testView.setId(id);
+    testView.setResponseToMsgId(0);
+    testView.setOperation(dbMsg);
+    testView.setLen(bufferSize);
+
+    DataRangeCursor cursor(testView.data(), testView.data() + testView.dataLen());
+    uassertStatusOK(cursor.writeAndAdvance<LittleEndian<uint32_t>>(0));
+    uassertStatusOK(cursor.writeAndAdvance<LittleEndian<uint8_t>>(0));
+    memcpy(const_cast<char*>(cursor.data()), body.objdata(), body.objsize());
+    return Message{buf};
+}
+
+BSONObj buildFindCommand(int i) {
+    return BSON("find"
+                << "orders"
+                << "filter"
+                << BSON("customerId" << i << "status"
+                                     << "shipped")
+                << "limit"
+                << 1
+                << "singleBatch"
+                << true
+                << "lsid"
+                << BSON("id" << i)
+                << "$db"
+                << "sales");
+}
+
+void assertSameMessage(const Message& expected, const Message& actual) {
+    const auto expectedView = expected.singleData();
+    const auto actualView = actual.singleData();
+    ASSERT_EQ(actualView.getNetworkOp(), expectedView.getNetworkOp());
+    ASSERT_EQ(actualView.getLen(), expectedView.getLen());
+    ASSERT_EQ(memcmp(actualView.data(), expectedView.data(), expectedView.dataLen()), 0);
+}
+
 TEST(MessageCompressorManager, NoCompressionRequested) {
     auto input = BSON("isMaster" << 1);
     checkServerNegotiation(input, {});
@@ -233,6 +276,105 @@ TEST(ZlibMessageCompressor, Fidelity) {
     checkFidelity(testMessage, stdx::make_unique<ZlibMessageCompressor>());
 }
 
+TEST(ZlibDictMessageCompressor, Fidelity) {
+    auto testMessage = buildMessage();
+    checkFidelity(testMessage, stdx::make_unique<ZlibDictMessageCompressor>());
+}
+
+TEST(ZlibDictMessageCompressor, Overflow) {
+    checkOverflow(stdx::make_unique<ZlibDictMessageCompressor>());
+}
+
+TEST(ZlibDictMessageCompressor, TrainsAndSendsDictionaryInBand) {
+    MessageCompressorRegistry registry;
+    registry.setSupportedCompressors({"zlibdict"});
+    registry.registerImplementation(stdx::make_unique<ZlibDictMessageCompressor>());
+    ASSERT_OK(registry.finalizeSupportedCompressors());
+
+    MessageCompressorManager sender(&registry);
+    MessageCompressorManager receiver(&registry);
+    BSONObjBuilder negotiatorOut;
+    sender.serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("zlibdict")),
+                           &negotiatorOut);
+
+    // Enough messages to train a dictionary with the default of 64 samples and use it for a while.
+    std::vector<int> compressedSizes;
+    for (int i = 0; i < 96; i++) {
+        auto msg = buildOpMsg(buildFindCommand(i), i);
+        auto compressed = assertOk(sender.compressMessage(msg));
+        compressedSizes.push_back(compressed.size());
+
+        auto decompressed = assertOk(receiver.decompressMessage(compressed));
+        assertSameMessage(msg, decompressed);
+    }
+
+    // The first message carries the seed dictionary and the one after training carries the
+    // trained dictionary, every other message only references them.
+    ASSERT_GT(compressedSizes[0], compressedSizes[1]);
+    ASSERT_GT(compressedSizes[64], compressedSizes[63]);
+    ASSERT_LT(compressedSizes[95], compressedSizes[1]);
+}
+
+TEST(ZlibDictMessageCompressor, UnknownDictionaryIsRejected) {
+    MessageCompressorRegistry registry;
+    registry.setSupportedCompressors({"zlibdict"});
+    registry.registerImplementation(stdx::make_unique<ZlibDictMessageCompressor>());
+    ASSERT_OK(registry.finalizeSupportedCompressors());
+
+    MessageCompressorManager sender(&registry);
+    BSONObjBuilder negotiatorOut;
+    sender.serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("zlibdict")),
+                           &negotiatorOut);
+
+    auto first = assertOk(sender.compressMessage(buildOpMsg(buildFindCommand(1), 1)));
+    auto second = assertOk(sender.compressMessage(buildOpMsg(buildFindCommand(2), 2)));
+
+    // A receiver that missed the message carrying the dictionary can't decode the ones after it.
+    MessageCompressorManager receiver(&registry);
+    ASSERT_NOT_OK(receiver.decompressMessage(second).getStatus());
+    ASSERT_OK(receiver.decompressMessage(first).getStatus());
+    ASSERT_OK(receiver.decompressMessage(second).getStatus());
+}
+
+TEST(ZlibDictMessageCompressor, TrainDictionary) {
+    ASSERT_TRUE(ZlibDictMessageCompressor::trainDictionary({}, 1024).empty());
+
+    std::vector<std::string> samples;
+    for (int i = 0; i < 16; i++) {
+        samples.push_back(str::stream() << "{lastKnownCommittedOpTime: " << i * 7919
+                                        << ", collection: 'oplog.rs'}");
+    }
+
+    auto dictionary = ZlibDictMessageCompressor::trainDictionary(samples, 256);
+    ASSERT_LTE(dictionary.size(), 256U);
+    ASSERT_NE(dictionary.find("lastKnownCommitted"), std::string::npos);
+    ASSERT_NE(dictionary.find("oplog.rs"), std::string::npos);
+}
+
+TEST(ZlibDictMessageCompressor, TrainingStopsAtItsTimeLimit) {
+    std::vector<std::string> samples(16, "{lastKnownCommittedOpTime: 1, collection: 'oplog.rs'}");
+    ASSERT_FALSE(ZlibDictMessageCompressor::trainDictionary(samples, 256).empty());
+    ASSERT_TRUE(ZlibDictMessageCompressor::trainDictionary(samples, 256, Milliseconds(0)).empty());
+}
+
+TEST(ZlibDictMessageCompressor, MaxCompressedSizeOnlyCoversEmbeddedDictionaries) {
+    ZlibDictMessageCompressor compressor;
+    auto state = compressor.makeSessionState();
+    const auto payload = buildFindCommand(1);
+    ConstDataRange input(payload.objdata(), payload.objdata() + payload.objsize());
+    const auto seedSize = ZlibDictMessageCompressor::seedDictionary().size();
+
+    // The first message embeds the seed dictionary, the next ones only reference it.
+    for (int i = 0; i < 2; i++) {
+        const auto maxSize = compressor.getMaxCompressedSizeForSession(state.get(), input.length());
+        ASSERT_EQ(maxSize > seedSize, i == 0);
+        std::vector<char> buffer(maxSize);
+        ASSERT_OK(compressor.compressDataForSession(
+            state.get(), dbMsg, input, DataRange(buffer.data(), buffer.size())));
+    }
+    ASSERT_LT(compressor.getMaxCompressedSize(input.length()), input.length() + 32);
+}
+
 TEST(SnappyMessageCompressor, Overflow) {
     checkOverflow(stdx::make_unique<SnappyMessageCompressor>());
 }
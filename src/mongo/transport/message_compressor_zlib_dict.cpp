@@ -0,0 +1,696 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/message_compressor_zlib_dict.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "mongo/base/checked_cast.h"
+#include "mongo/base/data_range_cursor.h"
+#include "mongo/base/data_type_endian.h"
+#include "mongo/base/init.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
+
+#include <zlib.h>
+
+namespace mongo {
+namespace {
+
+// The zlib compression level. Low levels are several times faster than zlib's default, and the
+// preset dictionary makes up most of the ratio they lose on small messages.
+MONGO_EXPORT_SERVER_PARAMETER(zlibDictCompressionLevel, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 9)
+            return Status(ErrorCodes::BadValue,
+                          "zlibDictCompressionLevel must be between 1 and 9");
+        return Status::OK();
+    });
+
+// The number of OP_MSG payloads a connection samples before training its own dictionary. Zero
+// disables training and connections keep using the seed dictionary.
+MONGO_EXPORT_SERVER_PARAMETER(zlibDictTrainingSamples, int, 64)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1024)
+            return Status(ErrorCodes::BadValue,
+                          "zlibDictTrainingSamples must be between 0 and 1024");
+        return Status::OK();
+    });
+
+// The maximum size of the dictionaries connections train.
+MONGO_EXPORT_SERVER_PARAMETER(zlibDictMaxDictionaryBytes, int, 8 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 256 ||
+            newVal > static_cast<int>(ZlibDictMessageCompressor::kMaxDictionarySize))
+            return Status(ErrorCodes::BadValue,
+                          "zlibDictMaxDictionaryBytes must be between 256 and 32768");
+        return Status::OK();
+    });
+
+constexpr uint8_t kEmbeddedDictionary = 0x1;
+
+// Only the beginning of each payload is kept for training, command documents put their most
+// repetitive fields first.
+constexpr size_t kMaxSampleSize = 2048;
+
+// Training runs on the thread sending the message that completes the samples, so both its input
+// and its run time are capped. Training stops collecting samples once they hold this many bytes.
+constexpr size_t kMaxTrainingBytes = 64 * 1024;
+constexpr Milliseconds kMaxTrainingTime{10};
+
+// The frame flags, and the dictionary id zlib adds to the header of a stream that uses one.
+constexpr size_t kFlagsSize = sizeof(uint8_t);
+constexpr size_t kDictionaryIdSize = sizeof(uint32_t);
+
+// A trained dictionary smaller than this isn't worth sending to the peer.
+constexpr size_t kMinTrainedDictionarySize = 32;
+
+// The number of dictionaries a connection remembers from its peer.
+constexpr size_t kMaxReceivedDictionaries = 4;
+
+// Training parameters: substring length used to measure how common content is, and the length
+// and stride of the candidate segments cut from the samples.
+constexpr size_t kKmerSize = 8;
+constexpr size_t kSegmentSize = 64;
+constexpr size_t kSegmentStep = 16;
+
+struct Dictionary {
+    explicit Dictionary(std::string data)
+        : bytes(std::move(data)),
+          id(static_cast<uint32_t>(::adler32(::adler32(0L, Z_NULL, 0),
+                                             reinterpret_cast<const Bytef*>(bytes.data()),
+                                             bytes.size()))) {}
+
+    const std::string bytes;
+    // The adler32 of the dictionary, which zlib records in the header of streams that use it.
+    const uint32_t id;
+};
+
+class ZlibDictSessionState : public MessageCompressorBase::SessionState {
+public:
+    const Dictionary* findReceived(uint32_t id) const {
+        for (auto&& dict : _received) {
+            if (dict->id == id)
+                return dict.get();
+        }
+        return nullptr;
+    }
+
+    void rememberReceived(std::shared_ptr<const Dictionary> dict) {
+        if (findReceived(dict->id))
+            return;
+        _received.push_back(std::move(dict));
+        if (_received.size() > kMaxReceivedDictionaries)
+            _received.pop_front();
+    }
+
+    // Sending side. The dictionary messages are compressed with, and whether it has already
+    // been sent to the peer.
+    std::shared_ptr<const Dictionary> sendDictionary;
+    bool sendDictionaryEmbedded = false;
+
+    // Payload prefixes collected for training, released once training is done.
+    std::vector<std::string> samples;
+    size_t sampleBytes = 0;
+    bool trainingDone = false;
+
+private:
+    // Receiving side. Dictionaries embedded by the peer, most recent last.
+    std::deque<std::shared_ptr<const Dictionary>> _received;
+};
+
+const std::shared_ptr<const Dictionary>& seed() {
+    static const auto dict = [] {
+        const char zeros[20] = {};
+        auto appendClusterTime = [&](BSONObjBuilder* bob) {
+            BSONObjBuilder clusterTime(bob->subobjStart("$clusterTime"));
+            clusterTime.append("clusterTime", Timestamp());
+            BSONObjBuilder signature(clusterTime.subobjStart("signature"));
+            signature.appendBinData("hash", sizeof(zeros), BinDataGeneral, zeros);
+            signature.append("keyId", 0LL);
+        };
+        auto appendOpTime = [](BSONObjBuilder* bob, StringData name) {
+            BSONObjBuilder opTime(bob->subobjStart(name));
+            opTime.append("ts", Timestamp());
+            opTime.append("t", 0LL);
+        };
+
+        // Least common shapes first, deflate reaches the end of the dictionary most cheaply.
+        std::vector<BSONObj> docs;
+        docs.push_back(BSON("ismaster" << true << "secondary" << false << "hosts"
+                                       << BSONArray() << "setName"
+                                       << ""
+                                       << "setVersion" << 1 << "primary"
+                                       << ""
+                                       << "me"
+                                       << ""
+                                       << "maxBsonObjectSize" << 0 << "maxMessageSizeBytes" << 0
+                                       << "maxWriteBatchSize" << 0 << "localTime" << Date_t()
+                                       << "logicalSessionTimeoutMinutes" << 30
+                                       << "minWireVersion" << 0 << "maxWireVersion" << 7
+                                       << "readOnly" << false));
+        {
+            BSONObjBuilder bob;
+            bob.append("replSetHeartbeat", "");
+            bob.append("configVersion", 1);
+            bob.append("hbv", 1);
+            bob.append("from", "");
+            bob.append("fromId", 0);
+            bob.append("term", 0LL);
+            bob.append("$db", "admin");
+            docs.push_back(bob.obj());
+        }
+        {
+            BSONObjBuilder bob;
+            bob.append("ok", 1.0);
+            bob.append("electionTime", Timestamp());
+            bob.append("state", 1);
+            bob.append("v", 1);
+            bob.append("hbmsg", "");
+            bob.append("set", "");
+            bob.append("syncingTo", "");
+            bob.append("term", 0LL);
+            bob.append("primaryId", 0);
+            appendOpTime(&bob, "durableOpTime");
+            appendOpTime(&bob, "opTime");
+            docs.push_back(bob.obj());
+        }
+        docs.push_back(BSON("aggregate"
+                            << ""
+                            << "pipeline"
+                            << BSON_ARRAY(BSON("$match" << BSONObj())
+                                          << BSON("$group" << BSON("_id" << BSONNULL << "count"
+                                                                         << BSON("$sum" << 1))))
+                            << "cursor"
+                            << BSONObj()));
+        docs.push_back(BSON("update"
+                            << ""
+                            << "ordered"
+                            << true
+                            << "updates"
+                            << BSON_ARRAY(BSON("q" << BSONObj() << "u" << BSON("$set" << BSONObj())
+                                                   << "upsert"
+                                                   << false
+                                                   << "multi"
+                                                   << false))));
+        docs.push_back(BSON("delete"
+                            << ""
+                            << "ordered"
+                            << true
+                            << "deletes"
+                            << BSON_ARRAY(BSON("q" << BSONObj() << "limit" << 0))));
+        docs.push_back(BSON("insert"
+                            << ""
+                            << "ordered"
+                            << true
+                            << "documents"
+                            << BSONArray()
+                            << "writeConcern"
+                            << BSON("w"
+                                    << "majority"
+                                    << "wtimeout"
+                                    << 0)));
+        {
+            BSONObjBuilder bob;
+            bob.append("getMore", 0LL);
+            bob.append("collection", "");
+            bob.append("batchSize", 0);
+            bob.append("maxTimeMS", 0);
+            bob.append("term", 0LL);
+            appendOpTime(&bob, "lastKnownCommittedOpTime");
+            bob.append("$db", "local");
+            docs.push_back(bob.obj());
+        }
+        {
+            BSONObjBuilder bob;
+            bob.append("n", 1);
+            bob.append("nModified", 0);
+            bob.append("opTime", BSON("ts" << Timestamp() << "t" << 0LL));
+            bob.append("electionId", OID());
+            bob.append("ok", 1.0);
+            bob.append("operationTime", Timestamp());
+            appendClusterTime(&bob);
+            docs.push_back(bob.obj());
+        }
+        {
+            BSONObjBuilder bob;
+            {
+                BSONObjBuilder cursor(bob.subobjStart("cursor"));
+                cursor.append("firstBatch", BSONArray());
+                cursor.append("nextBatch", BSONArray());
+                cursor.append("id", 0LL);
+                cursor.append("ns", "");
+            }
+            bob.append("ok", 1.0);
+            bob.append("operationTime", Timestamp());
+            {
+                BSONObjBuilder gleStats(bob.subobjStart("$gleStats"));
+                gleStats.append("lastOpTime", Timestamp());
+                gleStats.append("electionId", OID());
+            }
+            appendClusterTime(&bob);
+            docs.push_back(bob.obj());
+        }
+        {
+            BSONObjBuilder bob;
+            bob.append("find", "");
+            bob.append("filter", BSON("_id" << OID()));
+            bob.append("limit", 1);
+            bob.append("singleBatch", true);
+            bob.append("readConcern", BSON("level"
+                                           << "majority"));
+            {
+                BSONObjBuilder lsid(bob.subobjStart("lsid"));
+                lsid.appendBinData("id", 16, newUUID, zeros);
+            }
+            appendClusterTime(&bob);
+            bob.append("$readPreference", BSON("mode"
+                                               << "primaryPreferred"));
+            bob.append("$db", "admin");
+            docs.push_back(bob.obj());
+        }
+
+        std::string bytes;
+        for (auto&& doc : docs) {
+            bytes.append(doc.objdata(), doc.objsize());
+        }
+        return std::make_shared<const Dictionary>(std::move(bytes));
+    }();
+    return dict;
+}
+
+struct Frame {
+    std::shared_ptr<const Dictionary> embedded;
+    ConstDataRange stream{nullptr, nullptr};
+};
+
+StatusWith<Frame> parseFrame(ConstDataRange input) {
+    const Status invalid{ErrorCodes::BadValue, "Compressed message was invalid or corrupted"};
+
+    ConstDataRangeCursor cursor(input.data(), input.data() + input.length());
+    auto swFlags = cursor.readAndAdvance<LittleEndian<uint8_t>>();
+    if (!swFlags.isOK() || (swFlags.getValue() & ~kEmbeddedDictionary))
+        return invalid;
+
+    Frame frame;
+    if (swFlags.getValue() & kEmbeddedDictionary) {
+        auto swLength = cursor.readAndAdvance<LittleEndian<uint32_t>>();
+        if (!swLength.isOK())
+            return invalid;
+        const size_t length = swLength.getValue();
+        if (length == 0 || length > ZlibDictMessageCompressor::kMaxDictionarySize ||
+            length > cursor.length())
+            return invalid;
+        frame.embedded = std::make_shared<const Dictionary>(std::string(cursor.data(), length));
+        if (!cursor.advance(length).isOK())
+            return invalid;
+    }
+
+    frame.stream = ConstDataRange(cursor.data(), cursor.data() + cursor.length());
+    return frame;
+}
+
+/**
+ * Writes a frame holding 'input' deflated against 'dict' to 'output'. A null 'dict' compresses
+ * without a dictionary. Returns the number of bytes written.
+ */
+StatusWith<std::size_t> writeFrame(const Dictionary* dict,
+                                   bool embed,
+                                   ConstDataRange input,
+                                   DataRange output) {
+    const Status tooSmall{ErrorCodes::BadValue, "Could not compress input"};
+
+    DataRangeCursor cursor(const_cast<char*>(output.data()),
+                           const_cast<char*>(output.data()) + output.length());
+    const uint8_t flags = (dict && embed) ? kEmbeddedDictionary : 0;
+    if (!cursor.writeAndAdvance<LittleEndian<uint8_t>>(flags).isOK())
+        return tooSmall;
+    if (flags & kEmbeddedDictionary) {
+        if (!cursor.writeAndAdvance<LittleEndian<uint32_t>>(dict->bytes.size()).isOK() ||
+            !cursor.write(ConstDataRange(dict->bytes.data(), dict->bytes.size())).isOK() ||
+            !cursor.advance(dict->bytes.size()).isOK())
+            return tooSmall;
+    }
+    const size_t headerSize = output.length() - cursor.length();
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (::deflateInit2(&stream,
+                       zlibDictCompressionLevel.load(),
+                       Z_DEFLATED,
+                       MAX_WBITS,
+                       8,
+                       Z_DEFAULT_STRATEGY) != Z_OK) {
+        return Status{ErrorCodes::InternalError, "Could not initialize zlib"};
+    }
+    const auto guard = MakeGuard([&] { ::deflateEnd(&stream); });
+
+    if (dict &&
+        ::deflateSetDictionary(&stream,
+                               reinterpret_cast<const Bytef*>(dict->bytes.data()),
+                               dict->bytes.size()) != Z_OK) {
+        return Status{ErrorCodes::InternalError, "Could not set zlib dictionary"};
+    }
+
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input.data()));
+    stream.avail_in = input.length();
+    stream.next_out = reinterpret_cast<Bytef*>(const_cast<char*>(cursor.data()));
+    stream.avail_out = cursor.length();
+    if (::deflate(&stream, Z_FINISH) != Z_STREAM_END)
+        return tooSmall;
+
+    return {headerSize + stream.total_out};
+}
+
+/**
+ * Inflates 'stream' into 'output'. 'lookup' maps the dictionary id found in the stream header to
+ * a dictionary, or nullptr if it isn't known.
+ */
+template <typename Lookup>
+StatusWith<std::size_t> inflateStream(ConstDataRange input, DataRange output, Lookup&& lookup) {
+    const Status invalid{ErrorCodes::BadValue, "Compressed message was invalid or corrupted"};
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (::inflateInit(&stream) != Z_OK)
+        return Status{ErrorCodes::InternalError, "Could not initialize zlib"};
+    const auto guard = MakeGuard([&] { ::inflateEnd(&stream); });
+
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input.data()));
+    stream.avail_in = input.length();
+    stream.next_out = reinterpret_cast<Bytef*>(const_cast<char*>(output.data()));
+    stream.avail_out = output.length();
+
+    int ret = ::inflate(&stream, Z_FINISH);
+    if (ret == Z_NEED_DICT) {
+        const Dictionary* dict = lookup(static_cast<uint32_t>(stream.adler));
+        if (!dict)
+            return Status{ErrorCodes::BadValue, "Compressed message uses an unknown dictionary"};
+        if (::inflateSetDictionary(&stream,
+                                   reinterpret_cast<const Bytef*>(dict->bytes.data()),
+                                   dict->bytes.size()) != Z_OK)
+            return invalid;
+        ret = ::inflate(&stream, Z_FINISH);
+    }
+
+    if (ret != Z_STREAM_END)
+        return invalid;
+    return {static_cast<std::size_t>(stream.total_out)};
+}
+
+void noteSample(ZlibDictSessionState* session, ConstDataRange payload) {
+    const int wanted = zlibDictTrainingSamples.load();
+    if (session->trainingDone || wanted <= 0)
+        return;
+
+    session->samples.emplace_back(payload.data(), std::min(payload.length(), kMaxSampleSize));
+    session->sampleBytes += session->samples.back().size();
+    if (session->samples.size() < static_cast<size_t>(wanted) &&
+        session->sampleBytes < kMaxTrainingBytes)
+        return;
+
+    const size_t maxSize = zlibDictMaxDictionaryBytes.load();
+    Timer timer;
+    auto trained =
+        ZlibDictMessageCompressor::trainDictionary(session->samples, maxSize, kMaxTrainingTime);
+    LOG(2) << "Trained a compression dictionary from " << session->samples.size() << " samples ("
+           << session->sampleBytes << " bytes) in " << timer.millis() << "ms";
+    session->trainingDone = true;
+    std::vector<std::string>().swap(session->samples);
+    session->sampleBytes = 0;
+
+    if (trained.size() < kMinTrainedDictionarySize) {
+        LOG(2) << "Trained compression dictionary is only " << trained.size()
+               << " bytes, keeping the seed dictionary";
+        return;
+    }
+
+    // Traffic that is very uniform trains a small dictionary. Fill the rest of the budget with the
+    // end of the seed, ahead of the trained content so the trained part stays closest.
+    const auto& seedBytes = seed()->bytes;
+    const auto seedPart = std::min(seedBytes.size(), maxSize - std::min(maxSize, trained.size()));
+    trained.insert(0, seedBytes, seedBytes.size() - seedPart, seedPart);
+
+    LOG(2) << "Switching to a trained compression dictionary of " << trained.size() << " bytes";
+    session->sendDictionary = std::make_shared<const Dictionary>(std::move(trained));
+    session->sendDictionaryEmbedded = false;
+}
+
+}  // namespace
+
+constexpr size_t ZlibDictMessageCompressor::kMaxDictionarySize;
+
+ZlibDictMessageCompressor::ZlibDictMessageCompressor()
+    : MessageCompressorBase(MessageCompressor::kZlibDict) {}
+
+std::size_t ZlibDictMessageCompressor::getMaxCompressedSize(size_t inputSize) {
+    // compressData never uses a dictionary.
+    return kFlagsSize + ::compressBound(inputSize);
+}
+
+StatusWith<std::size_t> ZlibDictMessageCompressor::compressData(ConstDataRange input,
+                                                                DataRange output) {
+    auto sws = writeFrame(nullptr, false, input, output);
+    if (sws.isOK())
+        counterHitCompress(input.length(), sws.getValue());
+    return sws;
+}
+
+StatusWith<std::size_t> ZlibDictMessageCompressor::decompressData(ConstDataRange input,
+                                                                  DataRange output) {
+    auto swFrame = parseFrame(input);
+    if (!swFrame.isOK())
+        return swFrame.getStatus();
+    const auto& frame = swFrame.getValue();
+
+    auto sws = inflateStream(frame.stream, output, [&](uint32_t id) -> const Dictionary* {
+        return (frame.embedded && frame.embedded->id == id) ? frame.embedded.get() : nullptr;
+    });
+    if (sws.isOK())
+        counterHitDecompress(input.length(), sws.getValue());
+    return sws;
+}
+
+std::unique_ptr<MessageCompressorBase::SessionState>
+ZlibDictMessageCompressor::makeSessionState() {
+    return stdx::make_unique<ZlibDictSessionState>();
+}
+
+std::size_t ZlibDictMessageCompressor::getMaxCompressedSizeForSession(SessionState* state,
+                                                                      size_t inputSize) {
+    if (!state)
+        return getMaxCompressedSize(inputSize);
+    auto session = checked_cast<ZlibDictSessionState*>(state);
+
+    size_t embedSize = 0;
+    if (!session->sendDictionary || !session->sendDictionaryEmbedded) {
+        const auto& dict = session->sendDictionary ? session->sendDictionary : seed();
+        embedSize = sizeof(uint32_t) + dict->bytes.size();
+    }
+    return kFlagsSize + embedSize + ::compressBound(inputSize) + kDictionaryIdSize;
+}
+
+StatusWith<std::size_t> ZlibDictMessageCompressor::compressDataForSession(SessionState* state,
+                                                                          int32_t originalOpCode,
+                                                                          ConstDataRange input,
+                                                                          DataRange output) {
+    if (!state)
+        return compressData(input, output);
+    auto session = checked_cast<ZlibDictSessionState*>(state);
+
+    if (!session->sendDictionary)
+        session->sendDictionary = seed();
+
+    auto sws = writeFrame(
+        session->sendDictionary.get(), !session->sendDictionaryEmbedded, input, output);
+    if (!sws.isOK())
+        return sws;
+    session->sendDictionaryEmbedded = true;
+
+    if (originalOpCode == dbMsg)
+        noteSample(session, input);
+
+    counterHitCompress(input.length(), sws.getValue());
+    return sws;
+}
+
+StatusWith<std::size_t> ZlibDictMessageCompressor::decompressDataForSession(SessionState* state,
+                                                                            ConstDataRange input,
+                                                                            DataRange output) {
+    if (!state)
+        return decompressData(input, output);
+    auto session = checked_cast<ZlibDictSessionState*>(state);
+
+    auto swFrame = parseFrame(input);
+    if (!swFrame.isOK())
+        return swFrame.getStatus();
+    const auto& frame = swFrame.getValue();
+    if (frame.embedded)
+        session->rememberReceived(frame.embedded);
+
+    auto sws = inflateStream(
+        frame.stream, output, [&](uint32_t id) { return session->findReceived(id); });
+    if (sws.isOK())
+        counterHitDecompress(input.length(), sws.getValue());
+    return sws;
+}
+
+std::string ZlibDictMessageCompressor::trainDictionary(const std::vector<std::string>& samples,
+                                                       size_t maxSize,
+                                                       Milliseconds maxTime) {
+    maxSize = std::min(maxSize, kMaxDictionarySize);
+    Timer timer;
+    auto outOfTime = [&] { return Milliseconds(timer.millis()) >= maxTime; };
+    auto kmerAt = [&](const std::string& sample, size_t pos) {
+        uint64_t kmer;
+        std::memcpy(&kmer, sample.data() + pos, sizeof(kmer));
+        return kmer;
+    };
+    static_assert(kKmerSize == sizeof(uint64_t), "k-mers are read as 64-bit words");
+
+    // Count the number of samples each k-mer appears in.
+    std::unordered_map<uint64_t, uint32_t> frequencies;
+    std::unordered_set<uint64_t> seen;
+    for (auto&& sample : samples) {
+        if (outOfTime())
+            return {};
+        seen.clear();
+        for (size_t i = 0; i + kKmerSize <= sample.size(); ++i) {
+            auto kmer = kmerAt(sample, i);
+            if (seen.insert(kmer).second)
+                ++frequencies[kmer];
+        }
+    }
+
+    struct Segment {
+        bool operator<(const Segment& other) const {
+            return score < other.score;
+        }
+
+        uint64_t score;
+        size_t sample;
+        size_t begin;
+        size_t end;
+    };
+
+    // A segment scores the sum of the frequencies of its distinct k-mers. K-mers found in a single
+    // sample score nothing, they are unlikely to recur.
+    std::vector<uint64_t> kmers;
+    auto scoreSegment = [&](const Segment& segment) {
+        kmers.clear();
+        for (size_t i = segment.begin; i + kKmerSize <= segment.end; ++i)
+            kmers.push_back(kmerAt(samples[segment.sample], i));
+        std::sort(kmers.begin(), kmers.end());
+        kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+
+        uint64_t score = 0;
+        for (auto kmer : kmers) {
+            auto it = frequencies.find(kmer);
+            if (it != frequencies.end() && it->second > 1)
+                score += it->second;
+        }
+        return score;
+    };
+
+    std::priority_queue<Segment> candidates;
+    for (size_t i = 0; i < samples.size() && !outOfTime(); ++i) {
+        const auto size = samples[i].size();
+        for (size_t begin = 0; begin + kKmerSize <= size; begin += kSegmentStep) {
+            Segment segment{0, i, begin, std::min(begin + kSegmentSize, size)};
+            segment.score = scoreSegment(segment);
+            if (segment.score > 0)
+                candidates.push(segment);
+        }
+    }
+
+    // Greedily take the best segment and clear the frequencies of the k-mers it covers. Scores
+    // only drop as k-mers get covered, so a segment that still beats the next candidate after
+    // being rescored is the best one left.
+    std::vector<Segment> chosen;
+    size_t totalSize = 0;
+    while (!candidates.empty() && totalSize + kKmerSize <= maxSize && !outOfTime()) {
+        auto segment = candidates.top();
+        candidates.pop();
+        if (totalSize + (segment.end - segment.begin) > maxSize)
+            continue;
+
+        segment.score = scoreSegment(segment);
+        if (segment.score == 0)
+            continue;
+        if (!candidates.empty() && segment.score < candidates.top().score) {
+            candidates.push(segment);
+            continue;
+        }
+
+        chosen.push_back(segment);
+        totalSize += segment.end - segment.begin;
+        for (auto kmer : kmers) {
+            auto it = frequencies.find(kmer);
+            if (it != frequencies.end())
+                it->second = 0;
+        }
+    }
+
+    // The first segments chosen are the most valuable, put them last.
+    std::string dictionary;
+    dictionary.reserve(totalSize);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dictionary.append(samples[it->sample], it->begin, it->end - it->begin);
+    }
+    return dictionary;
+}
+
+const std::string& ZlibDictMessageCompressor::seedDictionary() {
+    return seed()->bytes;
+}
+
+MONGO_INITIALIZER_GENERAL(ZlibDictMessageCompressorInit,
+                          ("EndStartupOptionHandling"),
+                          ("AllCompressorsRegistered"))
+(InitializerContext* context) {
+    auto& compressorRegistry = MessageCompressorRegistry::get();
+    compressorRegistry.registerImplementation(stdx::make_unique<ZlibDictMessageCompressor>());
+    return Status::OK();
+}
+
+}  // namespace mongo
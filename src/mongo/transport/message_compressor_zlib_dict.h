@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/transport/message_compressor_base.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+
+/**
+ * A zlib based compressor for the small, repetitive command documents that make up most OP_MSG
+ * traffic between cluster members. It deflates at a low level against a preset dictionary: a
+ * built-in seed of common command fields at first, and then a dictionary trained on the OP_MSG
+ * payloads the connection has sent. Each dictionary is embedded in the first message of a
+ * connection that uses it, so the receiver never needs to know it in advance.
+ *
+ * Frame layout of the compressed data:
+ *     uint8 flags
+ *     [uint32 dictionaryLength, dictionary bytes]    if flags has kEmbeddedDictionary set
+ *     zlib stream, whose header names the preset dictionary by its adler32
+ */
+class ZlibDictMessageCompressor final : public MessageCompressorBase {
+public:
+    ZlibDictMessageCompressor();
+
+    std::size_t getMaxCompressedSize(size_t inputSize) override;
+
+    /*
+     * The stateless entry points don't use a dictionary when compressing. When decompressing
+     * they can only resolve a dictionary embedded in the same frame.
+     */
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
+
+    std::unique_ptr<SessionState> makeSessionState() override;
+
+    /*
+     * Only the first message that uses a dictionary embeds it, later ones add just the dictionary
+     * id to the stream header.
+     */
+    std::size_t getMaxCompressedSizeForSession(SessionState* state, size_t inputSize) override;
+
+    StatusWith<std::size_t> compressDataForSession(SessionState* state,
+                                                   int32_t originalOpCode,
+                                                   ConstDataRange input,
+                                                   DataRange output) override;
+
+    StatusWith<std::size_t> decompressDataForSession(SessionState* state,
+                                                     ConstDataRange input,
+                                                     DataRange output) override;
+
+    /*
+     * Builds a dictionary of at most 'maxSize' bytes from 'samples'. Segments are picked greedily
+     * by how many samples share their 8-byte substrings, and the most useful segments are placed
+     * at the end of the dictionary where deflate can reach them with the shortest distances. Once
+     * 'maxTime' has passed, training stops and returns the segments chosen so far.
+     */
+    static std::string trainDictionary(const std::vector<std::string>& samples,
+                                       size_t maxSize,
+                                       Milliseconds maxTime = Milliseconds::max());
+
+    /*
+     * Returns the built-in dictionary used before a connection has trained its own.
+     */
+    static const std::string& seedDictionary();
+
+    // The largest dictionary deflate can use, and thus the largest we accept from a peer.
+    static constexpr size_t kMaxDictionarySize = 32 * 1024;
+};
+
+}  // namespace mongo
@@ -91,8 +91,8 @@ void ServiceEntryPointImpl::startSession(transport::SessionHandle session) {
     std::string countErrmsg;
     auto transportMode = _svcCtx->getServiceExecutor()->transportMode();
 
-    if (serverGlobalParams.adminWhiteList.include(session->remote().host()) ||
-        serverGlobalParams.adminWhiteList.include(session->local().host())) {
+    if (serverGlobalParams.adminWhiteList.include(*remoteAddr) ||
+        serverGlobalParams.adminWhiteList.include(*localAddr)) {
         session->setInAdminWhiteList();
     }
 
@@ -79,6 +79,32 @@ MONGO_EXPORT_SERVER_PARAMETER(adaptiveServiceExecutorIdlePctThreshold, int, 60);
 // value.
 MONGO_EXPORT_SERVER_PARAMETER(adaptiveServiceExecutorRecursionLimit, int, 8);
 
+// The executor will not start more than this many threads to relieve stuck or starved workers.
+// Zero (the default) leaves the pool uncapped.
+MONGO_EXPORT_SERVER_PARAMETER(adaptiveServiceExecutorMaxThreads, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0)
+            return Status(ErrorCodes::BadValue, "adaptiveServiceExecutorMaxThreads must be >= 0");
+        return Status::OK();
+    });
+
+// The executor for admin whitelist sessions always keeps this many threads around, independently
+// of the threads reserved for customer sessions.
+MONGO_EXPORT_SERVER_PARAMETER(adminServiceExecutorReservedThreads, int, 2)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1)
+            return Status(ErrorCodes::BadValue, "adminServiceExecutorReservedThreads must be >= 1");
+        return Status::OK();
+    });
+
+// The maximum number of threads the admin executor may grow to. Zero leaves it uncapped.
+MONGO_EXPORT_SERVER_PARAMETER(adminServiceExecutorMaxThreads, int, 16)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0)
+            return Status(ErrorCodes::BadValue, "adminServiceExecutorMaxThreads must be >= 0");
+        return Status::OK();
+    });
+
 constexpr auto kTotalQueued = "totalQueued"_sd;
 constexpr auto kTotalExecuted = "totalExecuted"_sd;
 constexpr auto kTotalTimeExecutingUs = "totalTimeExecutingMicros"_sd;
@@ -87,6 +113,8 @@ constexpr auto kTotalTimeQueuedUs = "totalTimeQueuedMicros"_sd;
 constexpr auto kThreadsInUse = "threadsInUse"_sd;
 constexpr auto kThreadsRunning = "threadsRunning"_sd;
 constexpr auto kThreadsPending = "threadsPending"_sd;
+constexpr auto kMaxThreads = "maxThreads"_sd;
+constexpr auto kThreadCapHits = "threadCapHits"_sd;
 constexpr auto kExecutorLabel = "executor"_sd;
 constexpr auto kExecutorName = "adaptive"_sd;
 constexpr auto kStuckDetection = "stuckThreadsDetected"_sd;
@@ -101,7 +129,7 @@ int64_t ticksToMicros(TickSource::Tick ticks, TickSource* tickSource) {
 }
 
 struct ServerParameterOptions : public ServiceExecutorAdaptive::Options {
-    int reservedThreads() const final {
+    int reservedThreads() const override {
         int value = adaptiveServiceExecutorReservedThreads.load();
         if (value == -1) {
             value = ProcessInfo::getNumAvailableCores() / 2;
@@ -145,6 +173,20 @@ struct ServerParameterOptions : public ServiceExecutorAdaptive::Options {
     int recursionLimit() const final {
         return adaptiveServiceExecutorRecursionLimit.load();
     }
+
+    int maxThreads() const override {
+        return adaptiveServiceExecutorMaxThreads.load();
+    }
+};
+
+struct AdminServerParameterOptions : public ServerParameterOptions {
+    int reservedThreads() const final {
+        return adminServiceExecutorReservedThreads.load();
+    }
+
+    int maxThreads() const final {
+        return adminServiceExecutorMaxThreads.load();
+    }
 };
 
 }  // namespace
@@ -152,6 +194,10 @@ struct ServerParameterOptions : public ServiceExecutorAdaptive::Options {
 thread_local ServiceExecutorAdaptive::ThreadState* ServiceExecutorAdaptive::_localThreadState =
     nullptr;
 
+std::unique_ptr<ServiceExecutorAdaptive::Options> ServiceExecutorAdaptive::makeAdminOptions() {
+    return stdx::make_unique<AdminServerParameterOptions>();
+}
+
 ServiceExecutorAdaptive::ServiceExecutorAdaptive(ServiceContext* ctx, ReactorHandle reactor)
     : ServiceExecutorAdaptive(
           ctx, std::move(reactor), stdx::make_unique<ServerParameterOptions>()) {}
@@ -379,6 +425,16 @@ void ServiceExecutorAdaptive::_controllerThreadRoutine() {
                 // When the executor is stuck, we halve the stuck thread timeout to be more
                 // aggressive the next time out unsticking the executor, and then start a new
                 // thread to unblock the executor for now.
+                //
+                // If the pool is already at its thread cap, then leave it blocked. The cap exists
+                // so that one class of sessions cannot starve the rest of the server of threads.
+                if (_isAtThreadCap()) {
+                    _threadCapHits.addAndFetch(1);
+                    LOG(1) << "Detected blocked worker threads, but executor is at its cap of "
+                           << _config->maxThreads() << " threads";
+                    continue;
+                }
+
                 stuckThreadTimeout /= 2;
                 stuckThreadTimeout = std::max(Milliseconds{10}, stuckThreadTimeout);
                 log() << "Detected blocked worker threads, "
@@ -452,12 +508,27 @@ void ServiceExecutorAdaptive::_controllerThreadRoutine() {
         // number of tasks executing (the number of free threads), then start a new worker to
         // avoid starvation.
         if (_isStarved()) {
+            if (_isAtThreadCap()) {
+                _threadCapHits.addAndFetch(1);
+                LOG(1) << "Executor is starved, but at its cap of " << _config->maxThreads()
+                       << " threads";
+                continue;
+            }
             log() << "Starting worker thread to avoid starvation.";
             _startWorkerThread(ThreadCreationReason::kStarvation);
         }
     }
 }
 
+bool ServiceExecutorAdaptive::_isAtThreadCap() const {
+    auto maxThreads = _config->maxThreads();
+    if (maxThreads <= 0)
+        return false;
+
+    // The reserve always wins over the cap so a misconfigured cap can't leave the pool empty.
+    return _threadsRunning.load() >= std::max(maxThreads, _config->reservedThreads());
+}
+
 void ServiceExecutorAdaptive::_startWorkerThread(ThreadCreationReason reason) {
     stdx::unique_lock<stdx::mutex> lk(_threadsMutex);
     auto it = _threads.emplace(_threads.begin(), _tickSource);
@@ -675,7 +746,9 @@ void ServiceExecutorAdaptive::appendStats(BSONObjBuilder* bob) const {
             << ticksToMicros(_getThreadTimerTotal(ThreadTimer::kExecuting, lk), _tickSource)  //
             << kTotalTimeQueuedUs << ticksToMicros(_totalSpentQueued.load(), _tickSource)     //
             << kThreadsRunning << _threadsRunning.load()                                      //
-            << kThreadsPending << _threadsPending.load();
+            << kThreadsPending << _threadsPending.load()                                      //
+            << kMaxThreads << _config->maxThreads()                                           //
+            << kThreadCapHits << _threadCapHits.load();
 
     BSONObjBuilder threadStartReasons(section.subobjStart(kThreadReasons));
     for (size_t i = 0; i < _threadStartCounters.size(); i++) {
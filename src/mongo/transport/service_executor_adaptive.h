@@ -79,8 +79,21 @@ public:
         // The maximum allowable depth of recursion for tasks scheduled with the MayRecurse flag
         // before stack unwinding is forced.
         virtual int recursionLimit() const = 0;
+
+        // The maximum number of worker threads the controller may start to relieve stuck or
+        // starved pools. Reserved threads are always started. Zero means no cap.
+        virtual int maxThreads() const {
+            return 0;
+        }
     };
 
+    /**
+     * Returns Options backed by the adminServiceExecutor* server parameters. These are used by
+     * the executor that services sessions from the admin whitelist, so that customer load
+     * cannot consume the threads that administrative connections depend on.
+     */
+    static std::unique_ptr<Options> makeAdminOptions();
+
     explicit ServiceExecutorAdaptive(ServiceContext* ctx, ReactorHandle reactor);
     explicit ServiceExecutorAdaptive(ServiceContext* ctx,
                                      ReactorHandle reactor,
@@ -197,6 +210,7 @@ private:
     void _workerThreadRoutine(int threadId, ThreadList::iterator it);
     void _controllerThreadRoutine();
     bool _isStarved() const;
+    bool _isAtThreadCap() const;
     Milliseconds _getThreadJitter() const;
 
     void _accumulateTaskMetrics(MetricsArray* outArray, const MetricsArray& inputArray) const;
@@ -233,6 +247,7 @@ private:
     AtomicWord<int64_t> _totalQueued{0};
     AtomicWord<int64_t> _totalExecuted{0};
     AtomicWord<TickSource::Tick> _totalSpentQueued{0};
+    AtomicWord<int64_t> _threadCapHits{0};
 
     // Threads signal this condition variable when they exit so we can gracefully shutdown
     // the executor.
@@ -32,7 +32,11 @@
 
 #include "boost/optional.hpp"
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/service_context.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/service_executor_task_names.h"
@@ -82,6 +86,12 @@ struct TestOptions : public ServiceExecutorAdaptive::Options {
     }
 };
 
+struct CappedOptions : public TestOptions {
+    int maxThreads() const final {
+        return 2;
+    }
+};
+
 /* This implements the portions of the transport::Reactor based on ASIO, but leaves out
  * the methods not needed by ServiceExecutors.
  *
@@ -205,6 +215,72 @@ TEST_F(ServiceExecutorAdaptiveFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+/*
+ * This tests that the executor stops starting threads for stuck tasks once it reaches its
+ * maxThreads() cap, and that queued tasks still run once a thread becomes free.
+ */
+TEST_F(ServiceExecutorAdaptiveFixture, TestThreadCap) {
+    auto configOwned = stdx::make_unique<CappedOptions>();
+    auto config = configOwned.get();
+    auto exec = stdx::make_unique<ServiceExecutorAdaptive>(
+        getGlobalServiceContext(), std::make_shared<ASIOReactor>(), std::move(configOwned));
+    ASSERT_OK(exec->start());
+
+    stdx::mutex mutex;
+    stdx::condition_variable cond;
+    int started = 0;
+    bool released = false;
+    auto guard = MakeGuard([&] {
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            released = true;
+            cond.notify_all();
+        }
+        ASSERT_OK(exec->shutdown(config->workerThreadRunTime() * 2));
+    });
+
+    auto blockedTask = [&] {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        ++started;
+        cond.notify_all();
+        cond.wait(lk, [&] { return released; });
+    };
+
+    log() << "Scheduling 3 blocked tasks on an executor capped at 2 threads";
+    for (auto i = 0; i < 3; i++) {
+        ASSERT_OK(exec->schedule(blockedTask,
+                                 ServiceExecutor::kEmptyFlags,
+                                 ServiceExecutorTaskName::kSSMProcessMessage));
+    }
+
+    log() << "Waiting for the capped number of tasks to start";
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        cond.wait(lk, [&] { return started == config->maxThreads(); });
+    }
+
+    // Give the controller several stuck thread timeouts in which it would normally have started
+    // another thread.
+    stdx::this_thread::sleep_for(config->stuckThreadTimeout().toSystemDuration() * 3);
+    ASSERT_EQ(exec->threadsRunning(), config->maxThreads());
+    {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        ASSERT_EQ(started, config->maxThreads());
+    }
+
+    BSONObjBuilder bob;
+    exec->appendStats(&bob);
+    auto stats = bob.obj()["serviceExecutorTaskStats"].Obj();
+    ASSERT_EQ(stats["maxThreads"].numberInt(), config->maxThreads());
+    ASSERT_GT(stats["threadCapHits"].numberLong(), 0);
+
+    log() << "Unblocking tasks";
+    stdx::unique_lock<stdx::mutex> lk(mutex);
+    released = true;
+    cond.notify_all();
+    cond.wait(lk, [&] { return started == 3; });
+}
+
 TEST_F(ServiceExecutorSynchronousFixture, BasicTaskRuns) {
     ASSERT_OK(executor->start());
     auto guard = MakeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
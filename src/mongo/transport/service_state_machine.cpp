@@ -226,6 +226,8 @@ ServiceStateMachine::ServiceStateMachine(ServiceContext* svcContext,
       _sep{svcContext->getServiceEntryPoint()},
       _transportMode(transportMode),
       _serviceContext(svcContext),
+      _serviceExecutor(session->inAdminWhiteList() ? svcContext->getAdminServiceExecutor()
+                                                   : svcContext->getServiceExecutor()),
       _sessionHandle(session),
       _threadName{str::stream() << "conn" << _session()->id()},
       _dbClient{svcContext->makeClient(_threadName, std::move(session))},
@@ -479,8 +481,7 @@ void ServiceStateMachine::_scheduleNextWithGuard(ThreadGuard guard,
         ssm->_runNextInGuard(std::move(guard));
     };
     guard.release();
-    Status status =
-        _serviceContext->getServiceExecutor()->schedule(std::move(func), flags, taskName);
+    Status status = _serviceExecutor->schedule(std::move(func), flags, taskName);
     if (status.isOK()) {
         return;
     }
@@ -219,6 +219,7 @@ private:
     transport::Mode _transportMode;
 
     ServiceContext* const _serviceContext;
+    transport::ServiceExecutor* const _serviceExecutor;
 
     transport::SessionHandle _sessionHandle;
     const std::string _threadName;
@@ -32,10 +32,12 @@
 
 #include "mongo/base/system_error.h"
 #include "mongo/config.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/transport/asio_utils.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/net/socket_utils.h"
 #ifdef MONGO_CONFIG_SSL
@@ -53,6 +55,37 @@ namespace transport {
 
 MONGO_FAIL_POINT_DEFINE(transportLayerASIOshortOpportunisticReadWrite);
 
+// The most replies an ingress session queues up before writing them out together. asio gathers at
+// most 64 buffers into one sendmsg call. A value of 1 disables send coalescing.
+MONGO_EXPORT_SERVER_PARAMETER(sendCoalescingMaxMessages, int, 16)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "sendCoalescingMaxMessages must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+// Queued replies are written out as soon as they add up to this many bytes.
+MONGO_EXPORT_SERVER_PARAMETER(sendCoalescingMaxBytes, int, 64 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue, "sendCoalescingMaxBytes must be non-negative");
+        }
+        return Status::OK();
+    });
+
+// The longest a reply waits in the queue for company while the socket is idle. Zero writes the
+// queue out as soon as the socket is idle.
+MONGO_EXPORT_SERVER_PARAMETER(sendCoalescingMaxDelayMicros, int, 200)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "sendCoalescingMaxDelayMicros must be non-negative");
+        }
+        return Status::OK();
+    });
+
 template <typename SuccessValue>
 auto futurize(const std::error_code& ec, SuccessValue&& successValue) {
     using Result = Future<std::decay_t<SuccessValue>>;
@@ -81,6 +114,7 @@ public:
     ASIOSession(TransportLayerASIO* tl, GenericSocket socket, bool isIngressSession) try
         : _socket(std::move(socket)),
           _tl(tl),
+          _sendFlushTimer(_socket.get_executor().context()),
           _isIngressSession(isIngressSession) {
         auto family = endpointToSockAddr(_socket.local_endpoint()).getType();
         if (family == AF_INET || family == AF_INET6) {
@@ -118,6 +152,8 @@ public:
     void end() override {
         if (getSocket().is_open()) {
             std::error_code ec;
+            failQueuedSends({ErrorCodes::SocketException,
+                             "Session ended before its queued replies were written"});
             cancelAsyncOperations();
             getSocket().shutdown(GenericSocket::shutdown_both, ec);
             if ((ec) && (ec != asio::error::not_connected)) {
@@ -133,6 +169,10 @@ public:
 
     Future<Message> asyncSourceMessage(const transport::BatonHandle& baton = nullptr) override {
         ensureAsync();
+
+        // Replies still waiting in the send queue must not be held back while we wait for the
+        // peer, who may well be waiting for them.
+        flushQueuedSends(stdx::unique_lock<stdx::mutex>(_sendMutex));
         return sourceMessageImpl(baton);
     }
 
@@ -143,6 +183,7 @@ public:
             .then([this, &message] {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
+                    networkCounter.hitPhysicalWrite(1);
                 }
             })
             .getNoThrow();
@@ -151,10 +192,22 @@ public:
     Future<void> asyncSinkMessage(Message message,
                                   const transport::BatonHandle& baton = nullptr) override {
         ensureAsync();
+
+        stdx::unique_lock<stdx::mutex> lk(_sendMutex);
+        if (!_sendStatus.isOK()) {
+            return _sendStatus;
+        }
+
+        if (_shouldCoalesceSends(baton) || _sendInFlight || !_sendQueue.empty()) {
+            return queueSend(std::move(lk), std::move(message));
+        }
+        lk.unlock();
+
         return write(asio::buffer(message.buf(), message.size()), baton)
             .then([this, message /*keep the buffer alive*/]() {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
+                    networkCounter.hitPhysicalWrite(1);
                 }
             });
     }
@@ -341,6 +394,159 @@ private:
         return _socket;
     }
 
+    /**
+     * Replies on async ingress sessions are queued and written out together with one gathered
+     * write. Egress sessions are driven by the network interface, which waits for every send
+     * before it reads, and SSL streams cannot share a socket between an in-flight write and
+     * the next read's handshake traffic, so both keep writing each message as it is sunk.
+     */
+    bool _shouldCoalesceSends(const transport::BatonHandle& baton) {
+#ifdef MONGO_CONFIG_SSL
+        if (_sslSocket) {
+            return false;
+        }
+#endif
+        return _isIngressSession && !baton && sendCoalescingMaxMessages.load() > 1;
+    }
+
+    /**
+     * Appends a message to the send queue. The queue is written out once it reaches
+     * sendCoalescingMaxMessages messages or sendCoalescingMaxBytes bytes, when the
+     * sendCoalescingMaxDelayMicros timer fires, when a write already in flight completes, or
+     * when the session starts reading again, whichever comes first.
+     *
+     * The returned future is ready at once unless the queue is full, in which case it is ready
+     * once the queue has reached the socket, so that a slow peer pushes back on the producer.
+     * Errors from a write that nobody waited for are returned by the next asyncSinkMessage.
+     */
+    Future<void> queueSend(stdx::unique_lock<stdx::mutex> lk, Message message) {
+        _sendQueueBytes += message.size();
+        _sendQueue.push_back(std::move(message));
+
+        const auto maxBytes = static_cast<size_t>(sendCoalescingMaxBytes.load());
+        const auto maxMessages = static_cast<size_t>(sendCoalescingMaxMessages.load());
+        if (_sendQueueBytes >= maxBytes || _sendQueue.size() >= maxMessages) {
+            auto pf = makePromiseFuture<void>();
+            _sendQueueWaiters.push_back(pf.promise.share());
+            flushQueuedSends(std::move(lk));
+            return std::move(pf.future);
+        }
+
+        const auto maxDelay = sendCoalescingMaxDelayMicros.load();
+        if (maxDelay == 0) {
+            flushQueuedSends(std::move(lk));
+        } else if (!_sendInFlight && !_sendFlushTimerArmed) {
+            // A write in flight flushes the queue when it completes, so the timer only covers an
+            // idle socket.
+            _sendFlushTimerArmed = true;
+            _sendFlushTimer.expires_after(std::chrono::microseconds(maxDelay));
+            _sendFlushTimer.async_wait([ this, self = shared_from_this() ](std::error_code ec) {
+                if (ec) {
+                    return;
+                }
+                stdx::unique_lock<stdx::mutex> lk(_sendMutex);
+                _sendFlushTimerArmed = false;
+                flushQueuedSends(std::move(lk));
+            });
+        }
+        return Future<void>::makeReady();
+    }
+
+    /**
+     * Writes out everything in the send queue with a single gathered write straight from the
+     * messages' buffers. Only one write is in flight at a time; whatever is queued behind it goes
+     * out as soon as it completes.
+     */
+    void flushQueuedSends(stdx::unique_lock<stdx::mutex> lk) {
+        if (_sendInFlight || _sendQueue.empty() || !_sendStatus.isOK()) {
+            return;
+        }
+
+        if (_sendFlushTimerArmed) {
+            std::error_code ec;
+            _sendFlushTimer.cancel(ec);
+            _sendFlushTimerArmed = false;
+        }
+
+        auto messages = std::move(_sendQueue);
+        auto waiters = std::move(_sendQueueWaiters);
+        const auto bytes = _sendQueueBytes;
+        _sendQueue.clear();
+        _sendQueueWaiters.clear();
+        _sendQueueBytes = 0;
+        _sendInFlight = true;
+        lk.unlock();
+
+        ConstBufferVector buffers;
+        for (const auto& message : messages) {
+            buffers.push_back(asio::buffer(message.buf(), message.size()));
+        }
+
+        // The completion may run inline if the whole queue fit in the socket buffer.
+        write(buffers).getAsync([
+            this,
+            self = shared_from_this(),
+            messages = std::move(messages) /*keep the buffers alive*/,
+            waiters = std::move(waiters),
+            bytes
+        ](Status status) mutable {
+            if (status.isOK()) {
+                networkCounter.hitPhysicalOut(bytes);
+                networkCounter.hitPhysicalWrite(messages.size());
+            }
+
+            stdx::unique_lock<stdx::mutex> lk(_sendMutex);
+            _sendInFlight = false;
+            if (!status.isOK()) {
+                _sendStatus = status;
+                for (auto& waiter : _sendQueueWaiters) {
+                    waiters.push_back(std::move(waiter));
+                }
+                _sendQueueWaiters.clear();
+                _sendQueue.clear();
+                _sendQueueBytes = 0;
+            }
+            flushQueuedSends(std::move(lk));
+
+            for (auto& waiter : waiters) {
+                if (status.isOK()) {
+                    waiter.emplaceValue();
+                } else {
+                    waiter.setError(status);
+                }
+            }
+        });
+    }
+
+    /**
+     * Drops the send queue of a session that is ending. Its socket is about to be shut down, so
+     * nothing still queued can reach the peer. The queue's waiters and every later
+     * asyncSinkMessage fail with 'status'. A write already in flight fails by itself once the
+     * socket is shut down, and fails its own waiters.
+     */
+    void failQueuedSends(Status status) {
+        std::vector<SharedPromise<void>> waiters;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_sendMutex);
+            if (_sendFlushTimerArmed) {
+                std::error_code ec;
+                _sendFlushTimer.cancel(ec);
+                _sendFlushTimerArmed = false;
+            }
+            if (_sendStatus.isOK()) {
+                _sendStatus = status;
+            }
+            waiters = std::move(_sendQueueWaiters);
+            _sendQueueWaiters.clear();
+            _sendQueue.clear();
+            _sendQueueBytes = 0;
+        }
+
+        for (auto& waiter : waiters) {
+            waiter.setError(status);
+        }
+    }
+
     Future<Message> sourceMessageImpl(const transport::BatonHandle& baton = nullptr) {
         static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
 
@@ -522,14 +728,21 @@ private:
 
         if (MONGO_FAIL_POINT(transportLayerASIOshortOpportunisticReadWrite) &&
             _blockingMode == Async) {
-            asio::const_buffer localBuffer = buffers;
-
-            if (buffers.size()) {
-                localBuffer = asio::const_buffer(buffers.data(), 1);
+            // Write only the first byte of the first buffer, which works for both single buffers
+            // and gathered sequences.
+            asio::const_buffer localBuffer;
+            const auto totalSize = asio::buffer_size(buffers);
+
+            if (totalSize) {
+                auto first = asio::buffer_sequence_begin(buffers);
+                while (first->size() == 0) {
+                    ++first;
+                }
+                localBuffer = asio::const_buffer(first->data(), 1);
             }
 
             size = asio::write(stream, localBuffer, ec);
-            if (!ec && buffers.size() > 1) {
+            if (!ec && totalSize > 1) {
                 ec = asio::error::would_block;
             }
         } else {
@@ -710,6 +923,15 @@ private:
 
     TransportLayerASIO* const _tl;
 
+    // Replies queued for a gathered write, see queueSend().
+    stdx::mutex _sendMutex;
+    std::vector<Message> _sendQueue;
+    std::vector<SharedPromise<void>> _sendQueueWaiters;
+    size_t _sendQueueBytes = 0;
+    bool _sendInFlight = false;
+    Status _sendStatus = Status::OK();
+    asio::steady_timer _sendFlushTimer;
+    bool _sendFlushTimerArmed = false;
 
     bool _isIngressSession;
 };
@@ -31,11 +31,16 @@
 
 #include "mongo/transport/transport_layer_asio.h"
 
+#include "mongo/base/data_view.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/rpc/op_msg.h"
+#include "mongo/transport/asio_utils.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/sock.h"
 
@@ -89,6 +94,12 @@ public:
         _cv.wait(lock, [&] { return !_sessions.empty(); });
     }
 
+    transport::SessionHandle waitForSession() {
+        stdx::unique_lock<stdx::mutex> lock(_mutex);
+        _cv.wait(lock, [&] { return !_sessions.empty(); });
+        return _sessions.front();
+    }
+
 private:
     mutable stdx::mutex _mutex;
     stdx::condition_variable _cv;
@@ -358,5 +369,237 @@ TEST(TransportLayerASIO, SwitchTimeoutModes) {
     tla->shutdown();
 }
 
+TEST(TransportLayerASIO, ConstBufferVectorAdvancesAcrossBuffers) {
+    const char first[] = "abc";
+    const char second[] = "defgh";
+    transport::ConstBufferVector buffers;
+    buffers.push_back(asio::buffer(first, 3));
+    buffers.push_back(asio::buffer(first, 0));
+    buffers.push_back(asio::buffer(second, 5));
+    ASSERT_EQ(buffers.count(), 2UL);
+    ASSERT_EQ(asio::buffer_size(buffers), 8UL);
+
+    // A short write that stops inside the first buffer.
+    auto resumed = buffers;
+    resumed += 2;
+    ASSERT_EQ(resumed.count(), 2UL);
+    ASSERT_EQ(asio::buffer_size(resumed), 6UL);
+    ASSERT_EQ(static_cast<const char*>(resumed.begin()->data()), first + 2);
+
+    // One that stops inside the second, leaving the original untouched.
+    resumed += 3;
+    ASSERT_EQ(resumed.count(), 1UL);
+    ASSERT_EQ(static_cast<const char*>(resumed.begin()->data()), second + 2);
+    ASSERT_EQ(asio::buffer_size(buffers), 8UL);
+
+    resumed += 3;
+    ASSERT_EQ(resumed.count(), 0UL);
+    ASSERT_EQ(asio::buffer_size(resumed), 0UL);
+}
+
+/* Sets a server parameter for the rest of the scope. */
+class ScopedServerParameter {
+public:
+    ScopedServerParameter(const std::string& name, int value) {
+        auto&& params = ServerParameterSet::getGlobal()->getMap();
+        auto it = params.find(name);
+        invariant(it != params.end());
+        _param = it->second;
+
+        BSONObjBuilder bob;
+        _param->append(nullptr, bob, name);
+        _old = bob.obj();
+        ASSERT_OK(_param->setFromString(std::to_string(value)));
+    }
+
+    ~ScopedServerParameter() {
+        invariant(_param->set(_old.firstElement()).isOK());
+    }
+
+private:
+    ServerParameter* _param;
+    BSONObj _old;
+};
+
+/*
+ * Sinks replies asynchronously on an ingress session, whose peer is a blocking socket. The ingress
+ * reactor, normally run by the service executor, only runs once the test calls startReactor(), so
+ * writes that didn't complete inline stay in flight until then.
+ */
+class SendCoalescingTest : public unittest::Test {
+protected:
+    void setUp() override {
+        tla = makeAndStartTL(&sep);
+        sep.setTransportLayer(tla.get());
+
+        std::error_code ec;
+        peer.connect(
+            asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), tla->listenerPort()), ec);
+        ASSERT_EQ(ec, std::error_code());
+        session = sep.waitForSession();
+    }
+
+    void tearDown() override {
+        if (reactorThread.joinable()) {
+            reactor->stop();
+            reactorThread.join();
+        }
+        session.reset();
+        sep.endAllSessions({});
+        tla->shutdown();
+    }
+
+    void startReactor() {
+        reactor = tla->getReactor(transport::TransportLayer::kIngress);
+        reactorThread = stdx::thread([reactor = reactor] { reactor->run(); });
+    }
+
+    static Message makeMessage() {
+        OpMsgBuilder builder;
+        builder.setBody(BSON("ok" << 1 << "pad" << std::string(100, 'x')));
+        Message msg = builder.finish();
+        msg.header().setResponseToMsgId(0);
+        msg.header().setId(0);
+        return msg;
+    }
+
+    Future<void> sink() {
+        return session->asyncSinkMessage(makeMessage());
+    }
+
+    // Reads 'count' whole messages from the peer socket.
+    void receiveMessages(int count) {
+        for (int i = 0; i < count; i++) {
+            char header[sizeof(int32_t)];
+            asio::read(peer, asio::buffer(header, sizeof(header)));
+            std::vector<char> rest(ConstDataView(header).read<LittleEndian<int32_t>>() -
+                                   sizeof(header));
+            asio::read(peer, asio::buffer(rest.data(), rest.size()));
+        }
+    }
+
+    static long long physicalWrites() {
+        BSONObjBuilder bob;
+        networkCounter.append(bob);
+        return bob.obj()["sendCoalescing"]["writes"].numberLong();
+    }
+
+    ServiceEntryPointUtil sep;
+    std::unique_ptr<transport::TransportLayerASIO> tla;
+    asio::io_context peerContext;
+    asio::ip::tcp::socket peer{peerContext};
+    transport::SessionHandle session;
+    transport::ReactorHandle reactor;
+    stdx::thread reactorThread;
+};
+
+TEST_F(SendCoalescingTest, FlushesAtMessageThreshold) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 4);
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 10 * 1000 * 1000);
+    startReactor();
+
+    const auto writesBefore = physicalWrites();
+    for (int i = 0; i < 3; i++) {
+        ASSERT_OK(sink().getNoThrow());
+    }
+    ASSERT_EQ(physicalWrites(), writesBefore);
+
+    // The fourth reply fills the queue, and its sink waits for the gathered write.
+    ASSERT_OK(sink().getNoThrow());
+    ASSERT_EQ(physicalWrites(), writesBefore + 1);
+    receiveMessages(4);
+}
+
+TEST_F(SendCoalescingTest, FlushesAtByteThreshold) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 64);
+    ScopedServerParameter maxBytes("sendCoalescingMaxBytes", 2 * makeMessage().size());
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 10 * 1000 * 1000);
+    startReactor();
+
+    const auto writesBefore = physicalWrites();
+    ASSERT_OK(sink().getNoThrow());
+    ASSERT_EQ(physicalWrites(), writesBefore);
+
+    ASSERT_OK(sink().getNoThrow());
+    ASSERT_EQ(physicalWrites(), writesBefore + 1);
+    receiveMessages(2);
+}
+
+TEST_F(SendCoalescingTest, FlushesAfterDelayOnIdleSocket) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 64);
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 1000);
+    startReactor();
+
+    // Nothing else ever flushes this queue, so the reply only arrives once the timer fires.
+    auto future = sink();
+    ASSERT_TRUE(future.isReady());
+    ASSERT_OK(std::move(future).getNoThrow());
+    receiveMessages(1);
+}
+
+TEST_F(SendCoalescingTest, FullQueueWaitsForTheWrite) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 2);
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 10 * 1000 * 1000);
+    FailPointEnableBlock shortWrites("transportLayerASIOshortOpportunisticReadWrite");
+
+    // Each write only gets its first byte out inline, the rest waits for the reactor.
+    ASSERT_OK(sink().getNoThrow());
+    auto firstWrite = sink();
+    ASSERT_FALSE(firstWrite.isReady());
+
+    // Replies queue up behind the write in flight until the queue is full again.
+    ASSERT_OK(sink().getNoThrow());
+    auto secondWrite = sink();
+    ASSERT_FALSE(secondWrite.isReady());
+
+    startReactor();
+    ASSERT_OK(std::move(firstWrite).getNoThrow());
+    ASSERT_OK(std::move(secondWrite).getNoThrow());
+    receiveMessages(4);
+}
+
+TEST_F(SendCoalescingTest, WriteErrorFailsALaterSink) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 64);
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 0);
+    startReactor();
+
+    // Reset the connection so that writes to it fail.
+    peer.set_option(asio::socket_base::linger(true, 0));
+    peer.close();
+
+    // The sink that queues a failing write has already returned by the time the write fails, so
+    // the error is returned by a later sink instead.
+    ASSERT_OK(sink().getNoThrow());
+    Status status = Status::OK();
+    for (int i = 0; i < 100 && status.isOK(); i++) {
+        stdx::this_thread::sleep_for(Milliseconds(10).toSystemDuration());
+        status = sink().getNoThrow();
+    }
+    ASSERT_NOT_OK(status);
+    ASSERT_EQ(sink().getNoThrow(), status);
+}
+
+TEST_F(SendCoalescingTest, EndFailsQueuedReplies) {
+    ScopedServerParameter maxMessages("sendCoalescingMaxMessages", 2);
+    ScopedServerParameter maxDelay("sendCoalescingMaxDelayMicros", 10 * 1000 * 1000);
+    FailPointEnableBlock shortWrites("transportLayerASIOshortOpportunisticReadWrite");
+
+    ASSERT_OK(sink().getNoThrow());
+    auto inFlight = sink();
+    ASSERT_OK(sink().getNoThrow());
+    auto queued = sink();
+    ASSERT_FALSE(queued.isReady());
+
+    // The queued replies can't be written once the socket is shut down, so ending the session
+    // fails their waiter and every later sink.
+    session->end();
+    ASSERT_EQ(std::move(queued).getNoThrow(), ErrorCodes::SocketException);
+    ASSERT_EQ(sink().getNoThrow(), ErrorCodes::SocketException);
+
+    // The write that was already in flight completes, one way or the other.
+    startReactor();
+    std::move(inFlight).getNoThrow().ignore();
+}
+
 }  // namespace
 }  // namespace mongo
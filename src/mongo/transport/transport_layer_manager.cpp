@@ -142,12 +142,27 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
 
     auto transportLayerASIO = stdx::make_unique<transport::TransportLayerASIO>(opts, sep);
 
+    // Sessions from the admin whitelist get their own executor so that customer load can't
+    // take the threads administrative connections need. The admin executor is only created when
+    // a whitelist is configured at startup; a whitelist loaded later by the reload command shares
+    // the main executor. In adaptive mode the admin executor's workers run their own reactor, but
+    // an admin session's socket I/O still completes on the ingress reactor that accepted it.
+    const bool hasAdminWhiteList = config->adminWhiteList.rangeSize() > 0;
     if (config->serviceExecutor == "adaptive") {
         auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
         ctx->setServiceExecutor(
             stdx::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+
+        if (hasAdminWhiteList) {
+            auto adminReactor = transportLayerASIO->getReactor(TransportLayer::kNewReactor);
+            ctx->setAdminServiceExecutor(stdx::make_unique<ServiceExecutorAdaptive>(
+                ctx, std::move(adminReactor), ServiceExecutorAdaptive::makeAdminOptions()));
+        }
     } else if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(stdx::make_unique<ServiceExecutorSynchronous>(ctx));
+        if (hasAdminWhiteList) {
+            ctx->setAdminServiceExecutor(stdx::make_unique<ServiceExecutorSynchronous>(ctx));
+        }
     }
     transportLayer = std::move(transportLayerASIO);
 
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/new.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A bounded, lock-free queue for many producers and a single consumer.
+ *
+ * The queue is a fixed ring of cells, each tagged with a sequence number that tells producers
+ * and the consumer whether the cell is free or holds a published value (the scheme described by
+ * Dmitry Vyukov for bounded MPMC queues). Producers claim a cell with a single compare-and-swap
+ * on the enqueue position; the consumer never contends with producers except on the cell it is
+ * reading. Neither push nor pop ever blocks or allocates.
+ *
+ * The capacity is rounded up to the next power of two.
+ *
+ * Only one thread may call tryPop() at a time. tryPush() may be called from any thread.
+ */
+template <typename T>
+class BoundedMPSCQueue {
+    MONGO_DISALLOW_COPYING(BoundedMPSCQueue);
+
+public:
+    explicit BoundedMPSCQueue(size_t capacity)
+        : _mask(_roundUpToPowerOfTwo(capacity) - 1), _cells(new Cell[_mask + 1]) {
+        for (size_t i = 0; i <= _mask; ++i) {
+            _cells[i].sequence.store(i);
+        }
+    }
+
+    /**
+     * Moves "value" into the queue. Returns false, leaving "value" untouched, if the queue is
+     * full.
+     */
+    bool tryPush(T&& value) {
+        size_t pos = _enqueuePos.load();
+        while (true) {
+            Cell& cell = _cells[pos & _mask];
+            const size_t seq = cell.sequence.load();
+            const std::ptrdiff_t diff =
+                static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                const size_t observed = _enqueuePos.compareAndSwap(pos, pos + 1);
+                if (observed == pos) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1);
+                    return true;
+                }
+                pos = observed;
+            } else if (diff < 0) {
+                // The consumer has not yet released this cell from the previous lap.
+                return false;
+            } else {
+                pos = _enqueuePos.load();
+            }
+        }
+    }
+
+    /**
+     * Moves the oldest published value into "out". Returns false if there is nothing to read.
+     *
+     * A producer that has claimed a cell but not yet published into it makes the queue look
+     * empty from that cell onward until it finishes; size() still counts the claimed cell.
+     */
+    bool tryPop(T* out) {
+        const size_t pos = _dequeuePos.loadRelaxed();
+        Cell& cell = _cells[pos & _mask];
+        if (cell.sequence.load() != pos + 1) {
+            return false;
+        }
+        *out = std::move(cell.value);
+        cell.value = T();
+        _dequeuePos.store(pos + 1);
+        cell.sequence.store(pos + _mask + 1);
+        return true;
+    }
+
+    /**
+     * Returns the number of claimed cells. Approximate when called concurrently with push/pop.
+     */
+    size_t size() const {
+        const size_t dequeued = _dequeuePos.load();
+        const size_t enqueued = _enqueuePos.load();
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return _mask + 1;
+    }
+
+    /**
+     * Total number of values ever claimed by producers and released by the consumer. A value
+     * pushed before enqueuedCount() was read has been popped once dequeuedCount() reaches it.
+     */
+    size_t enqueuedCount() const {
+        return _enqueuePos.load();
+    }
+
+    size_t dequeuedCount() const {
+        return _dequeuePos.load();
+    }
+
+private:
+    struct Cell {
+        AtomicWord<size_t> sequence;
+        T value;
+    };
+
+    static size_t _roundUpToPowerOfTwo(size_t n) {
+        invariant(n > 0);
+        size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t _mask;
+    const std::unique_ptr<Cell[]> _cells;
+
+    // Producers and the consumer each own one position; keep them on separate cache lines.
+    char _pad0[stdx::hardware_destructive_interference_size];
+    AtomicWord<size_t> _enqueuePos{0};
+    char _pad1[stdx::hardware_destructive_interference_size];
+    AtomicWord<size_t> _dequeuePos{0};
+    char _pad2[stdx::hardware_destructive_interference_size];
+};
+
+}  // namespace mongo
@@ -0,0 +1,133 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/bounded_mpsc_queue.h"
+
+namespace mongo {
+namespace {
+
+TEST(BoundedMPSCQueueTest, CapacityIsRoundedUpToPowerOfTwo) {
+    ASSERT_EQ(1U, BoundedMPSCQueue<int>(1).capacity());
+    ASSERT_EQ(8U, BoundedMPSCQueue<int>(5).capacity());
+    ASSERT_EQ(16U, BoundedMPSCQueue<int>(16).capacity());
+}
+
+TEST(BoundedMPSCQueueTest, PopFromEmptyQueueFails) {
+    BoundedMPSCQueue<int> queue(4);
+    int out = -1;
+    ASSERT_FALSE(queue.tryPop(&out));
+    ASSERT_EQ(-1, out);
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(BoundedMPSCQueueTest, PreservesFifoOrderAcrossWraparound) {
+    BoundedMPSCQueue<int> queue(4);
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(queue.tryPush(int(next++)));
+        }
+        ASSERT_EQ(3U, queue.size());
+        for (int i = 0; i < 3; ++i) {
+            int out;
+            ASSERT_TRUE(queue.tryPop(&out));
+            ASSERT_EQ(expected++, out);
+        }
+    }
+    ASSERT_EQ(30U, queue.enqueuedCount());
+    ASSERT_EQ(30U, queue.dequeuedCount());
+}
+
+TEST(BoundedMPSCQueueTest, PushToFullQueueFailsWithoutConsumingValue) {
+    BoundedMPSCQueue<std::unique_ptr<int>> queue(2);
+    ASSERT_TRUE(queue.tryPush(std::make_unique<int>(1)));
+    ASSERT_TRUE(queue.tryPush(std::make_unique<int>(2)));
+
+    auto extra = std::make_unique<int>(3);
+    ASSERT_FALSE(queue.tryPush(std::move(extra)));
+    ASSERT(extra);
+    ASSERT_EQ(2U, queue.size());
+
+    std::unique_ptr<int> out;
+    ASSERT_TRUE(queue.tryPop(&out));
+    ASSERT_EQ(1, *out);
+    ASSERT_TRUE(queue.tryPush(std::move(extra)));
+    ASSERT_FALSE(extra);
+}
+
+TEST(BoundedMPSCQueueTest, ConcurrentProducersDeliverEveryValueOnce) {
+    const int kProducers = 4;
+    const int kPerProducer = 20000;
+    BoundedMPSCQueue<int> queue(64);
+
+    std::vector<stdx::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                while (!queue.tryPush(p * kPerProducer + i)) {
+                    stdx::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> lastSeen(kProducers, -1);
+    std::vector<int> seen(kProducers * kPerProducer, 0);
+    int received = 0;
+    while (received < kProducers * kPerProducer) {
+        int value;
+        if (!queue.tryPop(&value)) {
+            stdx::this_thread::yield();
+            continue;
+        }
+        ++seen[value];
+        // Values from a single producer must arrive in the order they were pushed.
+        const int producer = value / kPerProducer;
+        ASSERT_LT(lastSeen[producer], value);
+        lastSeen[producer] = value;
+        ++received;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    for (int count : seen) {
+        ASSERT_EQ(1, count);
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+}  // namespace
+}  // namespace mongo
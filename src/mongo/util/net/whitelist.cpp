@@ -39,9 +39,12 @@
 #include <arpa/inet.h>
 #include <sstream>
 
+#include <algorithm>
+#include <atomic>
+
 #include <boost/algorithm/string.hpp>
 #include "mongo/util/text.h"
-// #include "mongo/util/concurrency/rwlock.h"
+#include "mongo/util/net/sockaddr.h"
 #include "mongo/util/net/whitelist.h"
 
 namespace mongo {
@@ -181,7 +184,7 @@ namespace mongo {
         return true;
     }
 
-    void IpRange::toString(std::stringstream& ss) {
+    void IpRange::toString(std::stringstream& ss) const {
 
         std::string min_ipstr;
         std::string max_ipstr;
@@ -192,6 +195,99 @@ namespace mongo {
         ss << "[" << min_ipstr << "," << max_ipstr << "] ";
     }
 
+namespace {
+
+    const __uint128_t kMaxV4 = 0xffffffffULL;
+
+    // Source of WhiteList::_generation values, so that a thread's cached Table can never be
+    // mistaken for another WhiteList's.
+    AtomicUInt64 nextGeneration{0};
+
+    struct CachedTable {
+        const WhiteList* owner = nullptr;
+        uint64_t generation = 0;
+        std::shared_ptr<const WhiteList::Table> table;
+    };
+
+    thread_local CachedTable cachedTable;
+
+}  // namespace
+
+    WhiteList::Table::Table(const std::map<__uint128_t, IpRange>& merged, std::string path)
+        : _path(std::move(path)) {
+        _ranges.reserve(merged.size());
+        for (const auto& entry : merged) {
+            const IpRange& range = entry.second;
+            _ranges.push_back(range);
+
+            if (range.min <= kMaxV4) {
+                V4Range v4;
+                v4.min = static_cast<uint32_t>(range.min);
+                v4.max = static_cast<uint32_t>(std::min(range.max, kMaxV4));
+                _v4.push_back(v4);
+            }
+            if (range.max > kMaxV4) {
+                IpRange v6 = range;
+                v6.min = std::max(range.min, kMaxV4 + 1);
+                _v6.push_back(v6);
+            }
+        }
+
+        auto it = _v4.begin();
+        for (uint64_t octet = 0; octet < 256; ++octet) {
+            const uint64_t first = octet << 24;
+            while (it != _v4.end() && it->max < first) {
+                ++it;
+            }
+            _v4Index[octet] = static_cast<uint32_t>(it - _v4.begin());
+        }
+        _v4Index[256] = static_cast<uint32_t>(_v4.size());
+    }
+
+    bool WhiteList::Table::includeV4(uint32_t ip) const {
+        // The range holding "ip", if any, is the first one ending at or after it. That is no
+        // later than the first range reaching the next octet.
+        const uint32_t octet = ip >> 24;
+        auto begin = _v4.begin() + _v4Index[octet];
+        auto end = _v4.begin() + std::min<size_t>(_v4Index[octet + 1] + 1, _v4.size());
+        auto it = std::lower_bound(
+            begin, end, ip, [](const V4Range& range, uint32_t value) { return range.max < value; });
+        return it != end && it->min <= ip;
+    }
+
+    bool WhiteList::Table::include(const __uint128_t& ip) const {
+        if (ip <= kMaxV4) {
+            return includeV4(static_cast<uint32_t>(ip));
+        }
+
+        auto it = std::lower_bound(
+            _v6.begin(), _v6.end(), ip, [](const IpRange& range, const __uint128_t& value) {
+                return range.max < value;
+            });
+        return it != _v6.end() && it->min <= ip;
+    }
+
+    WhiteList::WhiteList() {
+        _publish(std::make_shared<Table>());
+    }
+
+    void WhiteList::_publish(std::shared_ptr<const Table> table) {
+        // The table is stored before the generation moves, so a thread that sees the new
+        // generation loads a table at least that new.
+        std::atomic_store(&_table, std::move(table));
+        _generation.store(nextGeneration.addAndFetch(1));
+    }
+
+    const WhiteList::Table& WhiteList::_snapshot() const {
+        const uint64_t generation = _generation.load();
+        if (cachedTable.owner != this || cachedTable.generation != generation) {
+            cachedTable.table = std::atomic_load(&_table);
+            cachedTable.owner = this;
+            cachedTable.generation = generation;
+        }
+        return *cachedTable.table;
+    }
+
     bool WhiteList::parseFromFile(const std::string& path, std::string& errmsg) {
         if (path.empty() || path[0] != '/') {
             errmsg = "must be absolute path";
@@ -217,29 +313,39 @@ namespace mongo {
             return false;
         }
 
-        char line[kMaxFileSize + 1] = {0};
-        if(fgets(line, kMaxFileSize, f) == NULL) {
+        std::unique_ptr<char[]> line(new char[kMaxFileSize + 1]());
+        if(fgets(line.get(), kMaxFileSize, f) == NULL) {
+            fclose(f);
             return false;
         }
         fclose(f);
 
-        std::string content = line;
+        std::string content = line.get();
         boost::trim(content);
         
-        if (!parseFromString(content)) {
+        std::map<__uint128_t, IpRange> merged;
+        if (!_parse(content, merged)) {
             errmsg = "whitelist format invalid";
             return false;
         }
 
-        _path = path;
+        _publish(std::make_shared<Table>(merged, path));
         return true;
     }
 
     // eg: 192.168.1.100,192.168.1.100/24
     bool WhiteList::parseFromString(const std::string& line) {
+        std::map<__uint128_t, IpRange> merged;
+        if (!_parse(line, merged)) {
+            return false;
+        }
+
+        _publish(std::make_shared<Table>(merged, path()));
+        return true;
+    }
+
+    bool WhiteList::_parse(const std::string& line, std::map<__uint128_t, IpRange>& whiteList) {
         if (line.empty()) {
-            // rwlock lk(_lock, true);
-            _whiteList.clear();
             return true;
         }
 
@@ -257,7 +363,6 @@ namespace mongo {
         }
 
         // merge overlapped items
-        std::map<__uint128_t, IpRange> whiteList;
         IpRange last;
         auto mit = whiteMap.begin();
         for ( ; mit != whiteMap.end(); mit++ ) {
@@ -277,40 +382,40 @@ namespace mongo {
             whiteList.insert(std::make_pair(last.min, last));
         }
 
-        // swap to update
-        // rwlock lk(_lock, true);
-        _whiteList.swap(whiteList);
-     
         return true;
     }
 
-    int WhiteList::rangeSize() {
-        // rwlock lk(_lock, false);
-        return _whiteList.size();
+    int WhiteList::rangeSize() const {
+        return _snapshot().ranges().size();
     }
 
-    bool WhiteList::include(const __uint128_t& ip) {
-        // rwlock lk(_lock, false);
-        if (_whiteList.empty()) {
-            return false;
-        }
-
-        std::map<__uint128_t, IpRange>::iterator it = _whiteList.lower_bound(ip);
-        if (it != _whiteList.end() && it->second.include(ip)) {
-            return true;
-        }
-
-        if (it != _whiteList.begin()) {
-            it--;
-            if (it->second.include(ip)) {
-                return true;
+    bool WhiteList::include(const SockAddr& addr) const {
+        const Table& table = _snapshot();
+        switch (addr.getType()) {
+            case AF_INET:
+                return table.includeV4(ntohl(addr.as<sockaddr_in>().sin_addr.s_addr));
+            case AF_INET6: {
+                const in6_addr& ip6addr = addr.as<sockaddr_in6>().sin6_addr;
+                __uint128_t ipval = 0;
+                for (int i = 0; i < 16; i++) {
+                    ipval = (ipval << 8) | ip6addr.s6_addr[i];
+                }
+                if (IN6_IS_ADDR_V4MAPPED(&ip6addr) &&
+                    table.includeV4(static_cast<uint32_t>(ipval & kMaxV4))) {
+                    return true;
+                }
+                return table.include(ipval);
             }
+            default:
+                return false;
         }
+    }
 
-        return false;
+    bool WhiteList::include(const __uint128_t& ip) const {
+        return _snapshot().include(ip);
     }
 
-    bool WhiteList::include(const std::string& ipstr) {
+    bool WhiteList::include(const std::string& ipstr) const {
         __uint128_t ipval = 0;
         if (!IpRange::addrToUint(ipstr, ipval)) {
             return false;
@@ -319,42 +424,37 @@ namespace mongo {
     }
 
     void WhiteList::setMatchAll() {
-        // rwlock lk(_lock, true);
         IpRange range;
         range.min = 0;
         range.max = IpRange::maxNum;
-        _whiteList.clear();
-        _whiteList.insert(std::make_pair(range.min, range));
+        std::map<__uint128_t, IpRange> merged;
+        merged.insert(std::make_pair(range.min, range));
+        _publish(std::make_shared<Table>(merged, path()));
     }
 
-    bool WhiteList::isMatchAll() {
-        // rwlock lk(_lock, false);
-        if (_whiteList.size() != 1) {
+    bool WhiteList::isMatchAll() const {
+        const auto& ranges = _snapshot().ranges();
+        if (ranges.size() != 1) {
             return false;
         }
 
-        auto it = _whiteList.begin();
-        return it->second.min == 0 && it->second.max == IpRange::maxNum;
+        return ranges[0].min == 0 && ranges[0].max == IpRange::maxNum;
     }
 
     void WhiteList::setMatchNone() {
-        // rwlock lk(_lock, true);
-        _whiteList.clear();
+        _publish(std::make_shared<Table>(std::map<__uint128_t, IpRange>(), path()));
     }
 
-    bool WhiteList::isMatchNone() {
-        // rwlock lk(_lock, false);
-        return _whiteList.empty();
+    bool WhiteList::isMatchNone() const {
+        return _snapshot().ranges().empty();
     }
 
-    std::string WhiteList::toString() {
+    std::string WhiteList::toString() const {
         std::stringstream ss;
-        // rwlock lk(_lock, false);
-        auto it = _whiteList.begin();
-        for ( ; it != _whiteList.end(); it++ ) {
-            it->second.toString(ss);
+        for (const auto& range : _snapshot().ranges()) {
+            range.toString(ss);
         }
         return ss.str();
     }
 
-}
\ No newline at end of file
+}
@@ -28,10 +28,19 @@
 
 #pragma once
 
-// #include "mongo/util/concurrency/rwlock.h"
+#include <array>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
+    struct SockAddr;
+
     struct IpRange {
         __uint128_t min;
         __uint128_t max;
@@ -60,7 +69,7 @@ namespace mongo {
         static int ipType(const std::string& ipstr);
         static bool parseItem(const std::string& raw, IpRange& range);
 
-        void toString(std::stringstream& ss);
+        void toString(std::stringstream& ss) const;
     };
 
     /* 
@@ -69,30 +78,91 @@ namespace mongo {
      * 1. single ip, 192.168.1.100
      * 2. netmask, 192.168.1.100/24
      * 3. net range, 192.168.1.100-192.168.1.200
+     *
+     * The parsed list is compiled into an immutable Table and published by swapping a pointer, so
+     * a reload never changes the ranges under a reader and readers take no lock. Each thread
+     * keeps the Table it last used and only reloads the pointer after a publish.
      */
     class WhiteList {
     public:
-        //WhiteList():_lock("whitelistMutex") {  }
+        /*
+         * Merged, non-overlapping ranges in two lookup structures. IPv4 addresses (::a.b.c.d,
+         * see IpRange::addrToUint) are searched among the ranges that can hold their first
+         * octet, found through a 256-entry index; other addresses by binary search over sorted
+         * 128-bit ranges. A range crossing 2^32 is split between the two.
+         */
+        class Table {
+        public:
+            Table() = default;
+            Table(const std::map<__uint128_t, IpRange>& merged, std::string path);
+
+            bool include(const __uint128_t& ip) const;
+
+            bool includeV4(uint32_t ip) const;
+
+            // The merged ranges, in order.
+            const std::vector<IpRange>& ranges() const {
+                return _ranges;
+            }
+
+            const std::string& path() const {
+                return _path;
+            }
+
+        private:
+            struct V4Range {
+                uint32_t min;
+                uint32_t max;
+            };
+
+            std::vector<IpRange> _ranges;
+
+            std::vector<V4Range> _v4;
+            // _v4Index[o] is the first range in _v4 ending at or after o.0.0.0; _v4Index[256] is
+            // _v4.size().
+            std::array<uint32_t, 257> _v4Index{};
+
+            std::vector<IpRange> _v6;
+
+            std::string _path;
+        };
+
+        WhiteList();
+
         bool parseFromFile(const std::string& path, std::string& errmsg);
         bool parseFromString(const std::string& line);
-        bool include(const __uint128_t& ip);
-        bool include(const std::string& ipstr);
-        int rangeSize();
-        std::string toString();
+
+        /*
+         * Matches an accepted connection's address without formatting it. An IPv4-mapped IPv6
+         * address also matches the IPv4 ranges.
+         */
+        bool include(const SockAddr& addr) const;
+        bool include(const __uint128_t& ip) const;
+        bool include(const std::string& ipstr) const;
+        int rangeSize() const;
+        std::string toString() const;
 
         void setMatchAll();
-        bool isMatchAll();
+        bool isMatchAll() const;
         void setMatchNone();
-        bool isMatchNone();
+        bool isMatchNone() const;
 
-        std::string path() {
-            return _path;
+        std::string path() const {
+            return _snapshot().path();
         }
 
     private:
-        std::map<__uint128_t, IpRange> _whiteList;
-        std::string _path;
-        // RWLock _lock;
+        static bool _parse(const std::string& line, std::map<__uint128_t, IpRange>& merged);
+
+        void _publish(std::shared_ptr<const Table> table);
+
+        // The current Table, from this thread's cache when nothing was published since.
+        const Table& _snapshot() const;
+
+        // Read and written with std::atomic_load/std::atomic_store.
+        std::shared_ptr<const Table> _table;
+        // Unique across all WhiteLists; bumped after every publish.
+        AtomicUInt64 _generation;
     };
 
-}
\ No newline at end of file
+}
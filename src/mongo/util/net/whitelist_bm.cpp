@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/net/sockaddr.h"
+#include "mongo/util/net/whitelist.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * A whitelist of state.range(0) /24 networks spread over the IPv4 space, plus one IPv6 network.
+ */
+std::string makeWhiteList(int entries) {
+    std::string line = "2001:db8::/32";
+    for (int i = 0; i < entries; ++i) {
+        const uint32_t net = static_cast<uint32_t>(i) * 2654435761u & 0xffffff00u;
+        std::string addr;
+        IpRange::uintToAddr(net, addr);
+        line += "," + addr + "/24";
+    }
+    return line;
+}
+
+/**
+ * Peers of a reconnect storm: mostly unlisted clients, some from listed networks.
+ */
+std::vector<SockAddr> makePeers(int entries) {
+    std::vector<SockAddr> peers;
+    for (int i = 0; i < 256; ++i) {
+        uint32_t ip = static_cast<uint32_t>(i) * 40503u * 65537u;
+        if (i % 8 == 0) {
+            ip = (static_cast<uint32_t>(i % entries) * 2654435761u & 0xffffff00u) | 7;
+        }
+        std::string addr;
+        IpRange::uintToAddr(ip, addr);
+        peers.emplace_back(addr, 27017, AF_INET);
+    }
+    return peers;
+}
+
+/**
+ * The per-connection check before the whitelist was compiled: the remote and local host strings
+ * are parsed again and looked up in a std::map of ranges.
+ */
+class LegacyWhiteList {
+public:
+    explicit LegacyWhiteList(const std::string& line) {
+        std::multimap<__uint128_t, IpRange> sorted;
+        for (const auto& item : StringSplitter::split(line, ",")) {
+            IpRange range;
+            invariant(IpRange::parseItem(item, range));
+            sorted.insert(std::make_pair(range.min, range));
+        }
+        for (const auto& entry : sorted) {
+            _ranges.insert(entry);
+        }
+    }
+
+    bool include(const std::string& ipstr) const {
+        __uint128_t ip = 0;
+        if (!IpRange::addrToUint(ipstr, ip) || _ranges.empty()) {
+            return false;
+        }
+        auto it = _ranges.lower_bound(ip);
+        if (it != _ranges.end() && it->second.include(ip)) {
+            return true;
+        }
+        if (it != _ranges.begin()) {
+            --it;
+            return it->second.include(ip);
+        }
+        return false;
+    }
+
+private:
+    std::map<__uint128_t, IpRange> _ranges;
+};
+
+void BM_StartSessionLegacy(benchmark::State& state) {
+    const std::string line = makeWhiteList(state.range(0));
+    static std::unique_ptr<LegacyWhiteList> whiteList;
+    if (state.thread_index == 0) {
+        whiteList = std::make_unique<LegacyWhiteList>(line);
+    }
+    std::vector<std::string> remotes;
+    for (const auto& peer : makePeers(state.range(0))) {
+        remotes.push_back(peer.getAddr());
+    }
+    const std::string local = "192.0.2.1";
+
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& remote = remotes[i++ % remotes.size()];
+        benchmark::DoNotOptimize(whiteList->include(remote) || whiteList->include(local));
+    }
+
+    if (state.thread_index == 0) {
+        whiteList.reset();
+    }
+}
+
+void BM_StartSessionCompiled(benchmark::State& state) {
+    static WhiteList whiteList;
+    if (state.thread_index == 0) {
+        invariant(whiteList.parseFromString(makeWhiteList(state.range(0))));
+    }
+    const std::vector<SockAddr> remotes = makePeers(state.range(0));
+    const SockAddr local("192.0.2.1", 27017, AF_INET);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        const SockAddr& remote = remotes[i++ % remotes.size()];
+        benchmark::DoNotOptimize(whiteList.include(remote) || whiteList.include(local));
+    }
+}
+
+// A storm of accepts while an operator reloads the whitelist.
+void BM_StartSessionCompiledDuringReload(benchmark::State& state) {
+    static WhiteList whiteList;
+    const std::string line = makeWhiteList(state.range(0));
+    if (state.thread_index == 0) {
+        invariant(whiteList.parseFromString(line));
+    }
+    const std::vector<SockAddr> remotes = makePeers(state.range(0));
+    const SockAddr local("192.0.2.1", 27017, AF_INET);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        if (state.thread_index == 0 && i % 1024 == 0) {
+            invariant(whiteList.parseFromString(line));
+        }
+        const SockAddr& remote = remotes[i++ % remotes.size()];
+        benchmark::DoNotOptimize(whiteList.include(remote) || whiteList.include(local));
+    }
+}
+
+BENCHMARK(BM_StartSessionLegacy)->Arg(16)->Arg(256)->Arg(4096)->ThreadRange(1, 16);
+BENCHMARK(BM_StartSessionCompiled)->Arg(16)->Arg(256)->Arg(4096)->ThreadRange(1, 16);
+BENCHMARK(BM_StartSessionCompiledDuringReload)->Arg(256)->ThreadRange(1, 16);
+
+}  // namespace
+}  // namespace mongo
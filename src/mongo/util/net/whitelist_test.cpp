@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2018 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects
+ * for all of the code used other than as permitted herein. If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so. If you do not
+ * wish to do so, delete this exception statement from your version. If you
+ * delete this exception statement from all source files in the program,
+ * then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/whitelist.h"
+
+#include <sys/socket.h>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/sockaddr.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace {
+
+TEST(WhiteListTest, MatchesSingleMaskAndRange) {
+    WhiteList whiteList;
+    ASSERT_TRUE(
+        whiteList.parseFromString("192.168.1.100,10.1.0.0/16,172.16.0.10-172.16.0.20,fe80::/10"));
+
+    ASSERT_TRUE(whiteList.include(std::string("192.168.1.100")));
+    ASSERT_FALSE(whiteList.include(std::string("192.168.1.101")));
+    ASSERT_TRUE(whiteList.include(std::string("10.1.255.255")));
+    ASSERT_FALSE(whiteList.include(std::string("10.2.0.0")));
+    ASSERT_TRUE(whiteList.include(std::string("172.16.0.10")));
+    ASSERT_TRUE(whiteList.include(std::string("172.16.0.20")));
+    ASSERT_FALSE(whiteList.include(std::string("172.16.0.21")));
+    ASSERT_TRUE(whiteList.include(std::string("fe80::1")));
+    ASSERT_FALSE(whiteList.include(std::string("fec0::1")));
+    ASSERT_FALSE(whiteList.include(std::string("not an address")));
+    ASSERT_EQ(4, whiteList.rangeSize());
+}
+
+TEST(WhiteListTest, MergesOverlappingRanges) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.parseFromString("10.0.0.0/24,10.0.0.128-10.0.1.10,10.0.0.5"));
+    ASSERT_EQ(1, whiteList.rangeSize());
+    ASSERT_TRUE(whiteList.include(std::string("10.0.1.10")));
+    ASSERT_FALSE(whiteList.include(std::string("10.0.1.11")));
+}
+
+TEST(WhiteListTest, RangeSpanningFirstOctets) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.parseFromString("9.255.255.250-12.0.0.5"));
+
+    ASSERT_FALSE(whiteList.include(std::string("9.255.255.249")));
+    ASSERT_TRUE(whiteList.include(std::string("9.255.255.250")));
+    ASSERT_TRUE(whiteList.include(std::string("10.0.0.0")));
+    ASSERT_TRUE(whiteList.include(std::string("11.128.0.1")));
+    ASSERT_TRUE(whiteList.include(std::string("12.0.0.5")));
+    ASSERT_FALSE(whiteList.include(std::string("12.0.0.6")));
+    ASSERT_FALSE(whiteList.include(std::string("255.255.255.255")));
+}
+
+TEST(WhiteListTest, MatchAllAndNone) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.isMatchNone());
+    ASSERT_FALSE(whiteList.include(std::string("127.0.0.1")));
+
+    whiteList.setMatchAll();
+    ASSERT_TRUE(whiteList.isMatchAll());
+    ASSERT_TRUE(whiteList.include(std::string("127.0.0.1")));
+    ASSERT_TRUE(whiteList.include(std::string("2001:db8::1")));
+
+    whiteList.setMatchNone();
+    ASSERT_TRUE(whiteList.isMatchNone());
+    ASSERT_FALSE(whiteList.include(std::string("2001:db8::1")));
+}
+
+TEST(WhiteListTest, RejectsInvalidListAndKeepsPrevious) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.parseFromString("10.0.0.1"));
+    ASSERT_FALSE(whiteList.parseFromString("10.0.0.2,bogus"));
+    ASSERT_TRUE(whiteList.include(std::string("10.0.0.1")));
+    ASSERT_FALSE(whiteList.include(std::string("10.0.0.2")));
+}
+
+TEST(WhiteListTest, MatchesSockAddr) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.parseFromString("10.0.0.0/8,2001:db8::/32"));
+
+    ASSERT_TRUE(whiteList.include(SockAddr("10.1.2.3", 27017, AF_INET)));
+    ASSERT_FALSE(whiteList.include(SockAddr("11.1.2.3", 27017, AF_INET)));
+    ASSERT_TRUE(whiteList.include(SockAddr("2001:db8::5", 27017, AF_INET6)));
+    ASSERT_FALSE(whiteList.include(SockAddr("2001:db9::5", 27017, AF_INET6)));
+
+    // A dual-stack listener reports IPv4 peers as IPv4-mapped IPv6 addresses.
+    ASSERT_TRUE(whiteList.include(SockAddr("::ffff:10.1.2.3", 27017, AF_INET6)));
+    ASSERT_FALSE(whiteList.include(SockAddr("::ffff:11.1.2.3", 27017, AF_INET6)));
+}
+
+TEST(WhiteListTest, AgreesWithLinearScan) {
+    PseudoRandom random(1);
+    for (int round = 0; round < 20; ++round) {
+        std::string line;
+        for (int i = 0; i < 50; ++i) {
+            const uint32_t low = static_cast<uint32_t>(random.nextInt64());
+            const uint32_t high = low + static_cast<uint32_t>(random.nextInt32(1 << 20));
+            std::string lowStr, highStr;
+            IpRange::uintToAddr(low, lowStr);
+            IpRange::uintToAddr(std::max(low, high), highStr);
+            line += (i ? "," : "") + lowStr + "-" + highStr;
+        }
+
+        WhiteList whiteList;
+        ASSERT_TRUE(whiteList.parseFromString(line));
+
+        std::vector<IpRange> ranges;
+        for (const auto& item : StringSplitter::split(line, ",")) {
+            IpRange range;
+            ASSERT_TRUE(IpRange::parseItem(item, range));
+            ranges.push_back(range);
+        }
+
+        for (int probe = 0; probe < 1000; ++probe) {
+            const __uint128_t ip = static_cast<uint32_t>(random.nextInt64());
+            bool expected = false;
+            for (const auto& range : ranges) {
+                expected = expected || range.include(ip);
+            }
+            ASSERT_EQ(expected, whiteList.include(ip));
+        }
+    }
+}
+
+TEST(WhiteListTest, ReaderSeesWholeListsDuringReload) {
+    WhiteList whiteList;
+    ASSERT_TRUE(whiteList.parseFromString("10.0.0.1,10.0.0.2"));
+
+    AtomicBool done{false};
+    AtomicInt64 mismatches{0};
+    stdx::thread reader([&] {
+        while (!done.load()) {
+            // 10.0.0.1 is in every list published below.
+            if (!whiteList.include(std::string("10.0.0.1"))) {
+                mismatches.fetchAndAdd(1);
+            }
+        }
+    });
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(whiteList.parseFromString(i % 2 ? "10.0.0.1,10.0.0.2" : "10.0.0.3,10.0.0.1"));
+    }
+    done.store(true);
+    reader.join();
+
+    ASSERT_EQ(0, mismatches.load());
+}
+
+}  // namespace
+}  // namespace mongo